@@ -0,0 +1,100 @@
+/* STM32 items on the ESP32 bridge: interval aggregates, alert bursts and the messages for the network task. */
+#ifndef BRIDGE_EVENTS_H
+#define BRIDGE_EVENTS_H
+
+#include <Arduino.h>
+#include "../../Common/Inc/telemetry_proto.h"   // Relative: the Arduino build has no include path
+#include "../Inc/telemetry_agg.h"
+#include "../../Common/Inc/vest_config.h"
+
+#define BURST_PRE_SAMPLES          30     // PPG records kept before an alert starts (~30 s)
+#define BURST_POST_SAMPLES         30     // ... and sent after it ends
+
+// One report as journaled, little-endian, CRC-16/CCITT-FALSE over the bytes before crc
+struct __attribute__((packed)) JournalRecord {
+  uint32_t seq;         // Journal position, never reused
+  uint32_t boot;        // Boot id (BridgeUplink.boot) of the boot that took it
+  uint32_t uptimeMs;
+  uint32_t epoch;       // Unix time, 0 if the clock was not set yet
+  tlm_agg_summary_t hr;    // x10 bpm, over the interval; n = 0 if none
+  tlm_agg_summary_t spo2;  // x10 %
+  tlm_agg_summary_t temp;  // x100 °C
+  uint16_t crc;
+};
+static_assert(sizeof(JournalRecord) == 48, "JournalRecord is the on-flash format");
+
+// I/O task -> network task. Everything that may block (HTTPS, LittleFS) runs
+// in the network task; the I/O task only posts, without waiting.
+enum NetMsgType : uint8_t {
+  NET_REPORT,    // 30 s report, to the journal
+  NET_ALERT,     // Alert transition (only transitions and summaries are sent)
+  NET_SUMMARY,
+  NET_BURST,     // Delta-encoded full-resolution samples around an alert
+  NET_RECORD,    // STM32 record, streamed live (MQTT only)
+  NET_TYPES
+};
+
+struct NetBurst {
+  uint16_t alertId;
+  uint16_t chunk;
+  uint16_t count;
+  uint16_t len;
+  uint8_t  data[TLM_BURST_MAX];
+};
+
+struct NetMsg {
+  NetMsgType type;
+  union {
+    JournalRecord report;                      // NET_REPORT
+    struct { bool active; float score; } alert;  // NET_ALERT: START smoothed score, END peak
+    struct { float mean; float max; } summary;   // NET_SUMMARY
+    NetBurst burst;                            // NET_BURST
+    tp_record_t record;                        // NET_RECORD
+  };
+};
+
+struct BridgeEventsOps {
+  bool (*post)(void* user, const NetMsg& msg);   // To the network task, without waiting; false if dropped
+  void (*stats)(void* user);                     // After the STM32's TXQ line: the bridge's own counters
+  void* user;
+};
+
+struct BurstSample {
+  int32_t v[TLM_BURST_FIELDS];   // ts_ms, hr_x10, spo2_x10, celsius_x100 (INT16_MIN before the first)
+};
+
+/*
+ * Every STM32 record adds to the aggregates of the current interval, which
+ * eventsReport() summarises and resets. Full-resolution burst around an
+ * anomaly alert: the last BURST_PRE_SAMPLES PPG records before it starts,
+ * all of it, BURST_POST_SAMPLES after it ends, posted in NET_BURST chunks.
+ * Alert transitions and summaries are posted as they come; with live, every
+ * record is also posted as NET_RECORD. I/O task only.
+ */
+struct BridgeEvents {
+  BridgeEventsOps ops;
+  bool        live;
+  int16_t     lastTempX100;   // Last LM35 temperature, INT16_MIN if none yet
+  tlm_agg_t   aggHr;          // hr_x10, records with TP_PPG_HR_VALID
+  tlm_agg_t   aggSpo2;        // spo2_x10, records with TP_PPG_FINGER
+  tlm_agg_t   aggTemp;        // LM35 celsius_x100
+  BurstSample burstRing[BURST_PRE_SAMPLES];
+  uint32_t    burstRingCount;
+  tlm_burst_t burst;
+  bool        burstActive;
+  int32_t     burstPost;      // Samples left after the alert ended, -1 while it lasts
+  uint16_t    burstAlertId;
+  uint16_t    burstChunk;
+};
+
+void eventsBegin(BridgeEvents& e, const BridgeEventsOps& ops, bool live);
+
+// tlm_rx_ops_t callbacks, user is the BridgeEvents
+void eventsRecord(void* user, const tp_record_t* r);
+void eventsBinary(void* user, const uint8_t* item, size_t len);
+void eventsLine(void* user, const char* line, size_t len);
+
+// Summaries of the interval into r (hr, spo2, temp), then a new interval
+void eventsReport(BridgeEvents& e, JournalRecord& r);
+
+#endif /* BRIDGE_EVENTS_H */
@@ -0,0 +1,66 @@
+/* UART link to the STM32 (ESP32 bridge): sealed batch reception, NACKs and the link rate. */
+#ifndef BRIDGE_LINK_H
+#define BRIDGE_LINK_H
+
+#include <Arduino.h>
+#include "mbedtls/gcm.h"
+#include "../Inc/telemetry_rx.h"
+
+/*
+ * Frame: COBS([session(4)][ctr(4)][ciphertext][tag(16)][CRC16(2)]) 0x00, see
+ * Common/Inc/telemetry_proto.h. Nonce = session big-endian + 4 zero bytes +
+ * ctr big-endian; the 8-byte header is authenticated too. The plaintext is a
+ * batch of items, each a binary record/frame or ASCII line(s), decoded by
+ * Bridge/Src/telemetry_rx.c on fixed buffers and handled in place (no heap).
+ * mbedtls decrypts straight from the decoder buffer into rx.pt.
+ *
+ * The link starts at TP_LINK_BAUD_BASE and sends HELLO every LINK_HELLO_MS,
+ * offering fastBaud with RTS/CTS. The STM32 ACCEPTs inside a sealed batch;
+ * the switch waits for the end of the pump. No authentic batch for
+ * LINK_SILENCE_MS at the fast rate (STM32 reset, line trouble): back to the
+ * base rate. Frame counter gaps are NACKed on the same UART. The bytes a
+ * RAW item announces (the STM32 trace dump) are passed by, not decoded; if
+ * fewer come than announced, skipping ends LINK_RAW_MARGIN_MS after they
+ * were due.
+ *
+ * Link messages are handled here; the other items go to the application's
+ * record, binary and line callbacks (its open and nack are not used).
+ * I/O task only.
+ */
+#define LINK_HELLO_MS            1000     // HELLO until accepted, then as the keep-alive the STM32 expects
+#define LINK_SILENCE_MS         10000     // No authentic batch this long at the fast rate: back to the base rate
+#define LINK_RTS_THRESHOLD        100     // RX FIFO bytes (of 128) before RTS holds the STM32
+#define LINK_RAW_MARGIN_MS       1000     // Beyond twice the wire time of announced raw bytes
+
+struct BridgeLink {
+  HardwareSerial*     uart;
+  mbedtls_gcm_context gcm;
+  tlm_rx_t            rx;
+  tlm_rx_ops_t        app;
+  uint32_t fastBaud;
+  uint32_t baud;
+  uint32_t pendingBaud;   // ACCEPTed, switched after the pump
+  uint8_t  pendingFlags;
+  uint32_t helloAt;
+  uint32_t heardAt;       // Last authentic batch
+  uint32_t switches;
+  uint32_t fallbacks;     // Back to TP_LINK_BAUD_BASE after LINK_SILENCE_MS
+  uint32_t bytes;         // Received from the STM32
+  uint32_t rawLeft;       // Announced unframed bytes still to pass by
+  uint32_t rawUntil;      // millis() at which skipping gives up
+  uint32_t rawBytes;      // Passed by, in total
+};
+
+// Keys the cipher and resets the receiver; uart already runs at TP_LINK_BAUD_BASE
+void linkBegin(BridgeLink& l, HardwareSerial& uart, const uint8_t key[16], uint32_t fastBaud, const tlm_rx_ops_t& app);
+
+// Feeds what the UART holds to the receiver. Returns the batches accepted.
+uint32_t linkPump(BridgeLink& l);
+
+// After each pump: switch once the STM32 accepted, fall back if it went quiet, HELLO every LINK_HELLO_MS
+void linkPoll(BridgeLink& l, uint32_t now, bool heard);
+
+// Sends a text command line ("CFG ...", Common/Inc/vest_config.h) to the STM32, without its end of line
+void linkCommand(BridgeLink& l, const char* line);
+
+#endif /* BRIDGE_LINK_H */
@@ -0,0 +1,60 @@
+/* HTTPS uplink of the ESP32 bridge: Firestore REST commits, or the ingestion endpoint. */
+#ifndef BRIDGE_UPLINK_H
+#define BRIDGE_UPLINK_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include "../Inc/bridge_events.h"
+
+#define FIRESTORE_URL   "https://firestore.googleapis.com"
+
+struct UplinkConfig {
+  const char* firestoreUrl;   // FIRESTORE_URL, or a stand-in (tools/ingest_server.py)
+  const char* projectId;
+  const char* apiKey;
+  const char* collection;
+  const char* docId;
+  const char* ingestionUrl;   // POST { hr, spo2, temp, timestamp } per report; empty: Firestore commits
+};
+
+struct FsField {
+  const char* name;
+  double      value;
+};
+
+/*
+ * One documents:commit per upload over a kept-alive TLS connection (HTTP
+ * keep-alive); a request that fails on a connection the server dropped is
+ * retried once on a new one. Network task only: calls block for up to the
+ * timeout given to uplinkBegin().
+ */
+struct BridgeUplink {
+  UplinkConfig     cfg;
+  uint32_t         boot;         // Random per boot, prefixes the history and burst document ids
+  WiFiClientSecure client;
+  HTTPClient       http;
+  uint32_t         commits;
+  uint32_t         failures;
+  uint32_t         handshakes;   // TLS connections opened; the rest reused the open one
+  uint32_t         lastMs;       // Duration of the last commit, handshake included
+};
+
+void uplinkBegin(BridgeUplink& u, const UplinkConfig& cfg, uint32_t boot, uint32_t timeoutMs);
+
+// Fields of the user document, other fields untouched
+bool commitToFirestore(BridgeUplink& u, const FsField* fields, size_t n);
+
+// Reports as history/<boot>-<seq>; the newest also updates the user document
+bool commitReports(BridgeUplink& u, const JournalRecord* recs, size_t n, bool newest);
+
+// One burst chunk as bursts/<boot>-<alert>-<chunk>
+bool commitBurst(BridgeUplink& u, const NetBurst& b);
+
+bool sendTelemetryJSON(BridgeUplink& u, uint16_t hr, uint16_t spo2, float temp, unsigned long ts);
+
+// A run of reports: one POST each to the ingestion endpoint if set (its API
+// takes one report), else one Firestore commit for the run
+bool postReports(BridgeUplink& u, const JournalRecord* recs, size_t n, bool newest);
+
+#endif /* BRIDGE_UPLINK_H */
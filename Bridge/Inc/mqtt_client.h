@@ -0,0 +1,152 @@
+/* MQTT 3.1.1 publisher with QoS-1 delivery over any byte stream, no heap (ESP32 bridge). */
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The caller owns the transport (TCP or TLS socket): it opens it, passes
+ * received bytes to Mqtt_Feed() and sends through ops.write. mqtt_t holds
+ * the protocol state and MQTT_INFLIGHT encoded QoS-1 PUBLISHes until their
+ * PUBACK. Those are sent again, with DUP set and in their original order,
+ * after every CONNACK, so a dropped connection loses nothing the window
+ * held; a message may arrive twice and the subscriber must tolerate it.
+ *
+ * Publish only: the client never subscribes, and PUBLISH packets from the
+ * broker are skipped. Mqtt_Poll() sends PINGREQ when nothing else went out
+ * for keepalive seconds, and reports the connection lost when CONNACK or
+ * PINGRESP takes longer than MQTT_REPLY_TIMEOUT_MS.
+ */
+#define MQTT_PACKET_MAX         (320U)     // Encoded PUBLISH, topic and header included
+#define MQTT_INFLIGHT           (8U)       // QoS-1 PUBLISHes awaiting PUBACK
+#define MQTT_RX_MAX             (8U)       // Packet body kept; longer bodies are skipped
+#define MQTT_REPLY_TIMEOUT_MS   (10000U)
+
+typedef enum {
+  MQTT_DISCONNECTED = 0,
+  MQTT_CONNECTING   = 1,   // CONNECT sent, waiting for CONNACK
+  MQTT_CONNECTED    = 2,
+} mqtt_state_t;
+
+typedef struct {
+  // Sends len bytes; returns 1 if all were written, 0 if the transport failed
+  uint8_t (*write)(void *user, const uint8_t *data, size_t len);
+  void *user;
+} mqtt_ops_t;
+
+typedef struct {
+  const char    *client_id;
+  const char    *username;      // NULL: none
+  const char    *password;      // NULL: none (needs a username)
+  const char    *will_topic;    // NULL: no will
+  const uint8_t *will_msg;
+  uint16_t       will_len;
+  uint8_t        will_retain;
+  uint8_t        clean;         // Clean session
+  uint16_t       keepalive_s;   // 0: no keep-alive
+} mqtt_connect_t;
+
+typedef struct {
+  uint32_t connects;      // CONNACK accepted
+  uint32_t refused;       // CONNACK with a return code
+  uint32_t timeouts;      // No CONNACK or PINGRESP in time
+  uint32_t published;     // PUBLISHes sent the first time, QoS 0 and 1
+  uint32_t acked;         // PUBACKs matching an in-flight PUBLISH
+  uint32_t resent;        // Sent again after a reconnect, DUP set
+  uint32_t window_full;   // Mqtt_Publish() refused: MQTT_INFLIGHT in flight
+  uint32_t pings;
+  uint32_t bad_packets;   // Malformed, unexpected or unknown PUBACK id
+  uint32_t bytes_out;
+  uint32_t ack_ms_last;   // PUBLISH (or its last resend) to PUBACK
+  uint32_t ack_ms_max;
+} mqtt_stats_t;
+
+typedef struct {
+  uint16_t id;            // Packet identifier, 0: free
+  uint16_t len;
+  uint32_t order;         // Resend order
+  uint32_t sent_ms;
+  uint8_t  sent;          // Written at least once
+  uint8_t  buf[MQTT_PACKET_MAX];
+} mqtt_slot_t;
+
+typedef struct {
+  mqtt_ops_t   ops;
+  mqtt_stats_t stats;
+  uint8_t      state;         // mqtt_state_t
+  uint8_t      return_code;   // Of the last CONNACK
+  uint8_t      ping_pending;
+  uint8_t      inflight;
+  uint16_t     keepalive_s;
+  uint16_t     next_id;
+  uint32_t     order;
+  uint32_t     last_tx_ms;
+  uint32_t     wait_ms;       // CONNECT or PINGREQ sent at
+  mqtt_slot_t  slots[MQTT_INFLIGHT];
+  // Receive parser
+  uint8_t      rx_hdr;        // Fixed header byte, 0: waiting for one
+  uint8_t      rx_len_done;
+  uint8_t      rx_len_shift;
+  uint32_t     rx_len;        // Remaining length
+  uint32_t     rx_got;
+  uint8_t      rx_body[MQTT_RX_MAX];
+} mqtt_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+void Mqtt_Init(mqtt_t *m, const mqtt_ops_t *ops);
+
+/**
+ * @brief Sends CONNECT on a freshly opened transport. In-flight PUBLISHes
+ * are kept and go out again once the CONNACK is in.
+ * @retval 1 if written, 0 if the options do not fit or the write failed.
+ */
+uint8_t Mqtt_Connect(mqtt_t *m, const mqtt_connect_t *opt, uint32_t now);
+
+/**
+ * @brief Publishes. QoS 1 is stored in the in-flight window and written at
+ * once if connected, otherwise after the next CONNACK; QoS 0 needs a
+ * connection.
+ * @retval 1 if sent or stored, 0 if not connected (QoS 0), the window is
+ * full, the packet is larger than MQTT_PACKET_MAX or the write failed.
+ */
+uint8_t Mqtt_Publish(mqtt_t *m, const char *topic, const uint8_t *payload, size_t len,
+                     uint8_t qos, uint8_t retain, uint32_t now);
+
+/**
+ * @brief Feeds bytes from the transport; CONNACK, PUBACK and PINGRESP are
+ * handled from within the call.
+ */
+void Mqtt_Feed(mqtt_t *m, const uint8_t *data, size_t len, uint32_t now);
+
+/**
+ * @brief Keep-alive and reply timeouts; call at least every second.
+ * @retval mqtt_state_t, MQTT_DISCONNECTED once the connection is lost
+ * (close the transport and connect again).
+ */
+uint8_t Mqtt_Poll(mqtt_t *m, uint32_t now);
+
+/**
+ * @brief Ends the session: sends DISCONNECT if graceful and connected (the
+ * broker then drops the will). The in-flight window is kept.
+ */
+void Mqtt_Disconnect(mqtt_t *m, uint8_t graceful);
+
+/**
+ * @brief Encodes one PUBLISH.
+ * @retval Packet length, or 0 if it does not fit in cap.
+ */
+size_t Mqtt_EncodePublish(uint8_t *out, size_t cap, const char *topic, const uint8_t *payload, size_t len,
+                          uint8_t qos, uint8_t retain, uint8_t dup, uint16_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_CLIENT_H */
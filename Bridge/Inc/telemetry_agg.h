@@ -0,0 +1,82 @@
+/* Edge summaries of decoded telemetry: per-interval aggregates and delta-encoded bursts (ESP32 bridge). */
+#ifndef TELEMETRY_AGG_H
+#define TELEMETRY_AGG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Aggregates keep exact integer sums of the fixed-point values as received
+ * (hr_x10, spo2_x10, celsius_x100), so mean and standard deviation carry no
+ * rounding drift however many samples an interval holds. A summary is 10
+ * bytes per metric, in the input's own scale.
+ *
+ * Bursts store full-resolution samples as zigzag LEB128 varints of the
+ * difference to the previous sample, field by field; the first sample of a
+ * burst is relative to zero, so each burst decodes on its own. Slowly moving
+ * vital signs sampled every second take about 5 bytes per sample.
+ */
+#define TLM_AGG_N_MAX           (0xFFFFU)   // Samples past this are ignored
+#define TLM_BURST_FIELDS        (4U)        // ts_ms, hr_x10, spo2_x10, celsius_x100
+#define TLM_BURST_MAX           (180U)      // Encoded bytes per burst (240 in base64)
+#define TLM_BURST_SAMPLE_MAX    (TLM_BURST_FIELDS * 5U)
+
+typedef struct {
+  int32_t  min;
+  int32_t  max;
+  int64_t  sum;
+  uint64_t sumsq;
+  uint32_t n;
+} tlm_agg_t;
+
+typedef struct __attribute__((packed)) {
+  int16_t  min;
+  int16_t  max;
+  int16_t  mean;       // Rounded
+  uint16_t std;        // Population standard deviation, rounded down
+  uint16_t n;          // 0: no sample, the other fields are 0
+} tlm_agg_summary_t;
+
+typedef struct {
+  uint8_t  buf[TLM_BURST_MAX];
+  uint16_t len;
+  uint16_t count;
+  uint32_t prev[TLM_BURST_FIELDS];
+} tlm_burst_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+void TlmAgg_Reset(tlm_agg_t *agg);
+
+/**
+ * @brief Adds one sample; v must fit in an int16_t.
+ */
+void TlmAgg_Add(tlm_agg_t *agg, int32_t v);
+
+void TlmAgg_Summarize(const tlm_agg_t *agg, tlm_agg_summary_t *out);
+
+void TlmBurst_Init(tlm_burst_t *burst);
+
+/**
+ * @brief Appends one sample (wrapping differences, so ts_ms may roll over).
+ * @retval 1 if added, 0 if the burst is full (send it and start another).
+ */
+uint8_t TlmBurst_Add(tlm_burst_t *burst, const int32_t v[TLM_BURST_FIELDS]);
+
+/**
+ * @brief Decodes the next sample of an encoded burst; start with *pos = 0
+ * and v all zero. v is updated in place.
+ * @retval 1 if a sample was decoded, 0 at the end or if the data is malformed.
+ */
+uint8_t TlmBurst_Next(const uint8_t *buf, size_t len, size_t *pos, int32_t v[TLM_BURST_FIELDS]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_AGG_H */
@@ -0,0 +1,89 @@
+/* Receive side of the telemetry link: frames to authenticated batches to items, no heap (ESP32 bridge). */
+#ifndef TELEMETRY_RX_H
+#define TELEMETRY_RX_H
+
+#include "../../Common/Inc/telemetry_proto.h"   // Relative: the Arduino build has no include path
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * TlmRx_Feed() runs the whole chain on fixed buffers held in tlm_rx_t:
+ *   bytes -> tp_decoder_t -> open (GCM, supplied by the caller) into pt[]
+ *   -> session / counter check -> batch walk -> items
+ * Items are handed out in place, pointing into pt[]: records as validated
+ * tp_record_t overlays, other binary items (first byte >= 0x80) as is, and
+ * text split into trimmed, NUL-terminated lines in line[]. Nothing is copied
+ * beyond the decryption and the text line, and nothing is allocated.
+ *
+ * A gap in the frame counter is reported once through ops.nack as it is
+ * seen; frames of the gap that come in later (retransmitted) are accepted
+ * while they are less than TLM_RX_WINDOW frames behind the newest, once.
+ * Their records are handed out like the others, only late.
+ */
+#define TLM_RX_LINE_MAX         (255U)   // Longer lines are cut (and counted)
+#define TLM_RX_WINDOW           TP_LINK_NACK_WINDOW   // Frames, bits of tlm_rx_t.missing
+
+// Decrypts and authenticates len bytes of ct into pt. Returns 1 if authentic.
+typedef uint8_t (*tlm_rx_open_fn)(void *user, const uint8_t nonce[TP_NONCE_LEN],
+                                  const uint8_t *aad, size_t aad_len,
+                                  const uint8_t *ct, size_t len,
+                                  const uint8_t tag[TP_SEAL_TAG_LEN], uint8_t *pt);
+
+typedef struct {
+  tlm_rx_open_fn open;    // NULL: batches are sent in clear, without a tag
+  void (*record)(void *user, const tp_record_t *rec);
+  void (*binary)(void *user, const uint8_t *item, size_t len);   // RT_STATS, DLOG, ...
+  void (*line)(void *user, const char *line, size_t len);
+  // Frames first .. first + count - 1 of session are missing; NULL: no retransmission
+  void (*nack)(void *user, uint32_t session, uint32_t first, uint8_t count);
+  void *user;
+} tlm_rx_ops_t;
+
+typedef struct {
+  uint32_t session;       // Of the last authentic batch
+  uint32_t last_ctr;
+  uint32_t lost_frames;   // Gaps in the frame counter, as seen
+  uint32_t recovered;     // ... of which came in later; lost for good: the difference
+  uint32_t nacks;         // Gaps reported through ops.nack
+  uint32_t auth_failures; // Too short or tag mismatch: batch dropped whole
+  uint32_t replays;       // Authentic but not newer than the last batch
+  uint32_t batches;
+  uint32_t items;
+  uint32_t lost_records;  // Gaps in the record sequence
+  uint32_t bad_records;   // Record tag, but wrong version, type or length
+  uint32_t lines;
+  uint32_t long_lines;    // Cut at TLM_RX_LINE_MAX
+} tlm_rx_stats_t;
+
+typedef struct {
+  tp_decoder_t   dec;
+  tlm_rx_ops_t   ops;
+  tlm_rx_stats_t stats;
+  uint64_t missing;       // Bit k: frame last_ctr - k is still expected
+  uint8_t  pt[TP_BATCH_MAX];
+  char     line[TLM_RX_LINE_MAX + 1U];
+  uint16_t line_len;
+  uint8_t  line_cut;
+  uint8_t  last_seq;
+  uint8_t  seq_valid;
+  uint8_t  late;          // Set while the items of a retransmitted batch are handed out
+} tlm_rx_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+void TlmRx_Init(tlm_rx_t *rx, const tlm_rx_ops_t *ops);
+
+/**
+ * @brief Feeds received bytes; items are dispatched from within the call.
+ * @retval Batches accepted.
+ */
+uint32_t TlmRx_Feed(tlm_rx_t *rx, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_RX_H */
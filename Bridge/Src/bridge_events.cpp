@@ -0,0 +1,206 @@
+/* STM32 items on the ESP32 bridge, see Bridge/Inc/bridge_events.h. */
+
+#include "../Inc/bridge_events.h"  // Relative: the Arduino build has no Bridge/Inc include path
+#include <string.h>
+
+// Binary CPU load frame from either core (Common/Inc/runtime_stats.h), little-endian:
+// [tag][version][core][n][window_us(4)][idle_x100(2)][isr_x100(2)] then n x [name(4)][cpu_x100(2)]
+static const uint8_t RT_STATS_TAG        = 0xC5;
+static const uint8_t RT_STATS_VERSION    = 1;
+static const uint16_t RT_STATS_HEADER_LEN = 12;
+static const uint16_t RT_STATS_TASK_LEN   = 6;
+
+// Deferred log frame from the CM4 (CM4/Core/Inc/dlog.h): IDs and raw arguments only,
+// printed as hex for tools/dlog_decode.py, which holds the message strings
+static const uint8_t DLOG_TAG        = 0xC6;
+static const uint16_t DLOG_HEADER_LEN = 8;
+
+static uint32_t rdLe32(const uint8_t* p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t rdLe16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static void eventsPost(BridgeEvents& e, const NetMsg& msg)
+{
+  if (e.ops.post != NULL) e.ops.post(e.ops.user, msg);
+}
+
+static void burstFlush(BridgeEvents& e)
+{
+  if (e.burst.count == 0) return;
+  NetMsg msg = {};
+  msg.type = NET_BURST;
+  msg.burst.alertId = e.burstAlertId;
+  msg.burst.chunk = e.burstChunk++;
+  msg.burst.count = e.burst.count;
+  msg.burst.len = e.burst.len;
+  memcpy(msg.burst.data, e.burst.buf, e.burst.len);
+  eventsPost(e, msg);
+  TlmBurst_Init(&e.burst);
+}
+
+static void burstAdd(BridgeEvents& e, const BurstSample& s)
+{
+  if (!TlmBurst_Add(&e.burst, s.v)) {
+    burstFlush(e);
+    TlmBurst_Add(&e.burst, s.v);
+  }
+}
+
+static void burstStart(BridgeEvents& e, uint16_t alertId)
+{
+  if (e.burstActive) {
+    e.burstPost = -1;   // New alert before the tail of the last one was sent: keep going
+    return;
+  }
+  e.burstActive = true;
+  e.burstPost = -1;
+  e.burstAlertId = alertId;
+  e.burstChunk = 0;
+  TlmBurst_Init(&e.burst);
+  uint32_t n = (e.burstRingCount < BURST_PRE_SAMPLES) ? e.burstRingCount : BURST_PRE_SAMPLES;
+  for (uint32_t i = e.burstRingCount - n; i < e.burstRingCount; i++) burstAdd(e, e.burstRing[i % BURST_PRE_SAMPLES]);
+}
+
+// Every PPG record goes into the pre-trigger ring, and into the burst while one is open
+static void burstSample(BridgeEvents& e, const tp_ppg_t& p)
+{
+  BurstSample s = { { (int32_t)p.h.ts_ms, p.hr_x10, p.spo2_x10, e.lastTempX100 } };
+  e.burstRing[e.burstRingCount++ % BURST_PRE_SAMPLES] = s;
+  if (!e.burstActive) return;
+  burstAdd(e, s);
+  if (e.burstPost > 0 && --e.burstPost == 0) {
+    burstFlush(e);
+    e.burstActive = false;
+  }
+}
+
+static void processLoadFrame(const uint8_t* f, uint16_t len)
+{
+  uint8_t n = f[3];
+  if (f[1] != RT_STATS_VERSION || len < RT_STATS_HEADER_LEN + (uint16_t)n * RT_STATS_TASK_LEN) {
+    Serial.printf("STM32: bad load frame (v%u, %u bytes)\n", f[1], len);
+    return;
+  }
+  uint16_t idle = rdLe16(&f[8]);
+  uint16_t isr = rdLe16(&f[10]);
+  Serial.printf("LOAD M%u win=%lums idle=%u.%02u%% isr=%u.%02u%%", f[2], (unsigned long)(rdLe32(&f[4]) / 1000UL),
+                idle / 100, idle % 100, isr / 100, isr % 100);
+  for (uint8_t i = 0; i < n; i++) {
+    const uint8_t* t = &f[RT_STATS_HEADER_LEN + i * RT_STATS_TASK_LEN];
+    uint16_t cpu = rdLe16(&t[4]);
+    Serial.printf(" %.4s=%u.%02u%%", (const char*)t, cpu / 100, cpu % 100);
+  }
+  Serial.println();
+}
+
+static void processLogFrame(const uint8_t* f, uint16_t len)
+{
+  Serial.printf("DLOG M%u ", f[3]);
+  for (uint16_t i = 0; i < len; i++) Serial.printf("%02x", f[i]);
+  Serial.println();
+}
+
+void eventsBegin(BridgeEvents& e, const BridgeEventsOps& ops, bool live)
+{
+  memset(&e, 0, sizeof(e));
+  e.ops = ops;
+  e.live = live;
+  e.lastTempX100 = INT16_MIN;
+  e.burstPost = -1;
+}
+
+// Binary measurement record (TP_RECORD_TAG), validated in place by telemetry_rx.c
+void eventsRecord(void* user, const tp_record_t* r)
+{
+  BridgeEvents& e = *(BridgeEvents*)user;
+  const tp_record_t& rec = *r;
+  if (e.live) {
+    NetMsg live = {};
+    live.type = NET_RECORD;
+    memcpy(&live.record, r, TlmProto_RecordLen(rec.h.type));
+    eventsPost(e, live);
+  }
+  switch (rec.h.type) {
+    case TP_REC_PPG:
+      if (rec.ppg.flags & TP_PPG_HR_VALID) TlmAgg_Add(&e.aggHr, rec.ppg.hr_x10);
+      if (rec.ppg.flags & TP_PPG_FINGER) TlmAgg_Add(&e.aggSpo2, rec.ppg.spo2_x10);
+      burstSample(e, rec.ppg);
+      Serial.printf("▶ STM32 HR/SPO2: %u / %u (PI %u.%02u%%, %u peaks)\n", (rec.ppg.hr_x10 + 5) / 10,
+                    (rec.ppg.spo2_x10 + 5) / 10, rec.ppg.pi_x100 / 100, rec.ppg.pi_x100 % 100, rec.ppg.peaks);
+      break;
+    case TP_REC_TEMP:
+      if (rec.temp.source == TP_TEMP_LM35) {
+        e.lastTempX100 = rec.temp.celsius_x100;
+        TlmAgg_Add(&e.aggTemp, e.lastTempX100);
+        Serial.printf("▶ STM32 Temp: %.1f °C\n", e.lastTempX100 / 100.0f);
+      } else {
+        Serial.printf("ℹ️ STM32 Sensor Die Temp: %.2f °C\n", rec.temp.celsius_x100 / 100.0f);
+      }
+      break;
+    case TP_REC_EVENT:
+    {
+      NetMsg msg = {};
+      if (rec.event.event == 1) {          // AI_EVENT_ALERT_START
+        msg.type = NET_ALERT;
+        msg.alert.active = true;
+        msg.alert.score = rec.event.score_x1000 / 1000.0f;
+        Serial.printf("🚨 Anomaly alert #%u (score %.2f)\n", rec.event.alert_id, msg.alert.score);
+        burstStart(e, rec.event.alert_id);
+      } else if (rec.event.event == 2) {   // AI_EVENT_ALERT_END
+        msg.type = NET_ALERT;
+        msg.alert.active = false;
+        msg.alert.score = rec.event.peak_x1000 / 1000.0f;
+        Serial.printf("✅ Anomaly alert #%u over (peak %.2f)\n", rec.event.alert_id, msg.alert.score);
+        if (e.burstActive) e.burstPost = BURST_POST_SAMPLES;
+      } else if (rec.event.event == 3) {   // AI_EVENT_SUMMARY
+        msg.type = NET_SUMMARY;
+        msg.summary.mean = rec.event.score_x1000 / 1000.0f;
+        msg.summary.max = rec.event.peak_x1000 / 1000.0f;
+      } else {
+        break;
+      }
+      eventsPost(e, msg);
+      break;
+    }
+    case TP_REC_CONFIG:
+    {
+      // The settings in force after command cmd_id (0: boot), applied or not
+      const vest_config_t cfg = { rec.config.rate_hz, rec.config.pw_us, rec.config.led_ir, rec.config.led_red,
+                                  rec.config.dsp, rec.config.ai, rec.config.report_ms };
+      char text[VEST_CMD_LINE_MAX];
+      VestCfg_Format(&cfg, text, sizeof(text));
+      Serial.printf("⚙️ STM32 config #%u: %s, %s\n", rec.config.cmd_id,
+                    VestCfg_StatusName(rec.config.status), text);
+      break;
+    }
+  }
+}
+
+void eventsBinary(void* user, const uint8_t* item, size_t len)
+{
+  (void)user;
+  if (item[0] == RT_STATS_TAG && len >= RT_STATS_HEADER_LEN) {
+    processLoadFrame(item, (uint16_t)len);
+  } else if (item[0] == DLOG_TAG && len >= DLOG_HEADER_LEN) {
+    processLogFrame(item, (uint16_t)len);
+  } else {
+    Serial.printf("STM32: unknown item 0x%02x (%u bytes)\n", item[0], (unsigned)len);
+  }
+}
+
+void eventsLine(void* user, const char* line, size_t len)
+{
+  BridgeEvents& e = *(BridgeEvents*)user;
+  // Reports (HEALTH, POWER, TXQ) stay text: just log
+  Serial.printf("STM32: %s\n", line);
+  if (len >= 4 && memcmp(line, "TXQ:", 4) == 0 && e.ops.stats != NULL) e.ops.stats(e.ops.user);
+}
+
+void eventsReport(BridgeEvents& e, JournalRecord& r)
+{
+  TlmAgg_Summarize(&e.aggHr, &r.hr);
+  TlmAgg_Summarize(&e.aggSpo2, &r.spo2);
+  TlmAgg_Summarize(&e.aggTemp, &r.temp);
+  TlmAgg_Reset(&e.aggHr);
+  TlmAgg_Reset(&e.aggSpo2);
+  TlmAgg_Reset(&e.aggTemp);
+}
@@ -0,0 +1,155 @@
+/* UART link to the STM32 (ESP32 bridge), see Bridge/Inc/bridge_link.h. */
+
+#include "../Inc/bridge_link.h"  // Relative: the Arduino build has no Bridge/Inc include path
+#include <string.h>
+
+static uint8_t linkOpen(void* user, const uint8_t nonce[TP_NONCE_LEN], const uint8_t* aad, size_t aadLen,
+                        const uint8_t* ct, size_t len, const uint8_t tag[TP_SEAL_TAG_LEN], uint8_t* pt)
+{
+  BridgeLink* l = (BridgeLink*)user;
+  return mbedtls_gcm_auth_decrypt(&l->gcm, len, nonce, TP_NONCE_LEN, aad, aadLen,
+                                  tag, TP_SEAL_TAG_LEN, ct, pt) == 0;
+}
+
+static void linkRecord(void* user, const tp_record_t* r)
+{
+  BridgeLink* l = (BridgeLink*)user;
+  if (l->app.record != NULL) l->app.record(l->app.user, r);
+}
+
+static void linkBinary(void* user, const uint8_t* item, size_t len)
+{
+  BridgeLink* l = (BridgeLink*)user;
+  if (item[0] == TP_LINK_TAG) {
+    const tp_link_t* msg = TlmProto_LinkView(item, len);
+    if (msg != NULL && msg->op == TP_LINK_ACCEPT && msg->value != l->baud) {
+      l->pendingBaud = msg->value;
+      l->pendingFlags = msg->flags;
+    } else if (msg != NULL && msg->op == TP_LINK_RAW && !l->rx.late) {
+      // A retransmitted announcement is stale: its bytes went by long ago
+      l->rawLeft = msg->value;
+      l->rawUntil = millis() + (uint32_t)((uint64_t)msg->value * 20000U / l->baud) + LINK_RAW_MARGIN_MS;
+      Serial.printf("ℹ️ Trace brute du STM32 : %lu octets non décodés\n", (unsigned long)msg->value);
+    }
+  } else if (l->app.binary != NULL) {
+    l->app.binary(l->app.user, item, len);
+  }
+}
+
+static void linkLine(void* user, const char* line, size_t len)
+{
+  BridgeLink* l = (BridgeLink*)user;
+  if (l->app.line != NULL) l->app.line(l->app.user, line, len);
+}
+
+// Link message to the STM32: a bare frame, after delimiters that may be lost waking it from STOP
+static void linkSend(BridgeLink& l, uint8_t op, uint8_t flags, uint8_t count, uint32_t session, uint32_t value)
+{
+  const tp_link_t msg = { TP_LINK_TAG, op, flags, count, session, value };
+  uint8_t frame[TP_LINK_PREAMBLE + TP_FRAME_MAX(sizeof(tp_link_t))];
+  memset(frame, TP_FRAME_DELIM, TP_LINK_PREAMBLE);
+  size_t n = TlmProto_FrameEncode((const uint8_t*)&msg, sizeof(msg), &frame[TP_LINK_PREAMBLE],
+                                  sizeof(frame) - TP_LINK_PREAMBLE);
+  l.uart->write(frame, TP_LINK_PREAMBLE + n);
+}
+
+void linkCommand(BridgeLink& l, const char* line)
+{
+  // The delimiters also clear whatever partial line the STM32 holds
+  uint8_t preamble[TP_LINK_PREAMBLE];
+  memset(preamble, TP_FRAME_DELIM, sizeof(preamble));
+  l.uart->write(preamble, sizeof(preamble));
+  l.uart->write((const uint8_t*)line, strlen(line));
+  l.uart->write((const uint8_t*)"\n", 1);
+}
+
+// Gap in the STM32 frame counter (Bridge/Src/telemetry_rx.c): ask for those frames again
+static void linkNack(void* user, uint32_t session, uint32_t first, uint8_t count)
+{
+  linkSend(*(BridgeLink*)user, TP_LINK_NACK, 0, count, session, first);
+}
+
+static void linkSetRate(BridgeLink& l, uint32_t baud, uint8_t flags)
+{
+  l.uart->flush();
+  l.uart->setHwFlowCtrlMode((flags & TP_LINK_RTSCTS) ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE,
+                            LINK_RTS_THRESHOLD);
+  l.uart->updateBaudRate(baud);
+  l.baud = baud;
+  l.heardAt = millis();
+  l.switches++;
+  Serial.printf("✅ UART1 à %lu bauds%s\n", (unsigned long)baud, (flags & TP_LINK_RTSCTS) ? " (RTS/CTS)" : "");
+}
+
+void linkBegin(BridgeLink& l, HardwareSerial& uart, const uint8_t key[16], uint32_t fastBaud, const tlm_rx_ops_t& app)
+{
+  l.uart = &uart;
+  l.app = app;
+  l.fastBaud = fastBaud;
+  l.baud = TP_LINK_BAUD_BASE;
+  l.pendingBaud = 0;
+  l.pendingFlags = 0;
+  l.helloAt = 0;
+  l.heardAt = 0;
+  l.switches = 0;
+  l.fallbacks = 0;
+  l.bytes = 0;
+  l.rawLeft = 0;
+  l.rawUntil = 0;
+  l.rawBytes = 0;
+  mbedtls_gcm_init(&l.gcm);
+  mbedtls_gcm_setkey(&l.gcm, MBEDTLS_CIPHER_ID_AES, key, 128);
+  const tlm_rx_ops_t ops = { linkOpen, linkRecord, linkBinary, linkLine, linkNack, &l };
+  TlmRx_Init(&l.rx, &ops);
+}
+
+uint32_t linkPump(BridgeLink& l)
+{
+  uint8_t chunk[64];
+  uint32_t batches = 0;
+  int avail;
+  while ((avail = l.uart->available()) > 0) {
+    size_t n = l.uart->read(chunk, (size_t)avail < sizeof(chunk) ? (size_t)avail : sizeof(chunk));
+    if (n == 0) break;
+    l.bytes += n;
+    // Frame by frame: a RAW item takes effect right after the delimiter of its frame
+    size_t pos = 0;
+    while (pos < n) {
+      size_t k;
+      if (l.rawLeft > 0) {
+        k = (l.rawLeft < n - pos) ? l.rawLeft : n - pos;
+        l.rawLeft -= k;
+        l.rawBytes += k;
+      } else {
+        const uint8_t* end = (const uint8_t*)memchr(&chunk[pos], TP_FRAME_DELIM, n - pos);
+        k = (end != NULL) ? (size_t)(end - &chunk[pos]) + 1U : n - pos;
+        batches += TlmRx_Feed(&l.rx, &chunk[pos], k);
+      }
+      pos += k;
+    }
+  }
+  return batches;
+}
+
+void linkPoll(BridgeLink& l, uint32_t now, bool heard)
+{
+  if (heard) l.heardAt = now;
+  if (l.rawLeft > 0 && (int32_t)(now - l.rawUntil) >= 0) {
+    // Cut short on the STM32 side (tracer dump timed out): decode again
+    Serial.printf("⚠️ Trace brute du STM32 incomplète : %lu octets manquants\n", (unsigned long)l.rawLeft);
+    l.rawLeft = 0;
+  }
+  if (l.pendingBaud != 0) {
+    linkSetRate(l, l.pendingBaud, l.pendingFlags);
+    l.pendingBaud = 0;
+  } else if (l.baud != TP_LINK_BAUD_BASE && now - l.heardAt >= LINK_SILENCE_MS) {
+    // STM32 reset (it starts at 115200) or line trouble: negotiate again
+    l.fallbacks++;
+    linkSetRate(l, TP_LINK_BAUD_BASE, 0);
+    Serial.println("⚠️ Liaison STM32 muette : retour à 115200 bauds");
+  }
+  if (now - l.helloAt >= LINK_HELLO_MS) {
+    l.helloAt = now;
+    linkSend(l, TP_LINK_HELLO, TP_LINK_RTSCTS, 0, 0, l.fastBaud);
+  }
+}
@@ -0,0 +1,203 @@
+/* HTTPS uplink of the ESP32 bridge, see Bridge/Inc/bridge_uplink.h. */
+
+#include "../Inc/bridge_uplink.h"  // Relative: the Arduino build has no Bridge/Inc include path
+#include "mbedtls/base64.h"
+#include <string.h>
+#include <time.h>
+
+static String firestoreDocName(const BridgeUplink& u, const String& path) {
+  return String("projects/") + u.cfg.projectId + "/databases/(default)/documents/" + path;
+}
+
+static String firestoreUserDoc(const BridgeUplink& u) {
+  return firestoreDocName(u, String(u.cfg.collection) + "/" + u.cfg.docId);
+}
+
+static String firestoreFields(const FsField* fields, size_t n) {
+  String s = "{";
+  for (size_t i = 0; i < n; i++) {
+    if (i > 0) s += ",";
+    s += String("\"") + fields[i].name + "\":{\"doubleValue\":" + String(fields[i].value, 2) + "}";
+  }
+  return s + "}";
+}
+
+// Sends writes (comma-separated Firestore Write objects) as one atomic commit
+static bool firestoreCommit(BridgeUplink& u, const String& writes, const char* what) {
+  String url = String(u.cfg.firestoreUrl) + "/v1/projects/" + u.cfg.projectId
+             + "/databases/(default)/documents:commit?key=" + u.cfg.apiKey;
+  String body = String("{\"writes\":[") + writes + "]}";
+  uint32_t t0 = millis();
+  int code = 0;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (!u.client.connected()) u.handshakes++;
+    u.http.begin(u.client, url);
+    u.http.addHeader("Content-Type", "application/json");
+    code = u.http.POST(body);
+    u.http.end();                  // Keeps the connection when the server allows it
+    if (code > 0) break;
+    u.client.stop();               // Stale or broken connection: reconnect once
+  }
+  u.lastMs = millis() - t0;
+
+  if (code == HTTP_CODE_OK) {
+    u.commits++;
+    Serial.printf("✔️ Firestore commit: %s in %lu ms\n", what, (unsigned long)u.lastMs);
+    return true;
+  }
+  u.failures++;
+  Serial.printf("❌ Firestore HTTP %d: %s\n", code, HTTPClient::errorToString(code).c_str());
+  return false;
+}
+
+// Write of fields into the user document, other fields untouched
+static String firestoreUserWrite(const BridgeUplink& u, const FsField* fields, size_t n) {
+  String mask;
+  for (size_t i = 0; i < n; i++) {
+    mask += String((i > 0) ? ",\"" : "\"") + fields[i].name + "\"";
+  }
+  return String("{\"update\":{\"name\":\"") + firestoreUserDoc(u)
+       + "\",\"fields\":" + firestoreFields(fields, n) + "},\"updateMask\":{\"fieldPaths\":[" + mask + "]}}";
+}
+
+// Unix time of a journaled report: its own stamp, or derived from the uptime
+// once the clock is set if it was taken during this boot. 0 if unknown.
+static uint32_t reportEpoch(const BridgeUplink& u, const JournalRecord& r) {
+  if (r.epoch != 0) return r.epoch;
+  time_t now = time(nullptr);
+  if (r.boot != u.boot || now < 1600000000) return 0;
+  return (uint32_t)now - (millis() - r.uptimeMs) / 1000U;
+}
+
+// Interval means as the user-facing fields: hr, spo2 (rounded as before) and temp if any
+static size_t reportFields(const JournalRecord& r, FsField* f) {
+  size_t n = 0;
+  f[n++] = { "hr", (double)((r.hr.mean + 5) / 10) };
+  f[n++] = { "spo2", (double)((r.spo2.mean + 5) / 10) };
+  if (r.temp.n != 0) f[n++] = { "temp", r.temp.mean / 100.0 };
+  return n;
+}
+
+// The three interval summaries (min, max, mean, std, n; see tlm_agg_summary_t) as one bytesValue
+static String reportAggField(const JournalRecord& r) {
+  uint8_t raw[3 * sizeof(tlm_agg_summary_t)];
+  unsigned char b64[48];
+  size_t olen = 0;
+  memcpy(&raw[0], &r.hr, sizeof(r.hr));
+  memcpy(&raw[sizeof(r.hr)], &r.spo2, sizeof(r.spo2));
+  memcpy(&raw[2 * sizeof(r.hr)], &r.temp, sizeof(r.temp));
+  mbedtls_base64_encode(b64, sizeof(b64), &olen, raw, sizeof(raw));
+  return String(",\"agg\":{\"bytesValue\":\"") + (const char*)b64 + "\"}";
+}
+
+void uplinkBegin(BridgeUplink& u, const UplinkConfig& cfg, uint32_t boot, uint32_t timeoutMs)
+{
+  u.cfg = cfg;
+  u.boot = boot;
+  u.commits = 0;
+  u.failures = 0;
+  u.handshakes = 0;
+  u.lastMs = 0;
+  // Like HTTPClient's default for https, the server certificate is not pinned
+  u.client.setInsecure();
+  u.http.setReuse(true);
+  u.http.setTimeout(timeoutMs);
+}
+
+bool commitToFirestore(BridgeUplink& u, const FsField* fields, size_t n) {
+  return firestoreCommit(u, firestoreUserWrite(u, fields, n), "fields");
+}
+
+// Rewriting a history document that an earlier, unacknowledged commit already stored is harmless
+bool commitReports(BridgeUplink& u, const JournalRecord* recs, size_t n, bool newest) {
+  String user = firestoreUserDoc(u);
+  String writes;
+  writes.reserve(n * 480 + 256);
+  for (size_t i = 0; i < n; i++) {
+    const JournalRecord& r = recs[i];
+    FsField f[3];
+    size_t nf = reportFields(r, f);
+    String fields = firestoreFields(f, nf);
+    char id[24];
+    snprintf(id, sizeof(id), "%08lx-%lu", (unsigned long)r.boot, (unsigned long)r.seq);
+    fields.remove(fields.length() - 1);   // Reopen the map for the extra fields
+    fields += String(",\"uptimeMs\":{\"integerValue\":\"") + r.uptimeMs + "\"}";
+    fields += reportAggField(r);
+    uint32_t epoch = reportEpoch(u, r);
+    if (epoch != 0) {
+      time_t t = (time_t)epoch;
+      struct tm tm;
+      char iso[24];
+      gmtime_r(&t, &tm);
+      strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%SZ", &tm);
+      fields += String(",\"ts\":{\"timestampValue\":\"") + iso + "\"}";
+    }
+    fields += "}";
+    if (i > 0) writes += ",";
+    writes += String("{\"update\":{\"name\":\"") + user + "/history/" + id + "\",\"fields\":" + fields + "},"
+            + "\"updateTransforms\":[{\"fieldPath\":\"receivedAt\",\"setToServerValue\":\"REQUEST_TIME\"}]}";
+    if (newest && i == n - 1) writes += String(",") + firestoreUserWrite(u, f, nf);
+  }
+  char what[32];
+  snprintf(what, sizeof(what), "%u report(s)", (unsigned)n);
+  return firestoreCommit(u, writes, what);
+}
+
+// The samples stay delta-encoded (Bridge/Inc/telemetry_agg.h), base64 in a bytesValue
+bool commitBurst(BridgeUplink& u, const NetBurst& b) {
+  unsigned char b64[4 * ((TLM_BURST_MAX + 2) / 3) + 1];
+  size_t olen = 0;
+  mbedtls_base64_encode(b64, sizeof(b64), &olen, b.data, b.len);
+  char id[32];
+  snprintf(id, sizeof(id), "%08lx-%u-%u", (unsigned long)u.boot, b.alertId, b.chunk);
+  String write = String("{\"update\":{\"name\":\"") + firestoreUserDoc(u)
+               + "/bursts/" + id + "\",\"fields\":{"
+               + "\"alertId\":{\"integerValue\":\"" + b.alertId + "\"},"
+               + "\"chunk\":{\"integerValue\":\"" + b.chunk + "\"},"
+               + "\"n\":{\"integerValue\":\"" + b.count + "\"},"
+               + "\"samples\":{\"bytesValue\":\"" + (const char*)b64 + "\"}}},"
+               + "\"updateTransforms\":[{\"fieldPath\":\"receivedAt\",\"setToServerValue\":\"REQUEST_TIME\"}]}";
+  char what[32];
+  snprintf(what, sizeof(what), "burst %u/%u", b.alertId, b.chunk);
+  return firestoreCommit(u, write, what);
+}
+
+bool sendTelemetryJSON(BridgeUplink& u, uint16_t hr, uint16_t spo2, float temp, unsigned long ts) {
+  if (strlen(u.cfg.ingestionUrl) == 0) return false;
+
+  HTTPClient http;
+  http.begin(u.cfg.ingestionUrl);
+  http.addHeader("Content-Type", "application/json");
+  http.addHeader("X-Vest-Id", u.cfg.docId);
+
+  String body = String("{")
+    + "\"hr\":" + String(hr) + ","
+    + "\"spo2\":" + String(spo2) + ","
+    + "\"temp\":" + String(temp,1) + ","
+    + "\"timestamp\":" + String(ts)
+    + "}";
+
+  int code = http.POST(body);
+  if (code == HTTP_CODE_OK || code == HTTP_CODE_ACCEPTED) {
+    Serial.println("✔️ Telemetry sent to ingestion endpoint");
+    http.end();
+    return true;
+  } else {
+    Serial.printf("❌ Ingestion HTTP %d: %s\n", code, http.errorToString(code).c_str());
+    http.end();
+    return false;
+  }
+}
+
+bool postReports(BridgeUplink& u, const JournalRecord* recs, size_t n, bool newest) {
+  if (strlen(u.cfg.ingestionUrl) == 0) return commitReports(u, recs, n, newest);
+  for (size_t i = 0; i < n; i++) {
+    const JournalRecord& r = recs[i];
+    uint32_t epoch = reportEpoch(u, r);
+    float temp = (r.temp.n != 0) ? r.temp.mean / 100.0f : 0.0f;
+    if (!sendTelemetryJSON(u, (r.hr.mean + 5) / 10, (r.spo2.mean + 5) / 10, temp, epoch ? epoch : r.uptimeMs / 1000UL)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,337 @@
+/* MQTT 3.1.1 publisher with QoS-1 delivery over any byte stream, no heap (ESP32 bridge). */
+
+#include "../Inc/mqtt_client.h"  // Relative: the Arduino build has no Bridge/Inc include path
+#include <string.h>
+
+// Control packet types (fixed header, high nibble)
+#define MQ_CONNECT      (1U)
+#define MQ_CONNACK      (2U)
+#define MQ_PUBLISH      (3U)
+#define MQ_PUBACK       (4U)
+#define MQ_PINGREQ      (12U)
+#define MQ_PINGRESP     (13U)
+#define MQ_DISCONNECT   (14U)
+
+#define MQ_DUP          (0x08U)
+#define MQ_LEN_MAX      (4U)     // Remaining length bytes
+
+// Remaining length, 7 bits per byte, least significant first
+static size_t mq_put_len(uint8_t *out, uint32_t n)
+{
+  size_t i = 0;
+  do {
+    uint8_t b = (uint8_t)(n & 0x7FU);
+    n >>= 7;
+    out[i++] = (uint8_t)(b | ((n != 0U) ? 0x80U : 0U));
+  } while (n != 0U);
+  return i;
+}
+
+static size_t mq_put_str(uint8_t *out, const void *s, size_t len)
+{
+  out[0] = (uint8_t)(len >> 8);
+  out[1] = (uint8_t)len;
+  memcpy(&out[2], s, len);
+  return 2U + len;
+}
+
+static uint8_t mq_write(mqtt_t *m, const uint8_t *data, size_t len, uint32_t now)
+{
+  if (!m->ops.write(m->ops.user, data, len)) {
+    m->state = MQTT_DISCONNECTED;
+    return 0;
+  }
+  m->stats.bytes_out += (uint32_t)len;
+  m->last_tx_ms = now;
+  return 1;
+}
+
+static void mq_rx_reset(mqtt_t *m)
+{
+  m->rx_hdr = 0;
+  m->rx_len_done = 0;
+  m->rx_len_shift = 0;
+  m->rx_len = 0;
+  m->rx_got = 0;
+}
+
+static void mq_send_slot(mqtt_t *m, mqtt_slot_t *s, uint32_t now)
+{
+  if (s->sent) {
+    s->buf[0] |= MQ_DUP;
+    m->stats.resent++;
+  } else {
+    m->stats.published++;
+  }
+  s->sent = 1;
+  s->sent_ms = now;
+  (void)mq_write(m, s->buf, s->len, now);
+}
+
+// Whole window, oldest first, as long as the transport takes it
+static void mq_resend(mqtt_t *m, uint32_t now)
+{
+  uint32_t last = 0;
+  for (uint32_t n = 0; n < m->inflight && m->state == MQTT_CONNECTED; n++) {
+    mqtt_slot_t *next = NULL;
+    for (uint32_t i = 0; i < MQTT_INFLIGHT; i++) {
+      mqtt_slot_t *s = &m->slots[i];
+      if (s->id != 0U && (int32_t)(s->order - last) > 0 && (next == NULL || (int32_t)(s->order - next->order) < 0)) {
+        next = s;
+      }
+    }
+    if (next == NULL) break;
+    last = next->order;
+    mq_send_slot(m, next, now);
+  }
+}
+
+static void mq_dispatch(mqtt_t *m, uint32_t now)
+{
+  uint8_t type = (uint8_t)(m->rx_hdr >> 4);
+
+  switch (type) {
+    case MQ_CONNACK:
+      if (m->rx_len != 2U || m->state != MQTT_CONNECTING) {
+        m->stats.bad_packets++;
+        break;
+      }
+      m->return_code = m->rx_body[1];
+      if (m->return_code != 0U) {
+        m->stats.refused++;
+        m->state = MQTT_DISCONNECTED;
+        break;
+      }
+      m->stats.connects++;
+      m->state = MQTT_CONNECTED;
+      m->ping_pending = 0;
+      mq_resend(m, now);
+      break;
+    case MQ_PUBACK:
+    {
+      uint16_t id = (uint16_t)((m->rx_body[0] << 8) | m->rx_body[1]);
+      mqtt_slot_t *s = NULL;
+      if (m->rx_len == 2U && id != 0U) {
+        for (uint32_t i = 0; i < MQTT_INFLIGHT; i++) {
+          if (m->slots[i].id == id && m->slots[i].sent) s = &m->slots[i];
+        }
+      }
+      if (s == NULL) {
+        m->stats.bad_packets++;
+        break;
+      }
+      m->stats.acked++;
+      m->stats.ack_ms_last = now - s->sent_ms;
+      if (m->stats.ack_ms_last > m->stats.ack_ms_max) m->stats.ack_ms_max = m->stats.ack_ms_last;
+      s->id = 0;
+      m->inflight--;
+      break;
+    }
+    case MQ_PINGRESP:
+      m->ping_pending = 0;
+      break;
+    case MQ_PUBLISH:
+      break;   // Not subscribed to anything: ignored
+    default:
+      m->stats.bad_packets++;
+      break;
+  }
+}
+
+void Mqtt_Init(mqtt_t *m, const mqtt_ops_t *ops)
+{
+  memset(m, 0, sizeof(*m));
+  m->ops = *ops;
+  m->next_id = 1;
+}
+
+uint8_t Mqtt_Connect(mqtt_t *m, const mqtt_connect_t *opt, uint32_t now)
+{
+  uint8_t pkt[MQTT_PACKET_MAX];
+  size_t cid = strlen(opt->client_id);
+  size_t wt = (opt->will_topic != NULL) ? strlen(opt->will_topic) : 0U;
+  size_t user = (opt->username != NULL) ? strlen(opt->username) : 0U;
+  size_t pass = (opt->username != NULL && opt->password != NULL) ? strlen(opt->password) : 0U;
+  size_t rem = 10U + 2U + cid;
+  uint8_t flags = opt->clean ? 0x02U : 0U;
+
+  if (opt->will_topic != NULL) {
+    rem += 2U + wt + 2U + opt->will_len;
+    flags |= 0x04U | 0x08U | (opt->will_retain ? 0x20U : 0U);   // Will at QoS 1
+  }
+  if (opt->username != NULL) {
+    rem += 2U + user;
+    flags |= 0x80U;
+    if (opt->password != NULL) {
+      rem += 2U + pass;
+      flags |= 0x40U;
+    }
+  }
+  if (1U + MQ_LEN_MAX + rem > sizeof(pkt)) return 0;
+
+  size_t n = 0;
+  pkt[n++] = (uint8_t)(MQ_CONNECT << 4);
+  n += mq_put_len(&pkt[n], (uint32_t)rem);
+  n += mq_put_str(&pkt[n], "MQTT", 4U);
+  pkt[n++] = 4U;   // Protocol level 3.1.1
+  pkt[n++] = flags;
+  pkt[n++] = (uint8_t)(opt->keepalive_s >> 8);
+  pkt[n++] = (uint8_t)opt->keepalive_s;
+  n += mq_put_str(&pkt[n], opt->client_id, cid);
+  if (opt->will_topic != NULL) {
+    n += mq_put_str(&pkt[n], opt->will_topic, wt);
+    n += mq_put_str(&pkt[n], opt->will_msg, opt->will_len);
+  }
+  if (opt->username != NULL) {
+    n += mq_put_str(&pkt[n], opt->username, user);
+    if (opt->password != NULL) n += mq_put_str(&pkt[n], opt->password, pass);
+  }
+
+  mq_rx_reset(m);
+  m->keepalive_s = opt->keepalive_s;
+  m->ping_pending = 0;
+  m->state = MQTT_CONNECTING;
+  m->wait_ms = now;
+  return mq_write(m, pkt, n, now);
+}
+
+size_t Mqtt_EncodePublish(uint8_t *out, size_t cap, const char *topic, const uint8_t *payload, size_t len,
+                          uint8_t qos, uint8_t retain, uint8_t dup, uint16_t id)
+{
+  size_t tl = strlen(topic);
+  size_t rem = 2U + tl + ((qos != 0U) ? 2U : 0U) + len;
+  uint8_t hdr[1U + MQ_LEN_MAX];
+  size_t hl;
+
+  if (qos > 1U || rem > 0x0FFFFFFFU) return 0;
+  hdr[0] = (uint8_t)((MQ_PUBLISH << 4) | (dup ? MQ_DUP : 0U) | (qos << 1) | (retain ? 1U : 0U));
+  hl = 1U + mq_put_len(&hdr[1], (uint32_t)rem);
+  if (hl + rem > cap) return 0;
+
+  size_t n = hl;
+  memcpy(out, hdr, hl);
+  n += mq_put_str(&out[n], topic, tl);
+  if (qos != 0U) {
+    out[n++] = (uint8_t)(id >> 8);
+    out[n++] = (uint8_t)id;
+  }
+  if (len != 0U) memcpy(&out[n], payload, len);
+  return n + len;
+}
+
+uint8_t Mqtt_Publish(mqtt_t *m, const char *topic, const uint8_t *payload, size_t len,
+                     uint8_t qos, uint8_t retain, uint32_t now)
+{
+  if (qos == 0U) {
+    uint8_t pkt[MQTT_PACKET_MAX];
+    if (m->state != MQTT_CONNECTED) return 0;
+    size_t n = Mqtt_EncodePublish(pkt, sizeof(pkt), topic, payload, len, 0U, retain, 0U, 0U);
+    if (n == 0U || !mq_write(m, pkt, n, now)) return 0;
+    m->stats.published++;
+    return 1;
+  }
+  if (qos != 1U) return 0;
+
+  mqtt_slot_t *s = NULL;
+  for (uint32_t i = 0; i < MQTT_INFLIGHT && s == NULL; i++) {
+    if (m->slots[i].id == 0U) s = &m->slots[i];
+  }
+  if (s == NULL) {
+    m->stats.window_full++;
+    return 0;
+  }
+
+  // Next identifier not in flight, never 0
+  uint16_t id;
+  uint8_t used;
+  do {
+    id = m->next_id++;
+    if (m->next_id == 0U) m->next_id = 1;
+    used = 0;
+    for (uint32_t i = 0; i < MQTT_INFLIGHT; i++) {
+      if (m->slots[i].id == id) used = 1;
+    }
+  } while (used);
+
+  size_t n = Mqtt_EncodePublish(s->buf, sizeof(s->buf), topic, payload, len, 1U, retain, 0U, id);
+  if (n == 0U) return 0;
+  s->id = id;
+  s->len = (uint16_t)n;
+  s->order = ++m->order;
+  s->sent = 0;
+  m->inflight++;
+  if (m->state == MQTT_CONNECTED) mq_send_slot(m, s, now);
+  return 1;   // Kept even if the write failed: it goes out after the reconnect
+}
+
+void Mqtt_Feed(mqtt_t *m, const uint8_t *data, size_t len, uint32_t now)
+{
+  for (size_t i = 0; i < len; i++) {
+    uint8_t b = data[i];
+
+    if (m->rx_hdr == 0U) {
+      if (b == 0U) {
+        m->stats.bad_packets++;   // Reserved type
+        continue;
+      }
+      mq_rx_reset(m);
+      m->rx_hdr = b;
+      continue;
+    }
+    if (!m->rx_len_done) {
+      m->rx_len |= (uint32_t)(b & 0x7FU) << m->rx_len_shift;
+      m->rx_len_shift = (uint8_t)(m->rx_len_shift + 7U);
+      if ((b & 0x80U) == 0U) {
+        m->rx_len_done = 1;
+        if (m->rx_len == 0U) {
+          mq_dispatch(m, now);
+          m->rx_hdr = 0;
+        }
+      } else if (m->rx_len_shift >= 7U * MQ_LEN_MAX) {
+        m->stats.bad_packets++;
+        m->rx_hdr = 0;
+      }
+      continue;
+    }
+    if (m->rx_got < MQTT_RX_MAX) m->rx_body[m->rx_got] = b;
+    if (++m->rx_got == m->rx_len) {
+      mq_dispatch(m, now);
+      m->rx_hdr = 0;
+    }
+  }
+}
+
+uint8_t Mqtt_Poll(mqtt_t *m, uint32_t now)
+{
+  if (m->state == MQTT_CONNECTING) {
+    if (now - m->wait_ms > MQTT_REPLY_TIMEOUT_MS) {
+      m->stats.timeouts++;
+      m->state = MQTT_DISCONNECTED;
+    }
+  } else if (m->state == MQTT_CONNECTED) {
+    if (m->ping_pending) {
+      if (now - m->wait_ms > MQTT_REPLY_TIMEOUT_MS) {
+        m->stats.timeouts++;
+        m->state = MQTT_DISCONNECTED;
+      }
+    } else if (m->keepalive_s != 0U && now - m->last_tx_ms >= (uint32_t)m->keepalive_s * 1000U) {
+      const uint8_t ping[2] = { (uint8_t)(MQ_PINGREQ << 4), 0U };
+      m->ping_pending = 1;
+      m->wait_ms = now;
+      m->stats.pings++;
+      (void)mq_write(m, ping, sizeof(ping), now);
+    }
+  }
+  return m->state;
+}
+
+void Mqtt_Disconnect(mqtt_t *m, uint8_t graceful)
+{
+  if (graceful && m->state == MQTT_CONNECTED) {
+    const uint8_t bye[2] = { (uint8_t)(MQ_DISCONNECT << 4), 0U };
+    (void)mq_write(m, bye, sizeof(bye), m->last_tx_ms);
+  }
+  m->state = MQTT_DISCONNECTED;
+  m->ping_pending = 0;
+  mq_rx_reset(m);
+}
@@ -0,0 +1,105 @@
+/* Edge summaries of decoded telemetry: per-interval aggregates and delta-encoded bursts (ESP32 bridge). */
+
+#include "../Inc/telemetry_agg.h"  // Relative: the Arduino build has no Bridge/Inc include path
+#include <string.h>
+
+// floor(sqrt(v)), bit by bit
+static uint64_t agg_isqrt(uint64_t v)
+{
+  uint64_t r = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > v) bit >>= 2;
+  while (bit != 0U) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return r;
+}
+
+void TlmAgg_Reset(tlm_agg_t *agg)
+{
+  memset(agg, 0, sizeof(*agg));
+}
+
+void TlmAgg_Add(tlm_agg_t *agg, int32_t v)
+{
+  if (agg->n >= TLM_AGG_N_MAX) return;
+  if (agg->n == 0U || v < agg->min) agg->min = v;
+  if (agg->n == 0U || v > agg->max) agg->max = v;
+  agg->sum += v;
+  agg->sumsq += (uint64_t)((int64_t)v * v);
+  agg->n++;
+}
+
+void TlmAgg_Summarize(const tlm_agg_t *agg, tlm_agg_summary_t *out)
+{
+  memset(out, 0, sizeof(*out));
+  if (agg->n == 0U) return;
+
+  int64_t n = (int64_t)agg->n;
+  int64_t half = (agg->sum >= 0) ? n / 2 : -(n / 2);
+  // n * sumsq - sum^2 = n^2 * variance; at most 2^16 * 2^16 * 2^30, no overflow
+  uint64_t sum_abs = (uint64_t)((agg->sum >= 0) ? agg->sum : -agg->sum);
+  uint64_t m2 = (uint64_t)n * agg->sumsq - sum_abs * sum_abs;
+
+  out->min = (int16_t)agg->min;
+  out->max = (int16_t)agg->max;
+  out->mean = (int16_t)((agg->sum + half) / n);
+  out->std = (uint16_t)(agg_isqrt(m2) / (uint64_t)n);
+  out->n = (uint16_t)agg->n;
+}
+
+void TlmBurst_Init(tlm_burst_t *burst)
+{
+  memset(burst, 0, sizeof(*burst));
+}
+
+uint8_t TlmBurst_Add(tlm_burst_t *burst, const int32_t v[TLM_BURST_FIELDS])
+{
+  uint8_t enc[TLM_BURST_SAMPLE_MAX];
+  size_t len = 0;
+
+  for (uint32_t i = 0; i < TLM_BURST_FIELDS; i++) {
+    uint32_t d = (uint32_t)v[i] - burst->prev[i];
+    uint32_t z = (d << 1) ^ (0U - (d >> 31));   // Zigzag: small negatives stay small
+    while (z >= 0x80U) {
+      enc[len++] = (uint8_t)(z | 0x80U);
+      z >>= 7;
+    }
+    enc[len++] = (uint8_t)z;
+  }
+  if (burst->len + len > TLM_BURST_MAX) return 0;
+
+  memcpy(&burst->buf[burst->len], enc, len);
+  burst->len = (uint16_t)(burst->len + len);
+  burst->count++;
+  for (uint32_t i = 0; i < TLM_BURST_FIELDS; i++) burst->prev[i] = (uint32_t)v[i];
+  return 1;
+}
+
+uint8_t TlmBurst_Next(const uint8_t *buf, size_t len, size_t *pos, int32_t v[TLM_BURST_FIELDS])
+{
+  size_t p = *pos;
+  uint32_t d[TLM_BURST_FIELDS];
+
+  if (p >= len) return 0;
+  for (uint32_t i = 0; i < TLM_BURST_FIELDS; i++) {
+    uint32_t z = 0;
+    for (uint32_t shift = 0;; shift += 7U) {
+      if (p >= len || shift > 28U) return 0;
+      uint8_t b = buf[p++];
+      z |= (uint32_t)(b & 0x7FU) << shift;
+      if ((b & 0x80U) == 0U) break;
+    }
+    d[i] = (z >> 1) ^ (0U - (z & 1U));
+  }
+  for (uint32_t i = 0; i < TLM_BURST_FIELDS; i++) v[i] = (int32_t)((uint32_t)v[i] + d[i]);
+  *pos = p;
+  return 1;
+}
@@ -0,0 +1,151 @@
+/* Receive side of the telemetry link: frames to authenticated batches to items, no heap (ESP32 bridge). */
+
+#include "../Inc/telemetry_rx.h"  // Relative: the Arduino build has no Bridge/Inc include path
+#include <string.h>
+
+static uint8_t rx_is_space(char c)
+{
+  return (uint8_t)(c == ' ' || c == '\t' || c == '\v' || c == '\f');
+}
+
+static void rx_record(tlm_rx_t *rx, const uint8_t *item, size_t len, uint8_t late)
+{
+  const tp_record_t *rec = TlmProto_RecordView(item, len);
+  if (rec == NULL) {
+    rx->stats.bad_records++;
+    return;
+  }
+  if (late) {
+    // Counted lost when the newer frame showed the gap; the sequence stays where it is
+    if (rx->stats.lost_records > 0U) rx->stats.lost_records--;
+    if (rx->ops.record != NULL) rx->ops.record(rx->ops.user, rec);
+    return;
+  }
+  if (rx->seq_valid && rec->h.seq != (uint8_t)(rx->last_seq + 1U)) {
+    rx->stats.lost_records += (uint8_t)(rec->h.seq - rx->last_seq - 1U);
+  }
+  rx->last_seq = rec->h.seq;
+  rx->seq_valid = 1;
+  if (rx->ops.record != NULL) rx->ops.record(rx->ops.user, rec);
+}
+
+// Text may span items; lines end at '\n', '\r' is dropped, blanks are trimmed
+static void rx_text(tlm_rx_t *rx, const uint8_t *item, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    char c = (char)item[i];
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (rx->line_len == 0U && rx_is_space(c)) continue;
+      if (rx->line_len < TLM_RX_LINE_MAX) {
+        rx->line[rx->line_len++] = c;
+      } else {
+        rx->line_cut = 1;
+      }
+      continue;
+    }
+
+    uint16_t n = rx->line_len;
+    while (n > 0U && rx_is_space(rx->line[n - 1U])) n--;
+    rx->line[n] = '\0';
+    if (n > 0U) {
+      rx->stats.lines++;
+      if (rx->line_cut) rx->stats.long_lines++;
+      if (rx->ops.line != NULL) rx->ops.line(rx->ops.user, rx->line, n);
+    }
+    rx->line_len = 0;
+    rx->line_cut = 0;
+  }
+}
+
+static void rx_batch(tlm_rx_t *rx, const uint8_t *body, size_t len)
+{
+  tp_seal_hdr_t hdr;
+  const uint8_t *batch = body + TP_SEAL_HDR_LEN;
+  size_t batch_len = len - TP_SEAL_HDR_LEN;
+
+  memcpy(&hdr, body, sizeof(hdr));
+  if (rx->ops.open != NULL) {
+    uint8_t nonce[TP_NONCE_LEN];
+    if (len < TP_SEAL_HDR_LEN + TP_SEAL_TAG_LEN) {
+      rx->stats.auth_failures++;
+      return;
+    }
+    batch_len -= TP_SEAL_TAG_LEN;
+    TlmProto_Nonce(hdr.session, hdr.ctr, nonce);
+    if (!rx->ops.open(rx->ops.user, nonce, body, TP_SEAL_HDR_LEN, batch, batch_len,
+                      body + len - TP_SEAL_TAG_LEN, rx->pt)) {
+      rx->stats.auth_failures++;
+      return;
+    }
+    batch = rx->pt;
+  }
+
+  uint8_t late = 0;
+  if (hdr.session != rx->stats.session) {
+    // Sender rebooted: new nonce prefix, counters start over
+    rx->stats.session = hdr.session;
+    rx->stats.last_ctr = 0;
+    rx->missing = 0;
+    rx->seq_valid = 0;
+  } else if (hdr.ctr <= rx->stats.last_ctr) {
+    // Older: only a frame of a reported gap, and only once
+    uint32_t age = rx->stats.last_ctr - hdr.ctr;
+    if (age >= TLM_RX_WINDOW || (rx->missing & (1ULL << age)) == 0U) {
+      rx->stats.replays++;
+      return;
+    }
+    rx->missing &= ~(1ULL << age);
+    rx->stats.recovered++;
+    late = 1;
+  }
+  if (!late) {
+    uint32_t gap = (rx->stats.last_ctr != 0U) ? hdr.ctr - rx->stats.last_ctr - 1U : 0U;
+    rx->missing = (gap + 1U < TLM_RX_WINDOW) ? rx->missing << (gap + 1U) : 0U;
+    if (gap > 0U) {
+      uint32_t ask = (gap < TLM_RX_WINDOW) ? gap : TLM_RX_WINDOW - 1U;
+      rx->stats.lost_frames += gap;
+      rx->missing |= ((1ULL << ask) - 1U) << 1;
+      if (rx->ops.nack != NULL) {
+        rx->stats.nacks++;
+        rx->ops.nack(rx->ops.user, hdr.session, hdr.ctr - ask, (uint8_t)ask);
+      }
+    }
+    rx->stats.last_ctr = hdr.ctr;
+  }
+  rx->stats.batches++;
+  rx->late = late;
+
+  size_t pos = 0;
+  const uint8_t *item = NULL;
+  size_t n;
+  while ((n = TlmProto_BatchNext(batch, batch_len, &pos, &item)) != 0U) {
+    rx->stats.items++;
+    if (item[0] == TP_RECORD_TAG) {
+      rx_record(rx, item, n, late);
+    } else if (item[0] >= 0x80U) {
+      if (rx->ops.binary != NULL) rx->ops.binary(rx->ops.user, item, n);
+    } else {
+      rx_text(rx, item, n);
+    }
+  }
+}
+
+void TlmRx_Init(tlm_rx_t *rx, const tlm_rx_ops_t *ops)
+{
+  memset(rx, 0, sizeof(*rx));
+  TlmProto_DecoderInit(&rx->dec);
+  rx->ops = *ops;
+}
+
+uint32_t TlmRx_Feed(tlm_rx_t *rx, const uint8_t *data, size_t len)
+{
+  uint32_t before = rx->stats.batches;
+
+  for (size_t i = 0; i < len; i++) {
+    const uint8_t *body = NULL;
+    size_t n = TlmProto_DecoderFeed(&rx->dec, data[i], &body);
+    if (n != 0U) rx_batch(rx, body, n);   // 0: mid-frame, or a bad frame (counted in dec)
+  }
+  return rx->stats.batches - before;
+}
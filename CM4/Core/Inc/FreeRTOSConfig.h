@@ -63,18 +63,21 @@
 #define configUSE_PREEMPTION                     1
 #define configSUPPORT_STATIC_ALLOCATION          1
 #define configSUPPORT_DYNAMIC_ALLOCATION         1
-#define configUSE_IDLE_HOOK                      0
+#define configUSE_IDLE_HOOK                      1
 #define configUSE_TICK_HOOK                      0
+#define configUSE_TICKLESS_IDLE                  2
 #define configCPU_CLOCK_HZ                       ( SystemD2Clock )
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)15360)
+#define configTOTAL_HEAP_SIZE                    ((size_t)1024)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_TRACE_FACILITY                 1
+#define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
 #define configQUEUE_REGISTRY_SIZE                8
+#define configCHECK_FOR_STACK_OVERFLOW           2
 #define configUSE_RECURSIVE_MUTEXES              1
 #define configUSE_COUNTING_SEMAPHORES            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
@@ -116,6 +119,7 @@ to exclude the API function. */
 #define INCLUDE_xQueueGetMutexHolder         1
 #define INCLUDE_uxTaskGetStackHighWaterMark  1
 #define INCLUDE_xTaskGetCurrentTaskHandle    1
+#define INCLUDE_xTaskGetIdleTaskHandle       1   // runtime_stats.c finds the idle task by handle
 #define INCLUDE_eTaskGetState                1
 
 /*
@@ -155,6 +159,16 @@ header file. */
 #define configASSERT( x ) if ((x) == 0) {taskDISABLE_INTERRUPTS(); for( ;; );}
 /* USER CODE END 1 */
 
+/* USER CODE BEGIN 2 */
+/* Definitions needed when configGENERATE_RUN_TIME_STATS is on */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE getRunTimeCounterValue
+/* USER CODE END 2 */
+
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
 standard names. */
 #define vPortSVCHandler    SVC_Handler
@@ -165,6 +179,17 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Tickless idle: D2 STOP with LPTIM1 timekeeping (lowpower.c) */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    2
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+void LowPower_SuppressTicksAndSleep(uint32_t expected_ticks);
+#endif
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) LowPower_SuppressTicksAndSleep( xExpectedIdleTime )
+/* Event tracer (tracer.c): one record per context switch */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#include "tracer.h"
+#define traceTASK_SWITCHED_IN() TRACE_EVENT( TRACE_EV_TASK_IN, 0U, pxCurrentTCB->uxTCBNumber )
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,40 @@
+/**
+  ******************************************************************************
+  * @file    aes_fast.h
+  * @brief   AES-128 encryption with a cached key schedule and a T-table round.
+  ******************************************************************************
+  * The key is expanded once (AesFast_KeyInit) and each round is four table
+  * lookups per column instead of tiny-AES's byte-wise SubBytes/xtime
+  * MixColumns. One 1 KB table (rotated for the other three columns) is built
+  * in RAM on first use from the S-box.
+  *
+  * Modes are built on top of it (aes_gcm.c).
+  ******************************************************************************
+  */
+#ifndef AES_FAST_H
+#define AES_FAST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AES_FAST_BLOCKLEN    (16U)
+#define AES_FAST_ROUNDS      (10U)
+
+typedef struct {
+  uint32_t rk[4U * (AES_FAST_ROUNDS + 1U)];   // Round keys, big-endian words
+} aes_fast_key_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Expands a 128-bit key (and builds the T-table on first call).
+ */
+void AesFast_KeyInit(aes_fast_key_t *key, const uint8_t k[16]);
+
+/**
+ * @brief Encrypts one block; in and out may overlap.
+ */
+void AesFast_EncryptBlock(const aes_fast_key_t *key, const uint8_t in[16], uint8_t out[16]);
+
+#endif /* AES_FAST_H */
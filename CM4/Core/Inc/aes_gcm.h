@@ -0,0 +1,76 @@
+/**
+  ******************************************************************************
+  * @file    aes_gcm.h
+  * @brief   AES-128-GCM (NIST SP 800-38D) on aes_fast.c, with the keystream of
+  *          the next frames precomputed from idle time.
+  ******************************************************************************
+  * Nonces are 96 bits: a fixed 8-byte prefix given at init (the session)
+  * followed by a 32-bit big-endian frame counter. Frame n uses the counter
+  * blocks prefix || n || 1 (tag mask), prefix || n || 2, ... so its keystream
+  * does not depend on the data and can be computed before the data exists.
+  *
+  * AesGcm_Refill() fills the blocks of the next AES_GCM_KS_FRAMES frames
+  * after the last sealed one; AesGcm_Seal() takes what is ready and computes
+  * the rest. GHASH (4-bit tables, 256 bytes) always runs on the send path.
+  * One refilling context and one sealing context (e.g. the idle task and the
+  * telemetry task); no lock is needed between them.
+  ******************************************************************************
+  */
+#ifndef AES_GCM_H
+#define AES_GCM_H
+
+#include "aes_fast.h"
+
+#define AES_GCM_PREFIX_LEN   (8U)
+#define AES_GCM_TAG_LEN      (16U)
+#define AES_GCM_KS_BLOCKS    (16U)   // Data blocks precomputed per frame (256 bytes)
+#define AES_GCM_KS_FRAMES    (2U)    // Frames precomputed ahead
+
+typedef struct {
+  uint32_t frame;      // Counter the blocks belong to
+  uint32_t ready;      // Blocks [0, ready) are valid: E(J0), E(J0 + 1), ...
+  uint8_t  ks[1U + AES_GCM_KS_BLOCKS][AES_FAST_BLOCKLEN];
+} aes_gcm_ks_t;
+
+typedef struct {
+  aes_fast_key_t key;
+  uint64_t hl[16];     // GHASH: multiples of H, low and high halves
+  uint64_t hh[16];
+  uint8_t  prefix[AES_GCM_PREFIX_LEN];
+  aes_gcm_ks_t ks[AES_GCM_KS_FRAMES];
+  uint32_t tail;       // Next frame to seal (seal side)
+  uint32_t hits;       // Keystream blocks taken from the cache
+  uint32_t misses;     // Keystream blocks computed on the send path
+} aes_gcm_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Expands the key, derives the GHASH tables and empties the cache.
+ * @param first_frame Counter of the first frame that will be sealed.
+ */
+void AesGcm_Init(aes_gcm_t *ctx, const uint8_t key[16], const uint8_t prefix[AES_GCM_PREFIX_LEN],
+                 uint32_t first_frame);
+
+/**
+ * @brief Precomputes up to max_blocks keystream blocks for the next frames.
+ * @retval Blocks generated (0 when the cache is full).
+ */
+uint32_t AesGcm_Refill(aes_gcm_t *ctx, uint32_t max_blocks);
+
+/**
+ * @brief Encrypts buf in place and writes the tag; aad is authenticated only.
+ * Frame counters must not repeat for the lifetime of the prefix.
+ */
+void AesGcm_Seal(aes_gcm_t *ctx, uint32_t frame, const uint8_t *aad, size_t aad_len,
+                 uint8_t *buf, size_t len, uint8_t tag[AES_GCM_TAG_LEN]);
+
+/**
+ * @brief Checks the tag, then decrypts buf in place. Does not use the cache.
+ * @retval 1 if authentic (buf decrypted), 0 otherwise (buf untouched).
+ */
+uint8_t AesGcm_Open(const aes_gcm_t *ctx, uint32_t frame, const uint8_t *aad, size_t aad_len,
+                    uint8_t *buf, size_t len, const uint8_t tag[AES_GCM_TAG_LEN]);
+
+#endif /* AES_GCM_H */
@@ -0,0 +1,135 @@
+/**
+  ******************************************************************************
+  * @file    app_tasks.h
+  * @brief   CM4 application tasks: acquisition, DSP, IPC publisher, telemetry.
+  ******************************************************************************
+  * Data flow:
+  *   EXTI5 (MAX30100 INT) --thread flag--> acquisition --ppg queue--> dsp
+  *   dsp --result queue--> ipc --mailbox + HSEM 5--> CM7
+  *   dsp, ipc, acquisition --telemetry queue--> telemetry --USART3--> ESP32
+  *   ESP32 --USART3 RX DMA (uart_rx.c)--> CFG line --thread flag--> acquisition
+  *
+  * CFG commands (vest_config.h) retune the pipeline at run time: the
+  * acquisition task reprograms the MAX30100 with the sensor shut down, the
+  * dsp task restarts its window on the next block (window length follows the
+  * sample rate, ~APP_PPG_WINDOW_MS), ipc stops feeding the CM7 with AI=0 and
+  * telemetry thins PPG records to REPORT. Every command is answered with a
+  * TP_REC_CONFIG record carrying the settings in force.
+  *
+  * Each peripheral has one owner: I2C1 = acquisition, ADC1 = ipc,
+  * USART3 TX = telemetry, D2 mailbox/event ring = ipc. Producers never block
+  * on a full queue; they drop and count (app_stats_t).
+  *
+  * Stacks, control blocks and queue storage are static (app_tasks.c), sizes
+  * are checked at compile time and nothing is taken from the FreeRTOS heap.
+  *
+  * Idle time is tickless (lowpower.c): D2 STOP when nothing is due for at
+  * least LOWPOWER_MIN_STOP_TICKS, woken by LPTIM1, MAX30100 INT or USART3 RX.
+  * Every wake-up adds its latency (tens of us) to the WCRT figures below.
+  *
+  * Context switches, ISRs, I2C and UART transfers, STOP periods and queue
+  * drops are recorded by tracer.c; "TRC?" on USART3 makes the telemetry task
+  * dump the ring (tools/trace_decode.py turns it into a Perfetto timeline).
+  *
+  * Drivers and tasks log through dlog.h (ID + raw arguments, no printf); the
+  * telemetry task sends the records as binary frames after every message and
+  * at least every APP_LOG_DRAIN_MS.
+  *
+  * Task         Priority               Period / trigger        Deadline  WCRT
+  * (figures at the boot settings, 100 Hz; 200 Hz halves the acquisition and
+  * dsp periods and doubles the window)
+  * acquisition  osPriorityHigh         A_FULL every 160 ms     20 ms     ~7 ms
+  * dsp          osPriorityAboveNormal  16-sample block         160 ms    ~8 ms
+  * ipc          osPriorityNormal       1.28 s frame, 100 ms    1.28 s    ~9 ms
+  * telemetry    osPriorityBelowNormal  queued message          -         ~15 ms
+  *
+  * Budgets behind the WCRT column (ISRs ignored, they are a few us each):
+  * - acquisition: status + 64-byte FIFO read over I2C, ~67 bytes on the bus,
+  *   ~6 ms at 100 kHz, plus the two temperature registers when TEMP_RDY is set.
+  *   Deadline: the 16-entry FIFO overflows two sample periods after A_FULL.
+  * - dsp: < 0.5 ms to append a block, DC/AC/peaks on 128 samples every 8th
+  *   block (256 every 16th at 200 Hz), plus one acquisition preemption. Four
+  *   queued blocks give 640 ms slack.
+  * - ipc: mailbox write and HSEM release (us), LM35 (32 polled conversions,
+  *   < 1 ms) every 5 s, plus acquisition and dsp preemption.
+  * - telemetry: encrypting and queueing one frame is well under 1 ms; DMA
+  *   sends it (~11 ms for ~130 bytes at 115200 baud) while the task goes on.
+  *   With SECURE_UART_POOL_LEN frames queued it waits up to
+  *   SECURE_UART_WAIT_MS, then drops the oldest. Nothing waits for it.
+  ******************************************************************************
+  */
+#ifndef APP_TASKS_H
+#define APP_TASKS_H
+
+#include "main.h"
+#include "athlet_features.h"
+
+#define APP_PPG_WINDOW_MS        (1280U)   // HR/SpO2 window, whole 16-sample blocks (8 at 100 Hz)
+#define APP_PPG_WINDOW_BLOCKS_MAX (16U)    // At 200 Hz, the highest RATE
+#define APP_LM35_PERIOD_MS       (5000U)
+#define APP_DIE_TEMP_PERIOD_MS   (10000U)
+#define APP_EVENT_POLL_MS        (100U)    // CM7 event ring poll
+#define APP_SENSOR_WATCHDOG_MS   (500U)    // Service the sensor anyway if INT stays quiet
+#define APP_HEALTH_PERIOD_MS     (10000U)
+#define APP_LOG_DRAIN_MS         (500U)    // Deferred log (dlog.h) flush when telemetry is idle
+#define APP_RAW_CTS_MARGIN_MS    (500U)    // Trace dump chunk timeout beyond twice its wire time (ESP32 holding CTS)
+
+// Mailbox features the CM4 cannot measure yet
+#define APP_DEFAULT_FATIGUE      (5.0f)
+#define APP_DEFAULT_ACTIVITY     (ATHLET_ACTIVITY_RUNNING)
+
+typedef struct {
+  uint32_t ppg_blocks;        // FIFO blocks read
+  uint32_t ppg_drops;         // Blocks lost, ppg queue full
+  uint32_t sensor_errors;     // MAX30100 init retries
+  uint32_t sensor_timeouts;   // Watchdog wake-ups without INT
+  uint32_t results;           // HR/SpO2 windows computed
+  uint32_t result_drops;      // Results lost, ipc queue full
+  uint32_t frames_published;  // Mailbox frames sent to the CM7
+  uint32_t telemetry_sent;
+  uint32_t telemetry_drops;   // Messages lost, telemetry queue full
+  uint32_t commands;          // CFG commands applied (or queries answered)
+  uint32_t command_errors;    // CFG commands rejected
+} app_stats_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Creates the queues and the four tasks. Call between osKernelInitialize()
+ * and osKernelStart().
+ * @param hi2c MAX30100 bus.
+ * @param hadc LM35 ADC.
+ * @param huart ESP32 link.
+ * @retval HAL_OK, or HAL_ERROR if an object could not be allocated.
+ */
+HAL_StatusTypeDef AppTasks_Init(I2C_HandleTypeDef *hi2c, ADC_HandleTypeDef *hadc, UART_HandleTypeDef *huart);
+
+/**
+ * @brief Call from the MAX30100 INT EXTI handler; wakes the acquisition task.
+ */
+void AppTasks_SensorIrq(void);
+
+/**
+ * @brief Call from the USART3 RX path (uart_rx.c) with every byte outside a
+ * weights blob. Assembles CFG lines and hands each command to the
+ * acquisition task; malformed ones, or one arriving while the previous is
+ * being applied, are answered straight away.
+ */
+void AppTasks_CommandByte(uint8_t byte);
+
+/**
+ * @brief Pipeline counters.
+ */
+const app_stats_t *AppTasks_GetStats(void);
+
+/**
+ * @brief Queues a health report: the telemetry task sends one HEALTH line per
+ * core with the stack watermark of every task and the heap low-water mark,
+ * a POWER line with the CM4 duty cycle and STOP wake-up figures, a TXQ line
+ * with the UART DMA queue counters, and one binary CPU load frame per core
+ * (runtime_stats.h).
+ */
+void AppTasks_ReportHealth(void);
+
+#endif /* APP_TASKS_H */
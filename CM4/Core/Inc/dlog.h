@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file    dlog.h
+  * @brief   CM4 deferred binary log: message ID plus raw arguments, formatted
+  *          on the host by tools/dlog_decode.py.
+  ******************************************************************************
+  * DLOGn() stores a timestamped record in a lock-free ring in a few dozen
+  * cycles, from any task or ISR (LDREX/STREX, interrupts stay enabled). When
+  * the ring is full the record is dropped and counted; the caller never waits.
+  * The telemetry task drains the ring into binary frames (tag DLOG_TAG) that
+  * go over the encrypted UART like any other telemetry; the ESP32 prints them
+  * as "DLOG M4 <hex>" lines for the host tool.
+  *
+  * Frame (little-endian):
+  *   [tag][version][n][core][dropped(4)] then n x dlog_record_t
+  ******************************************************************************
+  */
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+
+#define DLOG_ENABLE             1
+#define DLOG_RING_LEN           (64U)   // Power of two
+#define DLOG_MAX_ARGS           (3U)
+#define DLOG_FRAME_MAX_RECORDS  (12U)   // Frame stays within one secure_uart_send()
+
+#define DLOG_TAG                (0xC6U)
+#define DLOG_VERSION            (1U)
+#define DLOG_HEADER_LEN         (8U)
+#define DLOG_FRAME_LEN(n)       (DLOG_HEADER_LEN + (uint32_t)(n) * sizeof(dlog_record_t))
+
+typedef enum {
+  DLOG_ID_NONE = 0,
+#define DLOG_MSG(name_, fmt_) DLOG_##name_,
+#include "dlog_ids.h"
+#undef DLOG_MSG
+  DLOG_ID_COUNT
+} dlog_id_t;
+
+typedef struct {
+  uint32_t ts_us;                  // Run-time stats counter, 1 MHz
+  uint16_t id;                     // dlog_id_t
+  uint8_t  nargs;
+  uint8_t  reserved;
+  uint32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+typedef struct {
+  uint8_t  tag;                    // DLOG_TAG
+  uint8_t  version;                // DLOG_VERSION
+  uint8_t  n_records;
+  uint8_t  core;
+  uint32_t dropped;                // Records lost (ring full) since the previous frame
+  dlog_record_t records[DLOG_FRAME_MAX_RECORDS];
+} dlog_frame_t;
+
+// Floats travel as their IEEE-754 bits, the host formats them
+static inline uint32_t dlog_f32(float v)
+{
+  union { float f; uint32_t u; } c = { v };
+  return c.u;
+}
+
+#if DLOG_ENABLE
+#define DLOG0(name_)                DLog_Write(DLOG_##name_, 0U, 0U, 0U, 0U)
+#define DLOG1(name_, a_)            DLog_Write(DLOG_##name_, 1U, (uint32_t)(a_), 0U, 0U)
+#define DLOG2(name_, a_, b_)        DLog_Write(DLOG_##name_, 2U, (uint32_t)(a_), (uint32_t)(b_), 0U)
+#define DLOG3(name_, a_, b_, c_)    DLog_Write(DLOG_##name_, 3U, (uint32_t)(a_), (uint32_t)(b_), (uint32_t)(c_))
+#else
+#define DLOG0(name_)                do { } while (0)
+#define DLOG1(name_, a_)            do { (void)(a_); } while (0)
+#define DLOG2(name_, a_, b_)        do { (void)(a_); (void)(b_); } while (0)
+#define DLOG3(name_, a_, b_, c_)    do { (void)(a_); (void)(b_); (void)(c_); } while (0)
+#endif
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Appends one record. Any context; use the DLOGn() macros.
+ */
+void DLog_Write(uint16_t id, uint8_t nargs, uint32_t a0, uint32_t a1, uint32_t a2);
+
+/**
+ * @brief Moves up to DLOG_FRAME_MAX_RECORDS records into a frame. One
+ * consumer only (the telemetry task).
+ * @retval Frame length in bytes, 0 when there is nothing to send.
+ */
+uint32_t DLog_Drain(uint8_t core, dlog_frame_t *out);
+
+/**
+ * @brief Records dropped since boot.
+ */
+uint32_t DLog_Dropped(void);
+
+#endif /* DLOG_H */
@@ -0,0 +1,27 @@
+/**
+  ******************************************************************************
+  * @file    dlog_ids.h
+  * @brief   Deferred log message table: one DLOG_MSG(name, format) per message.
+  ******************************************************************************
+  * The enum in dlog.h and the host string table (tools/dlog_decode.py parses
+  * this file) are both generated from this list, so the firmware never links
+  * the format strings.
+  *
+  * IDs are positions in the list: append new messages at the end, and never
+  * reorder or remove one, or old captures decode to the wrong text.
+  * Formats take up to DLOG_MAX_ARGS 32-bit arguments: %u %d %x (with flags and
+  * width), %c, and %f for a float passed through dlog_f32().
+  ******************************************************************************
+  */
+/* No include guard: expanded once per DLOG_MSG definition */
+
+DLOG_MSG(MAX30100_READ_ERR,    "MAX30100 I2C read error reg 0x%02x status %u")
+DLOG_MSG(MAX30100_WRITE_ERR,   "MAX30100 I2C write error reg 0x%02x data 0x%02x status %u")
+DLOG_MSG(MAX30100_RESET_STUCK, "MAX30100 reset bit did not clear")
+DLOG_MSG(MAX30100_RESET_FAIL,  "MAX30100 reset failed")
+DLOG_MSG(MAX30100_PART_ID,     "MAX30100 part ID mismatch or read error, expected 0x11, got 0x%02x")
+DLOG_MSG(MAX30100_FIFO_ERR,    "MAX30100 FIFO read error status %u (%u bytes)")
+DLOG_MSG(MAX30100_TEMP_ERR,    "MAX30100 temperature read timeout or error")
+DLOG_MSG(SENSOR_INIT_FAIL,     "MAX30100 initialization failed (attempt %u), check connections")
+DLOG_MSG(SENSOR_READY,         "MAX30100 initialized, SpO2/HR mode")
+DLOG_MSG(LM35_READ_FAIL,       "LM35 ADC read failed")
@@ -0,0 +1,69 @@
+/* CM4 tickless idle: D2 STOP between ticks, LPTIM1 keeps FreeRTOS time. */
+#ifndef LOWPOWER_H
+#define LOWPOWER_H
+
+#include "main.h"
+
+#define LOWPOWER_MIN_STOP_TICKS   (5U)   // Shorter idle periods only WFI with the tick running
+
+typedef struct {
+  uint32_t window_ms;            // Time covered by duty_x100, since the previous call
+  uint32_t duty_x100;            // CPU awake share of the window, 0.01 % units
+  uint32_t sleeps;               // WFI with the tick running (short idle or STOP held)
+  uint32_t stops;                // D2 STOP entries
+  uint32_t stop_aborts;          // Task made ready between tick stop and WFI
+  uint32_t wakes_timer;          // STOP left on the LPTIM1 match
+  uint32_t wakes_irq;            // STOP left early on EXTI (MAX30100 INT, USART3 RX)
+  uint32_t stopped_ms;           // Total time spent in STOP
+  uint32_t wake_latency_us;      // Last timer wake: match to first instruction
+  uint32_t wake_latency_max_us;
+  uint32_t resume_cycles_max;    // WFI return to tick restarted, CPU cycles
+} lowpower_stats_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Starts LSI, sets LPTIM1 up as the STOP timebase and arms the D2
+ * wake-up lines of LPTIM1 and the UART (wake on RXNE, DMA reception paused
+ * across STOP). Call before osKernelStart() and before reception starts.
+ * @param huart UART that must wake the core on a received byte (USART3, HSI kernel clock).
+ * @retval HAL_OK, or HAL_ERROR if LSI does not start.
+ */
+HAL_StatusTypeDef LowPower_Init(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Keeps the core out of STOP while a DMA transfer or another
+ * clock-dependent operation is in flight. Nests; ISR safe.
+ */
+void LowPower_Hold(void);
+
+/**
+ * @brief Releases one LowPower_Hold().
+ */
+void LowPower_Release(void);
+
+/**
+ * @brief portSUPPRESS_TICKS_AND_SLEEP implementation, called by the idle task
+ * with the scheduler suspended.
+ */
+void LowPower_SuppressTicksAndSleep(uint32_t expected_ticks);
+
+/**
+ * @brief Copies the counters and closes the duty-cycle window. One caller only.
+ */
+void LowPower_GetStats(lowpower_stats_t *out);
+
+/**
+ * @brief Microseconds spent in STOP since boot, wrapping at 2^32. Added to the
+ * run-time stats timer, which does not count in STOP.
+ */
+uint32_t LowPower_StoppedUs(void);
+
+/**
+ * @brief Call from LPTIM1_IRQHandler. The match is normally consumed before
+ * interrupts are re-enabled; this only clears a late one.
+ */
+void LowPower_LptimIrq(void);
+
+#endif /* LOWPOWER_H */
@@ -5,7 +5,6 @@
 
 #include "main.h" // Assuming this includes your STM32 HAL drivers
 #include <string.h>
-#include <stdio.h> // For printf in debug messages
 
 /*----------------------------------------------------------------------------*/
 // General Configuration
@@ -70,6 +69,8 @@
 // Global flag indicating new data is available from FIFO
 // This flag is set in MAX30100_InterruptHandler and cleared in the main application loop.
 extern volatile uint8_t max30100_new_data_available;
+// Set by MAX30100_InterruptHandler when a conversion started with MAX30100_StartTemperature completed.
+extern volatile uint8_t max30100_new_temp_available;
 
 /*----------------------------------------------------------------------------*/
 // Enumerations for configuration
@@ -154,8 +155,8 @@ HAL_StatusTypeDef MAX30100_WriteReg(uint8_t regAddr, uint8_t data);
 HAL_StatusTypeDef MAX30100_ConfigInterrupts(uint8_t enable_a_full, uint8_t enable_temp_rdy);
 
 /**
- * @brief Interrupt handler to be called from STM32 EXTI ISR.
- * Reads interrupt status, processes FIFO or temperature data.
+ * @brief Services the INT pin: reads interrupt status, processes FIFO or temperature data.
+ * Uses blocking I2C, so call it from a task woken by the EXTI ISR, not from the ISR itself.
  */
 void MAX30100_InterruptHandler(void);
 
@@ -212,6 +213,14 @@ HAL_StatusTypeDef MAX30100_ReadFifoData(uint16_t* ir_data, uint16_t* red_data, u
  */
 HAL_StatusTypeDef MAX30100_ReadTemperature(float *pTemperature);
 
+/**
+ * @brief Starts a one-shot die temperature conversion and returns immediately.
+ * A_FULL stays enabled; the result arrives through TEMP_RDY, handled by
+ * MAX30100_InterruptHandler (max30100_last_temperature, max30100_new_temp_available).
+ * @retval HAL_OK if successful.
+ */
+HAL_StatusTypeDef MAX30100_StartTemperature(void);
+
 /**
  * @brief Puts the MAX30100 into shutdown mode.
  * @retval HAL_OK if successful.
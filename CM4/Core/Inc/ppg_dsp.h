@@ -0,0 +1,35 @@
+/* PPG processing: heart rate and SpO2 from a window of MAX30100 IR/RED samples. */
+#ifndef PPG_DSP_H
+#define PPG_DSP_H
+
+#include <stdint.h>
+
+typedef struct {
+  float heart_rate_bpm;  // 0 when no peak was found
+  float spo2_pct;        // 0 when the signal is too weak (no finger)
+  float ratio;           // R = (AC_red/DC_red) / (AC_ir/DC_ir)
+  float dc_ir;
+  float ac_ir;
+  float dc_red;
+  float ac_red;
+  int   peaks;
+} ppg_result_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Computes heart rate and SpO2 over one window.
+ * @param ir IR samples.
+ * @param red RED samples.
+ * @param size Samples per channel.
+ * @param sample_rate_hz PPG sample rate (must match the MAX30100 configuration).
+ * @param out Result.
+ */
+void PPG_Compute(const uint16_t *ir, const uint16_t *red, uint16_t size, float sample_rate_hz, ppg_result_t *out);
+
+float calculateDC(const uint16_t *samples, uint16_t size);
+float calculateAC(const uint16_t *samples, uint16_t size);
+int countPeaks(const uint16_t *samples, uint16_t size, float threshold, float min_peak_distance_samples);
+
+#endif /* PPG_DSP_H */
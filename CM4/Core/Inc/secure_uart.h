@@ -0,0 +1,117 @@
+/* Batched, AES-GCM sealed UART link to the ESP32 bridge, with NACK retransmission. */
+#ifndef SECURE_UART_H
+#define SECURE_UART_H
+
+#include "main.h"
+#include "telemetry_proto.h"
+
+// AES-128-GCM sealing of the UART batches to the ESP32
+#define ENABLE_AES_UART 1
+
+// Payloads are batched (telemetry_proto.h); each batch is sealed into a pool
+// buffer, queued and sent by DMA (DMA1 stream 1)
+#define SECURE_UART_POOL_LEN      (4U)
+#define SECURE_UART_PAYLOAD_MAX   TP_BATCH_ITEM_MAX
+#define SECURE_UART_FRAME_MAX     TP_FRAME_MAX(TP_BODY_MAX)
+#define SECURE_UART_WAIT_MS       (30U)    // Back-pressure on a full pool, then the oldest queued frame goes
+#define SECURE_UART_BATCH_MS      (3000U)  // Latency bound: a batch is sealed at most this long after its first item
+
+// Link mode (tp_link_t in telemetry_proto.h): TP_LINK_BAUD_BASE without flow
+// control until the ESP32 proposes more. USART3 runs off the 64 MHz HSI, so
+// 2 and 4 Mbaud are exact; RTS on PD12, CTS on PD11 (pulled down: an
+// unconnected or unpowered ESP32 never holds the transmitter).
+#define SECURE_UART_BAUD_MAX      (4000000UL)  // HSI / 16
+#define SECURE_UART_LINK_TIMEOUT_MS (5000U)  // No HELLO keep-alive this long: back to TP_LINK_BAUD_BASE
+#define SECURE_UART_SWITCH_GUARD_MS (20U)    // After an ACCEPT, time for the ESP32 to switch too
+// Sent frames kept for NACKs, as they went out (same counter, same ciphertext).
+// A gap is seen once the ESP32 pumps what is behind it in its RX ring: up to
+// the ring (RTS holds the rest) and a pump period, 21 frames at 2 Mbaud
+#define SECURE_UART_RETX_LEN      (32U)
+
+typedef struct {
+  uint32_t session;        // Nonce prefix of this boot
+  uint32_t items;          // Payloads batched
+  uint32_t frames_sent;
+  uint32_t bytes_sent;
+  uint32_t waits;          // secure_uart_send() found the pool full and waited
+  uint32_t drops_oldest;   // Queued frames discarded after SECURE_UART_WAIT_MS
+  uint32_t errors;         // DMA or UART errors, frame lost
+  uint32_t queued_max;     // Pool high-water mark, frames
+  uint32_t ks_hits;        // AES-GCM keystream blocks precomputed in idle time
+  uint32_t ks_misses;      // Keystream blocks computed on the send path
+  uint32_t baud;           // Current link rate
+  uint32_t link_changes;   // Rate switches, either way
+  uint32_t link_timeouts;  // ... of which back to TP_LINK_BAUD_BASE for want of a keep-alive
+  uint32_t nacks;          // NACK messages for this session
+  uint32_t retransmits;    // Frames sent again
+  uint32_t retx_expired;   // Frames asked for that had left the history
+} secure_uart_stats_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Selects the UART the frames go out on (USART3, DMA TX linked) and
+ * draws the session id from the RNG.
+ */
+void secure_uart_init(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Call from the idle hook: precomputes keystream for the next frames.
+ */
+void secure_uart_idle(void);
+
+/**
+ * @brief Adds one payload to the current batch. The batch is sealed and
+ * queued first if the payload does not fit, so this may wait at most
+ * SECURE_UART_WAIT_MS for a free buffer. Only the telemetry task may call
+ * the send/commit/poll/flush functions.
+ * @param data Plaintext item, truncated to SECURE_UART_PAYLOAD_MAX bytes.
+ * @param len Plaintext length.
+ */
+void secure_uart_send(const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Seals the current batch now, e.g. after an alert.
+ */
+void secure_uart_commit(void);
+
+/**
+ * @brief Seals the current batch once it is SECURE_UART_BATCH_MS old. Also
+ * where the link requests are served: frames asked for again are queued
+ * ahead of new ones, a HELLO is answered and the rate switched, and a rate
+ * whose keep-alive stopped is dropped.
+ * @retval ms until the batch is due, osWaitForever if it is empty.
+ */
+uint32_t secure_uart_poll(void);
+
+/**
+ * @brief Seals the current batch and waits until every queued frame is on
+ * the wire, e.g. before a blocking HAL_UART_Transmit() on the same UART.
+ * @retval HAL_OK, or HAL_TIMEOUT.
+ */
+HAL_StatusTypeDef secure_uart_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Call from HAL_UART_TxCpltCallback(); starts the next queued frame.
+ */
+void secure_uart_tx_complete(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Call from HAL_UART_ErrorCallback(); drops the frame if the error
+ * ended the transfer.
+ */
+void secure_uart_tx_error(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Call from the USART3 RX path (uart_rx.c) with every byte outside a
+ * weights blob; picks the link messages (tp_link_t) out of the stream.
+ */
+void secure_uart_rx_byte(uint8_t byte);
+
+/**
+ * @brief Copies the TX counters.
+ */
+void secure_uart_get_stats(secure_uart_stats_t *out);
+
+#endif /* SECURE_UART_H */
@@ -0,0 +1,122 @@
+/**
+  ******************************************************************************
+  * @file    tracer.h
+  * @brief   CM4 event tracer: fixed-size records in a RAM ring, dumped over
+  *          USART3 on request and turned into a Chrome/Perfetto timeline by
+  *          tools/trace_decode.py.
+  ******************************************************************************
+  * Each record is 8 bytes: a 1 MHz timestamp (the run-time stats counter,
+  * STOP time included) and an event id with two arguments. Recording takes
+  * ~30 cycles with interrupts masked; the ring keeps the last
+  * TRACER_RING_LEN events and overwrites the oldest.
+  *
+  * Dump (little-endian), written by the telemetry task after "TRC?" arrives
+  * on USART3 outside a weights blob:
+  *   tracer_dump_header_t
+  *   n_tasks x tracer_task_name_t     task number -> name, for TASK_IN
+  *   n_events x tracer_event_t        oldest first
+  *   CRC-32 (zlib) of everything above
+  * Recording is paused while the dump is sent; the ring restarts empty.
+  *
+  * This header is included by FreeRTOSConfig.h: no HAL or FreeRTOS types.
+  ******************************************************************************
+  */
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <stdint.h>
+
+#define TRACER_ENABLE        1
+#define TRACER_RING_LEN      (1024U)  // Power of two, 8 KB of RAM
+#define TRACER_MAX_TASKS     (8U)
+#define TRACER_NAME_LEN      (12U)
+
+#define TRACER_DUMP_MAGIC    (0x44435254u)  // "TRCD"
+#define TRACER_DUMP_VERSION  (1U)
+#define TRACER_DUMP_COMMAND  "TRC?"
+
+typedef enum {
+  TRACE_EV_TASK_IN       = 1,   // a16 = FreeRTOS task number
+  TRACE_EV_ISR_ENTER     = 2,   // a8 = tracer_irq_t
+  TRACE_EV_ISR_EXIT      = 3,   // a8 = tracer_irq_t
+  TRACE_EV_I2C_BEGIN     = 4,   // a8 = register, a16 = bytes
+  TRACE_EV_I2C_END       = 5,   // a8 = HAL status
+  TRACE_EV_UART_TX_BEGIN = 6,   // a16 = bytes
+  TRACE_EV_UART_TX_END   = 7,   // a8 = HAL status
+  TRACE_EV_STOP_ENTER    = 8,   // a16 = expected idle ticks
+  TRACE_EV_STOP_EXIT     = 9,   // a8 = 1 on the LPTIM1 deadline, 0 on another wake-up, a16 = ticks stepped
+  TRACE_EV_QUEUE_DROP    = 10,  // a8 = tracer_queue_t
+} tracer_event_id_t;
+
+typedef enum {
+  TRACE_IRQ_EXTI5  = 1,  // MAX30100 INT
+  TRACE_IRQ_USART3 = 2,
+  TRACE_IRQ_LPTIM1 = 3,
+} tracer_irq_t;
+
+typedef enum {
+  TRACE_QUEUE_PPG       = 1,
+  TRACE_QUEUE_RESULT    = 2,
+  TRACE_QUEUE_TELEMETRY = 3,
+} tracer_queue_t;
+
+typedef struct {
+  uint32_t ts_us;
+  uint8_t  id;    // tracer_event_id_t
+  uint8_t  a8;
+  uint16_t a16;
+} tracer_event_t;
+
+typedef struct {
+  uint32_t magic;       // TRACER_DUMP_MAGIC
+  uint8_t  version;     // TRACER_DUMP_VERSION
+  uint8_t  n_tasks;
+  uint16_t event_size;  // sizeof(tracer_event_t)
+  uint32_t ts_hz;       // Timestamp rate
+  uint32_t n_events;    // Records that follow the task table
+  uint32_t lost;        // Records overwritten since the previous dump
+} tracer_dump_header_t;
+
+typedef struct {
+  uint32_t number;
+  char     name[TRACER_NAME_LEN];  // NUL padded
+} tracer_task_name_t;
+
+typedef void (*tracer_write_fn)(const uint8_t *data, uint16_t len);
+typedef void (*tracer_begin_fn)(uint32_t total);
+
+#if TRACER_ENABLE
+#define TRACE_EVENT(id_, a8_, a16_)  Tracer_Record((uint8_t)(id_), (uint8_t)(a8_), (uint16_t)(a16_))
+#else
+#define TRACE_EVENT(id_, a8_, a16_)  do { } while (0)
+#endif
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Sets the function called (from the USART3 RX interrupt) when the
+ * dump command arrives.
+ */
+void Tracer_Init(void (*on_dump_request)(void));
+
+/**
+ * @brief Appends one record. Any context; use TRACE_EVENT() so that
+ * TRACER_ENABLE 0 removes the call.
+ */
+void Tracer_Record(uint8_t id, uint8_t a8, uint16_t a16);
+
+/**
+ * @brief Feeds a received USART3 byte to the command matcher.
+ */
+void Tracer_RxByte(uint8_t byte);
+
+/**
+ * @brief Writes the dump through write() in chunks. Task context only.
+ * @param begin Called once with the dump size in bytes, before the first
+ * write (e.g. to announce the unframed bytes on the link); may be NULL.
+ * @retval Number of events dumped.
+ */
+uint32_t Tracer_Dump(tracer_begin_fn begin, tracer_write_fn write);
+
+#endif /* TRACER_H */
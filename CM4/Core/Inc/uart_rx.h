@@ -0,0 +1,54 @@
+/* USART3 reception: circular DMA with idle-line events, fanned out to the byte consumers. */
+#ifndef UART_RX_H
+#define UART_RX_H
+
+#include "main.h"
+
+// DMA1 stream 2 fills the ring without end; the half, full and idle-line
+// events hand the new bytes to weights_rx.c, and those outside a weights blob
+// to the trace command matcher, the link decoder (secure_uart.c) and the CFG
+// command lines (app_tasks.c). 512 bytes are 2.5 ms at 2 Mbaud, the half
+// event leaves the interrupt 1.2 ms to run.
+#define UART_RX_RING_LEN          (512U)
+
+typedef struct {
+  uint32_t bytes;      // Handed to the consumers
+  uint32_t events;     // Half, full and idle-line events
+  uint32_t errors;     // Framing or noise, reception went on
+  uint32_t restarts;   // Overrun or DMA error: the stream was re-armed
+} uart_rx_stats_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Starts the endless DMA reception. Call after LowPower_Init().
+ * @param huart USART3, with its RX DMA linked (stm32h7xx_hal_msp.c).
+ * @retval HAL status of the reception request.
+ */
+HAL_StatusTypeDef UartRx_Start(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Call from HAL_UARTEx_RxEventCallback().
+ * @param pos Ring write index reported by the HAL (1..UART_RX_RING_LEN).
+ */
+void UartRx_Event(UART_HandleTypeDef *huart, uint16_t pos);
+
+/**
+ * @brief Call from HAL_UART_ErrorCallback(); re-arms the stream if the error
+ * stopped it. A weights blob cut by the lost bytes is dropped.
+ */
+void UartRx_Error(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Re-arms reception after the UART was reprogrammed (link rate
+ * switch, secure_uart.c). A blob cut short by the switch is dropped.
+ */
+HAL_StatusTypeDef UartRx_Resume(void);
+
+/**
+ * @brief Copies the counters.
+ */
+void UartRx_GetStats(uart_rx_stats_t *out);
+
+#endif /* UART_RX_H */
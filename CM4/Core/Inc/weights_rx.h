@@ -0,0 +1,34 @@
+/* Receives weights blobs on the ESP32/debug UART and stages them for the CM7. */
+#ifndef WEIGHTS_RX_H
+#define WEIGHTS_RX_H
+
+#include "main.h"
+#include "weights_blob.h"
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Clears the shared staging area and the loader. Called by UartRx_Start().
+ */
+void WeightsRx_Init(void);
+
+/**
+ * @brief Feeds one received byte (uart_rx.c, interrupt context). Once a
+ * complete blob passed its CRC checks, hands it to the CM7 through HSEM_ID_WEIGHTS.
+ * @retval 1 if the byte was outside a blob and is meant for the other
+ * consumers of the line, 0 if it was blob payload.
+ */
+uint8_t WeightsRx_Feed(uint8_t byte);
+
+/**
+ * @brief Drops a blob cut short by lost bytes or a UART reprogramming.
+ */
+void WeightsRx_Abort(void);
+
+/**
+ * @brief Loader state and error counters, for diagnostics.
+ */
+const wblob_loader_t *WeightsRx_GetLoader(void);
+
+#endif /* WEIGHTS_RX_H */
@@ -0,0 +1,105 @@
+/* AES-128 with a cached key schedule and T-table rounds. See aes_fast.h. */
+
+#include "aes_fast.h"
+
+static const uint8_t kSbox[256] = {
+  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint8_t kRcon[AES_FAST_ROUNDS] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+// Te[x] = { 2*S[x], S[x], S[x], 3*S[x] }, MixColumns of one S-box output
+static uint32_t s_te[256];
+static uint8_t s_te_ready = 0;
+
+#define ROR32(x_, n_)  (((x_) >> (n_)) | ((x_) << (32U - (n_))))
+
+static uint32_t load_be32(const uint8_t *p)
+{
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void store_be32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >> 24);
+  p[1] = (uint8_t)(v >> 16);
+  p[2] = (uint8_t)(v >> 8);
+  p[3] = (uint8_t)v;
+}
+
+static void te_build(void)
+{
+  for (uint32_t x = 0; x < 256U; x++) {
+    uint32_t s = kSbox[x];
+    uint32_t s2 = ((s << 1) ^ ((s & 0x80U) ? 0x1BU : 0U)) & 0xFFU;
+    s_te[x] = (s2 << 24) | (s << 16) | (s << 8) | (s2 ^ s);
+  }
+  s_te_ready = 1;
+}
+
+static uint32_t sub_word(uint32_t w)
+{
+  return ((uint32_t)kSbox[w >> 24] << 24) | ((uint32_t)kSbox[(w >> 16) & 0xFFU] << 16) |
+         ((uint32_t)kSbox[(w >> 8) & 0xFFU] << 8) | (uint32_t)kSbox[w & 0xFFU];
+}
+
+void AesFast_KeyInit(aes_fast_key_t *key, const uint8_t k[16])
+{
+  if (!s_te_ready) te_build();
+
+  for (uint32_t i = 0; i < 4U; i++) key->rk[i] = load_be32(&k[4U * i]);
+  for (uint32_t i = 4; i < 4U * (AES_FAST_ROUNDS + 1U); i++) {
+    uint32_t t = key->rk[i - 1U];
+    if ((i & 3U) == 0U) t = sub_word((t << 8) | (t >> 24)) ^ ((uint32_t)kRcon[(i / 4U) - 1U] << 24);
+    key->rk[i] = key->rk[i - 4U] ^ t;
+  }
+}
+
+void AesFast_EncryptBlock(const aes_fast_key_t *key, const uint8_t in[16], uint8_t out[16])
+{
+  const uint32_t *rk = key->rk;
+  uint32_t s0 = load_be32(&in[0]) ^ rk[0];
+  uint32_t s1 = load_be32(&in[4]) ^ rk[1];
+  uint32_t s2 = load_be32(&in[8]) ^ rk[2];
+  uint32_t s3 = load_be32(&in[12]) ^ rk[3];
+
+  // SubBytes + ShiftRows + MixColumns + AddRoundKey: one lookup per byte
+  for (uint32_t r = 1; r < AES_FAST_ROUNDS; r++) {
+    rk += 4;
+    uint32_t t0 = s_te[s0 >> 24] ^ ROR32(s_te[(s1 >> 16) & 0xFFU], 8) ^
+                  ROR32(s_te[(s2 >> 8) & 0xFFU], 16) ^ ROR32(s_te[s3 & 0xFFU], 24) ^ rk[0];
+    uint32_t t1 = s_te[s1 >> 24] ^ ROR32(s_te[(s2 >> 16) & 0xFFU], 8) ^
+                  ROR32(s_te[(s3 >> 8) & 0xFFU], 16) ^ ROR32(s_te[s0 & 0xFFU], 24) ^ rk[1];
+    uint32_t t2 = s_te[s2 >> 24] ^ ROR32(s_te[(s3 >> 16) & 0xFFU], 8) ^
+                  ROR32(s_te[(s0 >> 8) & 0xFFU], 16) ^ ROR32(s_te[s1 & 0xFFU], 24) ^ rk[2];
+    uint32_t t3 = s_te[s3 >> 24] ^ ROR32(s_te[(s0 >> 16) & 0xFFU], 8) ^
+                  ROR32(s_te[(s1 >> 8) & 0xFFU], 16) ^ ROR32(s_te[s2 & 0xFFU], 24) ^ rk[3];
+    s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+  }
+
+  // Last round has no MixColumns
+  rk += 4;
+  store_be32(&out[0],  (((uint32_t)kSbox[s0 >> 24] << 24) | ((uint32_t)kSbox[(s1 >> 16) & 0xFFU] << 16) |
+                        ((uint32_t)kSbox[(s2 >> 8) & 0xFFU] << 8) | kSbox[s3 & 0xFFU]) ^ rk[0]);
+  store_be32(&out[4],  (((uint32_t)kSbox[s1 >> 24] << 24) | ((uint32_t)kSbox[(s2 >> 16) & 0xFFU] << 16) |
+                        ((uint32_t)kSbox[(s3 >> 8) & 0xFFU] << 8) | kSbox[s0 & 0xFFU]) ^ rk[1]);
+  store_be32(&out[8],  (((uint32_t)kSbox[s2 >> 24] << 24) | ((uint32_t)kSbox[(s3 >> 16) & 0xFFU] << 16) |
+                        ((uint32_t)kSbox[(s0 >> 8) & 0xFFU] << 8) | kSbox[s1 & 0xFFU]) ^ rk[2]);
+  store_be32(&out[12], (((uint32_t)kSbox[s3 >> 24] << 24) | ((uint32_t)kSbox[(s0 >> 16) & 0xFFU] << 16) |
+                        ((uint32_t)kSbox[(s1 >> 8) & 0xFFU] << 8) | kSbox[s2 & 0xFFU]) ^ rk[3]);
+}
@@ -0,0 +1,242 @@
+/* AES-128-GCM with precomputed per-frame keystream. See aes_gcm.h. */
+
+#include "aes_gcm.h"
+#include <string.h>
+
+// Reduction of the four bits shifted out of a GHASH nibble step
+static const uint16_t kLast4[16] = {
+  0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+  0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+};
+
+static uint64_t load_be64(const uint8_t *p)
+{
+  uint64_t v = 0;
+  for (uint32_t i = 0; i < 8U; i++) v = (v << 8) | p[i];
+  return v;
+}
+
+static void store_be64(uint8_t *p, uint64_t v)
+{
+  for (uint32_t i = 0; i < 8U; i++) p[i] = (uint8_t)(v >> (56U - 8U * i));
+}
+
+// Shoup's 4-bit tables: hl/hh[i] = i * H in GF(2^128), bit-reflected
+static void ghash_tables(aes_gcm_t *ctx, const uint8_t h[16])
+{
+  uint64_t vh = load_be64(&h[0]);
+  uint64_t vl = load_be64(&h[8]);
+
+  ctx->hh[0] = 0;
+  ctx->hl[0] = 0;
+  ctx->hh[8] = vh;
+  ctx->hl[8] = vl;
+  for (uint32_t i = 4; i > 0U; i >>= 1) {
+    uint64_t t = (vl & 1U) ? 0xE100000000000000ULL : 0U;
+    vl = (vh << 63) | (vl >> 1);
+    vh = (vh >> 1) ^ t;
+    ctx->hh[i] = vh;
+    ctx->hl[i] = vl;
+  }
+  for (uint32_t i = 2; i <= 8U; i <<= 1) {
+    for (uint32_t j = 1; j < i; j++) {
+      ctx->hh[i + j] = ctx->hh[i] ^ ctx->hh[j];
+      ctx->hl[i + j] = ctx->hl[i] ^ ctx->hl[j];
+    }
+  }
+}
+
+// x = x * H
+static void ghash_mult(const aes_gcm_t *ctx, uint8_t x[16])
+{
+  uint8_t lo = x[15] & 0x0FU;
+  uint64_t zh = ctx->hh[lo];
+  uint64_t zl = ctx->hl[lo];
+
+  for (int i = 15; i >= 0; i--) {
+    lo = x[i] & 0x0FU;
+    uint8_t hi = (uint8_t)(x[i] >> 4);
+    uint8_t rem;
+
+    if (i != 15) {
+      rem = (uint8_t)(zl & 0x0FU);
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ ((uint64_t)kLast4[rem] << 48);
+      zh ^= ctx->hh[lo];
+      zl ^= ctx->hl[lo];
+    }
+    rem = (uint8_t)(zl & 0x0FU);
+    zl = (zh << 60) | (zl >> 4);
+    zh = (zh >> 4) ^ ((uint64_t)kLast4[rem] << 48);
+    zh ^= ctx->hh[hi];
+    zl ^= ctx->hl[hi];
+  }
+  store_be64(&x[0], zh);
+  store_be64(&x[8], zl);
+}
+
+// Absorbs len bytes, the last block zero-padded
+static void ghash_update(const aes_gcm_t *ctx, uint8_t x[16], const uint8_t *data, size_t len)
+{
+  while (len > 0U) {
+    size_t n = (len < AES_FAST_BLOCKLEN) ? len : AES_FAST_BLOCKLEN;
+    for (size_t k = 0; k < n; k++) x[k] ^= data[k];
+    ghash_mult(ctx, x);
+    data += n;
+    len -= n;
+  }
+}
+
+static void ghash_final(const aes_gcm_t *ctx, uint8_t x[16], size_t aad_len, size_t len)
+{
+  uint8_t lens[16];
+  store_be64(&lens[0], (uint64_t)aad_len * 8U);
+  store_be64(&lens[8], (uint64_t)len * 8U);
+  ghash_update(ctx, x, lens, sizeof(lens));
+}
+
+// E(prefix || frame || 1 + index): index 0 masks the tag, 1.. encrypt the data
+static void keystream_block(const aes_gcm_t *ctx, uint32_t frame, uint32_t index, uint8_t out[16])
+{
+  uint8_t block[AES_FAST_BLOCKLEN];
+  uint32_t ctr = index + 1U;
+
+  memcpy(block, ctx->prefix, AES_GCM_PREFIX_LEN);
+  block[8] = (uint8_t)(frame >> 24);
+  block[9] = (uint8_t)(frame >> 16);
+  block[10] = (uint8_t)(frame >> 8);
+  block[11] = (uint8_t)frame;
+  block[12] = (uint8_t)(ctr >> 24);
+  block[13] = (uint8_t)(ctr >> 16);
+  block[14] = (uint8_t)(ctr >> 8);
+  block[15] = (uint8_t)ctr;
+  AesFast_EncryptBlock(&ctx->key, block, out);
+}
+
+static void xor_block(uint8_t *p, const uint8_t *ks, size_t n)
+{
+  if (n == AES_FAST_BLOCKLEN) {
+    uint32_t w[4], x[4];
+    memcpy(w, p, sizeof(w));
+    memcpy(x, ks, sizeof(x));
+    w[0] ^= x[0]; w[1] ^= x[1]; w[2] ^= x[2]; w[3] ^= x[3];
+    memcpy(p, w, sizeof(w));
+  } else {
+    for (size_t k = 0; k < n; k++) p[k] ^= ks[k];
+  }
+}
+
+void AesGcm_Init(aes_gcm_t *ctx, const uint8_t key[16], const uint8_t prefix[AES_GCM_PREFIX_LEN],
+                 uint32_t first_frame)
+{
+  uint8_t h[AES_FAST_BLOCKLEN] = { 0 };
+
+  memset(ctx, 0, sizeof(*ctx));
+  AesFast_KeyInit(&ctx->key, key);
+  AesFast_EncryptBlock(&ctx->key, h, h);
+  ghash_tables(ctx, h);
+  memcpy(ctx->prefix, prefix, AES_GCM_PREFIX_LEN);
+  ctx->tail = first_frame;
+  for (uint32_t i = 0; i < AES_GCM_KS_FRAMES; i++) ctx->ks[i].frame = first_frame - 1U - i;  // Not a live frame
+}
+
+/*
+ * Single producer (refill), single consumer (seal). The producer only fills
+ * slots of frames in [tail, tail + AES_GCM_KS_FRAMES) as it last read tail,
+ * and only blocks at or above the slot's ready count; the sealer only reads
+ * the slot of its own frame, below the ready count it read. A slot is
+ * re-targeted only once the sealer is past its previous frame, since tail
+ * only moves forward. The refiller must run at a lower priority than the
+ * sealer so a seal is never interleaved with a refill step.
+ */
+uint32_t AesGcm_Refill(aes_gcm_t *ctx, uint32_t max_blocks)
+{
+  uint32_t n = 0;
+
+  for (uint32_t ahead = 0; ahead < AES_GCM_KS_FRAMES && n < max_blocks; ahead++) {
+    uint32_t frame = __atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE) + ahead;
+    aes_gcm_ks_t *slot = &ctx->ks[frame % AES_GCM_KS_FRAMES];
+
+    if (__atomic_load_n(&slot->frame, __ATOMIC_RELAXED) != frame) {
+      __atomic_store_n(&slot->ready, 0U, __ATOMIC_RELAXED);
+      __atomic_store_n(&slot->frame, frame, __ATOMIC_RELEASE);
+    }
+    uint32_t ready = slot->ready;
+    while (ready < 1U + AES_GCM_KS_BLOCKS && n < max_blocks) {
+      keystream_block(ctx, frame, ready, slot->ks[ready]);
+      ready++;
+      n++;
+      __atomic_store_n(&slot->ready, ready, __ATOMIC_RELEASE);
+      // The sealer moved on: this slot may belong to another frame now
+      if ((int32_t)(__atomic_load_n(&ctx->tail, __ATOMIC_ACQUIRE) - frame) > 0) break;
+    }
+  }
+  return n;
+}
+
+void AesGcm_Seal(aes_gcm_t *ctx, uint32_t frame, const uint8_t *aad, size_t aad_len,
+                 uint8_t *buf, size_t len, uint8_t tag[AES_GCM_TAG_LEN])
+{
+  const aes_gcm_ks_t *slot = &ctx->ks[frame % AES_GCM_KS_FRAMES];
+  uint32_t nblocks = (uint32_t)((len + AES_FAST_BLOCKLEN - 1U) / AES_FAST_BLOCKLEN);
+  uint32_t cached = 0;
+  uint8_t fresh[AES_FAST_BLOCKLEN];
+  uint8_t x[AES_FAST_BLOCKLEN] = { 0 };
+
+  // Release the slots of older frames, then see what is ready for this one
+  if ((int32_t)(frame - ctx->tail) > 0) __atomic_store_n(&ctx->tail, frame, __ATOMIC_RELEASE);
+  if (frame == ctx->tail && __atomic_load_n(&slot->frame, __ATOMIC_ACQUIRE) == frame) {
+    cached = __atomic_load_n(&slot->ready, __ATOMIC_ACQUIRE);
+  }
+
+  for (uint32_t i = 1; i <= nblocks; i++) {
+    size_t off = (size_t)(i - 1U) * AES_FAST_BLOCKLEN;
+    size_t n = (len - off < AES_FAST_BLOCKLEN) ? len - off : AES_FAST_BLOCKLEN;
+    const uint8_t *ks = fresh;
+    if (i < cached) {
+      ks = slot->ks[i];
+      ctx->hits++;
+    } else {
+      keystream_block(ctx, frame, i, fresh);
+      ctx->misses++;
+    }
+    xor_block(&buf[off], ks, n);
+  }
+
+  ghash_update(ctx, x, aad, aad_len);
+  ghash_update(ctx, x, buf, len);
+  ghash_final(ctx, x, aad_len, len);
+  if (cached > 0U) {
+    memcpy(fresh, slot->ks[0], sizeof(fresh));
+    ctx->hits++;
+  } else {
+    keystream_block(ctx, frame, 0U, fresh);
+    ctx->misses++;
+  }
+  for (uint32_t k = 0; k < AES_GCM_TAG_LEN; k++) tag[k] = x[k] ^ fresh[k];
+
+  // The next frame may now take over this slot
+  __atomic_store_n(&ctx->tail, frame + 1U, __ATOMIC_RELEASE);
+}
+
+uint8_t AesGcm_Open(const aes_gcm_t *ctx, uint32_t frame, const uint8_t *aad, size_t aad_len,
+                    uint8_t *buf, size_t len, const uint8_t tag[AES_GCM_TAG_LEN])
+{
+  uint8_t x[AES_FAST_BLOCKLEN] = { 0 };
+  uint8_t ks[AES_FAST_BLOCKLEN];
+  uint8_t diff = 0;
+
+  ghash_update(ctx, x, aad, aad_len);
+  ghash_update(ctx, x, buf, len);
+  ghash_final(ctx, x, aad_len, len);
+  keystream_block(ctx, frame, 0U, ks);
+  for (uint32_t k = 0; k < AES_GCM_TAG_LEN; k++) diff |= (uint8_t)(tag[k] ^ x[k] ^ ks[k]);
+  if (diff != 0U) return 0;
+
+  for (size_t off = 0; off < len; off += AES_FAST_BLOCKLEN) {
+    size_t n = (len - off < AES_FAST_BLOCKLEN) ? len - off : AES_FAST_BLOCKLEN;
+    keystream_block(ctx, frame, (uint32_t)(off / AES_FAST_BLOCKLEN) + 1U, ks);
+    xor_block(&buf[off], ks, n);
+  }
+  return 1;
+}
@@ -0,0 +1,816 @@
+/* CM4 application tasks: acquisition, DSP, IPC publisher, telemetry. See app_tasks.h. */
+
+#include "app_tasks.h"
+#include "cmsis_os.h"
+#include "dlog.h"
+#include "ipc_shared.h"
+#include "lowpower.h"
+#include "max30100_for_stm32_hal.h"
+#include "ppg_dsp.h"
+#include "rtos_health.h"
+#include "runtime_stats.h"
+#include "secure_uart.h"
+#include "telemetry_proto.h"
+#include "tracer.h"
+#include "uart_rx.h"
+#include "vest_config.h"
+#include <stdio.h>
+#include <string.h>
+
+#define APP_FLAG_SENSOR_INT   (1UL << 0)  // MAX30100 INT fired
+#define APP_FLAG_DIE_TEMP     (1UL << 1)  // Start a die temperature conversion
+#define APP_FLAG_CONFIG       (1UL << 2)  // CFG command waiting in s_cmd
+
+#define APP_PPG_QUEUE_LEN     (4U)
+#define APP_RESULT_QUEUE_LEN  (2U)
+#define APP_TLM_QUEUE_LEN     (8U)
+#define APP_PPG_WINDOW_MAX    (MAX30100_SAMPLES_PER_READ * APP_PPG_WINDOW_BLOCKS_MAX)
+
+// Stack depths in words; tune them with the HEALTH report watermarks
+#define APP_ACQ_STACK_WORDS   (256U)
+#define APP_DSP_STACK_WORDS   (192U)
+#define APP_IPC_STACK_WORDS   (256U)
+#define APP_TLM_STACK_WORDS   (640U)  // snprintf, sealed body and COBS scratch
+#define APP_TASK_COUNT        (4U)
+
+typedef struct {
+  uint32_t tick;
+  uint16_t rate_hz;   // Sample rate the block was taken at
+  uint8_t  cfg_gen;   // Sensor settings generation, a change restarts the window
+  uint16_t ir[MAX30100_SAMPLES_PER_READ];
+  uint16_t red[MAX30100_SAMPLES_PER_READ];
+} ppg_block_t;
+
+typedef enum {
+  TLM_PPG = 0,
+  TLM_LM35,
+  TLM_DIE_TEMP,
+  TLM_AI_EVENT,
+  TLM_HEALTH,    // No payload, the telemetry task takes the snapshots
+  TLM_TRACE_DUMP,  // No payload, the ring is written raw (tracer.h)
+  TLM_CONFIG,    // Answer to a CFG command, or the boot settings
+} tlm_kind_t;
+
+// Values travel in binary; records are built in the telemetry task only
+typedef struct {
+  uint8_t kind;  // tlm_kind_t
+  uint32_t tick; // Set by tlm_post(), the record timestamp
+  union {
+    ppg_result_t ppg;
+    struct {
+      float    celsius;
+      uint32_t raw;
+    } lm35;
+    float      die_celsius;
+    ai_event_t event;
+    struct {
+      vest_config_t cfg;  // In force when the answer was posted
+      uint16_t      id;
+      uint8_t       status;
+    } config;
+  } u;
+} telemetry_msg_t;
+
+/* Static RTOS objects -------------------------------------------------------*/
+// Stack, control block and attributes of one task; nothing comes from the FreeRTOS heap
+#define APP_STATIC_THREAD(name_, words_, prio_)                                           \
+  _Static_assert((words_) >= configMINIMAL_STACK_SIZE, #name_ " stack below minimum");    \
+  static uint32_t name_##TaskBuffer[words_];                                              \
+  static StaticTask_t name_##TaskControlBlock;                                            \
+  static const osThreadAttr_t name_##Task_attributes = {                                  \
+    .name = #name_,                                                                       \
+    .cb_mem = &name_##TaskControlBlock,                                                   \
+    .cb_size = sizeof(name_##TaskControlBlock),                                           \
+    .stack_mem = &name_##TaskBuffer[0],                                                   \
+    .stack_size = sizeof(name_##TaskBuffer),                                              \
+    .priority = (osPriority_t) (prio_),                                                   \
+  }
+
+// Storage, control block and attributes of one message queue
+#define APP_STATIC_QUEUE(name_, len_, type_)                                              \
+  _Static_assert((len_) > 0, #name_ " queue is empty");                                   \
+  static uint8_t name_##QueueBuffer[(len_) * sizeof(type_)];                              \
+  static StaticQueue_t name_##QueueControlBlock;                                          \
+  static const osMessageQueueAttr_t name_##Queue_attributes = {                           \
+    .name = #name_,                                                                       \
+    .cb_mem = &name_##QueueControlBlock,                                                  \
+    .cb_size = sizeof(name_##QueueControlBlock),                                          \
+    .mq_mem = &name_##QueueBuffer,                                                        \
+    .mq_size = sizeof(name_##QueueBuffer),                                                \
+  }
+
+APP_STATIC_THREAD(acq, APP_ACQ_STACK_WORDS, osPriorityHigh);
+APP_STATIC_THREAD(dsp, APP_DSP_STACK_WORDS, osPriorityAboveNormal);
+APP_STATIC_THREAD(ipc, APP_IPC_STACK_WORDS, osPriorityNormal);
+APP_STATIC_THREAD(telemetry, APP_TLM_STACK_WORDS, osPriorityBelowNormal);
+
+APP_STATIC_QUEUE(ppg, APP_PPG_QUEUE_LEN, ppg_block_t);
+APP_STATIC_QUEUE(result, APP_RESULT_QUEUE_LEN, ppg_result_t);
+APP_STATIC_QUEUE(tlm, APP_TLM_QUEUE_LEN, telemetry_msg_t);
+
+// Every task must fit in one health report: ours, defaultTask, idle and timer
+_Static_assert(APP_TASK_COUNT + 3U <= RTOS_HEALTH_MAX_TASKS, "health report cannot list every task");
+_Static_assert(APP_TASK_COUNT + 3U <= RUNTIME_STATS_MAX_TASKS, "load frame cannot list every task");
+_Static_assert(APP_TASK_COUNT + 3U <= TRACER_MAX_TASKS, "trace dump cannot name every task");
+_Static_assert(sizeof(telemetry_msg_t) <= 64U, "telemetry_msg_t grew, check APP_TLM_QUEUE_LEN");
+// Shared D2 SRAM map
+_Static_assert(sizeof(sensor_mailbox_t) <= SHARED_EVENTS_ADDR - SHARED_MAILBOX_ADDR, "mailbox overlaps event ring");
+_Static_assert(sizeof(ai_event_ring_t) <= SHARED_HEALTH_ADDR - SHARED_EVENTS_ADDR, "event ring overlaps health slot");
+_Static_assert(sizeof(rtos_health_t) <= SHARED_HEALTH_SIZE, "rtos_health_t does not fit its slot");
+_Static_assert(SHARED_HEALTH_ADDR + SHARED_HEALTH_SIZE <= SHARED_RUNTIME_ADDR, "health slot overlaps run-time stats");
+_Static_assert(sizeof(rt_stats_slot_t) <= SHARED_RUNTIME_SIZE, "rt_stats_slot_t does not fit its slot");
+
+static I2C_HandleTypeDef *s_hi2c;
+static ADC_HandleTypeDef *s_hadc;
+static UART_HandleTypeDef *s_huart;
+
+static osThreadId_t s_acq_thread;
+static osThreadId_t s_dsp_thread;
+static osThreadId_t s_ipc_thread;
+static osThreadId_t s_tlm_thread;
+static osMessageQueueId_t s_ppg_queue;
+static osMessageQueueId_t s_result_queue;
+static osMessageQueueId_t s_tlm_queue;
+
+static app_stats_t s_stats;
+
+// Written by the acquisition task only; whole copies through config_get(),
+// single fields (ai, report_ms) are read directly
+static vest_config_t s_cfg;
+// USART3 RX interrupt -> acquisition task, one command at a time
+static vest_line_t s_cmd_line;
+static vest_cmd_t s_cmd;
+static volatile uint8_t s_cmd_busy;
+
+static volatile sensor_mailbox_t *const s_mailbox = (sensor_mailbox_t *)SHARED_MAILBOX_ADDR;
+static ai_event_ring_t *const s_event_ring = (ai_event_ring_t *)SHARED_EVENTS_ADDR;
+static const volatile rtos_health_t *const s_cm7_health = (rtos_health_t *)SHARED_HEALTH_ADDR;
+static const volatile rt_stats_slot_t *const s_cm7_runtime = (rt_stats_slot_t *)SHARED_RUNTIME_ADDR;
+
+static void AcqTask(void *argument);
+static void DspTask(void *argument);
+static void IpcTask(void *argument);
+static void TelemetryTask(void *argument);
+
+static void tlm_post(telemetry_msg_t *msg)
+{
+  msg->tick = osKernelGetTickCount();
+  if (osMessageQueuePut(s_tlm_queue, msg, 0, 0) != osOK) {
+    s_stats.telemetry_drops++;
+    TRACE_EVENT(TRACE_EV_QUEUE_DROP, TRACE_QUEUE_TELEMETRY, 0U);
+  }
+}
+
+static void config_get(vest_config_t *out)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *out = s_cfg;
+  __set_PRIMASK(primask);
+}
+
+static void config_set(const vest_config_t *cfg)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  s_cfg = *cfg;
+  __set_PRIMASK(primask);
+}
+
+// Any context: the telemetry task answers with a TP_REC_CONFIG record
+static void tlm_post_config(uint16_t id, uint8_t status)
+{
+  telemetry_msg_t msg;
+  msg.kind = TLM_CONFIG;
+  config_get(&msg.u.config.cfg);
+  msg.u.config.id = id;
+  msg.u.config.status = status;
+  if (status == VEST_CFG_OK) {
+    s_stats.commands++;
+  } else {
+    s_stats.command_errors++;
+  }
+  tlm_post(&msg);
+}
+
+// USART3 RX interrupt, "TRC?" received
+static void tlm_request_trace_dump(void)
+{
+  telemetry_msg_t msg;
+  msg.kind = TLM_TRACE_DUMP;
+  tlm_post(&msg);
+}
+
+HAL_StatusTypeDef AppTasks_Init(I2C_HandleTypeDef *hi2c, ADC_HandleTypeDef *hadc, UART_HandleTypeDef *huart)
+{
+  s_hi2c = hi2c;
+  s_hadc = hadc;
+  s_huart = huart;
+  secure_uart_init(huart);
+  Tracer_Init(tlm_request_trace_dump);
+  memset(&s_stats, 0, sizeof(s_stats));
+  VestCfg_Defaults(&s_cfg);
+
+  s_ppg_queue = osMessageQueueNew(APP_PPG_QUEUE_LEN, sizeof(ppg_block_t), &ppgQueue_attributes);
+  s_result_queue = osMessageQueueNew(APP_RESULT_QUEUE_LEN, sizeof(ppg_result_t), &resultQueue_attributes);
+  s_tlm_queue = osMessageQueueNew(APP_TLM_QUEUE_LEN, sizeof(telemetry_msg_t), &tlmQueue_attributes);
+  if (s_ppg_queue == NULL || s_result_queue == NULL || s_tlm_queue == NULL) return HAL_ERROR;
+
+  s_acq_thread = osThreadNew(AcqTask, NULL, &acqTask_attributes);
+  s_dsp_thread = osThreadNew(DspTask, NULL, &dspTask_attributes);
+  s_ipc_thread = osThreadNew(IpcTask, NULL, &ipcTask_attributes);
+  s_tlm_thread = osThreadNew(TelemetryTask, NULL, &telemetryTask_attributes);
+  if (s_acq_thread == NULL || s_dsp_thread == NULL || s_ipc_thread == NULL || s_tlm_thread == NULL) {
+    return HAL_ERROR;
+  }
+  return HAL_OK;
+}
+
+void AppTasks_SensorIrq(void)
+{
+  // EXTI priority 5 is within configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+  if (s_acq_thread != NULL) {
+    osThreadFlagsSet(s_acq_thread, APP_FLAG_SENSOR_INT);
+  }
+}
+
+void AppTasks_CommandByte(uint8_t byte)
+{
+  vest_cmd_t cmd;
+
+  if (VestCfg_LineFeed(&s_cmd_line, byte) == 0U) return;
+  int st = VestCfg_Parse(s_cmd_line.buf, &cmd);
+  if (st < 0 || s_acq_thread == NULL) return;
+
+  // Malformed commands and commands arriving mid-apply are answered from here
+  if (st != VEST_CFG_OK) {
+    tlm_post_config(cmd.id, (uint8_t)st);
+  } else if (s_cmd_busy) {
+    tlm_post_config(cmd.id, VEST_CFG_ERR_BUSY);
+  } else {
+    s_cmd = cmd;
+    s_cmd_busy = 1;
+    osThreadFlagsSet(s_acq_thread, APP_FLAG_CONFIG);
+  }
+}
+
+const app_stats_t *AppTasks_GetStats(void)
+{
+  return &s_stats;
+}
+
+void AppTasks_ReportHealth(void)
+{
+  telemetry_msg_t msg;
+  msg.kind = TLM_HEALTH;
+  tlm_post(&msg);
+}
+
+/* Acquisition ---------------------------------------------------------------*/
+// Sole user of I2C1. Moves FIFO blocks out of the sensor and applies CFG commands.
+
+// Programs the sensor while it is shut down, so no sample mixes old and new settings
+static HAL_StatusTypeDef sensor_configure(const vest_config_t *cfg)
+{
+  MAX30100_OperatingMode mode = (cfg->dsp == VEST_DSP_HR) ? MAX30100_MODE_HRONLY_EN : MAX30100_MODE_SPO2_EN;
+
+  if (MAX30100_Shutdown() != HAL_OK) return HAL_ERROR;
+  if (cfg->dsp == VEST_DSP_OFF) return HAL_OK;
+  if (MAX30100_SetSpO2SampleRate((MAX30100_SpO2SampleRate)VestCfg_RateCode(cfg->rate_hz)) != HAL_OK ||
+      MAX30100_SetLedPulseWidth((MAX30100_LedPulseWidth)VestCfg_PulseWidthCode(cfg->pw_us)) != HAL_OK ||
+      MAX30100_SetLedCurrents((MAX30100_LedCurrent)cfg->led_red, (MAX30100_LedCurrent)cfg->led_ir) != HAL_OK ||
+      MAX30100_SetMode(mode) != HAL_OK || MAX30100_ClearFIFO() != HAL_OK) {
+    return HAL_ERROR;
+  }
+  max30100_new_data_available = 0;
+  return MAX30100_WakeUp();
+}
+
+// Applies s_cmd whole or not at all
+static uint8_t config_apply(uint8_t *gen)
+{
+  vest_config_t cur, next;
+
+  config_get(&cur);
+  uint8_t st = VestCfg_Merge(&cur, &s_cmd, &next);
+  if (st != VEST_CFG_OK) return st;
+
+  // REPORT and AI alone leave the sensor and the DSP window alone
+  if (next.rate_hz != cur.rate_hz || next.pw_us != cur.pw_us || next.led_ir != cur.led_ir ||
+      next.led_red != cur.led_red || next.dsp != cur.dsp) {
+    if (sensor_configure(&next) != HAL_OK) {
+      sensor_configure(&cur);
+      return VEST_CFG_ERR_SENSOR;
+    }
+    (*gen)++;
+  }
+  config_set(&next);
+  return VEST_CFG_OK;
+}
+
+static void AcqTask(void *argument)
+{
+  (void)argument;
+  ppg_block_t block;
+  telemetry_msg_t msg;
+  vest_config_t cfg;
+  uint8_t gen = 0;
+
+  while (MAX30100_Init(s_hi2c) != HAL_OK || MAX30100_SetMode(MAX30100_MODE_SPO2_EN) != HAL_OK) {
+    s_stats.sensor_errors++;
+    DLOG1(SENSOR_INIT_FAIL, s_stats.sensor_errors);
+    osDelay(1000);
+  }
+  DLOG0(SENSOR_READY);
+  tlm_post_config(0, VEST_CFG_OK);
+
+  for (;;) {
+    // Shut down, the sensor raises no INT: nothing to watch
+    config_get(&cfg);
+    uint32_t timeout = (cfg.dsp == VEST_DSP_OFF) ? osWaitForever : APP_SENSOR_WATCHDOG_MS;
+    uint32_t flags = osThreadFlagsWait(APP_FLAG_SENSOR_INT | APP_FLAG_DIE_TEMP | APP_FLAG_CONFIG,
+                                       osFlagsWaitAny, timeout);
+    if (flags == (uint32_t)osFlagsErrorTimeout) {
+      // A missed edge leaves INT asserted until the status register is read
+      s_stats.sensor_timeouts++;
+      flags = APP_FLAG_SENSOR_INT;
+    } else if (flags & osFlagsError) {
+      continue;
+    }
+
+    if (flags & APP_FLAG_CONFIG) {
+      tlm_post_config(s_cmd.id, config_apply(&gen));
+      s_cmd_busy = 0;
+      config_get(&cfg);
+    }
+    // A conversion would bring the sensor out of shutdown
+    if ((flags & APP_FLAG_DIE_TEMP) && cfg.dsp != VEST_DSP_OFF) {
+      MAX30100_StartTemperature();
+    }
+    if (!(flags & APP_FLAG_SENSOR_INT) || cfg.dsp == VEST_DSP_OFF) continue;
+
+    MAX30100_InterruptHandler();
+
+    if (max30100_new_data_available) {
+      max30100_new_data_available = 0;
+      block.tick = osKernelGetTickCount();
+      block.rate_hz = cfg.rate_hz;
+      block.cfg_gen = gen;
+      memcpy(block.ir, max30100_ir_buffer, sizeof(block.ir));
+      memcpy(block.red, max30100_red_buffer, sizeof(block.red));
+      s_stats.ppg_blocks++;
+      if (osMessageQueuePut(s_ppg_queue, &block, 0, 0) != osOK) {
+        s_stats.ppg_drops++;
+        TRACE_EVENT(TRACE_EV_QUEUE_DROP, TRACE_QUEUE_PPG, 0U);
+      }
+    }
+    if (max30100_new_temp_available) {
+      max30100_new_temp_available = 0;
+      msg.kind = TLM_DIE_TEMP;
+      msg.u.die_celsius = max30100_last_temperature;
+      tlm_post(&msg);
+    }
+  }
+}
+
+/* DSP -----------------------------------------------------------------------*/
+// Whole blocks closest to APP_PPG_WINDOW_MS at rate_hz: 4, 8, 13 or 16
+static uint32_t dsp_window_size(uint16_t rate_hz)
+{
+  const uint32_t block_units = MAX30100_SAMPLES_PER_READ * 1000U;
+  uint32_t blocks = ((uint32_t)rate_hz * APP_PPG_WINDOW_MS + block_units / 2U) / block_units;
+  if (blocks == 0U) blocks = 1U;
+  if (blocks > APP_PPG_WINDOW_BLOCKS_MAX) blocks = APP_PPG_WINDOW_BLOCKS_MAX;
+  return blocks * MAX30100_SAMPLES_PER_READ;
+}
+
+static void DspTask(void *argument)
+{
+  (void)argument;
+  static uint16_t ir_window[APP_PPG_WINDOW_MAX];
+  static uint16_t red_window[APP_PPG_WINDOW_MAX];
+  uint32_t fill = 0;
+  uint32_t size = 0;
+  uint16_t rate_hz = 0;
+  uint8_t gen = 0;
+  ppg_block_t block;
+  telemetry_msg_t msg;
+
+  for (;;) {
+    if (osMessageQueueGet(s_ppg_queue, &block, NULL, osWaitForever) != osOK) continue;
+
+    // New sensor settings: samples taken under the old ones are dropped
+    if (size == 0U || block.cfg_gen != gen || block.rate_hz != rate_hz) {
+      gen = block.cfg_gen;
+      rate_hz = block.rate_hz;
+      size = dsp_window_size(rate_hz);
+      fill = 0;
+    }
+
+    memcpy(&ir_window[fill], block.ir, sizeof(block.ir));
+    memcpy(&red_window[fill], block.red, sizeof(block.red));
+    fill += MAX30100_SAMPLES_PER_READ;
+    if (fill < size) continue;
+    fill = 0;
+
+    msg.kind = TLM_PPG;
+    PPG_Compute(ir_window, red_window, (uint16_t)size, (float)rate_hz, &msg.u.ppg);
+    s_stats.results++;
+
+    if (osMessageQueuePut(s_result_queue, &msg.u.ppg, 0, 0) != osOK) {
+      s_stats.result_drops++;
+      TRACE_EVENT(TRACE_EV_QUEUE_DROP, TRACE_QUEUE_RESULT, 0U);
+    }
+    tlm_post(&msg);
+  }
+}
+
+/* IPC publisher -------------------------------------------------------------*/
+// Reads the LM35 on ADC1, LM35: 10 mV/C on a 16-bit, 3.3 V converter
+static HAL_StatusTypeDef lm35_read(float *celsius, uint32_t *raw)
+{
+  const uint32_t num_samples = 32;
+  uint32_t adc_sum = 0;
+  uint32_t n = 0;
+
+  if (HAL_ADC_Start(s_hadc) != HAL_OK) return HAL_ERROR;
+  for (uint32_t i = 0; i < num_samples; i++) {
+    if (HAL_ADC_PollForConversion(s_hadc, 10) == HAL_OK) {
+      adc_sum += HAL_ADC_GetValue(s_hadc);
+      n++;
+    }
+  }
+  HAL_ADC_Stop(s_hadc);
+  if (n == 0) return HAL_TIMEOUT;
+
+  *raw = adc_sum / n;
+  *celsius = ((float)*raw * 3.3f / 65535.0f) * 100.0f;
+  return HAL_OK;
+}
+
+// Hands one feature frame to the CM7 (it invalidates its D-cache on the notification)
+static void mailbox_publish(const ppg_result_t *res, float temperature_c)
+{
+  s_mailbox->heart_rate_bpm = res->heart_rate_bpm;
+  s_mailbox->spo2_pct = res->spo2_pct;
+  s_mailbox->temperature_c = temperature_c;
+  s_mailbox->fatigue_score = APP_DEFAULT_FATIGUE;
+  s_mailbox->activity_code = APP_DEFAULT_ACTIVITY;
+  __DMB();
+  s_mailbox->seq = s_mailbox->seq + 1U;
+  s_mailbox->magic = SHARED_MAILBOX_MAGIC;
+  __DSB();
+
+  // Take + release raises the free interrupt on the CM7
+  if (HAL_HSEM_FastTake(HSEM_ID_MAILBOX) == HAL_OK) {
+    HAL_HSEM_Release(HSEM_ID_MAILBOX, 0);
+  }
+  s_stats.frames_published++;
+}
+
+// Moves alert events and summaries from the CM7 ring to the telemetry queue
+static void forward_ai_events(void)
+{
+  telemetry_msg_t msg;
+
+  if (s_event_ring->magic != SHARED_EVENTS_MAGIC) return;
+
+  msg.kind = TLM_AI_EVENT;
+  while (s_event_ring->tail != s_event_ring->head) {
+    msg.tick = osKernelGetTickCount();
+    msg.u.event = s_event_ring->events[s_event_ring->tail & (AI_EVENT_RING_LEN - 1U)];
+    // Leave the event in the ring while telemetry is backed up
+    if (osMessageQueuePut(s_tlm_queue, &msg, 0, 0) != osOK) break;
+    __DMB();
+    s_event_ring->tail++;
+  }
+}
+
+static void IpcTask(void *argument)
+{
+  (void)argument;
+  telemetry_msg_t msg;
+  ppg_result_t res;
+  float temperature_c = 0.0f;
+  uint32_t now = osKernelGetTickCount();
+  uint32_t next_lm35 = now;
+  uint32_t next_die = now + APP_DIE_TEMP_PERIOD_MS;
+
+  s_mailbox->magic = 0;
+  s_mailbox->seq = 0;
+
+  for (;;) {
+    if (osMessageQueueGet(s_result_queue, &res, NULL, APP_EVENT_POLL_MS) == osOK) {
+      // No finger on the sensor: nothing worth scoring; AI=0 keeps the CM7 out of it
+      if (s_cfg.ai && res.heart_rate_bpm > 0.0f && res.spo2_pct > 0.0f) {
+        mailbox_publish(&res, temperature_c);
+      }
+    }
+
+    now = osKernelGetTickCount();
+    if ((int32_t)(now - next_lm35) >= 0) {
+      next_lm35 = now + APP_LM35_PERIOD_MS;
+      msg.kind = TLM_LM35;
+      if (lm35_read(&msg.u.lm35.celsius, &msg.u.lm35.raw) == HAL_OK) {
+        temperature_c = msg.u.lm35.celsius;
+        tlm_post(&msg);
+      } else {
+        DLOG0(LM35_READ_FAIL);
+      }
+    }
+    if ((int32_t)(now - next_die) >= 0) {
+      next_die = now + APP_DIE_TEMP_PERIOD_MS;
+      osThreadFlagsSet(s_acq_thread, APP_FLAG_DIE_TEMP);
+    }
+
+    forward_ai_events();
+  }
+}
+
+/* Telemetry -----------------------------------------------------------------*/
+// Sole user of USART3 TX
+
+// Measurements go out as binary records (telemetry_proto.h), text stays for reports
+static size_t tlm_record(const telemetry_msg_t *msg, tp_record_t *rec)
+{
+  static uint8_t seq;
+  size_t len;
+
+  switch (msg->kind) {
+    case TLM_PPG: {
+      const ppg_result_t *p = &msg->u.ppg;
+      len = TlmProto_RecordInit(rec, TP_REC_PPG, seq, msg->tick);
+      rec->ppg.hr_x10 = TlmProto_ToU16(p->heart_rate_bpm, 10.0f);
+      rec->ppg.spo2_x10 = TlmProto_ToU16(p->spo2_pct, 10.0f);
+      rec->ppg.ratio_x1000 = TlmProto_ToU16(p->ratio, 1000.0f);
+      rec->ppg.pi_x100 = (p->dc_ir > 0.0f) ? TlmProto_ToU16(p->ac_ir / p->dc_ir, 10000.0f) : 0U;
+      rec->ppg.dc_ir = TlmProto_ToU16(p->dc_ir, 1.0f);
+      rec->ppg.dc_red = TlmProto_ToU16(p->dc_red, 1.0f);
+      rec->ppg.ac_ir = TlmProto_ToU16(p->ac_ir, 1.0f);
+      rec->ppg.ac_red = TlmProto_ToU16(p->ac_red, 1.0f);
+      rec->ppg.peaks = (uint8_t)((p->peaks < 0) ? 0 : (p->peaks > 255) ? 255 : p->peaks);
+      rec->ppg.flags = (uint8_t)(((p->spo2_pct > 0.0f) ? TP_PPG_FINGER : 0U) |
+                                 ((p->peaks >= 2) ? TP_PPG_HR_VALID : 0U));
+      break;
+    }
+    case TLM_LM35:
+      len = TlmProto_RecordInit(rec, TP_REC_TEMP, seq, msg->tick);
+      rec->temp.celsius_x100 = TlmProto_ToI16(msg->u.lm35.celsius, 100.0f);
+      rec->temp.source = TP_TEMP_LM35;
+      rec->temp.raw = msg->u.lm35.raw;
+      break;
+    case TLM_DIE_TEMP:
+      len = TlmProto_RecordInit(rec, TP_REC_TEMP, seq, msg->tick);
+      rec->temp.celsius_x100 = TlmProto_ToI16(msg->u.die_celsius, 100.0f);
+      rec->temp.source = TP_TEMP_MAX30100;
+      break;
+    case TLM_AI_EVENT: {
+      const ai_event_t *ev = &msg->u.event;
+      len = TlmProto_RecordInit(rec, TP_REC_EVENT, seq, msg->tick);
+      rec->event.event = ev->type;
+      rec->event.model = ev->model;
+      rec->event.alert_id = ev->alert_id;
+      rec->event.frame = ev->frame;
+      rec->event.score_x1000 = TlmProto_ToU16(ev->score, 1000.0f);
+      rec->event.peak_x1000 = TlmProto_ToU16(ev->peak, 1000.0f);
+      rec->event.duration = ev->duration;
+      rec->event.count = ev->count;
+      break;
+    }
+    case TLM_CONFIG: {
+      const vest_config_t *c = &msg->u.config.cfg;
+      len = TlmProto_RecordInit(rec, TP_REC_CONFIG, seq, msg->tick);
+      rec->config.cmd_id = msg->u.config.id;
+      rec->config.status = msg->u.config.status;
+      rec->config.dsp = c->dsp;
+      rec->config.rate_hz = c->rate_hz;
+      rec->config.pw_us = c->pw_us;
+      rec->config.led_ir = c->led_ir;
+      rec->config.led_red = c->led_red;
+      rec->config.ai = c->ai;
+      rec->config.report_ms = c->report_ms;
+      break;
+    }
+    default:
+      return 0;
+  }
+  seq++;
+  return len;
+}
+
+static void tlm_send_record(const telemetry_msg_t *msg)
+{
+  tp_record_t rec;
+  size_t len = tlm_record(msg, &rec);
+
+  if (len == 0U) return;
+  secure_uart_send((const uint8_t *)&rec, (uint16_t)len);
+  s_stats.telemetry_sent++;
+
+  // Alert edges and command answers do not wait for the batch to fill or age
+  if ((msg->kind == TLM_AI_EVENT &&
+       (msg->u.event.type == AI_EVENT_ALERT_START || msg->u.event.type == AI_EVENT_ALERT_END)) ||
+      msg->kind == TLM_CONFIG) {
+    secure_uart_commit();
+  }
+}
+
+// REPORT=<ms>: PPG records at most that often; the CM7 still gets every window
+static uint8_t tlm_ppg_due(uint32_t tick)
+{
+  static uint32_t last;
+  static uint8_t started;
+  uint32_t period = s_cfg.report_ms;
+
+  if (period != 0U && started && (tick - last) < period) return 0;
+  last = tick;
+  started = 1;
+  return 1;
+}
+
+// snprintf returns the untruncated length, clamp it to what is in line
+static void tlm_send_line(const char *line, int n, size_t size)
+{
+  if (n <= 0) return;
+  if ((size_t)n >= size) n = (int)size - 1;
+  secure_uart_send((const uint8_t *)line, (uint16_t)n);
+  s_stats.telemetry_sent++;
+}
+
+// HEALTH:<core> up=<s> heap=<free>/<min free> stack_min=<task>:<bytes>,...
+static int health_format(const char *core, const rtos_health_t *h, char *line, size_t size)
+{
+  int n = snprintf(line, size, "HEALTH:%s up=%lu heap=%lu/%lu stack_min=", core,
+                   h->uptime_ms / 1000U, h->heap_free, h->heap_free_min);
+  for (uint32_t i = 0; i < h->n_tasks && n > 0 && (size_t)n < size; i++) {
+    n += snprintf(line + n, size - (size_t)n, "%s%s:%lu", (i == 0) ? "" : ",",
+                  h->tasks[i].name, h->tasks[i].stack_free_min);
+  }
+  if (n > 0 && (size_t)n < size && h->tasks_total > h->n_tasks) {
+    n += snprintf(line + n, size - (size_t)n, ",+%lu", h->tasks_total - h->n_tasks);
+  }
+  if (n > 0 && (size_t)n < size) {
+    n += snprintf(line + n, size - (size_t)n, "\r\n");
+  }
+  return n;
+}
+
+// AI:M7 cache=<model>:<hits>/<misses>/<refreshes>:<skipped %>,...
+static int cache_format(const rtos_health_t *h, char *line, size_t size)
+{
+  int n = snprintf(line, size, "AI:M7 cache=");
+  for (uint32_t i = 0; i < h->n_models && n > 0 && (size_t)n < size; i++) {
+    const rtos_model_health_t *m = &h->models[i];
+    uint32_t lookups = m->hits + m->misses + m->refreshes;
+    uint32_t skip_x100 = lookups ? (uint32_t)((uint64_t)m->hits * 10000U / lookups) : 0U;
+    n += snprintf(line + n, size - (size_t)n, "%s%s:%lu/%lu/%lu:%lu.%02lu%%", (i == 0) ? "" : ",",
+                  m->name, m->hits, m->misses, m->refreshes, skip_x100 / 100U, skip_x100 % 100U);
+  }
+  if (n > 0 && (size_t)n < size) {
+    n += snprintf(line + n, size - (size_t)n, "\r\n");
+  }
+  return n;
+}
+
+// POWER:M4 duty=<awake %> win=<s> stop=<s total> ... lat=<last>/<max>us
+static int power_format(const lowpower_stats_t *p, char *line, size_t size)
+{
+  return snprintf(line, size,
+                  "POWER:M4 duty=%lu.%02lu%% win=%lus stop=%lus stops=%lu aborts=%lu sleeps=%lu "
+                  "wake_tmr=%lu wake_irq=%lu lat=%lu/%luus resume_max=%lucyc\r\n",
+                  p->duty_x100 / 100U, p->duty_x100 % 100U, p->window_ms / 1000U,
+                  p->stopped_ms / 1000U, p->stops, p->stop_aborts, p->sleeps, p->wakes_timer,
+                  p->wakes_irq, p->wake_latency_us, p->wake_latency_max_us, p->resume_cycles_max);
+}
+
+// TXQ:M4 sess=<id> items=<batched> sent=<frames> bytes= waits= drop_oldest= err= qmax=<frames>/<pool> ks=<idle>/<inline> blocks
+//   baud= link=<switches>/<timeouts> nack= retx=<resent>/<expired> rx=<bytes>/<errors>/<restarts> cfg=<ok>/<rejected>
+static int txq_format(const secure_uart_stats_t *q, const uart_rx_stats_t *r, char *line, size_t size)
+{
+  return snprintf(line, size,
+                  "TXQ:M4 sess=%08lx items=%lu sent=%lu bytes=%lu waits=%lu drop_oldest=%lu err=%lu qmax=%lu/%u ks=%lu/%lu "
+                  "baud=%lu link=%lu/%lu nack=%lu retx=%lu/%lu rx=%lu/%lu/%lu cfg=%lu/%lu\r\n",
+                  q->session, q->items, q->frames_sent, q->bytes_sent, q->waits, q->drops_oldest, q->errors,
+                  q->queued_max, (unsigned)SECURE_UART_POOL_LEN, q->ks_hits, q->ks_misses,
+                  q->baud, q->link_changes, q->link_timeouts, q->nacks, q->retransmits, q->retx_expired,
+                  r->bytes, r->errors, r->restarts, s_stats.commands, s_stats.command_errors);
+}
+
+static void tlm_send_frame(const rt_stats_frame_t *frame)
+{
+  secure_uart_send((const uint8_t *)frame, (uint16_t)RT_STATS_FRAME_LEN(frame->n_tasks));
+  s_stats.telemetry_sent++;
+}
+
+// Deferred log records go out as binary frames (DLOG_TAG)
+static void log_flush(void)
+{
+  static dlog_frame_t frame;
+  uint32_t len;
+
+  while ((len = DLog_Drain(4U, &frame)) != 0U) {
+    secure_uart_send((const uint8_t *)&frame, (uint16_t)len);
+    s_stats.telemetry_sent++;
+  }
+}
+
+static void health_send(char *line, size_t size)
+{
+  static rtos_health_t snap;
+  static rt_stats_frame_t load;
+  lowpower_stats_t power;
+  secure_uart_stats_t txq;
+  uart_rx_stats_t rx;
+
+  RtosHealth_Capture(&snap);
+  tlm_send_line(line, health_format("M4", &snap, line, size), size);
+  LowPower_GetStats(&power);
+  tlm_send_line(line, power_format(&power, line, size), size);
+  secure_uart_get_stats(&txq);
+  UartRx_GetStats(&rx);
+  tlm_send_line(line, txq_format(&txq, &rx, line, size), size);
+
+  // CPU load goes out as binary frames (RT_STATS_TAG), one per core
+  RunTimeStats_Capture(4U, &load);
+  tlm_send_frame(&load);
+  if (RunTimeStats_Read(s_cm7_runtime, &load)) {
+    tlm_send_frame(&load);
+  }
+
+  if (RtosHealth_Read(s_cm7_health, &snap)) {
+    tlm_send_line(line, health_format("M7", &snap, line, size), size);
+    if (snap.n_models > 0) tlm_send_line(line, cache_format(&snap, line, size), size);
+  }
+}
+
+// Trace dumps bypass the AES framing and the DMA queue: they are read on the
+// ST-LINK VCP. A sealed TP_LINK_RAW item announces their size, so the ESP32
+// passes them by instead of decoding them as frames.
+static struct {
+  uint32_t baud;
+  uint32_t total;
+  uint32_t sent;
+  uint8_t  failed;   // A chunk timed out: the rest is not sent
+} s_raw;
+
+static void tlm_begin_raw(uint32_t total)
+{
+  secure_uart_stats_t q;
+  const tp_link_t raw = { TP_LINK_TAG, TP_LINK_RAW, 0U, 0U, 0U, total };
+
+  secure_uart_send((const uint8_t *)&raw, (uint16_t)sizeof(raw));
+  secure_uart_flush(1000U);
+  secure_uart_get_stats(&q);
+  s_raw.baud = q.baud;
+  s_raw.total = total;
+  s_raw.sent = 0;
+  s_raw.failed = 0;
+}
+
+static void tlm_write_raw(const uint8_t *data, uint16_t len)
+{
+  if (s_raw.failed) return;
+  // Twice the wire time at the current rate (10 bits a byte), plus room for CTS holds
+  uint32_t timeout = (uint32_t)((uint64_t)len * 20000U / s_raw.baud) + APP_RAW_CTS_MARGIN_MS;
+  if (HAL_UART_Transmit(s_huart, (uint8_t *)data, len, timeout) != HAL_OK) {
+    s_raw.failed = 1;
+    return;
+  }
+  s_raw.sent += len;
+}
+
+// TRC:M4 events=<n> bytes=<sent>/<total> baud=<rate>[ truncated]
+static int trace_format(uint32_t events, char *line, size_t size)
+{
+  return snprintf(line, size, "TRC:M4 events=%lu bytes=%lu/%lu baud=%lu%s\r\n", events, s_raw.sent,
+                  s_raw.total, s_raw.baud, s_raw.failed ? " truncated" : "");
+}
+
+static void TelemetryTask(void *argument)
+{
+  (void)argument;
+  telemetry_msg_t msg;
+  char line[224];   // Below SECURE_UART_PAYLOAD_MAX
+
+  for (;;) {
+    // Wake for the log drain or when the open batch is due, whichever is first
+    uint32_t wait = secure_uart_poll();
+    if (wait > APP_LOG_DRAIN_MS) wait = APP_LOG_DRAIN_MS;
+    osStatus_t st = osMessageQueueGet(s_tlm_queue, &msg, NULL, wait);
+    log_flush();
+    if (st != osOK) continue;
+
+    if (msg.kind == TLM_HEALTH) {
+      health_send(line, sizeof(line));
+      continue;
+    }
+    if (msg.kind == TLM_TRACE_DUMP) {
+      secure_uart_flush(1000U);
+      uint32_t events = Tracer_Dump(tlm_begin_raw, tlm_write_raw);
+      tlm_send_line(line, trace_format(events, line, sizeof(line)), sizeof(line));
+      continue;
+    }
+    if (msg.kind == TLM_PPG && !tlm_ppg_due(msg.tick)) continue;
+    tlm_send_record(&msg);
+  }
+}
@@ -0,0 +1,84 @@
+/* CM4 deferred binary log: lock-free record ring drained by the telemetry task. */
+
+#include "dlog.h"
+#include "telemetry_proto.h"
+#include <string.h>
+
+_Static_assert((DLOG_RING_LEN & (DLOG_RING_LEN - 1U)) == 0U, "DLOG_RING_LEN must be a power of two");
+_Static_assert(sizeof(dlog_record_t) == 8U + 4U * DLOG_MAX_ARGS, "dlog_record_t is part of the frame format");
+_Static_assert(DLOG_FRAME_LEN(DLOG_FRAME_MAX_RECORDS) <= TP_BATCH_ITEM_MAX, "frame does not fit one secure_uart_send()");
+
+// 1 MHz run-time stats counter, freertos.c (STOP time included)
+extern unsigned long getRunTimeCounterValue(void);
+
+/*
+ * Multi-producer, single-consumer. A producer reserves slot s_head with a
+ * compare-and-swap (fails, and is counted, if the consumer is a full ring
+ * behind), fills it, then publishes it by storing its sequence number
+ * (index + 1). The consumer takes slots in order while the sequence matches,
+ * so a producer preempted between reserve and publish only delays the slots
+ * after its own.
+ */
+typedef struct {
+  volatile uint32_t seq;
+  dlog_record_t     rec;
+} dlog_slot_t;
+
+static dlog_slot_t s_ring[DLOG_RING_LEN];
+static uint32_t s_head = 0;            // Next slot to reserve, producers
+static uint32_t s_tail = 0;            // Next slot to read, consumer
+static uint32_t s_dropped = 0;
+static uint32_t s_dropped_reported = 0;
+
+void DLog_Write(uint16_t id, uint8_t nargs, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+  uint32_t head = __atomic_load_n(&s_head, __ATOMIC_RELAXED);
+
+  do {
+    if (head - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE) >= DLOG_RING_LEN) {
+      __atomic_fetch_add(&s_dropped, 1U, __ATOMIC_RELAXED);
+      return;
+    }
+  } while (!__atomic_compare_exchange_n(&s_head, &head, head + 1U, 1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+  dlog_slot_t *slot = &s_ring[head & (DLOG_RING_LEN - 1U)];
+  slot->rec.ts_us = (uint32_t)getRunTimeCounterValue();
+  slot->rec.id = id;
+  slot->rec.nargs = nargs;
+  slot->rec.reserved = 0;
+  slot->rec.args[0] = a0;
+  slot->rec.args[1] = a1;
+  slot->rec.args[2] = a2;
+  __atomic_store_n(&slot->seq, head + 1U, __ATOMIC_RELEASE);
+}
+
+uint32_t DLog_Drain(uint8_t core, dlog_frame_t *out)
+{
+  uint32_t tail = s_tail;
+  uint32_t n = 0;
+
+  while (n < DLOG_FRAME_MAX_RECORDS) {
+    dlog_slot_t *slot = &s_ring[tail & (DLOG_RING_LEN - 1U)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1U) break;
+    memcpy(&out->records[n++], &slot->rec, sizeof(dlog_record_t));
+    tail++;
+    // Hand the slot back before copying the next one
+    __atomic_store_n(&s_tail, tail, __ATOMIC_RELEASE);
+  }
+
+  uint32_t dropped = __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+  if (n == 0U && dropped == s_dropped_reported) return 0;
+
+  out->tag = DLOG_TAG;
+  out->version = DLOG_VERSION;
+  out->n_records = (uint8_t)n;
+  out->core = core;
+  out->dropped = dropped - s_dropped_reported;
+  s_dropped_reported = dropped;
+  return DLOG_FRAME_LEN(n);
+}
+
+uint32_t DLog_Dropped(void)
+{
+  return __atomic_load_n(&s_dropped, __ATOMIC_RELAXED);
+}
@@ -24,7 +24,9 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "lowpower.h"
+#include "runtime_stats.h"
+#include "secure_uart.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -52,6 +54,69 @@
 
 /* USER CODE END FunctionPrototypes */
 
+/* Hook prototypes */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+void vApplicationIdleHook(void);
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+void configureTimerForRunTimeStats(void)
+{
+  uint32_t tim_hz = HAL_RCC_GetPCLK1Freq();
+
+  // APB1 timers run at twice PCLK1 when the APB1 prescaler divides
+  if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_D2CFGR_D2PPRE1_DIV1) tim_hz *= 2U;
+
+  // TIM5 (32 bits) free-running at 1 MHz. It stops with D2 in STOP, so the
+  // counter adds the time lowpower.c measured there: the idle task gets it.
+  __HAL_RCC_TIM5_CLK_ENABLE();
+  TIM5->CR1 = 0;
+  TIM5->PSC = (tim_hz / RUNTIME_STATS_HZ) - 1U;
+  TIM5->ARR = 0xFFFFFFFFU;
+  TIM5->CNT = 0;
+  TIM5->EGR = TIM_EGR_UG;
+  TIM5->SR = 0;
+  TIM5->CR1 = TIM_CR1_CEN;
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return TIM5->CNT + LowPower_StoppedUs();
+}
+/* USER CODE END 1 */
+
+/* USER CODE BEGIN 2 */
+void vApplicationIdleHook( void )
+{
+   /* vApplicationIdleHook() will only be called if configUSE_IDLE_HOOK is set
+   to 1 in FreeRTOSConfig.h. It will be called on each iteration of the idle
+   task. It is essential that code added to this hook function never attempts
+   to block in any way (for example, call xQueueReceive() with a block time
+   specified, or call vTaskDelay()). If the application makes use of the
+   vTaskDelete() API function (as this demo application does) then it is also
+   important that vApplicationIdleHook() is permitted to return to its calling
+   function, because it is the responsibility of the idle task to clean up
+   memory allocated by the kernel to any task that has since been deleted. */
+  // AES-GCM keystream for the next UART batches, before the core goes to sleep
+  secure_uart_idle();
+}
+/* USER CODE END 2 */
+
+/* USER CODE BEGIN 4 */
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName)
+{
+   /* Run time stack overflow checking is performed if
+   configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2. This hook function is
+   called if a stack overflow is detected. */
+  (void)xTask;
+  (void)pcTaskName;
+  // Static stacks sit next to other data, do not run on with a corrupted neighbour
+  Error_Handler();
+}
+/* USER CODE END 4 */
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
@@ -0,0 +1,268 @@
+/* CM4 tickless idle: D2 STOP between ticks, LPTIM1 keeps FreeRTOS time. */
+
+#include "lowpower.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "tracer.h"
+
+/*
+ * Only the D2 domain stops: the CM7 keeps D1, the PLLs and the shared SRAM
+ * running, so nothing has to be reconfigured on wake-up. In D2 STOP the CM4,
+ * SysTick, I2C1, ADC1 and the DMA1 streams lose their clocks; what survives:
+ * - LPTIM1 on LSI (no LSE is fitted), EXTI line 47, wakes at the deadline;
+ * - GPIO EXTI (MAX30100 INT on PB5);
+ * - USART3 RX with UESM set and an HSI kernel clock, EXTI line 28.
+ * The acquisition path polls I2C and ADC, so no transfer can be cut short;
+ * DMA users take LowPower_Hold() for the duration of the transfer.
+ * USART3 reception (uart_rx.c) never ends, so it cannot hold: its DMA
+ * requests are masked across STOP and the wake-up flag (RXNE) is enabled
+ * instead. The byte that woke the core waits in RDR and the stream takes it
+ * once the requests are back; bytes arriving during the wake-up overrun and
+ * are lost, which is what the senders' preambles are for.
+ *
+ * LPTIM1 is driven at register level, the LPTIM HAL driver is not in the
+ * build. It runs DIV1 (31 us resolution on LSI), 16 bits, so one STOP lasts
+ * at most ~2 s and the idle task simply sleeps again.
+ *
+ * Time is carried in units of 1 / (LPTIM Hz * tick Hz) s: one tick is
+ * s_lptim_hz units and one LPTIM count is configTICK_RATE_HZ units. The
+ * SysTick phase at entry and the sub-tick remainder at exit are kept, so
+ * repeated STOPs do not drift the tick count.
+ */
+
+#define LP_EXTI_USART3_WKUP   (1UL << 28)   // EXTI_D2 IMR1, USART3 wake-up
+#define LP_EXTI_LPTIM1_WKUP   (1UL << 15)   // EXTI_D2 IMR2, line 47, LPTIM1 wake-up
+#define LP_LPTIM_MAX_COUNT    (0xFFFFUL)
+#define LP_LSI_TIMEOUT_MS     (5U)
+
+#define LP_SYSTICK_OFF        (SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk)
+#define LP_SYSTICK_ON         (LP_SYSTICK_OFF | SysTick_CTRL_ENABLE_Msk)
+
+static USART_TypeDef *s_wake_uart = NULL;
+static uint32_t s_lptim_hz = 0;
+static uint32_t s_cycles_per_tick = 0;
+static volatile uint32_t s_hold = 0;
+static lowpower_stats_t s_stats;
+
+// DWT CYCCNT stops with the core clock in WFI, so its advance is awake time.
+// It is folded into 64 bits on every idle entry, long before it can wrap.
+static uint32_t s_cyc_prev = 0;
+static uint64_t s_active_cycles = 0;
+static uint64_t s_window_active0 = 0;
+static TickType_t s_window_tick0 = 0;
+static uint64_t s_stopped_counts = 0;
+static volatile uint32_t s_stopped_us = 0;   // Run-time stats offset, wraps with the 1 MHz counter
+static uint32_t s_stopped_us_rem = 0;
+
+static void lp_account_active(void)
+{
+  uint32_t now = DWT->CYCCNT;
+  s_active_cycles += (uint32_t)(now - s_cyc_prev);
+  s_cyc_prev = now;
+}
+
+// CNT is clocked by LSI; read until two consecutive values agree
+static uint32_t lp_lptim_count(void)
+{
+  uint32_t a, b;
+  do {
+    a = LPTIM1->CNT;
+    b = LPTIM1->CNT;
+  } while (a != b);
+  return a;
+}
+
+HAL_StatusTypeDef LowPower_Init(UART_HandleTypeDef *huart)
+{
+  uint32_t start = HAL_GetTick();
+
+  __HAL_RCC_LSI_ENABLE();
+  while (__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) == 0U) {
+    if ((HAL_GetTick() - start) > LP_LSI_TIMEOUT_MS) return HAL_ERROR;
+  }
+  s_lptim_hz = LSI_VALUE;
+  s_cycles_per_tick = SystemD2Clock / configTICK_RATE_HZ;
+
+  __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSI);
+  __HAL_RCC_LPTIM1_CLK_ENABLE();
+  __HAL_RCC_LPTIM1_CLK_SLEEP_ENABLE();
+
+  // CFGR and IER are only writable while the timer is disabled
+  LPTIM1->CR = 0;
+  LPTIM1->CFGR = 0;                      // Internal clock, DIV1, software start
+  LPTIM1->IER = LPTIM_IER_ARRMIE;
+  LPTIM1->ICR = LPTIM_ICR_ARRMCF | LPTIM_ICR_ARROKCF;
+
+  // Enabled in the NVIC so the match ends WFI; with PRIMASK set it is consumed
+  // before it can run (see LowPower_LptimIrq)
+  HAL_NVIC_SetPriority(LPTIM1_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+  EXTI_D2->IMR2 |= LP_EXTI_LPTIM1_WKUP;
+
+  if (huart != NULL && huart->Instance == USART3) {
+    UART_WakeUpTypeDef wake = { .WakeUpEvent = UART_WAKEUP_ON_READDATA_NONEMPTY };
+    EXTI_D2->IMR1 |= LP_EXTI_USART3_WKUP;
+    if (HAL_UARTEx_StopModeWakeUpSourceConfig(huart, wake) != HAL_OK) return HAL_ERROR;
+    if (HAL_UARTEx_EnableStopMode(huart) != HAL_OK) return HAL_ERROR;
+    s_wake_uart = huart->Instance;
+  }
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  return HAL_OK;
+}
+
+void LowPower_Hold(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  s_hold++;
+  __set_PRIMASK(primask);
+}
+
+void LowPower_Release(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (s_hold > 0U) s_hold--;
+  __set_PRIMASK(primask);
+}
+
+void LowPower_SuppressTicksAndSleep(uint32_t expected_ticks)
+{
+  uint32_t max_ticks = (LP_LPTIM_MAX_COUNT * configTICK_RATE_HZ) / (s_lptim_hz ? s_lptim_hz : 1U);
+
+  __disable_irq();
+  __DSB();
+  __ISB();
+  lp_account_active();
+
+  // Too short for STOP to pay off, or the clocks are needed: sleep, tick running
+  if (s_lptim_hz == 0U || expected_ticks < LOWPOWER_MIN_STOP_TICKS || s_hold != 0U) {
+    if (eTaskConfirmSleepModeStatus() != eAbortSleep) {
+      s_stats.sleeps++;
+      __DSB();
+      __WFI();
+    }
+    __enable_irq();
+    return;
+  }
+
+  SysTick->CTRL = LP_SYSTICK_OFF;
+  if (eTaskConfirmSleepModeStatus() == eAbortSleep || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U) {
+    SysTick->CTRL = LP_SYSTICK_ON;
+    s_stats.stop_aborts++;
+    __enable_irq();
+    return;
+  }
+
+  if (expected_ticks > max_ticks) expected_ticks = max_ticks;
+
+  // Part of the current tick already gone, then the LPTIM counts to the deadline
+  uint32_t val = SysTick->VAL;
+  uint32_t phase_cyc = (val < s_cycles_per_tick) ? (s_cycles_per_tick - val) : 0U;
+  uint32_t phase = (uint32_t)(((uint64_t)phase_cyc * s_lptim_hz) / s_cycles_per_tick);
+  uint32_t counts = (expected_ticks * s_lptim_hz - phase) / configTICK_RATE_HZ;
+
+  LPTIM1->CR = LPTIM_CR_ENABLE;
+  LPTIM1->ARR = counts;
+  while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0U) {
+  }
+  LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+  LPTIM1->CR = LPTIM_CR_ENABLE | LPTIM_CR_CNTSTRT;
+
+  // RM0399: DMA reception must be disabled before Stop; the UART wakes the core itself
+  uint32_t uart_dmar = 0;
+  if (s_wake_uart != NULL) {
+    uart_dmar = s_wake_uart->CR3 & USART_CR3_DMAR;
+    s_wake_uart->CR3 = (s_wake_uart->CR3 & ~USART_CR3_DMAR) | USART_CR3_WUFIE;
+  }
+
+  s_stats.stops++;
+  TRACE_EVENT(TRACE_EV_STOP_ENTER, 0U, expected_ticks);
+  HAL_PWREx_EnterSTOPMode(PWR_MAINREGULATOR_ON, PWR_STOPENTRY_WFI, PWR_D2_DOMAIN);
+  uint32_t t_wake = DWT->CYCCNT;
+
+  if (s_wake_uart != NULL) {
+    s_wake_uart->CR3 = (s_wake_uart->CR3 & ~USART_CR3_WUFIE) | uart_dmar;
+    s_wake_uart->ICR = USART_ICR_WUCF;
+  }
+
+  // Continuous mode: CNT == ARR at the match, 0 one count later
+  uint32_t cnt = lp_lptim_count();
+  uint32_t elapsed;
+  uint8_t timer_wake = ((LPTIM1->ISR & LPTIM_ISR_ARRM) != 0U) ? 1U : 0U;
+  if (timer_wake) {
+    cnt = lp_lptim_count();
+    elapsed = (cnt == counts) ? counts : counts + 1U + cnt;
+    uint32_t latency_us = (uint32_t)(((uint64_t)(elapsed - counts) * 1000000U) / s_lptim_hz);
+    s_stats.wakes_timer++;
+    s_stats.wake_latency_us = latency_us;
+    if (latency_us > s_stats.wake_latency_max_us) s_stats.wake_latency_max_us = latency_us;
+  } else {
+    elapsed = cnt;
+    s_stats.wakes_irq++;
+  }
+
+  LPTIM1->ICR = LPTIM_ICR_ARRMCF | LPTIM_ICR_ARROKCF;
+  LPTIM1->CR = 0;
+  NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+  s_stopped_counts += elapsed;
+  uint64_t us_units = (uint64_t)elapsed * 1000000U + s_stopped_us_rem;
+  s_stopped_us += (uint32_t)(us_units / s_lptim_hz);
+  s_stopped_us_rem = (uint32_t)(us_units % s_lptim_hz);
+
+  uint32_t total = phase + elapsed * configTICK_RATE_HZ;
+  uint32_t ticks = total / s_lptim_hz;
+  uint32_t rem = total % s_lptim_hz;
+  if (ticks > expected_ticks) {
+    ticks = expected_ticks;
+    rem = 0;
+  }
+
+  // Next tick lands where it would have without the STOP
+  uint32_t reload = (uint32_t)(((uint64_t)(s_lptim_hz - rem) * s_cycles_per_tick) / s_lptim_hz);
+  SysTick->LOAD = (reload > 1U) ? (reload - 1U) : 1U;
+  SysTick->VAL = 0;
+  SysTick->CTRL = LP_SYSTICK_ON;
+  SysTick->LOAD = s_cycles_per_tick - 1U;
+
+  vTaskStepTick(ticks);
+  uwTick += ticks * portTICK_PERIOD_MS;   // HAL timebase shares SysTick
+  TRACE_EVENT(TRACE_EV_STOP_EXIT, timer_wake, ticks);
+
+  uint32_t resume = DWT->CYCCNT - t_wake;
+  if (resume > s_stats.resume_cycles_max) s_stats.resume_cycles_max = resume;
+  __enable_irq();
+}
+
+void LowPower_GetStats(lowpower_stats_t *out)
+{
+  taskENTER_CRITICAL();
+  lp_account_active();
+  TickType_t now = xTaskGetTickCount();
+  uint32_t ticks = (uint32_t)(now - s_window_tick0);
+  uint64_t active = s_active_cycles - s_window_active0;
+  uint64_t window_cyc = (uint64_t)ticks * s_cycles_per_tick;
+
+  *out = s_stats;
+  out->window_ms = ticks * portTICK_PERIOD_MS;
+  out->duty_x100 = window_cyc ? (uint32_t)((active * 10000U) / window_cyc) : 0U;
+  if (out->duty_x100 > 10000U) out->duty_x100 = 10000U;
+  out->stopped_ms = s_lptim_hz ? (uint32_t)((s_stopped_counts * 1000U) / s_lptim_hz) : 0U;
+
+  s_window_tick0 = now;
+  s_window_active0 = s_active_cycles;
+  taskEXIT_CRITICAL();
+}
+
+uint32_t LowPower_StoppedUs(void)
+{
+  return s_stopped_us;
+}
+
+void LowPower_LptimIrq(void)
+{
+  LPTIM1->ICR = LPTIM_ICR_ARRMCF | LPTIM_ICR_ARROKCF;
+}
@@ -18,19 +18,18 @@
 /* USER CODE END Header */
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
-#include "max30100_for_stm32_hal.h" // Your MAX30100 library
-#include "aes.h"
-#include <stdio.h>   // For snprintf
-#include <string.h>  // For strlen
-#include <math.h>    // For fabs, log for more advanced SpO2 if needed
 #include "cmsis_os.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "uart_rx.h"
+#include "app_tasks.h"
+#include "lowpower.h"
+#include "secure_uart.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
+typedef StaticTask_t osStaticThreadDef_t;
 /* USER CODE BEGIN PTD */
 
 /* USER CODE END PTD */
@@ -58,22 +57,19 @@ DMA_HandleTypeDef hdma_i2c1_rx;
 TIM_HandleTypeDef htim6;
 
 UART_HandleTypeDef huart3;
-
-// Buffer for heart rate calculation (e.g., 8 * 16 samples = 128 samples)
-#define HR_CALC_BUFFER_SIZE (MAX30100_SAMPLES_PER_READ * 8)
-static uint16_t hr_ir_sample_buffer[HR_CALC_BUFFER_SIZE];
-static uint16_t hr_red_sample_buffer[HR_CALC_BUFFER_SIZE];
-static uint16_t hr_buffer_idx = 0;
-static uint8_t hr_buffer_full = 0;
-
-// Sampling rate (must match MAX30100 configuration)
-const float ppg_sample_rate_hz = 100.0f; // Assuming 100Hz from MAX30100_SPO2_SAMPLERATE_100HZ
+DMA_HandleTypeDef hdma_usart3_rx;
+DMA_HandleTypeDef hdma_usart3_tx;
 
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
+uint32_t defaultTaskBuffer[ 128 ];
+osStaticThreadDef_t defaultTaskControlBlock;
 const osThreadAttr_t defaultTask_attributes = {
   .name = "defaultTask",
-  .stack_size = 128 * 4,
+  .cb_mem = &defaultTaskControlBlock,
+  .cb_size = sizeof(defaultTaskControlBlock),
+  .stack_mem = &defaultTaskBuffer[0],
+  .stack_size = sizeof(defaultTaskBuffer),
   .priority = (osPriority_t) osPriorityNormal,
 };
 /* USER CODE BEGIN PV */
@@ -89,50 +85,6 @@ static void MX_TIM6_Init(void);
 static void MX_USART3_UART_Init(void);
 void StartDefaultTask(void *argument);
 
-void processMAX30100Data(void);
-void readLM35Temperature(void); // Specific function for LM35
-float calculateDC(uint16_t *samples, uint16_t size);
-float calculateAC(uint16_t *samples, uint16_t size);
-int countPeaks(uint16_t *samples, uint16_t size, float threshold, float min_peak_distance_samples);
-
-// AES-CTR helper for securing UART frames to ESP32
-#define ENABLE_AES_UART 1
-static const uint8_t kAesKey128[16] = { 0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
-static uint32_t g_uart_iv_counter = 1;
-
-static void secure_uart_send(const uint8_t* data, uint16_t len)
-{
-#if ENABLE_AES_UART
-  struct AES_ctx ctx;
-  uint8_t iv[AES_BLOCKLEN] = {0};
-  // Simple monotonically increasing IV (last 4 bytes). Ensure ESP32 mirrors this.
-  iv[12] = (uint8_t)((g_uart_iv_counter >> 24) & 0xFF);
-  iv[13] = (uint8_t)((g_uart_iv_counter >> 16) & 0xFF);
-  iv[14] = (uint8_t)((g_uart_iv_counter >> 8) & 0xFF);
-  iv[15] = (uint8_t)(g_uart_iv_counter & 0xFF);
-
-  // Prepare frame: [0xAA 0x55][IV(16)][LEN(2)][CIPHERTEXT]
-  uint8_t header[2] = {0xAA, 0x55};
-  uint8_t len_be[2] = { (uint8_t)(len >> 8), (uint8_t)(len & 0xFF) };
-  // Copy plaintext to a mutable buffer
-  uint8_t buf[256];
-  uint16_t copy_len = (len > sizeof(buf)) ? sizeof(buf) : len; // truncate if oversized
-  memcpy(buf, data, copy_len);
-
-  AES_init_ctx_iv(&ctx, kAesKey128, iv);
-  AES_CTR_xcrypt_buffer(&ctx, buf, copy_len);
-
-  HAL_UART_Transmit(&huart3, header, sizeof(header), 100);
-  HAL_UART_Transmit(&huart3, iv, sizeof(iv), 100);
-  HAL_UART_Transmit(&huart3, len_be, sizeof(len_be), 100);
-  HAL_UART_Transmit(&huart3, buf, copy_len, 200);
-
-  g_uart_iv_counter++;
-#else
-  HAL_UART_Transmit(&huart3, (uint8_t*)data, len, 200);
-#endif
-}
-
 /* USER CODE BEGIN PFP */
 
 /* USER CODE END PFP */
@@ -189,7 +141,14 @@ int main(void)
   MX_TIM6_Init();
   MX_USART3_UART_Init();
   /* USER CODE BEGIN 2 */
-
+  if (LowPower_Init(&huart3) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  if (UartRx_Start(&huart3) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END 2 */
 
   /* Init scheduler */
@@ -217,6 +176,10 @@ int main(void)
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  if (AppTasks_Init(&hi2c1, &hadc1, &huart3) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -230,196 +193,13 @@ int main(void)
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
-  printf("System Initialized.\r\n");
-    printf("LM35 on PC0 (ADC1_INP10), MAX30100 on I2C1, INT PB5.\r\n");
-
-    /* Initialize MAX30100 */
-    if (MAX30100_Init(&hi2c1) == HAL_OK) {
-      printf("MAX30100 Initialized Successfully.\r\n");
-      if (MAX30100_SetMode(MAX30100_MODE_SPO2_EN) == HAL_OK) {
-          printf("MAX30100 Mode set to SpO2/HR.\r\n");
-      } else {
-          printf("Error: Failed to set MAX30100 mode.\r\n");
-      }
-    } else {
-      printf("Error: MAX30100 Initialization Failed. Check connections.\r\n");
-      while(1); // Halt on critical error
-    }
+  while (1)
+  {
+    /* USER CODE END WHILE */
 
-    // --- Enable your EXTI interrupt for MAX30100 INT pin here ---
-    // Example: HAL_NVIC_SetPriority(EXTIx_IRQn, 0, 0);
-    //          HAL_NVIC_EnableIRQ(EXTIx_IRQn);
-
-    uint32_t last_lm35_read_time = HAL_GetTick();
-    uint32_t last_max_temp_read_time = HAL_GetTick();
-
-    while (1)
-    {
-      if (max30100_new_data_available) {
-        max30100_new_data_available = 0; // Clear the flag
-        processMAX30100Data();
-      }
-
-      // Read LM35 temperature periodically
-      if (HAL_GetTick() - last_lm35_read_time >= 5000) { // Every 5 seconds
-        readLM35Temperature();
-        last_lm35_read_time = HAL_GetTick();
-      }
-
-      // Read MAX30100 internal temperature periodically
-      if (HAL_GetTick() - last_max_temp_read_time >= 10000) { // Every 10 seconds
-          float sensor_temp_max30100;
-          if(MAX30100_ReadTemperature(&sensor_temp_max30100) == HAL_OK) {
-              char temp_buf[40];
-              sprintf(temp_buf, "MAX30100 Die Temp: %.2f C\r\n", sensor_temp_max30100);
-              secure_uart_send((uint8_t*)temp_buf, strlen(temp_buf));
-          } else {
-              printf("Warning: Failed to read MAX30100 temperature.\r\n");
-          }
-          last_max_temp_read_time = HAL_GetTick();
-      }
-      // __WFI(); // Optional: Wait for interrupt to save power if main loop has nothing else
-    }
+    /* USER CODE BEGIN 3 */
   }
-void processMAX30100Data(void) {
-    // Copy data from library's buffer to the heart rate calculation buffer
-    for (int i = 0; i < MAX30100_SAMPLES_PER_READ; i++) {
-        if (hr_buffer_idx < HR_CALC_BUFFER_SIZE) {
-            hr_ir_sample_buffer[hr_buffer_idx] = max30100_ir_buffer[i];
-            hr_red_sample_buffer[hr_buffer_idx] = max30100_red_buffer[i];
-            hr_buffer_idx++;
-        }
-    }
-
-    if (hr_buffer_idx >= HR_CALC_BUFFER_SIZE) {
-        hr_buffer_full = 1;
-        hr_buffer_idx = 0;
-    }
-
-    if (hr_buffer_full) {
-        float dc_ir = calculateDC(hr_ir_sample_buffer, HR_CALC_BUFFER_SIZE);
-        float dc_red = calculateDC(hr_red_sample_buffer, HR_CALC_BUFFER_SIZE);
-        float ac_ir = calculateAC(hr_ir_sample_buffer, HR_CALC_BUFFER_SIZE);
-        float ac_red = calculateAC(hr_red_sample_buffer, HR_CALC_BUFFER_SIZE);
-
-        float spo2 = 0.0f;
-        float ratio = 0.0f;
-
-        if (dc_ir > 1000 && dc_red > 1000 && ac_ir > 20 && ac_red > 20) {
-            ratio = (ac_red / dc_red) / (ac_ir / dc_ir);
-            // Using a more standard quadratic formula. You might need to adjust/calibrate.
-            // spo2 = -45.060f * ratio * ratio + 30.354f * ratio + 94.845f;
-            // Or your original linear:
-            spo2 = -45.060f * ratio + 110.4f;
-
-            if (spo2 > 100.0f) spo2 = 100.0f;
-            if (spo2 < 70.0f) spo2 = 70.0f;
-        } else {
-            spo2 = 0.0f;
-        }
-
-        float heartRate = 0.0f;
-        float peak_threshold = dc_ir + (ac_ir * 0.3f); // Adjust 0.3f (30%) as needed
-        float min_peak_dist_samples = ppg_sample_rate_hz / (240.0f / 60.0f) ; // For max HR of 240bpm
-
-        int peaks = countPeaks(hr_ir_sample_buffer, HR_CALC_BUFFER_SIZE, peak_threshold, min_peak_dist_samples);
-
-        if (peaks > 0) {
-            float window_duration_sec = (float)HR_CALC_BUFFER_SIZE / ppg_sample_rate_hz;
-            heartRate = (float)peaks * 60.0f / window_duration_sec;
-        }
-        // Sanity checks for HR
-        if (heartRate > 220.0f || (heartRate < 40.0f && heartRate != 0.0f)) {
-             // heartRate = 0.0f; // Or print as is for debugging
-        }
-
-
-        char data_buf[120]; // Increased buffer size
-        sprintf(data_buf, "HR:%.1fbpm SpO2:%.1f%% IR(DC:%.0f AC:%.0f) RED(DC:%.0f AC:%.0f) R:%.3f Pks:%d\r\n",
-                heartRate, spo2, dc_ir, ac_ir, dc_red, ac_red, ratio, peaks);
-        secure_uart_send((uint8_t*)data_buf, strlen(data_buf));
-
-        hr_buffer_full = 0;
-        hr_buffer_idx = 0;
-    }
-}
-
-float calculateDC(uint16_t *samples, uint16_t size) {
-    if (size == 0) return 0.0f;
-    uint32_t sum = 0;
-    for (uint16_t i = 0; i < size; i++) {
-        sum += samples[i];
-    }
-    return (float)sum / size;
-}
-
-float calculateAC(uint16_t *samples, uint16_t size) {
-    if (size < 2) return 0.0f; // Need at least 2 samples for a difference
-    uint16_t max_val = samples[0];
-    uint16_t min_val = samples[0];
-    for (uint16_t i = 1; i < size; i++) {
-        if (samples[i] > max_val) max_val = samples[i];
-        if (samples[i] < min_val) min_val = samples[i];
-    }
-    return (float)(max_val - min_val);
-}
-
-int countPeaks(uint16_t *samples, uint16_t size, float threshold, float min_peak_distance_samples) {
-    int peak_count = 0;
-    uint16_t last_peak_idx = 0; // Initialize to 0 or a value that ensures first peak can be detected
-
-    if (size < 3) return 0;
-
-    for (uint16_t i = 1; i < size - 1; i++) {
-        // Basic peak: higher than neighbors and above threshold
-        if (samples[i] > threshold && samples[i] > samples[i-1] && samples[i] >= samples[i+1]) {
-            // Check minimum distance from the previously detected peak
-            if (last_peak_idx == 0 || (i - last_peak_idx) >= min_peak_distance_samples) {
-                 peak_count++;
-                 last_peak_idx = i;
-            }
-        }
-    }
-    return peak_count;
-}
-
-// Reads temperature from LM35 sensor connected to PA3 (ADC1_INP15)
-void readLM35Temperature(void) {
-    uint32_t adc_sum = 0;
-    const int num_samples = 32; // Number of samples to average
-
-    // Ensure ADC is started and poll for conversion
-    // This assumes hadc1 is already configured for PA3 (ADC1_INP15) in MX_ADC1_Init()
-    if (HAL_ADC_Start(&hadc1) != HAL_OK) {
-        printf("Error: HAL_ADC_Start failed for LM35.\r\n");
-        return;
-    }
-
-    for (int i = 0; i < num_samples; i++) {
-        if (HAL_ADC_PollForConversion(&hadc1, 100) == HAL_OK) { // 100ms timeout per conversion
-            adc_sum += HAL_ADC_GetValue(&hadc1);
-        } else {
-            printf("Warning: ADC Poll for LM35 timed out on sample %d.\r\n", i + 1);
-            // Optionally break or continue with fewer samples
-        }
-    }
-    HAL_ADC_Stop(&hadc1);
-
-    if (num_samples == 0) return; // Should not happen with const > 0
-    uint32_t raw_adc = adc_sum / num_samples;
-
-    // VREF typically 3.3V. STM32H7 ADC can be 16-bit (65535) or 12-bit (4095) etc.
-    // Check your CubeMX ADC resolution setting. Default for many H7 is 16-bit.
-    // If ADC resolution is 12-bit, use 4095.0f. If 16-bit, use 65535.0f.
-    float adc_resolution_divider = 65535.0f; // Assuming 16-bit resolution
-    // float adc_resolution_divider = 4095.0f; // If using 12-bit resolution
-
-    float voltage = (raw_adc * 3.3f) / adc_resolution_divider;
-    float tempC = voltage * 100.0f;  // LM35: 10mV/°C -> V / 0.01 = V * 100
-
-    char buf[50]; // Increased buffer size
-    sprintf(buf, "LM35 Temp: %.1f C (ADC Raw Avg: %lu)\r\n", tempC, raw_adc);
-    secure_uart_send((uint8_t*)buf, strlen(buf));
+  /* USER CODE END 3 */
 }
 
 /**
@@ -638,6 +418,12 @@ static void MX_DMA_Init(void)
   /* DMA1_Stream0_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, 5, 0);
   HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+  /* DMA1_Stream1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+  /* DMA1_Stream2_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream2_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream2_IRQn);
 
 }
 
@@ -658,11 +444,11 @@ static void MX_GPIO_Init(void)
   __HAL_RCC_GPIOB_CLK_ENABLE();
 
   /* USER CODE BEGIN MX_GPIO_Init_2 */
-  // Configure MAX30100 INT pin on PB5 as EXTI rising edge (adjust if wired differently)
+  // MAX30100 INT on PB5: open-drain, active low, asserted until the status register is read
   GPIO_InitTypeDef GPIO_InitStruct = {0};
   GPIO_InitStruct.Pin = GPIO_PIN_5;
-  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
-  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
   HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
   // Enable EXTI line interrupt for PB5
@@ -699,6 +485,22 @@ int _write(int file, char *ptr, int len)
   return len;
 }
 
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  UartRx_Event(huart, Size);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  secure_uart_tx_complete(huart);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  secure_uart_tx_error(huart);
+  UartRx_Error(huart);
+}
+
 /* USER CODE END 4 */
 
 /* USER CODE BEGIN Header_StartDefaultTask */
@@ -712,9 +514,11 @@ void StartDefaultTask(void *argument)
 {
   /* USER CODE BEGIN 5 */
   /* Infinite loop */
+  // The application runs in the tasks created by AppTasks_Init(); this one only reports health
   for(;;)
   {
-    osDelay(1);
+    osDelay(APP_HEALTH_PERIOD_MS);
+    AppTasks_ReportHealth();
   }
   /* USER CODE END 5 */
 }
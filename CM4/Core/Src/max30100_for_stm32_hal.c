@@ -2,6 +2,8 @@
 /* Libraries by @eepj www.github.com/eepj - Modified based on analysis */
 
 #include "max30100_for_stm32_hal.h"
+#include "tracer.h"
+#include "dlog.h"
 
 // Global I2C Handle (initialized in MAX30100_Init)
 static I2C_HandleTypeDef *_max30100_i2c_handle = NULL;
@@ -13,6 +15,7 @@ float max30100_last_temperature = 0.0f;
 
 // Global flag set by ISR, cleared by application
 volatile uint8_t max30100_new_data_available = 0;
+volatile uint8_t max30100_new_temp_available = 0;
 
 // Internal helper to read temperature registers
 static HAL_StatusTypeDef MAX30100_ReadTemperatureRegisters(int8_t *temp_int, uint8_t *temp_frac) {
@@ -23,18 +26,22 @@ static HAL_StatusTypeDef MAX30100_ReadTemperatureRegisters(int8_t *temp_int, uin
 
 HAL_StatusTypeDef MAX30100_ReadReg(uint8_t regAddr, uint8_t *pData) {
     if (_max30100_i2c_handle == NULL) return HAL_ERROR;
+    TRACE_EVENT(TRACE_EV_I2C_BEGIN, regAddr, 1U);
     HAL_StatusTypeDef status = HAL_I2C_Mem_Read(_max30100_i2c_handle, MAX30100_I2C_ADDR, regAddr, I2C_MEMADD_SIZE_8BIT, pData, 1, MAX30100_I2C_TIMEOUT);
+    TRACE_EVENT(TRACE_EV_I2C_END, status, 0U);
     if (status != HAL_OK) {
-        printf("MAX30100 I2C Read Error Reg:0x%02X, Status:%d\n", regAddr, status);
+        DLOG2(MAX30100_READ_ERR, regAddr, status);
     }
     return status;
 }
 
 HAL_StatusTypeDef MAX30100_WriteReg(uint8_t regAddr, uint8_t data) {
     if (_max30100_i2c_handle == NULL) return HAL_ERROR;
+    TRACE_EVENT(TRACE_EV_I2C_BEGIN, regAddr, 1U);
     HAL_StatusTypeDef status = HAL_I2C_Mem_Write(_max30100_i2c_handle, MAX30100_I2C_ADDR, regAddr, I2C_MEMADD_SIZE_8BIT, &data, 1, MAX30100_I2C_TIMEOUT);
+    TRACE_EVENT(TRACE_EV_I2C_END, status, 0U);
     if (status != HAL_OK) {
-         printf("MAX30100 I2C Write Error Reg:0x%02X, Data:0x%02X, Status:%d\n", regAddr, data, status);
+         DLOG3(MAX30100_WRITE_ERR, regAddr, data, status);
     }
     return status;
 }
@@ -56,7 +63,7 @@ HAL_StatusTypeDef MAX30100_Reset(void) {
     } while (retry < 10);
 
     if (retry == 10) {
-        printf("MAX30100 Reset bit did not clear.\n");
+        DLOG0(MAX30100_RESET_STUCK);
         return HAL_ERROR;
     }
     return HAL_OK;
@@ -67,14 +74,14 @@ HAL_StatusTypeDef MAX30100_Init(I2C_HandleTypeDef *hi2c) {
     max30100_new_data_available = 0;
 
     if (MAX30100_Reset() != HAL_OK) {
-        printf("MAX30100 Reset failed.\n");
+        DLOG0(MAX30100_RESET_FAIL);
         return HAL_ERROR;
     }
 
     // Verify Part ID
-    uint8_t part_id;
+    uint8_t part_id = 0;
     if (MAX30100_ReadReg(MAX30100_PART_ID, &part_id) != HAL_OK || part_id != 0x11) {
-         printf("MAX30100 Part ID mismatch or read error. Expected 0x11, got 0x%02X\n", part_id);
+         DLOG1(MAX30100_PART_ID, part_id);
         // return HAL_ERROR; // Continue for now, could be an issue with some modules/clones
     }
 
@@ -123,7 +130,7 @@ void MAX30100_InterruptHandler(void) {
         uint8_t temp_frac;
         if (MAX30100_ReadTemperatureRegisters(&temp_int, &temp_frac) == HAL_OK) {
             max30100_last_temperature = (float)temp_int + ((float)temp_frac * 0.0625f);
-            // Optionally, set another flag like: max30100_new_temp_data_available = 1;
+            max30100_new_temp_available = 1;
         }
         // Temp ready interrupt is usually one-shot; re-enable A_FULL if it was the primary one
         // Or simply ensure A_FULL interrupt enable wasn't cleared by temp reading logic.
@@ -175,8 +182,10 @@ HAL_StatusTypeDef MAX30100_ReadFifoData(uint16_t* ir_data, uint16_t* red_data, u
     uint8_t raw_fifo_data[MAX30100_BUFFER_SIZE_BYTES]; // Max 64 bytes for 16 samples
     uint16_t bytes_to_read = num_samples * MAX30100_BYTES_PER_SAMPLE;
 
+    TRACE_EVENT(TRACE_EV_I2C_BEGIN, MAX30100_FIFO_DATA, bytes_to_read);
     HAL_StatusTypeDef status = HAL_I2C_Mem_Read(_max30100_i2c_handle, MAX30100_I2C_ADDR, MAX30100_FIFO_DATA,
                                            I2C_MEMADD_SIZE_8BIT, raw_fifo_data, bytes_to_read, MAX30100_I2C_TIMEOUT);
+    TRACE_EVENT(TRACE_EV_I2C_END, status, 0U);
 
     if (status == HAL_OK) {
         for (uint8_t i = 0; i < num_samples; i++) {
@@ -190,7 +199,7 @@ HAL_StatusTypeDef MAX30100_ReadFifoData(uint16_t* ir_data, uint16_t* red_data, u
             red_data[i] = red_sample_raw;
         }
     } else {
-         printf("MAX30100 FIFO Read Error: %d\n", status);
+         DLOG2(MAX30100_FIFO_ERR, status, bytes_to_read);
     }
     return status;
 }
@@ -239,13 +248,22 @@ HAL_StatusTypeDef MAX30100_ReadTemperature(float *pTemperature) {
 
 
     if (!(temp_int_status & MAX30100_INT_TEMP_RDY_MASK)) {
-        printf("MAX30100 Temp Read Timeout or Error.\n");
+        DLOG0(MAX30100_TEMP_ERR);
         return HAL_TIMEOUT;
     }
 
     return HAL_OK;
 }
 
+HAL_StatusTypeDef MAX30100_StartTemperature(void) {
+    uint8_t mode_cfg;
+    if (MAX30100_ReadReg(MAX30100_MODE_CONFIG, &mode_cfg) != HAL_OK) return HAL_ERROR;
+    // TEMP_EN clears itself once the conversion (~29ms) is done
+    mode_cfg &= ~(MAX30100_MODE_SHDN_MASK | MAX30100_MODE_RESET_MASK);
+    if (MAX30100_WriteReg(MAX30100_MODE_CONFIG, mode_cfg | MAX30100_MODE_TEMP_EN_MASK) != HAL_OK) return HAL_ERROR;
+    return MAX30100_ConfigInterrupts(1, 1);
+}
+
 HAL_StatusTypeDef MAX30100_Shutdown(void) {
     uint8_t mode_cfg_val;
     if (MAX30100_ReadReg(MAX30100_MODE_CONFIG, &mode_cfg_val) != HAL_OK) return HAL_ERROR;
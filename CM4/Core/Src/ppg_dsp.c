@@ -0,0 +1,70 @@
+/* PPG processing: heart rate and SpO2 from a window of MAX30100 IR/RED samples. */
+
+#include "ppg_dsp.h"
+
+void PPG_Compute(const uint16_t *ir, const uint16_t *red, uint16_t size, float sample_rate_hz, ppg_result_t *out)
+{
+  out->dc_ir = calculateDC(ir, size);
+  out->dc_red = calculateDC(red, size);
+  out->ac_ir = calculateAC(ir, size);
+  out->ac_red = calculateAC(red, size);
+  out->ratio = 0.0f;
+  out->spo2_pct = 0.0f;
+
+  if (out->dc_ir > 1000 && out->dc_red > 1000 && out->ac_ir > 20 && out->ac_red > 20) {
+    out->ratio = (out->ac_red / out->dc_red) / (out->ac_ir / out->dc_ir);
+    // Linear calibration; the quadratic -45.060*R*R + 30.354*R + 94.845 is an alternative
+    out->spo2_pct = -45.060f * out->ratio + 110.4f;
+    if (out->spo2_pct > 100.0f) out->spo2_pct = 100.0f;
+    if (out->spo2_pct < 70.0f) out->spo2_pct = 70.0f;
+  }
+
+  float peak_threshold = out->dc_ir + (out->ac_ir * 0.3f);
+  float min_peak_dist_samples = sample_rate_hz / (240.0f / 60.0f); // For max HR of 240bpm
+  out->peaks = countPeaks(ir, size, peak_threshold, min_peak_dist_samples);
+
+  out->heart_rate_bpm = 0.0f;
+  if (out->peaks > 0) {
+    float window_duration_sec = (float)size / sample_rate_hz;
+    out->heart_rate_bpm = (float)out->peaks * 60.0f / window_duration_sec;
+  }
+}
+
+float calculateDC(const uint16_t *samples, uint16_t size) {
+    if (size == 0) return 0.0f;
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < size; i++) {
+        sum += samples[i];
+    }
+    return (float)sum / size;
+}
+
+float calculateAC(const uint16_t *samples, uint16_t size) {
+    if (size < 2) return 0.0f; // Need at least 2 samples for a difference
+    uint16_t max_val = samples[0];
+    uint16_t min_val = samples[0];
+    for (uint16_t i = 1; i < size; i++) {
+        if (samples[i] > max_val) max_val = samples[i];
+        if (samples[i] < min_val) min_val = samples[i];
+    }
+    return (float)(max_val - min_val);
+}
+
+int countPeaks(const uint16_t *samples, uint16_t size, float threshold, float min_peak_distance_samples) {
+    int peak_count = 0;
+    uint16_t last_peak_idx = 0; // Initialize to 0 or a value that ensures first peak can be detected
+
+    if (size < 3) return 0;
+
+    for (uint16_t i = 1; i < size - 1; i++) {
+        // Basic peak: higher than neighbors and above threshold
+        if (samples[i] > threshold && samples[i] > samples[i-1] && samples[i] >= samples[i+1]) {
+            // Check minimum distance from the previously detected peak
+            if (last_peak_idx == 0 || (i - last_peak_idx) >= min_peak_distance_samples) {
+                 peak_count++;
+                 last_peak_idx = i;
+            }
+        }
+    }
+    return peak_count;
+}
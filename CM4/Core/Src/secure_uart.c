@@ -0,0 +1,452 @@
+/* Batched, AES-GCM sealed UART link to the ESP32 bridge, with NACK retransmission. */
+
+#include "secure_uart.h"
+#include "aes_gcm.h"
+#include "cmsis_os.h"
+#include "lowpower.h"
+#include "telemetry_proto.h"
+#include "tracer.h"
+#include "uart_rx.h"
+#include <string.h>
+
+#define SUTX_FLAG_FREE        (1UL << 8)    // Thread flag: a pool buffer came back
+
+// DMA1 reaches D2 SRAM only at 0x30000000; the CM4 image uses its 0x10000000 alias
+#define SUTX_D2_ALIAS_BASE    (0x10000000UL)
+#define SUTX_D2_ALIAS_END     (0x10048000UL)
+#define SUTX_D2_DMA_OFFSET    (0x20000000UL)
+
+#define SUTX_RNG_TIMEOUT      (100000UL)    // Polls; the first word takes a few hundred cycles
+
+_Static_assert(SECURE_UART_POOL_LEN >= 2U, "drop-oldest needs a frame that is not in flight");
+_Static_assert(SECURE_UART_PAYLOAD_MAX <= TP_BATCH_ITEM_MAX, "payload must fit one batch");
+_Static_assert(TP_BATCH_MAX <= AES_GCM_KS_BLOCKS * AES_FAST_BLOCKLEN, "a full batch should not outrun the keystream cache");
+_Static_assert(SECURE_UART_RETX_LEN < TP_LINK_NACK_WINDOW, "the receiver would refuse the oldest retransmissions");
+
+typedef struct {
+  uint16_t len;
+  uint8_t  data[SECURE_UART_FRAME_MAX];
+} sutx_buf_t;
+
+static UART_HandleTypeDef *s_huart = NULL;
+
+#if ENABLE_AES_UART
+static const uint8_t kAesKey128[16] = { 0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
+static aes_gcm_t s_gcm;                 // Key expanded once, keystream filled from idle
+#endif
+static uint32_t g_uart_session = 0;     // Nonce prefix, new every boot
+static uint32_t g_uart_iv_counter = 1;  // Batch counter, rest of the nonce
+
+// Items wait here until the batch is full, old or committed
+static tp_batch_t s_batch;
+static uint32_t s_batch_start = 0;
+
+// Buffers move free list -> queue (oldest first) -> free list. When s_busy,
+// s_queue[0] is the frame the DMA is sending. All three change with IRQs masked.
+static sutx_buf_t s_pool[SECURE_UART_POOL_LEN];
+static uint8_t s_free[SECURE_UART_POOL_LEN];
+static uint32_t s_free_count = 0;
+static uint8_t s_queue[SECURE_UART_POOL_LEN];
+static volatile uint32_t s_queue_count = 0;
+static volatile uint8_t s_busy = 0;
+static osThreadId_t s_waiter = NULL;
+static volatile uint8_t s_paused = 0;   // Rate switch: nothing new starts on the wire
+static secure_uart_stats_t s_stats;
+
+// Every sealed frame, at s_retx[ctr % SECURE_UART_RETX_LEN], until overwritten
+static sutx_buf_t s_retx[SECURE_UART_RETX_LEN];
+static uint32_t s_retx_ctr[SECURE_UART_RETX_LEN];
+
+// Link messages from the ESP32 (RX interrupt), served by secure_uart_poll()
+static tp_decoder_t s_ctl_dec;
+static volatile uint32_t s_link_heard = 0;    // Tick of the last message
+static volatile uint8_t s_hello_pending = 0;
+static volatile uint32_t s_hello_baud = 0;
+static volatile uint8_t s_hello_flags = 0;
+static uint32_t s_nack_first = 0;             // Pending range, IRQs masked
+static uint32_t s_nack_count = 0;
+static uint32_t s_link_baud = TP_LINK_BAUD_BASE;
+static uint8_t s_link_flags = 0;
+
+static uint8_t *sutx_dma_addr(uint8_t *p)
+{
+  uint32_t a = (uint32_t)p;
+  if (a >= SUTX_D2_ALIAS_BASE && a < SUTX_D2_ALIAS_END) a += SUTX_D2_DMA_OFFSET;
+  return (uint8_t *)a;
+}
+
+static int sutx_alloc(void)
+{
+  int idx = -1;
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (s_free_count > 0U) idx = s_free[--s_free_count];
+  __set_PRIMASK(primask);
+  return idx;
+}
+
+// IRQs masked. Takes the oldest frame that is not on the wire yet.
+static int sutx_drop_oldest(void)
+{
+  uint32_t victim = s_busy ? 1U : 0U;
+  if (victim >= s_queue_count) return -1;
+
+  int idx = s_queue[victim];
+  for (uint32_t i = victim; i + 1U < s_queue_count; i++) s_queue[i] = s_queue[i + 1U];
+  s_queue_count--;
+  s_stats.drops_oldest++;
+  return idx;
+}
+
+// IRQs masked or in the UART/DMA interrupt
+static void sutx_start_next(void)
+{
+  while (!s_busy && !s_paused && s_queue_count > 0U) {
+    sutx_buf_t *buf = &s_pool[s_queue[0]];
+
+    s_busy = 1;
+    LowPower_Hold();  // DMA1 has no clock in D2 STOP
+    TRACE_EVENT(TRACE_EV_UART_TX_BEGIN, 0U, buf->len);
+    if (HAL_UART_Transmit_DMA(s_huart, sutx_dma_addr(buf->data), buf->len) == HAL_OK) return;
+
+    TRACE_EVENT(TRACE_EV_UART_TX_END, HAL_ERROR, 0U);
+    s_stats.errors++;
+    s_busy = 0;
+    LowPower_Release();
+    s_free[s_free_count++] = s_queue[0];
+    for (uint32_t i = 0; i + 1U < s_queue_count; i++) s_queue[i] = s_queue[i + 1U];
+    s_queue_count--;
+  }
+}
+
+// UART/DMA interrupt: the head frame is done, sent or not
+static void sutx_finish(uint8_t status)
+{
+  TRACE_EVENT(TRACE_EV_UART_TX_END, status, 0U);
+  s_free[s_free_count++] = s_queue[0];
+  for (uint32_t i = 0; i + 1U < s_queue_count; i++) s_queue[i] = s_queue[i + 1U];
+  s_queue_count--;
+  s_busy = 0;
+  LowPower_Release();
+  sutx_start_next();
+  if (s_waiter != NULL) osThreadFlagsSet(s_waiter, SUTX_FLAG_FREE);
+}
+
+// Session id from the RNG (HSI48 kernel clock). If the RNG does not come up
+// the UID and the boot time are mixed instead: weaker, but still differs
+// between boards and, usually, between boots.
+static uint32_t sutx_session_id(void)
+{
+  uint32_t id = 0;
+  uint32_t polls = 0;
+  uint8_t hsi48_was_on = (READ_BIT(RCC->CR, RCC_CR_HSI48ON) != 0U);
+
+  __HAL_RCC_HSI48_ENABLE();
+  while (!__HAL_RCC_GET_FLAG(RCC_FLAG_HSI48RDY) && polls++ < SUTX_RNG_TIMEOUT) {
+  }
+  __HAL_RCC_RNG_CLK_ENABLE();
+  RNG->CR |= RNG_CR_RNGEN;
+  polls = 0;
+  while ((RNG->SR & RNG_SR_DRDY) == 0U && polls++ < SUTX_RNG_TIMEOUT) {
+  }
+  if ((RNG->SR & (RNG_SR_DRDY | RNG_SR_SECS | RNG_SR_CECS)) == RNG_SR_DRDY) id = RNG->DR;
+  RNG->CR &= ~RNG_CR_RNGEN;
+  __HAL_RCC_RNG_CLK_DISABLE();
+  if (!hsi48_was_on) __HAL_RCC_HSI48_DISABLE();  // Nothing else runs on it
+
+  if (id == 0U) {
+    const uint32_t *uid = (const uint32_t *)UID_BASE;
+    id = (uid[0] ^ (uid[1] * 0x9E3779B9UL) ^ (uid[2] << 7)) + HAL_GetTick() * 0x85EBCA6BUL + SysTick->VAL;
+  }
+  return id;
+}
+
+// Back-pressure first, then make room by dropping the stalest telemetry
+static int sutx_take_buffer(void)
+{
+  int idx = sutx_alloc();
+  if (idx >= 0) return idx;
+
+  uint32_t start = osKernelGetTickCount();
+  s_stats.waits++;
+  s_waiter = osThreadGetId();
+  while ((idx = sutx_alloc()) < 0) {
+    uint32_t waited = osKernelGetTickCount() - start;
+    if (waited >= SECURE_UART_WAIT_MS) break;
+    osThreadFlagsWait(SUTX_FLAG_FREE, osFlagsWaitAny, SECURE_UART_WAIT_MS - waited);
+  }
+  s_waiter = NULL;
+  if (idx < 0) {
+    __disable_irq();
+    idx = sutx_drop_oldest();
+    __enable_irq();
+  }
+  return idx;
+}
+
+// Seals the batch into one frame, COBS([hdr][ciphertext][tag][crc16]) 0x00, and queues it
+static void sutx_seal(void)
+{
+  if (s_batch.count == 0U) return;
+
+  int idx = sutx_take_buffer();
+  if (idx >= 0) {
+    sutx_buf_t *buf = &s_pool[idx];
+    uint8_t body[TP_BODY_MAX];
+    tp_seal_hdr_t hdr = { g_uart_session, g_uart_iv_counter };
+    size_t len = TP_SEAL_HDR_LEN + s_batch.len;
+
+    memcpy(body, &hdr, TP_SEAL_HDR_LEN);
+    memcpy(&body[TP_SEAL_HDR_LEN], s_batch.buf, s_batch.len);
+#if ENABLE_AES_UART
+    AesGcm_Seal(&s_gcm, g_uart_iv_counter, body, TP_SEAL_HDR_LEN, &body[TP_SEAL_HDR_LEN], s_batch.len, &body[len]);
+    len += TP_SEAL_TAG_LEN;
+#endif
+    buf->len = (uint16_t)TlmProto_FrameEncode(body, len, buf->data, sizeof(buf->data));
+
+    uint32_t slot = g_uart_iv_counter % SECURE_UART_RETX_LEN;
+    memcpy(s_retx[slot].data, buf->data, buf->len);
+    s_retx[slot].len = buf->len;
+    s_retx_ctr[slot] = g_uart_iv_counter;
+
+    __disable_irq();
+    s_queue[s_queue_count++] = (uint8_t)idx;
+    if (s_queue_count > s_stats.queued_max) s_stats.queued_max = s_queue_count;
+    sutx_start_next();
+    __enable_irq();
+  }
+  // A dropped batch still uses up its counter, the receiver counts the gap
+  g_uart_iv_counter++;
+  TlmProto_BatchInit(&s_batch);
+}
+
+// A frame asked for again, from the history, ahead of every new frame
+static void sutx_resend(uint32_t ctr)
+{
+  uint32_t slot = ctr % SECURE_UART_RETX_LEN;
+  if (s_retx_ctr[slot] != ctr || s_retx[slot].len == 0U) {
+    s_stats.retx_expired++;
+    return;
+  }
+
+  int idx = sutx_take_buffer();
+  if (idx < 0) {
+    s_stats.retx_expired++;
+    return;
+  }
+  memcpy(s_pool[idx].data, s_retx[slot].data, s_retx[slot].len);
+  s_pool[idx].len = s_retx[slot].len;
+
+  __disable_irq();
+  uint32_t at = s_busy ? 1U : 0U;
+  for (uint32_t i = s_queue_count; i > at; i--) s_queue[i] = s_queue[i - 1U];
+  s_queue[at] = (uint8_t)idx;
+  s_queue_count++;
+  if (s_queue_count > s_stats.queued_max) s_stats.queued_max = s_queue_count;
+  s_stats.retransmits++;
+  sutx_start_next();
+  __enable_irq();
+}
+
+// Reprograms USART3. The frame on the wire is given SECURE_UART_WAIT_MS to
+// finish (CTS may hold it), then cut; the queue resumes at the new rate.
+static void sutx_link_config(uint32_t baud, uint8_t flags)
+{
+  uint32_t start = osKernelGetTickCount();
+
+  s_paused = 1;
+  while (s_busy && (osKernelGetTickCount() - start) < SECURE_UART_WAIT_MS) osDelay(1);
+  if (s_busy) {
+    HAL_UART_AbortTransmit(s_huart);  // Blocking, no callback
+    __disable_irq();
+    if (s_busy) {
+      s_stats.errors++;
+      sutx_finish(HAL_ERROR);
+    }
+    __enable_irq();
+  }
+
+  HAL_UART_AbortReceive(s_huart);
+  s_huart->Init.BaudRate = baud;
+  s_huart->Init.HwFlowCtl = (flags & TP_LINK_RTSCTS) ? UART_HWCONTROL_RTS_CTS : UART_HWCONTROL_NONE;
+  HAL_StatusTypeDef st = HAL_UART_Init(s_huart);  // The MSP is not run again: pins stay
+  TlmProto_DecoderInit(&s_ctl_dec);
+  UartRx_Resume();
+  s_link_baud = baud;
+  s_link_flags = flags;
+
+  __disable_irq();
+  if (st != HAL_OK) s_stats.errors++;
+  s_stats.baud = baud;
+  s_stats.link_changes++;
+  s_paused = 0;
+  sutx_start_next();
+  __enable_irq();
+}
+
+// HELLO from the ESP32: agree in a sealed ACCEPT, sent at the old rate, then switch
+static void sutx_accept(uint32_t baud, uint8_t flags)
+{
+  if (baud < TP_LINK_BAUD_BASE || baud > SECURE_UART_BAUD_MAX) return;  // The ESP32 stays where it is
+  flags &= TP_LINK_RTSCTS;
+
+  tp_link_t accept = { TP_LINK_TAG, TP_LINK_ACCEPT, flags, 0U, 0U, baud };
+  secure_uart_send((const uint8_t *)&accept, (uint16_t)sizeof(accept));
+  secure_uart_flush(1000U);
+  sutx_link_config(baud, flags);
+  osDelay(SECURE_UART_SWITCH_GUARD_MS);
+}
+
+static void sutx_service(void)
+{
+  if (s_hello_pending) {
+    s_hello_pending = 0;
+    uint32_t baud = s_hello_baud;
+    uint8_t flags = s_hello_flags;
+    if (baud != s_link_baud || (flags & TP_LINK_RTSCTS) != s_link_flags) sutx_accept(baud, flags);
+  } else if (s_link_baud != TP_LINK_BAUD_BASE &&
+             (osKernelGetTickCount() - s_link_heard) > SECURE_UART_LINK_TIMEOUT_MS) {
+    // ESP32 reset or unplugged: it starts over at the base rate
+    s_stats.link_timeouts++;
+    sutx_link_config(TP_LINK_BAUD_BASE, 0U);
+  }
+
+  __disable_irq();
+  uint32_t first = s_nack_first;
+  uint32_t count = s_nack_count;
+  s_nack_count = 0;
+  __enable_irq();
+  if (count > SECURE_UART_RETX_LEN) {
+    s_stats.retx_expired += count - SECURE_UART_RETX_LEN;
+    first += count - SECURE_UART_RETX_LEN;
+    count = SECURE_UART_RETX_LEN;
+  }
+  for (uint32_t i = 0; i < count; i++) sutx_resend(first + i);
+}
+
+void secure_uart_init(UART_HandleTypeDef *huart)
+{
+  s_huart = huart;
+  memset(&s_stats, 0, sizeof(s_stats));
+  for (uint32_t i = 0; i < SECURE_UART_POOL_LEN; i++) s_free[i] = (uint8_t)i;
+  s_free_count = SECURE_UART_POOL_LEN;
+  s_queue_count = 0;
+  s_busy = 0;
+  s_paused = 0;
+  memset(s_retx_ctr, 0, sizeof(s_retx_ctr));
+  TlmProto_DecoderInit(&s_ctl_dec);
+  s_link_baud = huart->Init.BaudRate;
+  s_link_flags = (huart->Init.HwFlowCtl == UART_HWCONTROL_RTS_CTS) ? TP_LINK_RTSCTS : 0U;
+  s_stats.baud = s_link_baud;
+  TlmProto_BatchInit(&s_batch);
+  g_uart_session = sutx_session_id();
+  s_stats.session = g_uart_session;
+#if ENABLE_AES_UART
+  uint8_t nonce[TP_NONCE_LEN];
+  TlmProto_Nonce(g_uart_session, 0U, nonce);
+  AesGcm_Init(&s_gcm, kAesKey128, nonce, g_uart_iv_counter);
+#endif
+}
+
+void secure_uart_idle(void)
+{
+#if ENABLE_AES_UART
+  if (s_huart != NULL) AesGcm_Refill(&s_gcm, AES_GCM_KS_BLOCKS);
+#endif
+}
+
+void secure_uart_send(const uint8_t* data, uint16_t len)
+{
+  if (s_huart == NULL || len == 0U) return;
+
+  uint16_t copy_len = (len > SECURE_UART_PAYLOAD_MAX) ? SECURE_UART_PAYLOAD_MAX : len; // truncate if oversized
+  if (!TlmProto_BatchAdd(&s_batch, data, copy_len)) {
+    sutx_seal();
+    TlmProto_BatchAdd(&s_batch, data, copy_len);
+  }
+  if (s_batch.count == 1U) s_batch_start = osKernelGetTickCount();
+  s_stats.items++;
+}
+
+void secure_uart_commit(void)
+{
+  sutx_seal();
+}
+
+uint32_t secure_uart_poll(void)
+{
+  sutx_service();
+  if (s_batch.count == 0U) return osWaitForever;
+
+  uint32_t age = osKernelGetTickCount() - s_batch_start;
+  if (age < SECURE_UART_BATCH_MS) return SECURE_UART_BATCH_MS - age;
+  sutx_seal();
+  return osWaitForever;
+}
+
+HAL_StatusTypeDef secure_uart_flush(uint32_t timeout_ms)
+{
+  uint32_t start = osKernelGetTickCount();
+
+  sutx_seal();
+  while (s_busy || s_queue_count > 0U) {
+    if ((osKernelGetTickCount() - start) >= timeout_ms) return HAL_TIMEOUT;
+    osDelay(1);
+  }
+  return HAL_OK;
+}
+
+void secure_uart_tx_complete(UART_HandleTypeDef *huart)
+{
+  if (huart != s_huart || !s_busy) return;
+  s_stats.frames_sent++;
+  s_stats.bytes_sent += s_pool[s_queue[0]].len;
+  sutx_finish(HAL_OK);
+}
+
+void secure_uart_tx_error(UART_HandleTypeDef *huart)
+{
+  // RX errors (uart_rx.c) leave the transmitter running
+  if (huart != s_huart || !s_busy || huart->gState != HAL_UART_STATE_READY) return;
+  s_stats.errors++;
+  sutx_finish(HAL_ERROR);
+}
+
+void secure_uart_rx_byte(uint8_t byte)
+{
+  const uint8_t *body = NULL;
+  size_t n = TlmProto_DecoderFeed(&s_ctl_dec, byte, &body);
+  const tp_link_t *msg = (n != 0U) ? TlmProto_LinkView(body, n) : NULL;
+  if (msg == NULL) return;
+
+  s_link_heard = osKernelGetTickCount();
+  if (msg->op == TP_LINK_HELLO) {
+    s_hello_baud = msg->value;
+    s_hello_flags = msg->flags;
+    s_hello_pending = 1;
+  } else if (msg->op == TP_LINK_NACK && msg->session == g_uart_session && msg->count != 0U) {
+    // Ranges not served yet merge
+    uint32_t first = msg->value;
+    uint32_t end = first + msg->count;
+    s_stats.nacks++;
+    if (s_nack_count != 0U) {
+      uint32_t pend_end = s_nack_first + s_nack_count;
+      if (s_nack_first < first) first = s_nack_first;
+      if (pend_end > end) end = pend_end;
+    }
+    s_nack_first = first;
+    s_nack_count = end - first;
+  }
+}
+
+void secure_uart_get_stats(secure_uart_stats_t *out)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *out = s_stats;
+  __set_PRIMASK(primask);
+#if ENABLE_AES_UART
+  out->ks_hits = s_gcm.hits;
+  out->ks_misses = s_gcm.misses;
+#endif
+}
@@ -24,7 +24,10 @@
 #include "task.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "max30100_for_stm32_hal.h"
+#include "app_tasks.h"
+#include "lowpower.h"
+#include "runtime_stats.h"
+#include "tracer.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -62,6 +65,8 @@ extern ADC_HandleTypeDef hadc1;
 extern DMA_HandleTypeDef hdma_i2c1_rx;
 extern I2C_HandleTypeDef hi2c1;
 extern TIM_HandleTypeDef htim6;
+extern DMA_HandleTypeDef hdma_usart3_rx;
+extern DMA_HandleTypeDef hdma_usart3_tx;
 extern UART_HandleTypeDef huart3;
 /* USER CODE BEGIN EV */
 
@@ -164,7 +169,7 @@ void DebugMon_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  RunTimeStats_IsrEnter();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
 #if (INCLUDE_xTaskGetSchedulerState == 1 )
@@ -176,7 +181,7 @@ void SysTick_Handler(void)
   }
 #endif /* INCLUDE_xTaskGetSchedulerState */
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  RunTimeStats_IsrExit();
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -201,6 +206,34 @@ void DMA1_Stream0_IRQHandler(void)
   /* USER CODE END DMA1_Stream0_IRQn 1 */
 }
 
+/**
+  * @brief This function handles DMA1 stream1 global interrupt.
+  */
+void DMA1_Stream1_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream1_IRQn 0 */
+  RunTimeStats_IsrEnter();
+  /* USER CODE END DMA1_Stream1_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart3_tx);
+  /* USER CODE BEGIN DMA1_Stream1_IRQn 1 */
+  RunTimeStats_IsrExit();
+  /* USER CODE END DMA1_Stream1_IRQn 1 */
+}
+
+/**
+  * @brief This function handles DMA1 stream2 global interrupt.
+  */
+void DMA1_Stream2_IRQHandler(void)
+{
+  /* USER CODE BEGIN DMA1_Stream2_IRQn 0 */
+  RunTimeStats_IsrEnter();
+  /* USER CODE END DMA1_Stream2_IRQn 0 */
+  HAL_DMA_IRQHandler(&hdma_usart3_rx);
+  /* USER CODE BEGIN DMA1_Stream2_IRQn 1 */
+  RunTimeStats_IsrExit();
+  /* USER CODE END DMA1_Stream2_IRQn 1 */
+}
+
 /**
   * @brief This function handles ADC1 and ADC2 global interrupts.
   */
@@ -249,11 +282,13 @@ void I2C1_ER_IRQHandler(void)
 void USART3_IRQHandler(void)
 {
   /* USER CODE BEGIN USART3_IRQn 0 */
-
+  RunTimeStats_IsrEnter();
+  TRACE_EVENT(TRACE_EV_ISR_ENTER, TRACE_IRQ_USART3, 0U);
   /* USER CODE END USART3_IRQn 0 */
   HAL_UART_IRQHandler(&huart3);
   /* USER CODE BEGIN USART3_IRQn 1 */
-
+  TRACE_EVENT(TRACE_EV_ISR_EXIT, TRACE_IRQ_USART3, 0U);
+  RunTimeStats_IsrExit();
   /* USER CODE END USART3_IRQn 1 */
 }
 
@@ -304,12 +339,29 @@ void FPU_IRQHandler(void)
 void EXTI9_5_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI9_5_IRQn 0 */
+  RunTimeStats_IsrEnter();
+  TRACE_EVENT(TRACE_EV_ISR_ENTER, TRACE_IRQ_EXTI5, 0U);
   if (__HAL_GPIO_EXTI_GET_IT(GPIO_PIN_5) != RESET)
   {
     __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_5);
-    MAX30100_InterruptHandler();
+    // The I2C transfer runs in the acquisition task
+    AppTasks_SensorIrq();
   }
+  TRACE_EVENT(TRACE_EV_ISR_EXIT, TRACE_IRQ_EXTI5, 0U);
+  RunTimeStats_IsrExit();
   /* USER CODE END EXTI9_5_IRQn 0 */
 }
 
+/**
+  * @brief This function handles LPTIM1 global interrupt (tickless idle timebase).
+  */
+void LPTIM1_IRQHandler(void)
+{
+  RunTimeStats_IsrEnter();
+  TRACE_EVENT(TRACE_EV_ISR_ENTER, TRACE_IRQ_LPTIM1, 0U);
+  LowPower_LptimIrq();
+  TRACE_EVENT(TRACE_EV_ISR_EXIT, TRACE_IRQ_LPTIM1, 0U);
+  RunTimeStats_IsrExit();
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,124 @@
+/* CM4 event tracer: RAM ring of fixed-size records, dumped on request. */
+
+#include "tracer.h"
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "weights_blob.h"
+#include <string.h>
+
+// 1 MHz run-time stats counter, freertos.c (STOP time included)
+extern unsigned long getRunTimeCounterValue(void);
+
+_Static_assert((TRACER_RING_LEN & (TRACER_RING_LEN - 1U)) == 0U, "TRACER_RING_LEN must be a power of two");
+_Static_assert(sizeof(tracer_event_t) == 8U, "tracer_event_t is part of the dump format");
+_Static_assert(sizeof(tracer_dump_header_t) == 20U, "tracer_dump_header_t is part of the dump format");
+_Static_assert(TRACER_RING_LEN * sizeof(tracer_event_t) <= 0xFFFFU, "ring does not fit one write");
+
+static tracer_event_t s_ring[TRACER_RING_LEN];
+static uint32_t s_head = 0;           // Records written, runs freely
+static uint32_t s_tail = 0;           // First record of the next dump
+static volatile uint8_t s_frozen = 0; // Set while a dump reads the ring
+static void (*s_on_dump_request)(void) = NULL;
+static uint8_t s_cmd_match = 0;
+static TaskStatus_t s_status[TRACER_MAX_TASKS];
+
+void Tracer_Init(void (*on_dump_request)(void))
+{
+  s_on_dump_request = on_dump_request;
+}
+
+void Tracer_Record(uint8_t id, uint8_t a8, uint16_t a16)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (!s_frozen) {
+    tracer_event_t *e = &s_ring[s_head & (TRACER_RING_LEN - 1U)];
+    e->ts_us = (uint32_t)getRunTimeCounterValue();
+    e->id = id;
+    e->a8 = a8;
+    e->a16 = a16;
+    s_head++;
+  }
+  __set_PRIMASK(primask);
+}
+
+void Tracer_RxByte(uint8_t byte)
+{
+  static const char kCmd[] = TRACER_DUMP_COMMAND;
+
+  if (byte == (uint8_t)kCmd[s_cmd_match]) {
+    if (++s_cmd_match == sizeof(kCmd) - 1U) {
+      s_cmd_match = 0;
+      if (s_on_dump_request != NULL) s_on_dump_request();
+    }
+  } else {
+    // "TRC?" has no repeated prefix, so restarting at this byte is enough
+    s_cmd_match = (byte == (uint8_t)kCmd[0]) ? 1U : 0U;
+  }
+}
+
+static void tracer_write(tracer_write_fn write, uint32_t *crc, const void *data, uint32_t len)
+{
+  if (len == 0U) return;
+  *crc = WBlob_Crc32(*crc, (const uint8_t *)data, len);
+  write((const uint8_t *)data, (uint16_t)len);
+}
+
+uint32_t Tracer_Dump(tracer_begin_fn begin, tracer_write_fn write)
+{
+  tracer_dump_header_t hdr;
+  tracer_task_name_t names[TRACER_MAX_TASKS];
+  uint32_t crc = 0;
+
+  // Names first: walking the task lists is traced like any other code
+  UBaseType_t n = uxTaskGetSystemState(s_status, TRACER_MAX_TASKS, NULL);
+  memset(names, 0, sizeof(names));
+  for (UBaseType_t i = 0; i < n; i++) {
+    names[i].number = (uint32_t)s_status[i].xTaskNumber;
+    strncpy(names[i].name, s_status[i].pcTaskName, TRACER_NAME_LEN - 1U);
+  }
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  s_frozen = 1;
+  uint32_t head = s_head;
+  uint32_t tail = s_tail;
+  __set_PRIMASK(primask);
+
+  uint32_t count = head - tail;
+  uint32_t lost = 0;
+  if (count > TRACER_RING_LEN) {
+    lost = count - TRACER_RING_LEN;
+    tail = head - TRACER_RING_LEN;
+    count = TRACER_RING_LEN;
+  }
+
+  hdr.magic = TRACER_DUMP_MAGIC;
+  hdr.version = TRACER_DUMP_VERSION;
+  hdr.n_tasks = (uint8_t)n;
+  hdr.event_size = (uint16_t)sizeof(tracer_event_t);
+  hdr.ts_hz = 1000000U;
+  hdr.n_events = count;
+  hdr.lost = lost;
+
+  if (begin != NULL) {
+    begin((uint32_t)(sizeof(hdr) + n * sizeof(tracer_task_name_t) + count * sizeof(tracer_event_t) + sizeof(crc)));
+  }
+  tracer_write(write, &crc, &hdr, sizeof(hdr));
+  tracer_write(write, &crc, names, n * sizeof(tracer_task_name_t));
+
+  // Oldest first: from tail to the end of the array, then the wrapped part
+  uint32_t start = tail & (TRACER_RING_LEN - 1U);
+  uint32_t first = (count < TRACER_RING_LEN - start) ? count : (TRACER_RING_LEN - start);
+  tracer_write(write, &crc, &s_ring[start], first * sizeof(tracer_event_t));
+  tracer_write(write, &crc, &s_ring[0], (count - first) * sizeof(tracer_event_t));
+  write((const uint8_t *)&crc, sizeof(crc));
+
+  __disable_irq();
+  s_tail = s_head;
+  s_frozen = 0;
+  __set_PRIMASK(primask);
+  return count;
+}
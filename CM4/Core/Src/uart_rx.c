@@ -0,0 +1,102 @@
+/* USART3 reception: circular DMA with idle-line events, fanned out to the byte consumers. */
+
+#include "uart_rx.h"
+#include "app_tasks.h"
+#include "secure_uart.h"
+#include "tracer.h"
+#include "weights_rx.h"
+
+// The CM4 image runs from the D2 SRAM alias, which DMA1 cannot address (see secure_uart.c)
+#define UART_RX_D2_ALIAS_BASE     (0x10000000UL)
+#define UART_RX_D2_ALIAS_END      (0x10048000UL)
+#define UART_RX_D2_DMA_OFFSET     (0x20000000UL)
+
+static UART_HandleTypeDef *s_huart = NULL;
+static uint8_t s_ring[UART_RX_RING_LEN];
+static uint16_t s_read;   // Next unread index
+static uart_rx_stats_t s_stats;
+
+static uint8_t *uartrx_dma_addr(uint8_t *p)
+{
+  uint32_t a = (uint32_t)p;
+  if (a >= UART_RX_D2_ALIAS_BASE && a < UART_RX_D2_ALIAS_END) a += UART_RX_D2_DMA_OFFSET;
+  return (uint8_t *)a;
+}
+
+// Commands and link messages share the line; bytes inside a blob are payload
+static void uartrx_dispatch(const uint8_t *data, uint16_t len)
+{
+  for (uint16_t i = 0; i < len; i++) {
+    if (WeightsRx_Feed(data[i])) {
+      Tracer_RxByte(data[i]);
+      secure_uart_rx_byte(data[i]);
+      AppTasks_CommandByte(data[i]);
+    }
+  }
+  s_stats.bytes += len;
+}
+
+// Hands over everything written up to pos, across the wrap
+static void uartrx_drain(uint16_t pos)
+{
+  if (pos > UART_RX_RING_LEN) return;
+  if (pos < s_read) {
+    uartrx_dispatch(&s_ring[s_read], (uint16_t)(UART_RX_RING_LEN - s_read));
+    s_read = 0;
+  }
+  if (pos > s_read) {
+    uartrx_dispatch(&s_ring[s_read], (uint16_t)(pos - s_read));
+    s_read = pos;
+  }
+  if (s_read == UART_RX_RING_LEN) s_read = 0;
+}
+
+static HAL_StatusTypeDef uartrx_arm(void)
+{
+  s_read = 0;
+  return HAL_UARTEx_ReceiveToIdle_DMA(s_huart, uartrx_dma_addr(s_ring), UART_RX_RING_LEN);
+}
+
+HAL_StatusTypeDef UartRx_Start(UART_HandleTypeDef *huart)
+{
+  s_huart = huart;
+  WeightsRx_Init();
+  return uartrx_arm();
+}
+
+void UartRx_Event(UART_HandleTypeDef *huart, uint16_t pos)
+{
+  if (huart != s_huart) return;
+  s_stats.events++;
+  uartrx_drain(pos);
+}
+
+void UartRx_Error(UART_HandleTypeDef *huart)
+{
+  if (huart != s_huart) return;
+
+  // Framing and noise errors leave the DMA running; overruns and DMA errors stop it
+  if (huart->RxState != HAL_UART_STATE_READY) {
+    s_stats.errors++;
+    return;
+  }
+  s_stats.restarts++;
+  uartrx_drain((uint16_t)(UART_RX_RING_LEN - __HAL_DMA_GET_COUNTER(huart->hdmarx)));
+  WeightsRx_Abort();
+  uartrx_arm();
+}
+
+HAL_StatusTypeDef UartRx_Resume(void)
+{
+  if (s_huart == NULL) return HAL_ERROR;
+  WeightsRx_Abort();
+  return uartrx_arm();
+}
+
+void UartRx_GetStats(uart_rx_stats_t *out)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *out = s_stats;
+  __set_PRIMASK(primask);
+}
@@ -0,0 +1,53 @@
+/* Receives weights blobs on the ESP32/debug UART and stages them for the CM7. */
+
+#include "weights_rx.h"
+#include "ipc_shared.h"
+
+static wblob_loader_t s_loader;
+static weights_stage_t *const s_stage = (weights_stage_t *)SHARED_WEIGHTS_ADDR;
+
+void WeightsRx_Init(void)
+{
+  s_stage->state = WEIGHTS_STAGE_IDLE;
+  s_stage->result = WBLOB_OK;
+  s_stage->length = 0;
+  WBlob_LoaderInit(&s_loader, (uint8_t *)SHARED_WEIGHTS_BLOB_ADDR, SHARED_WEIGHTS_BLOB_MAX);
+}
+
+static void WeightsRx_Publish(void)
+{
+  s_stage->length = s_loader.received;
+  __DMB();
+  s_stage->state = WEIGHTS_STAGE_READY;
+
+  // Take + release raises the free interrupt on the CM7
+  if (HAL_HSEM_FastTake(HSEM_ID_WEIGHTS) == HAL_OK) {
+    HAL_HSEM_Release(HSEM_ID_WEIGHTS, 0);
+  }
+}
+
+uint8_t WeightsRx_Feed(uint8_t byte)
+{
+  uint8_t outside = (s_loader.state == WBLOB_RX_HUNT || s_loader.state == WBLOB_RX_DONE);
+
+  // The staging area belongs to the CM7 until it marks the blob applied/rejected
+  if (s_stage->state != WEIGHTS_STAGE_READY) {
+    if (s_loader.state == WBLOB_RX_DONE) {
+      WBlob_LoaderReset(&s_loader);
+    }
+    if (WBlob_LoaderFeed(&s_loader, &byte, 1) == WBLOB_OK) {
+      WeightsRx_Publish();
+    }
+  }
+  return outside;
+}
+
+void WeightsRx_Abort(void)
+{
+  if (s_loader.state != WBLOB_RX_HUNT && s_loader.state != WBLOB_RX_DONE) WBlob_LoaderReset(&s_loader);
+}
+
+const wblob_loader_t *WeightsRx_GetLoader(void)
+{
+  return &s_loader;
+}
@@ -0,0 +1,58 @@
+/* Feature-delta cache: skips inference while the input vector has not moved. */
+#ifndef AI_FEATURE_CACHE_H
+#define AI_FEATURE_CACHE_H
+
+#include <stdint.h>
+
+#define FEATURE_CACHE_MAX_FEATURES   (8)
+
+typedef struct {
+  float    scored[FEATURE_CACHE_MAX_FEATURES];  // Input of the last real inference
+  float    tolerance[FEATURE_CACHE_MAX_FEATURES];
+  uint32_t n_features;
+  uint32_t max_age;     // Lookups served from cache before a forced refresh, 0 = no limit
+  uint32_t age;         // Lookups served since the last real inference
+  uint8_t  valid;
+  uint8_t  enabled;
+  // Counters
+  uint32_t hits;        // Cached prediction reused
+  uint32_t misses;      // A feature moved more than its tolerance (or no entry yet)
+  uint32_t refreshes;   // Forced by max_age although nothing moved
+} feature_cache_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Configures the cache and clears its entry and counters.
+ * @param cache Cache instance.
+ * @param tolerance Per-feature absolute tolerance; a feature "changed" when
+ *        |new - scored| > tolerance, so 0 means any change triggers inference.
+ * @param n_features Number of features (at most FEATURE_CACHE_MAX_FEATURES).
+ * @param max_age Maximum consecutive hits before a refresh is forced, 0 = none.
+ */
+void FeatureCache_Init(feature_cache_t *cache, const float *tolerance, uint32_t n_features, uint32_t max_age);
+
+/**
+ * @brief Decides whether the cached prediction can be reused for features.
+ * @retval 1 on a hit (skip inference), 0 if the caller must run and then
+ *         call FeatureCache_Store().
+ */
+uint8_t FeatureCache_Lookup(feature_cache_t *cache, const float *features);
+
+/**
+ * @brief Records the input of a completed inference as the new reference.
+ */
+void FeatureCache_Store(feature_cache_t *cache, const float *features);
+
+/**
+ * @brief Drops the entry, e.g. after the model weights changed.
+ */
+void FeatureCache_Invalidate(feature_cache_t *cache);
+
+/**
+ * @brief Enables or bypasses the cache (bypassed: every lookup is a miss).
+ */
+void FeatureCache_Enable(feature_cache_t *cache, uint8_t enable);
+
+#endif /* AI_FEATURE_CACHE_H */
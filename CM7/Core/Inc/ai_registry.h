@@ -0,0 +1,145 @@
+/* Model registry for the CM7: several X-CUBE-AI networks sharing one activation arena. */
+#ifndef AI_REGISTRY_H
+#define AI_REGISTRY_H
+
+#include "main.h"
+#include "ai_platform.h"
+#include "athlet.h"
+#include "athlet_data.h"
+#include "weights_blob.h"
+#include "ai_feature_cache.h"
+
+/*----------------------------------------------------------------------------*/
+// Registered networks
+//
+// X(id, c_name, C_NAME, period_frames, phase, scaler)
+//   c_name/C_NAME  : --name given to ST Edge AI Core (ai_<c_name>_*, AI_<C_NAME>_*)
+//   period_frames  : run once every N mailbox frames
+//   phase          : frame offset, spreads slow models away from each other
+//   scaler         : const ai_input_scaler_t * applied to the input (defined in
+//                    ai_registry.c), NULL if the network takes raw features
+//
+// To add a network, generate it into X-CUBE-AI/App, include its headers above
+// and add a line, e.g.
+//   X(AI_MODEL_FATIGUE,        fatigue, FATIGUE, 10, 3, NULL)
+//   X(AI_MODEL_SIGNAL_QUALITY, sigq,    SIGQ,     5, 1, NULL)
+#define AI_REGISTRY_MODELS(X) \
+  X(AI_MODEL_ANOMALY, athlet, ATHLET, 1, 0, AI_ATHLET_SCALER)
+
+#define AI_REGISTRY_MAX_OUTPUT   (4) // Outputs kept per model after each run
+
+// Input standardisation, (x - mean) / scale on the first n inputs
+typedef struct {
+  uint32_t     n;
+  const float *mean;
+  const float *scale;
+} ai_input_scaler_t;
+
+typedef enum {
+#define AI_REGISTRY_ENUM(id, c_name, C_NAME, period, phase, scaler) id,
+  AI_REGISTRY_MODELS(AI_REGISTRY_ENUM)
+#undef AI_REGISTRY_ENUM
+  AI_MODEL_COUNT
+} ai_model_id_t;
+
+// Per-model scheduling and timing counters (cycles are CM7 DWT cycles)
+typedef struct {
+  uint32_t runs;
+  uint32_t errors;
+  uint32_t last_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint32_t last_frame;       // Frame number of the last successful run
+  uint32_t weights_version;  // Blob model_version in use, 0 = compiled-in
+  uint32_t swaps;
+  float    output[AI_REGISTRY_MAX_OUTPUT];
+} ai_model_stats_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Creates every registered network on the shared activation arena.
+ * @retval HAL_OK if all networks were created, HAL_ERROR otherwise.
+ */
+HAL_StatusTypeDef AI_Registry_Init(void);
+
+/**
+ * @brief Feeds one feature frame and runs the networks that are due.
+ * Networks run one after the other, so the arena is reused safely: the input
+ * is copied in right before a run and the output copied out right after.
+ * A due model whose inputs stayed within the cache tolerances is not run and
+ * keeps its previous output (see AI_Registry_ConfigureCache()).
+ * @param features Feature vector in athlet_features.h order.
+ * @param n_features Number of floats in features.
+ * @retval Bit mask of the models (1 << ai_model_id_t) with an output for this
+ *         frame, computed or reused from the cache.
+ */
+uint32_t AI_Registry_OnFrame(const float *features, uint32_t n_features);
+
+/**
+ * @brief Forces a model to run on the next frame regardless of its period
+ * and of the feature cache.
+ * @param id Model identifier.
+ */
+void AI_Registry_Trigger(ai_model_id_t id);
+
+/**
+ * @brief Changes the scheduling rate of a model at runtime.
+ * @param id Model identifier.
+ * @param period_frames Run every N frames, 0 disables the model.
+ */
+void AI_Registry_SetPeriod(ai_model_id_t id, uint16_t period_frames);
+
+/**
+ * @brief Returns the counters and last output of a model.
+ * @param id Model identifier.
+ * @retval Pointer to the stats, NULL for an invalid id.
+ */
+const ai_model_stats_t *AI_Registry_GetStats(ai_model_id_t id);
+
+/**
+ * @brief X-CUBE-AI name of a model (c_name in AI_REGISTRY_MODELS), NULL for an invalid id.
+ */
+const char *AI_Registry_GetName(ai_model_id_t id);
+
+/**
+ * @brief Looks up a model by its X-CUBE-AI name (c_name in AI_REGISTRY_MODELS).
+ * @retval Model identifier, AI_MODEL_COUNT if unknown.
+ */
+ai_model_id_t AI_Registry_FindByName(const char *name);
+
+/**
+ * @brief Switches a model to new weights between two inferences.
+ * The weights are copied to the model's spare RAM slot and the network is
+ * re-created on them; if that fails the previous weights are restored.
+ * Must be called from the task that calls AI_Registry_OnFrame().
+ * @param id Model identifier.
+ * @param weights Raw weights array, AI_<NAME>_DATA_WEIGHTS_SIZE bytes.
+ * @param size Size of weights, must match the generated network.
+ * @param version Version reported in the model stats.
+ * @retval HAL_OK if the model now runs on the new weights.
+ */
+HAL_StatusTypeDef AI_Registry_SwapWeights(ai_model_id_t id, const uint8_t *weights, uint32_t size, uint32_t version);
+
+/**
+ * @brief Sets the feature-delta cache policy of a model.
+ * @param id Model identifier.
+ * @param tolerance ATHLET_FEATURE_COUNT absolute tolerances, NULL for the defaults.
+ * @param max_age Frames a cached output may be reused before a refresh, 0 = no limit.
+ */
+void AI_Registry_ConfigureCache(ai_model_id_t id, const float *tolerance, uint32_t max_age);
+
+/**
+ * @brief Returns the feature cache of a model (hit/miss/refresh counters).
+ * @param id Model identifier.
+ * @retval Pointer to the cache, NULL for an invalid id.
+ */
+const feature_cache_t *AI_Registry_GetCache(ai_model_id_t id);
+
+/**
+ * @brief Size in bytes of the shared activation arena (largest registered model).
+ */
+uint32_t AI_Registry_ArenaSize(void);
+
+#endif /* AI_REGISTRY_H */
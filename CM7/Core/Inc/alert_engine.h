@@ -0,0 +1,82 @@
+/* Alert engine: turns per-frame anomaly scores into rate-limited alert events. */
+#ifndef ALERT_ENGINE_H
+#define ALERT_ENGINE_H
+
+#include <stdint.h>
+#include "ipc_shared.h"
+
+#define ALERT_MEDIAN_MAX     (9U)  // Longest median window
+#define ALERT_MAX_EVENTS     (2U)  // Events one update can emit (END or START, plus SUMMARY)
+
+typedef enum {
+  ALERT_SMOOTH_EMA = 0,
+  ALERT_SMOOTH_MEDIAN,
+} alert_smoother_t;
+
+typedef struct {
+  alert_smoother_t smoother;
+  float    ema_alpha;              // Weight of the newest score, 0..1
+  uint8_t  median_len;             // Odd, 1..ALERT_MEDIAN_MAX
+  float    enter_threshold;        // Smoothed score that starts an alert...
+  float    exit_threshold;         // ...and the lower one that ends it (hysteresis)
+  uint32_t enter_frames;           // Consecutive frames above enter_threshold to start
+  uint32_t min_alert_frames;       // An alert lasts at least this long
+  uint32_t cooldown_frames;        // Quiet frames after an END before a new START
+  uint32_t summary_period_frames;  // Emit a SUMMARY every N frames, 0 = never
+} alert_config_t;
+
+typedef struct {
+  alert_config_t cfg;
+  uint8_t  model;
+  // Smoother
+  float    smoothed;
+  uint8_t  primed;
+  float    window[ALERT_MEDIAN_MAX];
+  uint8_t  window_idx;
+  uint8_t  window_fill;
+  // Alert state
+  uint8_t  in_alert;
+  uint32_t above_count;
+  uint32_t alert_frames;
+  uint32_t cooldown;
+  float    peak;
+  uint16_t alert_id;
+  // Summary window
+  uint32_t sum_frames;
+  float    sum_score;
+  float    sum_peak;
+  uint32_t sum_alerts;
+} alert_engine_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Fills cfg with the defaults used for the anomaly network.
+ */
+void AlertEngine_DefaultConfig(alert_config_t *cfg);
+
+/**
+ * @brief Resets the engine with a configuration.
+ * @param engine Engine instance.
+ * @param cfg Configuration, copied.
+ * @param model ai_model_id_t reported in the events.
+ */
+void AlertEngine_Init(alert_engine_t *engine, const alert_config_t *cfg, uint8_t model);
+
+/**
+ * @brief Feeds one raw score (e.g. the sigmoid output of the network).
+ * @param engine Engine instance.
+ * @param score Raw score of this frame.
+ * @param frame Frame number copied into the events.
+ * @param events Output array of at least ALERT_MAX_EVENTS entries.
+ * @retval Number of events written to events.
+ */
+uint32_t AlertEngine_Update(alert_engine_t *engine, float score, uint32_t frame, ai_event_t *events);
+
+/**
+ * @brief Current smoothed score.
+ */
+float AlertEngine_Smoothed(const alert_engine_t *engine);
+
+#endif /* ALERT_ENGINE_H */
@@ -0,0 +1,60 @@
+/* Feature-delta cache: skips inference while the input vector has not moved. */
+
+#include "ai_feature_cache.h"
+#include <string.h>
+
+void FeatureCache_Init(feature_cache_t *cache, const float *tolerance, uint32_t n_features, uint32_t max_age)
+{
+  memset(cache, 0, sizeof(*cache));
+  if (n_features > FEATURE_CACHE_MAX_FEATURES) n_features = FEATURE_CACHE_MAX_FEATURES;
+  memcpy(cache->tolerance, tolerance, n_features * sizeof(float));
+  cache->n_features = n_features;
+  cache->max_age = max_age;
+  cache->enabled = 1;
+}
+
+uint8_t FeatureCache_Lookup(feature_cache_t *cache, const float *features)
+{
+  if (!cache->enabled || !cache->valid) {
+    cache->misses++;
+    return 0;
+  }
+
+  // Compare against the last scored vector, not the last seen one, so slow drift still triggers
+  for (uint32_t i = 0; i < cache->n_features; i++) {
+    float delta = features[i] - cache->scored[i];
+    if (delta < 0.0f) delta = -delta;
+    if (delta > cache->tolerance[i]) {
+      cache->misses++;
+      return 0;
+    }
+  }
+
+  if (cache->max_age != 0 && cache->age >= cache->max_age) {
+    cache->refreshes++;
+    return 0;
+  }
+
+  cache->age++;
+  cache->hits++;
+  return 1;
+}
+
+void FeatureCache_Store(feature_cache_t *cache, const float *features)
+{
+  memcpy(cache->scored, features, cache->n_features * sizeof(float));
+  cache->age = 0;
+  cache->valid = 1;
+}
+
+void FeatureCache_Invalidate(feature_cache_t *cache)
+{
+  cache->valid = 0;
+  cache->age = 0;
+}
+
+void FeatureCache_Enable(feature_cache_t *cache, uint8_t enable)
+{
+  cache->enabled = enable ? 1 : 0;
+  if (!enable) FeatureCache_Invalidate(cache);
+}
@@ -0,0 +1,254 @@
+/* Model registry for the CM7: several X-CUBE-AI networks sharing one activation arena. */
+
+#include "ai_registry.h"
+#include "athlet_features.h"
+#include <string.h>
+
+#define AI_REGISTRY_SLOT_BUILTIN  (0xFFU)  // Compiled-in weights from athlet_data_params.c
+#define AI_REGISTRY_CACHE_MAX_AGE (30U)    // Frames a prediction may be reused before a refresh
+
+// Default per-feature change needed to re-run a model (sensor resolution or better)
+static const float kDefaultTolerance[ATHLET_FEATURE_COUNT] = {
+  [ATHLET_FEAT_HEART_RATE]  = 1.0f,   // bpm
+  [ATHLET_FEAT_SPO2]        = 0.5f,   // %
+  [ATHLET_FEAT_FATIGUE]     = 0.05f,
+  [ATHLET_FEAT_TEMPERATURE] = 0.1f,   // degC
+  [ATHLET_FEAT_ACTIVITY]    = 0.0f,   // Any activity change
+};
+
+// Anomaly network input scaling, until it is regenerated with the scaler folded in
+#if ATHLET_FEATURES_SCALING_FOLDED
+#define AI_ATHLET_SCALER          NULL
+#else
+static const float kAthletMean[ATHLET_FEATURE_COUNT] = ATHLET_SCALER_MEAN_INIT;
+static const float kAthletScale[ATHLET_FEATURE_COUNT] = ATHLET_SCALER_SCALE_INIT;
+static const ai_input_scaler_t kAthletScaler = { ATHLET_FEATURE_COUNT, kAthletMean, kAthletScale };
+#define AI_ATHLET_SCALER          (&kAthletScaler)
+#endif
+
+// Arena sized to the largest activations buffer of the registered models
+typedef union {
+#define AI_REGISTRY_ARENA(id, c_name, C_NAME, period, phase, scaler) \
+  uint8_t c_name[AI_##C_NAME##_DATA_ACTIVATIONS_SIZE];
+  AI_REGISTRY_MODELS(AI_REGISTRY_ARENA)
+#undef AI_REGISTRY_ARENA
+} ai_registry_arena_t;
+
+typedef struct {
+  const char *name;
+  ai_error   (*create_and_init)(ai_handle *network, const ai_handle activations[], const ai_handle weights[]);
+  ai_buffer *(*inputs_get)(ai_handle network, ai_u16 *n_buffer);
+  ai_buffer *(*outputs_get)(ai_handle network, ai_u16 *n_buffer);
+  ai_i32     (*run)(ai_handle network, const ai_buffer *input, ai_buffer *output);
+  ai_handle  (*destroy)(ai_handle network);
+  ai_handle  (*weights_get)(void);
+  uint32_t   weights_size;
+  uint8_t   *slot[2];        // RAM copies for hot-swapped weights
+  uint16_t   default_period;
+  uint16_t   phase;
+  const ai_input_scaler_t *scaler;   // NULL: raw features
+} ai_model_desc_t;
+
+// Two RAM slots per model: the live weights are never overwritten by a swap
+AI_ALIGNED(32)
+static struct {
+#define AI_REGISTRY_SLOTS(id, c_name, C_NAME, period, phase, scaler) \
+  uint64_t c_name[2][(AI_##C_NAME##_DATA_WEIGHTS_SIZE + 7) / 8];
+  AI_REGISTRY_MODELS(AI_REGISTRY_SLOTS)
+#undef AI_REGISTRY_SLOTS
+} s_weights;
+
+static const ai_model_desc_t s_models[AI_MODEL_COUNT] = {
+#define AI_REGISTRY_DESC(id, c_name, C_NAME, period, phase_, scaler_) \
+  [id] = { #c_name, ai_##c_name##_create_and_init, ai_##c_name##_inputs_get, \
+           ai_##c_name##_outputs_get, ai_##c_name##_run, ai_##c_name##_destroy, \
+           ai_##c_name##_data_weights_get, AI_##C_NAME##_DATA_WEIGHTS_SIZE, \
+           { (uint8_t *)s_weights.c_name[0], (uint8_t *)s_weights.c_name[1] }, \
+           (period), (phase_), (scaler_) },
+  AI_REGISTRY_MODELS(AI_REGISTRY_DESC)
+#undef AI_REGISTRY_DESC
+};
+
+AI_ALIGNED(32)
+static ai_registry_arena_t s_arena;
+
+static ai_handle s_handles[AI_MODEL_COUNT];
+static uint16_t s_period[AI_MODEL_COUNT];
+static uint8_t s_triggered[AI_MODEL_COUNT];
+static ai_model_stats_t s_stats[AI_MODEL_COUNT];
+static uint8_t s_live_slot[AI_MODEL_COUNT];
+static feature_cache_t s_cache[AI_MODEL_COUNT];
+static uint32_t s_frame = 0;
+
+static void AI_Registry_CycleCounterInit(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->LAR = 0xC5ACCE55;  // Unlock DWT on Cortex-M7
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+HAL_StatusTypeDef AI_Registry_Init(void)
+{
+  AI_Registry_CycleCounterInit();
+  memset(s_stats, 0, sizeof(s_stats));
+
+  const ai_handle act_addr[] = { AI_HANDLE_PTR(&s_arena) };
+  for (uint32_t id = 0; id < AI_MODEL_COUNT; id++) {
+    const ai_handle wgt_addr[] = { s_models[id].weights_get() };
+    ai_error err = s_models[id].create_and_init(&s_handles[id], act_addr, wgt_addr);
+    if (err.type != AI_ERROR_NONE) {
+      s_handles[id] = AI_HANDLE_NULL;
+      return HAL_ERROR;
+    }
+    s_period[id] = s_models[id].default_period;
+    s_triggered[id] = 0;
+    s_live_slot[id] = AI_REGISTRY_SLOT_BUILTIN;
+    FeatureCache_Init(&s_cache[id], kDefaultTolerance, ATHLET_FEATURE_COUNT, AI_REGISTRY_CACHE_MAX_AGE);
+  }
+  return HAL_OK;
+}
+
+static ai_i32 AI_Registry_Run(uint32_t id, const float *features, uint32_t n_features)
+{
+  // IO buffers live inside the shared arena, so re-fetch them for every run
+  ai_buffer *in = s_models[id].inputs_get(s_handles[id], NULL);
+  ai_buffer *out = s_models[id].outputs_get(s_handles[id], NULL);
+  if (in == NULL || out == NULL) return 0;
+
+  float *in_data = (float *)in[0].data;
+  uint32_t n_in = AI_BUFFER_SIZE(&in[0]);
+  const ai_input_scaler_t *sc = s_models[id].scaler;
+  for (uint32_t i = 0; i < n_in; i++) {
+    in_data[i] = (i < n_features) ? features[i] : 0.0f;
+    if (sc != NULL && i < sc->n) in_data[i] = (in_data[i] - sc->mean[i]) / sc->scale[i];
+  }
+
+  uint32_t start = DWT->CYCCNT;
+  ai_i32 nb = s_models[id].run(s_handles[id], &in[0], &out[0]);
+  uint32_t cycles = DWT->CYCCNT - start;
+
+  ai_model_stats_t *st = &s_stats[id];
+  if (nb <= 0) {
+    st->errors++;
+    return nb;
+  }
+
+  const float *out_data = (const float *)out[0].data;
+  uint32_t n_out = AI_BUFFER_SIZE(&out[0]);
+  if (n_out > AI_REGISTRY_MAX_OUTPUT) n_out = AI_REGISTRY_MAX_OUTPUT;
+  for (uint32_t i = 0; i < n_out; i++) {
+    st->output[i] = out_data[i];
+  }
+
+  st->runs++;
+  st->last_cycles = cycles;
+  if (cycles > st->max_cycles) st->max_cycles = cycles;
+  st->total_cycles += cycles;
+  st->last_frame = s_frame;
+  return nb;
+}
+
+uint32_t AI_Registry_OnFrame(const float *features, uint32_t n_features)
+{
+  uint32_t ran = 0;
+  for (uint32_t id = 0; id < AI_MODEL_COUNT; id++) {
+    if (s_handles[id] == AI_HANDLE_NULL) continue;
+
+    uint16_t period = s_period[id];
+    uint8_t due = s_triggered[id] ||
+                  (period != 0 && ((s_frame + s_models[id].phase) % period) == 0);
+    if (!due) continue;
+
+    // A hit keeps the previous output; a trigger always runs the network
+    uint8_t forced = s_triggered[id];
+    s_triggered[id] = 0;
+    if (!forced && FeatureCache_Lookup(&s_cache[id], features)) {
+      ran |= (1UL << id);
+      continue;
+    }
+
+    if (AI_Registry_Run(id, features, n_features) > 0) {
+      FeatureCache_Store(&s_cache[id], features);
+      ran |= (1UL << id);
+    }
+  }
+  s_frame++;
+  return ran;
+}
+
+void AI_Registry_Trigger(ai_model_id_t id)
+{
+  if (id < AI_MODEL_COUNT) s_triggered[id] = 1;
+}
+
+void AI_Registry_SetPeriod(ai_model_id_t id, uint16_t period_frames)
+{
+  if (id < AI_MODEL_COUNT) s_period[id] = period_frames;
+}
+
+const ai_model_stats_t *AI_Registry_GetStats(ai_model_id_t id)
+{
+  return (id < AI_MODEL_COUNT) ? &s_stats[id] : NULL;
+}
+
+const char *AI_Registry_GetName(ai_model_id_t id)
+{
+  return (id < AI_MODEL_COUNT) ? s_models[id].name : NULL;
+}
+
+ai_model_id_t AI_Registry_FindByName(const char *name)
+{
+  for (uint32_t id = 0; id < AI_MODEL_COUNT; id++) {
+    if (strncmp(name, s_models[id].name, WBLOB_NAME_LEN) == 0) return (ai_model_id_t)id;
+  }
+  return AI_MODEL_COUNT;
+}
+
+HAL_StatusTypeDef AI_Registry_SwapWeights(ai_model_id_t id, const uint8_t *weights, uint32_t size, uint32_t version)
+{
+  if (id >= AI_MODEL_COUNT || size != s_models[id].weights_size) return HAL_ERROR;
+
+  // Stage into the slot that is not live, so a failed swap leaves the model untouched
+  uint8_t next = (s_live_slot[id] == 0) ? 1 : 0;
+  memcpy(s_models[id].slot[next], weights, size);
+
+  const ai_handle act_addr[] = { AI_HANDLE_PTR(&s_arena) };
+  const ai_handle new_wgt[] = { AI_HANDLE_PTR(s_models[id].slot[next]) };
+  const ai_handle old_wgt[] = {
+    (s_live_slot[id] == AI_REGISTRY_SLOT_BUILTIN) ? s_models[id].weights_get() : AI_HANDLE_PTR(s_models[id].slot[s_live_slot[id]])
+  };
+
+  // Generated networks are single static instances: destroy, then re-create
+  s_models[id].destroy(s_handles[id]);
+  s_handles[id] = AI_HANDLE_NULL;
+  ai_error err = s_models[id].create_and_init(&s_handles[id], act_addr, new_wgt);
+  if (err.type != AI_ERROR_NONE) {
+    s_handles[id] = AI_HANDLE_NULL;
+    err = s_models[id].create_and_init(&s_handles[id], act_addr, old_wgt);
+    if (err.type != AI_ERROR_NONE) s_handles[id] = AI_HANDLE_NULL;
+    return HAL_ERROR;
+  }
+
+  s_live_slot[id] = next;
+  FeatureCache_Invalidate(&s_cache[id]);
+  s_stats[id].weights_version = version;
+  s_stats[id].swaps++;
+  return HAL_OK;
+}
+
+void AI_Registry_ConfigureCache(ai_model_id_t id, const float *tolerance, uint32_t max_age)
+{
+  if (id >= AI_MODEL_COUNT) return;
+  FeatureCache_Init(&s_cache[id], tolerance ? tolerance : kDefaultTolerance, ATHLET_FEATURE_COUNT, max_age);
+}
+
+const feature_cache_t *AI_Registry_GetCache(ai_model_id_t id)
+{
+  return (id < AI_MODEL_COUNT) ? &s_cache[id] : NULL;
+}
+
+uint32_t AI_Registry_ArenaSize(void)
+{
+  return (uint32_t)sizeof(s_arena);
+}
@@ -0,0 +1,135 @@
+/* Alert engine: turns per-frame anomaly scores into rate-limited alert events. */
+
+#include "alert_engine.h"
+#include <string.h>
+
+void AlertEngine_DefaultConfig(alert_config_t *cfg)
+{
+  cfg->smoother = ALERT_SMOOTH_EMA;
+  cfg->ema_alpha = 0.2f;
+  cfg->median_len = 5;
+  cfg->enter_threshold = 0.7f;
+  cfg->exit_threshold = 0.5f;
+  cfg->enter_frames = 3;
+  cfg->min_alert_frames = 10;
+  cfg->cooldown_frames = 10;
+  cfg->summary_period_frames = 300;
+}
+
+void AlertEngine_Init(alert_engine_t *engine, const alert_config_t *cfg, uint8_t model)
+{
+  memset(engine, 0, sizeof(*engine));
+  engine->cfg = *cfg;
+  if (engine->cfg.median_len == 0) engine->cfg.median_len = 1;
+  if (engine->cfg.median_len > ALERT_MEDIAN_MAX) engine->cfg.median_len = ALERT_MEDIAN_MAX;
+  if (engine->cfg.exit_threshold > engine->cfg.enter_threshold) {
+    engine->cfg.exit_threshold = engine->cfg.enter_threshold;
+  }
+  engine->model = model;
+}
+
+static float AlertEngine_Median(alert_engine_t *engine, float score)
+{
+  float sorted[ALERT_MEDIAN_MAX];
+  uint8_t len = engine->cfg.median_len;
+
+  engine->window[engine->window_idx] = score;
+  engine->window_idx = (uint8_t)((engine->window_idx + 1) % len);
+  if (engine->window_fill < len) engine->window_fill++;
+
+  // Insertion sort, the window holds at most ALERT_MEDIAN_MAX values
+  uint8_t n = engine->window_fill;
+  for (uint8_t i = 0; i < n; i++) {
+    float v = engine->window[i];
+    int8_t j = (int8_t)i - 1;
+    while (j >= 0 && sorted[j] > v) {
+      sorted[j + 1] = sorted[j];
+      j--;
+    }
+    sorted[j + 1] = v;
+  }
+  return sorted[n / 2];
+}
+
+static float AlertEngine_Smooth(alert_engine_t *engine, float score)
+{
+  if (engine->cfg.smoother == ALERT_SMOOTH_MEDIAN) {
+    engine->smoothed = AlertEngine_Median(engine, score);
+  } else if (!engine->primed) {
+    engine->smoothed = score;
+  } else {
+    engine->smoothed += engine->cfg.ema_alpha * (score - engine->smoothed);
+  }
+  engine->primed = 1;
+  return engine->smoothed;
+}
+
+static void AlertEngine_Event(const alert_engine_t *engine, ai_event_t *ev, uint8_t type, uint32_t frame)
+{
+  memset(ev, 0, sizeof(*ev));
+  ev->type = type;
+  ev->model = engine->model;
+  ev->alert_id = engine->alert_id;
+  ev->frame = frame;
+}
+
+uint32_t AlertEngine_Update(alert_engine_t *engine, float score, uint32_t frame, ai_event_t *events)
+{
+  const alert_config_t *cfg = &engine->cfg;
+  uint32_t n = 0;
+  float s = AlertEngine_Smooth(engine, score);
+
+  if (engine->in_alert) {
+    engine->alert_frames++;
+    if (s > engine->peak) engine->peak = s;
+
+    if (s < cfg->exit_threshold && engine->alert_frames >= cfg->min_alert_frames) {
+      ai_event_t *ev = &events[n++];
+      AlertEngine_Event(engine, ev, AI_EVENT_ALERT_END, frame);
+      ev->score = s;
+      ev->peak = engine->peak;
+      ev->duration = engine->alert_frames;
+      engine->in_alert = 0;
+      engine->cooldown = cfg->cooldown_frames;
+      engine->above_count = 0;
+    }
+  } else {
+    if (engine->cooldown) engine->cooldown--;
+    engine->above_count = (s >= cfg->enter_threshold) ? engine->above_count + 1 : 0;
+
+    if (engine->above_count >= cfg->enter_frames && engine->cooldown == 0) {
+      engine->in_alert = 1;
+      engine->alert_frames = 1;
+      engine->peak = s;
+      engine->alert_id++;
+      engine->sum_alerts++;
+      ai_event_t *ev = &events[n++];
+      AlertEngine_Event(engine, ev, AI_EVENT_ALERT_START, frame);
+      ev->score = s;
+      ev->peak = s;
+    }
+  }
+
+  // Periodic summary of the smoothed score
+  engine->sum_frames++;
+  engine->sum_score += s;
+  if (engine->sum_frames == 1 || s > engine->sum_peak) engine->sum_peak = s;
+  if (cfg->summary_period_frames != 0 && engine->sum_frames >= cfg->summary_period_frames) {
+    ai_event_t *ev = &events[n++];
+    AlertEngine_Event(engine, ev, AI_EVENT_SUMMARY, frame);
+    ev->score = engine->sum_score / (float)engine->sum_frames;
+    ev->peak = engine->sum_peak;
+    ev->duration = engine->sum_frames;
+    ev->count = engine->sum_alerts;
+    engine->sum_frames = 0;
+    engine->sum_score = 0.0f;
+    engine->sum_peak = 0.0f;
+    engine->sum_alerts = 0;
+  }
+  return n;
+}
+
+float AlertEngine_Smoothed(const alert_engine_t *engine)
+{
+  return engine->smoothed;
+}
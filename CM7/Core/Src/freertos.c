@@ -24,7 +24,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "runtime_stats.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -52,6 +52,58 @@
 
 /* USER CODE END FunctionPrototypes */
 
+/* Hook prototypes */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+static uint32_t s_rt_cycles_per_us;
+
+void configureTimerForRunTimeStats(void)
+{
+  // DWT CYCCNT: the CM7 idle task never sleeps, and a D2 timer would keep
+  // the CM4 domain out of STOP
+  s_rt_cycles_per_us = SystemCoreClock / RUNTIME_STATS_HZ;
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->LAR = 0xC5ACCE55U;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+// CYCCNT wraps every 9 s at 480 MHz; it is folded into a 1 MHz count on
+// every context switch and every instrumented ISR, which happen every tick
+unsigned long getRunTimeCounterValue(void)
+{
+  static uint32_t last_cyc, us, rem_cyc;
+  uint32_t primask = __get_PRIMASK();
+
+  if (s_rt_cycles_per_us == 0U) return 0;  // SysTick before the scheduler starts
+  __disable_irq();
+  uint32_t now = DWT->CYCCNT;
+  uint32_t cyc = rem_cyc + (now - last_cyc);
+  last_cyc = now;
+  us += cyc / s_rt_cycles_per_us;
+  rem_cyc = cyc % s_rt_cycles_per_us;
+  __set_PRIMASK(primask);
+  return us;
+}
+/* USER CODE END 1 */
+
+/* USER CODE BEGIN 4 */
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName)
+{
+   /* Run time stack overflow checking is performed if
+   configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2. This hook function is
+   called if a stack overflow is detected. */
+  (void)xTask;
+  (void)pcTaskName;
+  // Static stacks sit next to other data, do not run on with a corrupted neighbour
+  Error_Handler();
+}
+/* USER CODE END 4 */
+
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
 
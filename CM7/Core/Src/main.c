@@ -22,14 +22,20 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "athlet.h"
-#include "athlet_data.h"
-#include "athlet_data_params.h"
+#include "ai_registry.h"
+#include "alert_engine.h"
+#include "athlet_features.h"
+#include "ipc_shared.h"
+#include "rtos_health.h"
+#include "runtime_stats.h"
+#include "weights_blob.h"
 #include "core_cm7.h"
+#include <string.h>
 
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
+typedef StaticTask_t osStaticThreadDef_t;
 /* USER CODE BEGIN PTD */
 
 /* USER CODE END PTD */
@@ -41,6 +47,8 @@
 #define HSEM_ID_0 (0U) /* HW semaphore 0*/
 #endif
 
+#define HEALTH_PERIOD_MS (10000U) /* RTOS health snapshot for the CM4 report */
+
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -52,35 +60,30 @@
 
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
+uint32_t defaultTaskBuffer[ 256 ];
+osStaticThreadDef_t defaultTaskControlBlock;
 const osThreadAttr_t defaultTask_attributes = {
   .name = "defaultTask",
-  .stack_size = 128 * 4,
+  .cb_mem = &defaultTaskControlBlock,
+  .cb_size = sizeof(defaultTaskControlBlock),
+  .stack_mem = &defaultTaskBuffer[0],
+  .stack_size = sizeof(defaultTaskBuffer),
   .priority = (osPriority_t) osPriorityNormal,
 };
 /* USER CODE BEGIN PV */
-// Shared mailbox written by CM4 (D2 SRAM3 is shared between cores)
-#define SHARED_MAILBOX_ADDR   (0x30040000UL)
-#define SHARED_MAILBOX_MAGIC  (0xBA5ECAFEu)
-#define HSEM_ID_MAILBOX       (5U)
-
-typedef struct {
-  uint32_t magic;
-  uint32_t seq;
-  float    temperature_c;
-  float    spo2_pct;
-  float    heart_rate_bpm;
-  float    fatigue_score;   // 0..1
-  uint32_t reserved[4];
-} sensor_mailbox_t;
+// Shared mailbox written by CM4 (D2 SRAM3 is shared between cores), see ipc_shared.h
+#if AI_ATHLET_IN_1_SIZE != ATHLET_FEATURE_COUNT
+#error "X-CUBE-AI input size does not match athlet_features.h, regenerate the network"
+#endif
 
 static volatile sensor_mailbox_t* const g_sensor_mb = (sensor_mailbox_t*)SHARED_MAILBOX_ADDR;
 static volatile uint32_t g_mailbox_notified = 0;
+static volatile uint32_t g_weights_notified = 0;
 static uint32_t g_last_seq = 0;
-
-// AI runtime state
-static ai_handle g_network = AI_HANDLE_NULL;
-static ai_buffer g_ai_in_buf;
-static ai_buffer g_ai_out_buf;
+static ai_event_ring_t* const g_event_ring = (ai_event_ring_t*)SHARED_EVENTS_ADDR;
+static volatile rtos_health_t* const g_health = (rtos_health_t*)SHARED_HEALTH_ADDR;
+static volatile rt_stats_slot_t* const g_runtime = (rt_stats_slot_t*)SHARED_RUNTIME_ADDR;
+static alert_engine_t g_anomaly_alerts;
 
 /* USER CODE END PV */
 
@@ -91,10 +94,13 @@ static void MX_DMA_Init(void);
 void StartDefaultTask(void *argument);
 
 /* USER CODE BEGIN PFP */
-static void AI_Init(void);
-static ai_i32 AI_RunOnce(const float* features5, float* prediction1);
 static void Mailbox_Init(void);
 static void Mailbox_NotifyCallback(void);
+static void Mailbox_Process(void);
+static void Weights_Process(void);
+static void Events_Init(void);
+static void Events_Push(const ai_event_t* ev);
+static void Health_Publish(void);
 
 /* USER CODE END PFP */
 
@@ -174,7 +180,11 @@ Error_Handler();
   MX_DMA_Init();
   /* USER CODE BEGIN 2 */
   Mailbox_Init();
-  AI_Init();
+  Events_Init();
+  if (AI_Registry_Init() != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END 2 */
 
   /* Init scheduler */
@@ -220,27 +230,8 @@ Error_Handler();
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    // Process new data from CM4 when notified via HSEM
-    if (g_mailbox_notified) {
-      __disable_irq();
-      g_mailbox_notified = 0;
-      __enable_irq();
-
-      if (g_sensor_mb->magic == SHARED_MAILBOX_MAGIC && g_sensor_mb->seq != g_last_seq) {
-        g_last_seq = g_sensor_mb->seq;
-        float features[AI_ATHLET_IN_1_SIZE] = {0};
-        // Map: [temp, spo2, hr, fatigue, bias]
-        features[0] = g_sensor_mb->temperature_c;
-        features[1] = g_sensor_mb->spo2_pct;
-        features[2] = g_sensor_mb->heart_rate_bpm;
-        features[3] = g_sensor_mb->fatigue_score;
-        features[4] = 1.0f;
-
-        float pred = 0.0f;
-        (void)AI_RunOnce(features, &pred);
-        // Optionally signal back using another HSEM or write back to mailbox reserved area
-      }
-    }
+    Weights_Process();
+    Mailbox_Process();
   }
   /* USER CODE END 3 */
 }
@@ -319,6 +310,8 @@ static void MX_DMA_Init(void)
 static void Mailbox_NotifyCallback(void)
 {
   g_mailbox_notified = 1;
+  // HAL_HSEM_IRQHandler disables the notification, re-arm it for the next frame
+  HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(HSEM_ID_MAILBOX));
 }
 
 static void Mailbox_Init(void)
@@ -327,6 +320,7 @@ static void Mailbox_Init(void)
   HAL_NVIC_SetPriority(HSEM1_IRQn, 5, 0);
   HAL_NVIC_EnableIRQ(HSEM1_IRQn);
   HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(HSEM_ID_MAILBOX));
+  HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(HSEM_ID_WEIGHTS));
 }
 
 void HAL_HSEM_FreeCallback(uint32_t SemMask)
@@ -334,48 +328,135 @@ void HAL_HSEM_FreeCallback(uint32_t SemMask)
   if (SemMask & __HAL_HSEM_SEMID_TO_MASK(HSEM_ID_MAILBOX)) {
     Mailbox_NotifyCallback();
   }
+  if (SemMask & __HAL_HSEM_SEMID_TO_MASK(HSEM_ID_WEIGHTS)) {
+    g_weights_notified = 1;
+    HAL_HSEM_ActivateNotification(__HAL_HSEM_SEMID_TO_MASK(HSEM_ID_WEIGHTS));
+  }
 }
 
-static void AI_Init(void)
+// Applies a weights blob staged by the CM4, between two inferences
+static void Weights_Process(void)
 {
-  ai_error err;
-  const ai_handle act_addr[] = { AI_HANDLE_PTR(NULL) };
-  const ai_handle wgt_addr[] = { AI_HANDLE_PTR(ai_athlet_data_weights_get()) };
-  err = ai_athlet_create_and_init(&g_network, act_addr, wgt_addr);
-  if (err.type) {
-    while (1) { }
+  if (!g_weights_notified) return;
+  g_weights_notified = 0;
+
+  weights_stage_t *stage = (weights_stage_t *)SHARED_WEIGHTS_ADDR;
+  const uint8_t *blob = (const uint8_t *)SHARED_WEIGHTS_BLOB_ADDR;
+  SCB_InvalidateDCache_by_Addr((uint32_t *)SHARED_WEIGHTS_ADDR, SHARED_WEIGHTS_SIZE);
+  if (stage->state != WEIGHTS_STAGE_READY) return;
+
+  wblob_header_t hdr;
+  uint32_t len = (stage->length < SHARED_WEIGHTS_BLOB_MAX) ? stage->length : SHARED_WEIGHTS_BLOB_MAX;
+  wblob_status_t st = WBlob_Validate(blob, len, &hdr);
+  if (st == WBLOB_OK) {
+    ai_model_id_t id = AI_Registry_FindByName(hdr.model_name);
+    if (AI_Registry_SwapWeights(id, WBlob_Payload(blob), hdr.payload_size, hdr.model_version) != HAL_OK) {
+      st = WBLOB_ERR_MODEL;
+    }
   }
 
-  static float s_in[AI_ATHLET_IN_1_SIZE];
-  static float s_out[AI_ATHLET_OUT_1_SIZE];
-  g_ai_in_buf = (ai_buffer)AI_BUFFER_INIT(
-    AI_FLAG_NONE,
-    AI_ATHLET_IN_1_FORMAT,
-    AI_BUFFER_SHAPE_INIT(AI_SHAPE_BCWH, 4, 1, AI_ATHLET_IN_1_CHANNEL, 1, 1),
-    AI_ATHLET_IN_1_SIZE,
-    NULL,
-    s_in);
-  g_ai_out_buf = (ai_buffer)AI_BUFFER_INIT(
-    AI_FLAG_NONE,
-    AI_ATHLET_OUT_1_FORMAT,
-    AI_BUFFER_SHAPE_INIT(AI_SHAPE_BCWH, 4, 1, AI_ATHLET_OUT_1_CHANNEL, 1, 1),
-    AI_ATHLET_OUT_1_SIZE,
-    NULL,
-    s_out);
+  stage->result = st;
+  stage->state = (st == WBLOB_OK) ? WEIGHTS_STAGE_APPLIED : WEIGHTS_STAGE_REJECTED;
+  SCB_CleanDCache_by_Addr((uint32_t *)SHARED_WEIGHTS_ADDR, sizeof(weights_stage_t));
 }
 
-static ai_i32 AI_RunOnce(const float* features5, float* prediction1)
+// Runs the registered networks on a new CM4 frame, if any
+static void Mailbox_Process(void)
 {
-  float* in = (float*)g_ai_in_buf.data;
-  float* out = (float*)g_ai_out_buf.data;
-  for (uint32_t i = 0; i < AI_ATHLET_IN_1_SIZE; ++i) {
-    in[i] = features5[i];
+  if (!g_mailbox_notified) return;
+
+  __disable_irq();
+  g_mailbox_notified = 0;
+  __enable_irq();
+
+  SCB_InvalidateDCache_by_Addr((uint32_t*)SHARED_MAILBOX_ADDR, sizeof(sensor_mailbox_t));
+  if (g_sensor_mb->magic != SHARED_MAILBOX_MAGIC || g_sensor_mb->seq == g_last_seq) return;
+  g_last_seq = g_sensor_mb->seq;
+
+  float features[ATHLET_FEATURE_COUNT] = {0};
+  // Raw values in training order; the registry applies the model's input scaler, if any
+  features[ATHLET_FEAT_HEART_RATE]  = g_sensor_mb->heart_rate_bpm;
+  features[ATHLET_FEAT_SPO2]        = g_sensor_mb->spo2_pct;
+  features[ATHLET_FEAT_FATIGUE]     = g_sensor_mb->fatigue_score;
+  features[ATHLET_FEAT_TEMPERATURE] = g_sensor_mb->temperature_c;
+  features[ATHLET_FEAT_ACTIVITY]    = (float)g_sensor_mb->activity_code;
+
+  uint32_t ran = AI_Registry_OnFrame(features, ATHLET_FEATURE_COUNT);
+  if (ran & (1UL << AI_MODEL_ANOMALY)) {
+    // Only alert transitions and periodic summaries leave the CM7, not per-frame scores
+    ai_event_t events[ALERT_MAX_EVENTS];
+    float score = AI_Registry_GetStats(AI_MODEL_ANOMALY)->output[0];
+    uint32_t n = AlertEngine_Update(&g_anomaly_alerts, score, g_last_seq, events);
+    for (uint32_t i = 0; i < n; i++) {
+      Events_Push(&events[i]);
+    }
   }
-  ai_i32 nb = ai_athlet_run(g_network, &g_ai_in_buf, &g_ai_out_buf);
-  if (nb > 0) {
-    *prediction1 = out[0];
+}
+
+static void Events_Init(void)
+{
+  alert_config_t cfg;
+  AlertEngine_DefaultConfig(&cfg);
+  AlertEngine_Init(&g_anomaly_alerts, &cfg, AI_MODEL_ANOMALY);
+
+  // The CM4 ignores the ring until the magic is back
+  g_event_ring->magic = 0;
+  SCB_CleanDCache_by_Addr((uint32_t*)g_event_ring, 32);
+  g_event_ring->head = 0;
+  g_event_ring->tail = 0;
+  g_event_ring->dropped = 0;
+  SCB_CleanDCache_by_Addr((uint32_t*)g_event_ring, sizeof(ai_event_ring_t));
+  g_event_ring->magic = SHARED_EVENTS_MAGIC;
+  SCB_CleanDCache_by_Addr((uint32_t*)g_event_ring, 32);
+}
+
+// Single-producer push into the shared ring, drained by the CM4
+static void Events_Push(const ai_event_t* ev)
+{
+  // tail is written by the CM4 only, drop any stale copy of its line
+  SCB_InvalidateDCache_by_Addr((uint32_t*)&g_event_ring->tail, 32);
+  uint32_t head = g_event_ring->head;
+  if (head - g_event_ring->tail >= AI_EVENT_RING_LEN) {
+    g_event_ring->dropped++;
+    SCB_CleanDCache_by_Addr((uint32_t*)g_event_ring, 32);
+    return;
   }
-  return nb;
+
+  // Publish the event before the head that makes it visible
+  g_event_ring->events[head & (AI_EVENT_RING_LEN - 1U)] = *ev;
+  SCB_CleanDCache_by_Addr((uint32_t*)g_event_ring->events, sizeof(g_event_ring->events));
+  __DSB();
+  g_event_ring->head = head + 1U;
+  SCB_CleanDCache_by_Addr((uint32_t*)g_event_ring, 32);
+}
+
+// Publishes stack watermarks, heap low-water mark, feature-cache counters and CPU load for the CM4 health report
+static void Health_Publish(void)
+{
+  static rtos_health_t snap;
+  static rt_stats_frame_t load;
+  static uint32_t next_ms;
+  uint32_t now = osKernelGetTickCount();
+
+  if ((int32_t)(now - next_ms) < 0) return;
+  next_ms = now + HEALTH_PERIOD_MS;
+
+  RtosHealth_Capture(&snap);
+  for (uint32_t id = 0; id < AI_MODEL_COUNT && id < RTOS_HEALTH_MAX_MODELS; id++) {
+    const feature_cache_t* cache = AI_Registry_GetCache((ai_model_id_t)id);
+    rtos_model_health_t* m = &snap.models[snap.n_models++];
+    strncpy(m->name, AI_Registry_GetName((ai_model_id_t)id), RTOS_HEALTH_NAME_LEN - 1U);
+    m->name[RTOS_HEALTH_NAME_LEN - 1U] = '\0';
+    m->hits = cache->hits;
+    m->misses = cache->misses;
+    m->refreshes = cache->refreshes;
+  }
+  RtosHealth_Publish(g_health, &snap);
+  SCB_CleanDCache_by_Addr((uint32_t*)SHARED_HEALTH_ADDR, SHARED_HEALTH_SIZE);
+
+  RunTimeStats_Capture(7U, &load);
+  RunTimeStats_Publish(g_runtime, &load);
+  SCB_CleanDCache_by_Addr((uint32_t*)SHARED_RUNTIME_ADDR, SHARED_RUNTIME_SIZE);
 }
 
 /* USER CODE END 4 */
@@ -393,6 +474,9 @@ void StartDefaultTask(void *argument)
   /* Infinite loop */
   for(;;)
   {
+    Weights_Process();
+    Mailbox_Process();
+    Health_Publish();
     osDelay(1);
   }
   /* USER CODE END 5 */
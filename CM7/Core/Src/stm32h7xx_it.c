@@ -24,6 +24,7 @@
 #include "task.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "runtime_stats.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -159,7 +160,7 @@ void DebugMon_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  RunTimeStats_IsrEnter();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
 #if (INCLUDE_xTaskGetSchedulerState == 1 )
@@ -171,7 +172,7 @@ void SysTick_Handler(void)
   }
 #endif /* INCLUDE_xTaskGetSchedulerState */
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  RunTimeStats_IsrExit();
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -184,4 +185,14 @@ void SysTick_Handler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles HSEM1 global interrupt (CM4 mailbox and weights notifications).
+  */
+void HSEM1_IRQHandler(void)
+{
+  RunTimeStats_IsrEnter();
+  HAL_HSEM_IRQHandler();
+  RunTimeStats_IsrExit();
+}
+
 /* USER CODE END 1 */
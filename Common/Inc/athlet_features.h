@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file    athlet_features.h
+  * @brief   Input feature contract of the anomaly network.
+  *          Written from the app's scaler constants until
+  *          "anomaly model/export_folded_model.py" regenerates it from scaler.pkl.
+  ******************************************************************************
+  * The network input is the feature vector in this order. The compiled
+  * network still expects standardised input, so ai_registry.c applies the
+  * training scaler; once CM7/X-CUBE-AI/App is regenerated from
+  * athlete_model_folded.tflite, export with --folded and the scaler goes.
+  ******************************************************************************
+  */
+#ifndef ATHLET_FEATURES_H
+#define ATHLET_FEATURES_H
+
+/* Feature index in the network input vector */
+#define ATHLET_FEAT_HEART_RATE   (0U)  /* HeartRate [bpm] */
+#define ATHLET_FEAT_SPO2         (1U)  /* OxygenLevel [%] */
+#define ATHLET_FEAT_FATIGUE      (2U)  /* FatigueScore [1..10] */
+#define ATHLET_FEAT_TEMPERATURE  (3U)  /* tmp [degC] */
+#define ATHLET_FEAT_ACTIVITY     (4U)  /* Activity_encoded [LabelEncoder code] */
+#define ATHLET_FEATURE_COUNT     (5U)
+
+/* Scaling already applied inside the network (1 = feed raw values) */
+#define ATHLET_FEATURES_SCALING_FOLDED  (0)
+
+/* Activity LabelEncoder codes */
+#define ATHLET_ACTIVITY_CYCLING        (0U)
+#define ATHLET_ACTIVITY_RUNNING        (1U)
+#define ATHLET_ACTIVITY_TREADMILL      (2U)
+#define ATHLET_ACTIVITY_WEIGHTLIFTING  (3U)
+#define ATHLET_ACTIVITY_COUNT          (4U)
+
+/* Training scaler, applied on device while SCALING_FOLDED is 0 */
+#define ATHLET_SCALER_MEAN_INIT  { 130.10257f, 95.0995638f, 4.97696728f, 37.82234f, 1.522f }
+#define ATHLET_SCALER_SCALE_INIT { 14.7040725f, 2.9492447f, 1.91721221f, 0.335668772f, 1.11781752f }
+
+#endif /* ATHLET_FEATURES_H */
@@ -0,0 +1,101 @@
+/**
+  ******************************************************************************
+  * @file    ipc_shared.h
+  * @brief   Memory map and hardware semaphores shared by the CM4 and the CM7.
+  ******************************************************************************
+  * D2 SRAM layout used for inter-core exchange:
+  *   0x3003C000 - 0x3003FFFF  weights blob staging (CM4 writes, CM7 reads)
+  *   0x30040000 - 0x300400FF  sensor mailbox (CM4 writes, CM7 reads)
+  *   0x30040100 - 0x300403FF  AI event ring (CM7 writes, CM4 reads)
+  *   0x30040400 - 0x300404FF  CM7 RTOS health snapshot (CM7 writes, CM4 reads)
+  *   0x30040500 - 0x300405FF  CM7 run-time stats frame (CM7 writes, CM4 reads)
+  * All of it is excluded from the CM4 RAM region in its linker script.
+  ******************************************************************************
+  */
+#ifndef IPC_SHARED_H
+#define IPC_SHARED_H
+
+#include <stdint.h>
+
+/* Sensor mailbox ------------------------------------------------------------*/
+#define SHARED_MAILBOX_ADDR   (0x30040000UL)
+#define SHARED_MAILBOX_MAGIC  (0xBA5ECAFEu)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t seq;
+  float    temperature_c;
+  float    spo2_pct;
+  float    heart_rate_bpm;
+  float    fatigue_score;   // 1..10, as in training (ATHLET_FEAT_FATIGUE)
+  uint32_t activity_code;   // ATHLET_ACTIVITY_*
+  uint32_t reserved[3];
+} sensor_mailbox_t;
+
+/* Weights blob staging ------------------------------------------------------*/
+#define SHARED_WEIGHTS_ADDR   (0x3003C000UL)
+#define SHARED_WEIGHTS_SIZE   (16U * 1024U)
+
+// Handshake word at the start of the staging area (own 32-byte cache line)
+#define WEIGHTS_STAGE_IDLE      (0U)           // CM4 may write a new blob
+#define WEIGHTS_STAGE_READY     (0x52445921u)  // Blob complete, waiting for the CM7
+#define WEIGHTS_STAGE_APPLIED   (0x41504C59u)  // CM7 swapped to the new weights
+#define WEIGHTS_STAGE_REJECTED  (0x52454A21u)  // CM7 refused the blob, see result
+
+typedef struct {
+  volatile uint32_t state;   // WEIGHTS_STAGE_*
+  volatile int32_t  result;  // wblob_status_t of the last CM7 check
+  volatile uint32_t length;  // Blob bytes staged after this header
+  uint32_t reserved[5];
+} weights_stage_t;
+
+#define SHARED_WEIGHTS_BLOB_ADDR  (SHARED_WEIGHTS_ADDR + sizeof(weights_stage_t))
+#define SHARED_WEIGHTS_BLOB_MAX   (SHARED_WEIGHTS_SIZE - sizeof(weights_stage_t))
+
+/* AI events (CM7 -> CM4) ----------------------------------------------------*/
+#define SHARED_EVENTS_ADDR    (0x30040100UL)
+#define SHARED_EVENTS_MAGIC   (0xE7E47A11u)
+#define AI_EVENT_RING_LEN     (16U)  // Power of two
+
+typedef enum {
+  AI_EVENT_ALERT_START = 1,
+  AI_EVENT_ALERT_END   = 2,
+  AI_EVENT_SUMMARY     = 3,
+} ai_event_type_t;
+
+typedef struct {
+  uint8_t  type;       // ai_event_type_t
+  uint8_t  model;      // ai_model_id_t of the source network
+  uint16_t alert_id;   // Increments per alert; END carries the id of its START
+  uint32_t frame;      // Mailbox seq when the event fired
+  float    score;      // START: smoothed score, SUMMARY: mean smoothed score
+  float    peak;       // END/SUMMARY: highest smoothed score
+  uint32_t duration;   // END: frames in alert, SUMMARY: frames in the window
+  uint32_t count;      // SUMMARY: alerts started in the window
+} ai_event_t;
+
+// Single producer (CM7), single consumer (CM4). Indices run freely and are
+// masked on access; producer and consumer words sit in separate cache lines.
+typedef struct {
+  volatile uint32_t magic;    // SHARED_EVENTS_MAGIC once the CM7 reset the ring
+  volatile uint32_t head;     // Next slot the CM7 writes
+  volatile uint32_t dropped;  // Events lost because the ring was full
+  uint32_t reserved0[5];
+  volatile uint32_t tail;     // Next slot the CM4 reads
+  uint32_t reserved1[7];
+  ai_event_t events[AI_EVENT_RING_LEN];
+} ai_event_ring_t;
+
+/* RTOS health (CM7 -> CM4) -------------------------------------------------*/
+#define SHARED_HEALTH_ADDR    (0x30040400UL)  // rtos_health_t, see rtos_health.h
+#define SHARED_HEALTH_SIZE    (0x100U)
+
+/* Run-time stats (CM7 -> CM4) ----------------------------------------------*/
+#define SHARED_RUNTIME_ADDR   (0x30040500UL)  // rt_stats_slot_t, see runtime_stats.h
+#define SHARED_RUNTIME_SIZE   (0x100U)
+
+/* Hardware semaphores -------------------------------------------------------*/
+#define HSEM_ID_MAILBOX       (5U)  // CM4 -> CM7: new sensor frame
+#define HSEM_ID_WEIGHTS       (6U)  // CM4 -> CM7: weights blob staged
+
+#endif /* IPC_SHARED_H */
@@ -0,0 +1,58 @@
+/* FreeRTOS memory health: per-task stack watermarks and heap low-water mark. */
+#ifndef RTOS_HEALTH_H
+#define RTOS_HEALTH_H
+
+#include <stdint.h>
+
+#define RTOS_HEALTH_MAX_TASKS   (8U)   // Tasks listed per core, idle and timer included
+#define RTOS_HEALTH_NAME_LEN    (12U)  // Names are truncated to 11 characters
+#define RTOS_HEALTH_MAX_MODELS  (4U)   // AI models listed (CM7 only)
+
+typedef struct {
+  char     name[RTOS_HEALTH_NAME_LEN];
+  uint32_t stack_free_min;   // Bytes, from uxTaskGetStackHighWaterMark
+} rtos_task_health_t;
+
+// Feature-cache counters of one AI model (CM7/Core/Inc/ai_feature_cache.h)
+typedef struct {
+  char     name[RTOS_HEALTH_NAME_LEN];
+  uint32_t hits;             // Due, inputs within tolerance: inference skipped
+  uint32_t misses;
+  uint32_t refreshes;        // Forced by the cache age
+} rtos_model_health_t;
+
+// Same layout on both cores; the CM7 copy lives at SHARED_HEALTH_ADDR
+typedef struct {
+  volatile uint32_t seq;     // Odd while the writer updates the snapshot
+  uint32_t uptime_ms;
+  uint32_t heap_free;        // xPortGetFreeHeapSize
+  uint32_t heap_free_min;    // xPortGetMinimumEverFreeHeapSize
+  uint32_t tasks_total;      // Tasks in the system, may exceed n_tasks
+  uint32_t n_tasks;          // Entries used in tasks[], in creation order
+  rtos_task_health_t tasks[RTOS_HEALTH_MAX_TASKS];
+  uint32_t n_models;         // Entries used in models[], filled by the CM7 after the capture
+  rtos_model_health_t models[RTOS_HEALTH_MAX_MODELS];
+} rtos_health_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Fills a snapshot of the calling core (seq untouched, no models). Suspends the
+ * scheduler while it walks the task lists; call from one task only.
+ */
+void RtosHealth_Capture(rtos_health_t *out);
+
+/**
+ * @brief Copies snap into a slot read by the other core (seqlock writer).
+ * The caller cleans the D-cache over the slot afterwards if needed.
+ */
+void RtosHealth_Publish(volatile rtos_health_t *slot, const rtos_health_t *snap);
+
+/**
+ * @brief Copies a slot written by the other core (seqlock reader).
+ * @retval 1 on a consistent copy of a published snapshot, 0 otherwise.
+ */
+uint8_t RtosHealth_Read(const volatile rtos_health_t *slot, rtos_health_t *out);
+
+#endif /* RTOS_HEALTH_H */
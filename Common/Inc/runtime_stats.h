@@ -0,0 +1,74 @@
+/* FreeRTOS run-time stats: per-task CPU load, ISR time and idle share. */
+#ifndef RUNTIME_STATS_H
+#define RUNTIME_STATS_H
+
+#include <stdint.h>
+
+#define RUNTIME_STATS_HZ         (1000000U)  // portGET_RUN_TIME_COUNTER_VALUE rate, wraps after 71 min
+#define RUNTIME_STATS_MAX_TASKS  (8U)
+#define RUNTIME_STATS_NAME_LEN   (4U)        // Task names are cut to 4 characters in the frame
+
+// First payload byte of the frame; text telemetry lines are plain ASCII
+#define RT_STATS_TAG             (0xC5U)
+#define RT_STATS_VERSION         (1U)
+
+typedef struct __attribute__((packed)) {
+  char     name[RUNTIME_STATS_NAME_LEN];  // Not NUL terminated
+  uint16_t cpu_x100;                      // Share of the window, 0.01 % units
+} rt_task_load_t;
+
+// Little-endian wire format, sent as is; only n_tasks entries are sent
+typedef struct __attribute__((packed)) {
+  uint8_t  tag;          // RT_STATS_TAG
+  uint8_t  version;      // RT_STATS_VERSION
+  uint8_t  core;         // 4 = CM4, 7 = CM7
+  uint8_t  n_tasks;
+  uint32_t window_us;    // Time covered by the percentages
+  uint16_t idle_x100;    // Idle task share, ISRs taken while idle included
+  uint16_t isr_x100;     // Instrumented ISRs, already part of the task shares
+  rt_task_load_t tasks[RUNTIME_STATS_MAX_TASKS];  // Creation order
+} rt_stats_frame_t;
+
+#define RT_STATS_HEADER_LEN        (12U)
+#define RT_STATS_FRAME_LEN(n_)     (RT_STATS_HEADER_LEN + (uint32_t)(n_) * sizeof(rt_task_load_t))
+
+// CM7 frame for the CM4 reporter, at SHARED_RUNTIME_ADDR
+typedef struct {
+  volatile uint32_t seq;  // Odd while the writer updates the frame
+  rt_stats_frame_t frame;
+} rt_stats_slot_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Call first thing in an ISR to have its time counted. Only the
+ * outermost of nested ISRs is timed.
+ */
+void RunTimeStats_IsrEnter(void);
+
+/**
+ * @brief Call last thing in an ISR that called RunTimeStats_IsrEnter().
+ */
+void RunTimeStats_IsrExit(void);
+
+/**
+ * @brief Fills a frame with the load since the previous call (since boot on
+ * the first one). One caller per core.
+ * @param core 4 or 7, copied to the frame.
+ */
+void RunTimeStats_Capture(uint8_t core, rt_stats_frame_t *out);
+
+/**
+ * @brief Copies a frame into a slot read by the other core (seqlock writer).
+ * The caller cleans the D-cache over the slot afterwards if needed.
+ */
+void RunTimeStats_Publish(volatile rt_stats_slot_t *slot, const rt_stats_frame_t *frame);
+
+/**
+ * @brief Copies a slot written by the other core (seqlock reader).
+ * @retval 1 on a consistent copy of a published frame, 0 otherwise.
+ */
+uint8_t RunTimeStats_Read(const volatile rt_stats_slot_t *slot, rt_stats_frame_t *out);
+
+#endif /* RUNTIME_STATS_H */
@@ -0,0 +1,285 @@
+/* Binary telemetry: fixed-size records, batches and COBS/CRC-16 link framing (CM4 and ESP32). */
+#ifndef TELEMETRY_PROTO_H
+#define TELEMETRY_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Link frame:
+ *   COBS( [body][crc16(2)] ) 0x00
+ * CRC-16/CCITT-FALSE covers the body and catches line noise. COBS leaves
+ * 0x00 only as the delimiter, so a receiver resynchronises on the next one
+ * whatever was lost or corrupted.
+ *
+ * Body, one per batch (secure_uart.c):
+ *   [tp_seal_hdr_t(8)][batch, AES-128-GCM encrypted][tag(16)]
+ * session is drawn at boot and ctr counts batches from 1; together they make
+ * the 96-bit GCM nonce (TlmProto_Nonce). The header is the associated data,
+ * so a batch that was altered, replayed under another counter or damaged in
+ * a way the CRC missed fails the tag and is dropped whole. Built without
+ * encryption, the batch follows the header in clear and there is no tag.
+ *
+ * Batch:
+ *   [TP_BATCH_VERSION][count] then count x [len(1)][item]
+ * Items are dispatched on their first byte: TP_RECORD_TAG (below),
+ * RT_STATS_TAG, DLOG_TAG, TP_LINK_TAG, or plain ASCII text lines.
+ *
+ * Link control (tp_link_t), the other way, ESP32 -> CM4, is a bare frame
+ * whose body is the message itself, in clear: HELLO proposes a baud rate
+ * (and RTS/CTS), repeated as a keep-alive once it is in use; NACK asks for
+ * frames again by counter. The CM4 agrees to a HELLO with an ACCEPT item in
+ * a sealed batch, then switches. The ESP32 puts TP_LINK_PREAMBLE delimiters
+ * before each message: they are lost while USART3 wakes the CM4 from STOP.
+ * Before writing unframed bytes (the trace dump, tracer.h) the CM4 ends a
+ * sealed batch with a RAW item giving their count; the ESP32 passes them by
+ * instead of decoding them as broken frames.
+ */
+#define TP_FRAME_CRC_LEN        (2U)
+#define TP_FRAME_DELIM          (0x00U)
+#define TP_COBS_MAX(n_)         ((n_) + ((n_) / 254U) + 1U)
+#define TP_FRAME_MAX(body_)     (TP_COBS_MAX((body_) + TP_FRAME_CRC_LEN) + 1U)
+
+#define TP_SEAL_HDR_LEN         (8U)
+#define TP_SEAL_TAG_LEN         (16U)
+#define TP_NONCE_LEN            (12U)
+
+#define TP_BATCH_VERSION        (1U)
+#define TP_BATCH_HDR_LEN        (2U)
+#define TP_BATCH_MAX            (256U)   // Plaintext, headers included
+#define TP_BATCH_ITEM_MAX       (TP_BATCH_MAX - TP_BATCH_HDR_LEN - 1U)
+#define TP_BODY_MAX             (TP_SEAL_HDR_LEN + TP_BATCH_MAX + TP_SEAL_TAG_LEN)
+
+typedef struct __attribute__((packed)) {
+  uint32_t session;    // Random per sender boot
+  uint32_t ctr;        // Batch counter, from 1; gaps are lost frames
+} tp_seal_hdr_t;
+
+// Batch being filled, see TlmProto_BatchAdd()
+typedef struct {
+  uint8_t  buf[TP_BATCH_MAX];
+  uint16_t len;
+  uint8_t  count;
+} tp_batch_t;
+
+// Records: little-endian, packed, fixed size per type
+#define TP_RECORD_TAG           (0xC7U)
+#define TP_RECORD_VERSION       (1U)
+
+typedef enum {
+  TP_REC_PPG   = 1,
+  TP_REC_TEMP  = 2,
+  TP_REC_EVENT = 3,
+  TP_REC_CONFIG = 4,
+} tp_record_type_t;
+
+typedef enum {
+  TP_TEMP_LM35     = 0,
+  TP_TEMP_MAX30100 = 1,   // Sensor die
+} tp_temp_source_t;
+
+#define TP_PPG_FINGER           (1U << 0)   // SpO2 computed, signal above the floor
+#define TP_PPG_HR_VALID         (1U << 1)   // At least two peaks in the window
+
+typedef struct __attribute__((packed)) {
+  uint8_t  tag;        // TP_RECORD_TAG
+  uint8_t  version;    // TP_RECORD_VERSION
+  uint8_t  type;       // tp_record_type_t
+  uint8_t  seq;        // Per-sender record counter, gaps are lost records
+  uint32_t ts_ms;      // Sender uptime when the value was produced
+} tp_header_t;
+
+typedef struct __attribute__((packed)) {
+  tp_header_t h;
+  uint16_t hr_x10;       // bpm
+  uint16_t spo2_x10;     // %
+  uint16_t ratio_x1000;  // R = (AC_red/DC_red) / (AC_ir/DC_ir)
+  uint16_t pi_x100;      // Perfusion index AC_ir/DC_ir in %, signal quality
+  uint16_t dc_ir;
+  uint16_t dc_red;
+  uint16_t ac_ir;
+  uint16_t ac_red;
+  uint8_t  peaks;
+  uint8_t  flags;        // TP_PPG_*
+} tp_ppg_t;
+
+typedef struct __attribute__((packed)) {
+  tp_header_t h;
+  int16_t  celsius_x100;
+  uint8_t  source;     // tp_temp_source_t
+  uint8_t  reserved;
+  uint32_t raw;        // LM35: averaged ADC code, 0 otherwise
+} tp_temp_t;
+
+// Anomaly model output, see ai_event_t in ipc_shared.h
+typedef struct __attribute__((packed)) {
+  tp_header_t h;
+  uint8_t  event;        // ai_event_type_t
+  uint8_t  model;        // ai_model_id_t
+  uint16_t alert_id;
+  uint32_t frame;        // Mailbox seq
+  uint16_t score_x1000;  // START: smoothed score, SUMMARY: mean
+  uint16_t peak_x1000;   // END/SUMMARY: highest smoothed score
+  uint32_t duration;     // END: frames in alert, SUMMARY: frames in the window
+  uint32_t count;        // SUMMARY: alerts in the window
+} tp_event_t;
+
+// Acquisition settings in force, sent at boot (cmd_id 0) and as the answer
+// to every CFG command (vest_config.h), applied or not
+typedef struct __attribute__((packed)) {
+  tp_header_t h;
+  uint16_t cmd_id;       // Command answered, 0 at boot
+  uint8_t  status;       // vest_cfg_status_t
+  uint8_t  dsp;          // vest_dsp_mode_t
+  uint16_t rate_hz;      // MAX30100 sample rate
+  uint16_t pw_us;        // LED pulse width
+  uint8_t  led_ir;       // MAX30100 current codes, 0..15
+  uint8_t  led_red;
+  uint8_t  ai;           // 1: frames go to the CM7 models
+  uint8_t  reserved;
+  uint32_t report_ms;    // PPG record period, 0: every window
+} tp_config_t;
+
+typedef union {
+  tp_header_t h;
+  tp_ppg_t    ppg;
+  tp_temp_t   temp;
+  tp_event_t  event;
+  tp_config_t config;
+} tp_record_t;
+
+// Link control, see the frame description above
+#define TP_LINK_TAG             (0xC8U)
+#define TP_LINK_PREAMBLE        (2U)        // TP_FRAME_DELIM bytes ahead of a message
+#define TP_LINK_RTSCTS          (1U << 0)   // Hardware flow control, both directions
+#define TP_LINK_BAUD_BASE       (115200UL)  // Both ends at boot and after a fallback
+#define TP_LINK_NACK_WINDOW     (64U)       // Frames behind the newest the ESP32 still takes
+
+typedef enum {
+  TP_LINK_HELLO  = 1,   // ESP32: value = baud, flags = TP_LINK_*
+  TP_LINK_ACCEPT = 2,   // CM4, sealed item: value = baud, flags as agreed
+  TP_LINK_NACK   = 3,   // ESP32: frames value .. value + count - 1 of session
+  TP_LINK_RAW    = 4,   // CM4, sealed item: value = unframed bytes right after this frame
+} tp_link_op_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t  tag;        // TP_LINK_TAG
+  uint8_t  op;         // tp_link_op_t
+  uint8_t  flags;
+  uint8_t  count;      // NACK: frames asked for, from 1
+  uint32_t session;    // NACK: of the frames asked for, 0 otherwise
+  uint32_t value;
+} tp_link_t;
+
+// Streaming frame decoder, one per link
+typedef struct {
+  uint8_t  buf[TP_FRAME_MAX(TP_BODY_MAX)];
+  uint32_t len;
+  uint8_t  overflow;
+  uint32_t frames;       // Good frames
+  uint32_t crc_errors;
+  uint32_t bad_frames;   // Oversized, undecodable or shorter than header + CRC
+} tp_decoder_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF); pass 0xFFFF to start.
+ */
+uint16_t TlmProto_Crc16(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * @brief COBS-encodes len bytes; out holds at least TP_COBS_MAX(len). No delimiter.
+ * @retval Encoded length.
+ */
+size_t TlmProto_CobsEncode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Decodes one COBS block (delimiter excluded). out may equal in.
+ * @retval Decoded length, or 0 if the block is malformed.
+ */
+size_t TlmProto_CobsDecode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Builds a complete link frame, delimiter included.
+ * @param cap Size of out, at least TP_FRAME_MAX(len).
+ * @retval Frame length, or 0 if len > TP_BODY_MAX or out is too small.
+ */
+size_t TlmProto_FrameEncode(const uint8_t *body, size_t len, uint8_t *out, size_t cap);
+
+void TlmProto_DecoderInit(tp_decoder_t *dec);
+
+/**
+ * @brief Feeds one received byte.
+ * @retval Body length when the byte completed a good frame (body is set,
+ * valid until the next call), 0 otherwise.
+ */
+size_t TlmProto_DecoderFeed(tp_decoder_t *dec, uint8_t byte, const uint8_t **body);
+
+/**
+ * @brief GCM nonce of a batch: session big-endian, 4 zero bytes, ctr big-endian.
+ */
+void TlmProto_Nonce(uint32_t session, uint32_t ctr, uint8_t nonce[TP_NONCE_LEN]);
+
+void TlmProto_BatchInit(tp_batch_t *batch);
+
+/**
+ * @brief Appends one item.
+ * @retval 1 if added, 0 if it does not fit (seal the batch and retry) or
+ * len is 0 or above TP_BATCH_ITEM_MAX.
+ */
+uint8_t TlmProto_BatchAdd(tp_batch_t *batch, const uint8_t *item, size_t len);
+
+/**
+ * @brief Walks a received batch; start with *pos = 0.
+ * @retval Length of the next item (item is set), 0 at the end or if the
+ * batch is malformed.
+ */
+size_t TlmProto_BatchNext(const uint8_t *batch, size_t len, size_t *pos, const uint8_t **item);
+
+/**
+ * @brief Wire size of a record type, 0 if unknown.
+ */
+size_t TlmProto_RecordLen(uint8_t type);
+
+/**
+ * @brief Fills the record header.
+ * @retval Wire size of the record (TlmProto_RecordLen(type)).
+ */
+size_t TlmProto_RecordInit(tp_record_t *rec, uint8_t type, uint8_t seq, uint32_t ts_ms);
+
+/**
+ * @brief Checks tag, version, type and length, without copying.
+ * @retval The record overlaid on payload (valid as long as payload is), or
+ * NULL if invalid. Only the first TlmProto_RecordLen(type) bytes exist.
+ */
+const tp_record_t *TlmProto_RecordView(const uint8_t *payload, size_t len);
+
+/**
+ * @brief Checks tag, version, type and length and copies the record out.
+ * @retval 1 if valid, 0 otherwise.
+ */
+uint8_t TlmProto_RecordParse(const uint8_t *payload, size_t len, tp_record_t *out);
+
+/**
+ * @brief Checks tag, op and length of a link control message, without copying.
+ * @retval The message overlaid on data, or NULL if it is not one.
+ */
+const tp_link_t *TlmProto_LinkView(const uint8_t *data, size_t len);
+
+/**
+ * @brief Float to fixed point, rounded and saturated (NaN gives 0).
+ */
+uint16_t TlmProto_ToU16(float v, float scale);
+int16_t TlmProto_ToI16(float v, float scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_PROTO_H */
@@ -0,0 +1,140 @@
+/* Runtime acquisition settings and the CFG text commands that change them (CM4 and ESP32). */
+#ifndef VEST_CONFIG_H
+#define VEST_CONFIG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Command, one text line on USART3 (ESP32 -> CM4), CR or LF terminated:
+ *   CFG <id> [RATE=<Hz>] [PW=<us>] [LED_IR=<mA>] [LED_RED=<mA>]
+ *            [REPORT=<ms>] [DSP=OFF|HR|SPO2] [AI=0|1]
+ * id (1..65535) is echoed in the answer, a tp_config_t record with the
+ * settings in force afterwards. Without a key the command is a query. A
+ * command is applied whole or not at all. Other lines are not commands and
+ * are ignored; a 0x00 byte (frame delimiter) restarts the line, so link
+ * frames sharing the wire never leak into one.
+ *
+ *   RATE     MAX30100 sample rate: 50, 100, 167 or 200 Hz
+ *   PW       LED pulse width: 200, 400, 800 or 1600 us (ADC 13 to 16 bits).
+ *            The datasheet caps 1600 us at 100 Hz
+ *   LED_*    LED current, e.g. 20.8; rounded down to a MAX30100 step
+ *            (0 to 50.0 mA, codes 0..15)
+ *   REPORT   PPG record period, 0 (every window) or 1000..600000 ms
+ *   DSP      OFF: sensor shut down; HR: IR LED only, no SpO2 (the CM7
+ *            gets no frames); SPO2: both LEDs
+ *   AI       0: frames are not handed to the CM7 models
+ */
+#define VEST_CMD_PREFIX         "CFG"
+#define VEST_CMD_LINE_MAX       (96U)       // Longer lines are dropped
+#define VEST_CFG_REPORT_MIN_MS  (1000UL)
+#define VEST_CFG_REPORT_MAX_MS  (600000UL)
+
+typedef enum {
+  VEST_DSP_OFF  = 0,
+  VEST_DSP_HR   = 1,
+  VEST_DSP_SPO2 = 2,
+} vest_dsp_mode_t;
+
+typedef enum {
+  VEST_CFG_OK          = 0,
+  VEST_CFG_ERR_SYNTAX  = 1,   // Unknown key, malformed value or id
+  VEST_CFG_ERR_RANGE   = 2,   // Value outside the list above
+  VEST_CFG_ERR_COMBO   = 3,   // Pulse width too long for the sample rate
+  VEST_CFG_ERR_BUSY    = 4,   // Previous command still being applied
+  VEST_CFG_ERR_SENSOR  = 5,   // MAX30100 write failed, previous settings kept
+} vest_cfg_status_t;
+
+// Fields a command sets
+#define VEST_CFG_F_RATE         (1U << 0)
+#define VEST_CFG_F_PW           (1U << 1)
+#define VEST_CFG_F_LED_IR       (1U << 2)
+#define VEST_CFG_F_LED_RED      (1U << 3)
+#define VEST_CFG_F_REPORT       (1U << 4)
+#define VEST_CFG_F_DSP          (1U << 5)
+#define VEST_CFG_F_AI           (1U << 6)
+
+typedef struct {
+  uint16_t rate_hz;
+  uint16_t pw_us;
+  uint8_t  led_ir;       // MAX30100 current code, 0..15
+  uint8_t  led_red;
+  uint8_t  dsp;          // vest_dsp_mode_t
+  uint8_t  ai;
+  uint32_t report_ms;
+} vest_config_t;
+
+typedef struct {
+  uint16_t      id;
+  uint8_t       set;     // VEST_CFG_F_*
+  vest_config_t v;       // Fields outside set are undefined
+} vest_cmd_t;
+
+// Line assembler, one per input stream
+typedef struct {
+  char     buf[VEST_CMD_LINE_MAX + 1U];
+  uint8_t  len;
+  uint8_t  overflow;
+} vest_line_t;
+
+/*----------------------------------------------------------------------------*/
+// Public Function Prototypes
+
+/**
+ * @brief Boot settings: 100 Hz, 1600 us, 20.8 mA on both LEDs, SPO2, AI on,
+ * PPG record every window (the MAX30100 driver defaults).
+ */
+void VestCfg_Defaults(vest_config_t *cfg);
+
+void VestCfg_LineInit(vest_line_t *line);
+
+/**
+ * @brief Feeds one received byte; no allocation, usable from an interrupt.
+ * @retval Line length when the byte ended a non-empty line (line->buf is then
+ * NUL-terminated, valid until the next call), 0 otherwise.
+ */
+size_t VestCfg_LineFeed(vest_line_t *line, uint8_t byte);
+
+/**
+ * @brief Parses one line.
+ * @retval -1 if the line is not a CFG command, else a vest_cfg_status_t:
+ * VEST_CFG_OK, VEST_CFG_ERR_SYNTAX or VEST_CFG_ERR_RANGE. cmd->id is set
+ * whenever the id itself was readable (0 otherwise) so errors can be answered.
+ */
+int VestCfg_Parse(const char *line, vest_cmd_t *cmd);
+
+/**
+ * @brief out = cur with the fields of cmd, if the result is consistent.
+ * @retval VEST_CFG_OK, or VEST_CFG_ERR_COMBO (out untouched).
+ */
+uint8_t VestCfg_Merge(const vest_config_t *cur, const vest_cmd_t *cmd, vest_config_t *out);
+
+/**
+ * @brief Every key, as "RATE=100 PW=1600 ...": appended to "CFG <id> " it is
+ * a command that restores cfg.
+ * @retval Length written (truncated to size - 1).
+ */
+size_t VestCfg_Format(const vest_config_t *cfg, char *buf, size_t size);
+
+const char *VestCfg_StatusName(uint8_t status);
+
+/**
+ * @brief MAX30100 SPO2_SR and SPO2_LED_PW field values, 0xFF if unsupported.
+ */
+uint8_t VestCfg_RateCode(uint16_t rate_hz);
+uint8_t VestCfg_PulseWidthCode(uint16_t pw_us);
+
+/**
+ * @brief LED current of a MAX30100 code in 0.1 mA (0 for codes above 15).
+ */
+uint16_t VestCfg_LedTenthsMa(uint8_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VEST_CONFIG_H */
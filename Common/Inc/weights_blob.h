@@ -0,0 +1,109 @@
+/**
+  ******************************************************************************
+  * @file    weights_blob.h
+  * @brief   Versioned, CRC-checked container for X-CUBE-AI weights and the
+  *          streaming loader that receives it.
+  ******************************************************************************
+  * Layout (little-endian), produced by tools/pack_weights.py:
+  *   [wblob_header_t (48 bytes)][payload (payload_size bytes)]
+  * The payload is the raw weights array of the generated network
+  * (s_<name>_weights_array_u64), so it must match AI_<NAME>_DATA_WEIGHTS_SIZE.
+  * CRCs are CRC-32 (IEEE 802.3, same as zlib.crc32).
+  *
+  * This file has no HAL dependency and is also built by tools/host.
+  ******************************************************************************
+  */
+#ifndef WEIGHTS_BLOB_H
+#define WEIGHTS_BLOB_H
+
+#include <stdint.h>
+
+#define WBLOB_MAGIC            (0x42574941u)  // "AIWB"
+#define WBLOB_FORMAT_VERSION   (1U)
+#define WBLOB_NAME_LEN         (16U)
+
+typedef struct {
+  uint32_t magic;
+  uint16_t format_version;
+  uint16_t header_size;
+  char     model_name[WBLOB_NAME_LEN];  // X-CUBE-AI --name, NUL padded
+  uint32_t model_version;               // Increases with each export, 0 = compiled-in
+  uint32_t payload_size;
+  uint32_t payload_crc32;
+  uint32_t flags;                        // Reserved, 0
+  uint32_t reserved;
+  uint32_t header_crc32;                 // CRC of all previous header bytes
+} wblob_header_t;
+
+#define WBLOB_HEADER_SIZE      (48U)
+
+typedef enum {
+  WBLOB_OK = 0,
+  WBLOB_IN_PROGRESS,
+  WBLOB_ERR_MAGIC = -1,
+  WBLOB_ERR_VERSION = -2,
+  WBLOB_ERR_HEADER_CRC = -3,
+  WBLOB_ERR_TOO_LARGE = -4,
+  WBLOB_ERR_PAYLOAD_CRC = -5,
+  WBLOB_ERR_TRUNCATED = -6,
+  WBLOB_ERR_MODEL = -7,   // Unknown model name or payload size mismatch
+  WBLOB_ERR_BUSY = -8,    // Previous blob not consumed yet
+} wblob_status_t;
+
+typedef enum {
+  WBLOB_RX_HUNT = 0,  // Looking for the magic
+  WBLOB_RX_HEADER,
+  WBLOB_RX_PAYLOAD,
+  WBLOB_RX_DONE,
+} wblob_rx_state_t;
+
+// Streaming loader: bytes in, validated blob out in a caller-provided slot
+typedef struct {
+  uint8_t         *slot;
+  uint32_t         capacity;
+  uint32_t         received;   // Bytes written to slot
+  uint32_t         expected;   // Header + payload size once the header is valid
+  uint32_t         crc;        // Running payload CRC
+  wblob_rx_state_t state;
+  wblob_status_t   last_error;
+  uint32_t         errors;
+} wblob_loader_t;
+
+/**
+ * @brief Updates a CRC-32 with len bytes. Start with crc = 0.
+ */
+uint32_t WBlob_Crc32(uint32_t crc, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Checks a complete blob held in memory.
+ * @param blob Start of the header.
+ * @param len Bytes available at blob.
+ * @param header Optional copy of the decoded header.
+ * @retval WBLOB_OK or a WBLOB_ERR_* code.
+ */
+wblob_status_t WBlob_Validate(const uint8_t *blob, uint32_t len, wblob_header_t *header);
+
+/**
+ * @brief Returns a pointer to the payload of a validated blob.
+ */
+const uint8_t *WBlob_Payload(const uint8_t *blob);
+
+/**
+ * @brief Prepares a loader writing into slot.
+ */
+void WBlob_LoaderInit(wblob_loader_t *ld, uint8_t *slot, uint32_t capacity);
+
+/**
+ * @brief Feeds received bytes. Bytes before the magic are skipped, so the
+ * loader can sit on a link that also carries other traffic.
+ * @retval WBLOB_IN_PROGRESS, WBLOB_OK when a full valid blob is in the slot,
+ *         or a WBLOB_ERR_* code (the loader then hunts for the next magic).
+ */
+wblob_status_t WBlob_LoaderFeed(wblob_loader_t *ld, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Forgets any partial blob and hunts for the next magic.
+ */
+void WBlob_LoaderReset(wblob_loader_t *ld);
+
+#endif /* WEIGHTS_BLOB_H */
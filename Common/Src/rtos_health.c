@@ -0,0 +1,64 @@
+/* FreeRTOS memory health: per-task stack watermarks and heap low-water mark. */
+
+#include "rtos_health.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+// Task lists are walked into this array; uxTaskGetSystemState returns 0 if it is too small
+static TaskStatus_t s_status[RTOS_HEALTH_MAX_TASKS];
+
+void RtosHealth_Capture(rtos_health_t *out)
+{
+  UBaseType_t n = uxTaskGetSystemState(s_status, RTOS_HEALTH_MAX_TASKS, NULL);
+
+  // Creation order keeps the report columns stable
+  for (UBaseType_t i = 1; i < n; i++) {
+    TaskStatus_t s = s_status[i];
+    UBaseType_t j = i;
+    while (j > 0 && s_status[j - 1].xTaskNumber > s.xTaskNumber) {
+      s_status[j] = s_status[j - 1];
+      j--;
+    }
+    s_status[j] = s;
+  }
+
+  out->uptime_ms = (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+  out->heap_free = (uint32_t)xPortGetFreeHeapSize();
+  out->heap_free_min = (uint32_t)xPortGetMinimumEverFreeHeapSize();
+  out->tasks_total = (uint32_t)uxTaskGetNumberOfTasks();
+  out->n_tasks = (uint32_t)n;
+  out->n_models = 0;
+  for (UBaseType_t i = 0; i < n; i++) {
+    strncpy(out->tasks[i].name, s_status[i].pcTaskName, RTOS_HEALTH_NAME_LEN - 1U);
+    out->tasks[i].name[RTOS_HEALTH_NAME_LEN - 1U] = '\0';
+    out->tasks[i].stack_free_min = (uint32_t)s_status[i].usStackHighWaterMark * sizeof(StackType_t);
+  }
+}
+
+void RtosHealth_Publish(volatile rtos_health_t *slot, const rtos_health_t *snap)
+{
+  uint32_t seq = slot->seq;
+
+  slot->seq = seq | 1U;
+  __sync_synchronize();
+  memcpy((void *)((uint8_t *)slot + sizeof(slot->seq)), (const uint8_t *)snap + sizeof(snap->seq),
+         sizeof(rtos_health_t) - sizeof(snap->seq));
+  __sync_synchronize();
+  slot->seq = (seq | 1U) + 1U;
+}
+
+uint8_t RtosHealth_Read(const volatile rtos_health_t *slot, rtos_health_t *out)
+{
+  uint32_t seq = slot->seq;
+  if (seq == 0 || (seq & 1U)) return 0;
+
+  __sync_synchronize();
+  memcpy(out, (const void *)slot, sizeof(*out));
+  __sync_synchronize();
+  if (slot->seq != seq) return 0;
+
+  if (out->n_tasks > RTOS_HEALTH_MAX_TASKS) out->n_tasks = RTOS_HEALTH_MAX_TASKS;
+  if (out->n_models > RTOS_HEALTH_MAX_MODELS) out->n_models = RTOS_HEALTH_MAX_MODELS;
+  return 1;
+}
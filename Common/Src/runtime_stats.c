@@ -0,0 +1,121 @@
+/* FreeRTOS run-time stats: per-task CPU load, ISR time and idle share. */
+
+#include "runtime_stats.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+// Provided by freertos.c of each core (portGET_RUN_TIME_COUNTER_VALUE)
+extern unsigned long getRunTimeCounterValue(void);
+
+static TaskStatus_t s_status[RUNTIME_STATS_MAX_TASKS];
+
+// Counters at the previous capture, matched by task number
+static struct {
+  UBaseType_t number;
+  uint32_t    counter;
+} s_prev[RUNTIME_STATS_MAX_TASKS];
+static uint32_t s_prev_total = 0;
+static uint32_t s_prev_isr = 0;
+
+static volatile uint32_t s_isr_depth = 0;
+static volatile uint32_t s_isr_start = 0;
+static volatile uint32_t s_isr_us = 0;
+
+void RunTimeStats_IsrEnter(void)
+{
+  if (s_isr_depth++ == 0U) {
+    s_isr_start = (uint32_t)getRunTimeCounterValue();
+  }
+}
+
+void RunTimeStats_IsrExit(void)
+{
+  if (--s_isr_depth == 0U) {
+    s_isr_us += (uint32_t)getRunTimeCounterValue() - s_isr_start;
+  }
+}
+
+static uint16_t rt_share(uint32_t part, uint32_t window)
+{
+  if (window == 0U) return 0;
+  uint32_t x100 = (uint32_t)(((uint64_t)part * 10000U) / window);
+  return (uint16_t)((x100 > 10000U) ? 10000U : x100);
+}
+
+static uint32_t rt_prev_counter(UBaseType_t number)
+{
+  for (uint32_t i = 0; i < RUNTIME_STATS_MAX_TASKS; i++) {
+    if (s_prev[i].number == number) return s_prev[i].counter;
+  }
+  return 0;  // New task, its whole counter belongs to this window
+}
+
+void RunTimeStats_Capture(uint8_t core, rt_stats_frame_t *out)
+{
+  uint32_t total = 0;
+  UBaseType_t n = uxTaskGetSystemState(s_status, RUNTIME_STATS_MAX_TASKS, &total);
+  uint32_t isr = s_isr_us;
+  uint32_t window = total - s_prev_total;
+
+  // Creation order keeps the frame columns stable
+  for (UBaseType_t i = 1; i < n; i++) {
+    TaskStatus_t s = s_status[i];
+    UBaseType_t j = i;
+    while (j > 0 && s_status[j - 1].xTaskNumber > s.xTaskNumber) {
+      s_status[j] = s_status[j - 1];
+      j--;
+    }
+    s_status[j] = s;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->tag = RT_STATS_TAG;
+  out->version = RT_STATS_VERSION;
+  out->core = core;
+  out->n_tasks = (uint8_t)n;
+  out->window_us = window;
+  out->isr_x100 = rt_share(isr - s_prev_isr, window);
+
+  TaskHandle_t idle = xTaskGetIdleTaskHandle();
+  for (UBaseType_t i = 0; i < n; i++) {
+    uint32_t delta = (uint32_t)s_status[i].ulRunTimeCounter - rt_prev_counter(s_status[i].xTaskNumber);
+    strncpy(out->tasks[i].name, s_status[i].pcTaskName, RUNTIME_STATS_NAME_LEN);
+    out->tasks[i].cpu_x100 = rt_share(delta, window);
+    if (s_status[i].xHandle == idle) {
+      out->idle_x100 = out->tasks[i].cpu_x100;
+    }
+  }
+
+  for (UBaseType_t i = 0; i < RUNTIME_STATS_MAX_TASKS; i++) {
+    s_prev[i].number = (i < n) ? s_status[i].xTaskNumber : 0U;
+    s_prev[i].counter = (i < n) ? (uint32_t)s_status[i].ulRunTimeCounter : 0U;
+  }
+  s_prev_total = total;
+  s_prev_isr = isr;
+}
+
+void RunTimeStats_Publish(volatile rt_stats_slot_t *slot, const rt_stats_frame_t *frame)
+{
+  uint32_t seq = slot->seq;
+
+  slot->seq = seq | 1U;
+  __sync_synchronize();
+  memcpy((void *)&slot->frame, frame, sizeof(*frame));
+  __sync_synchronize();
+  slot->seq = (seq | 1U) + 1U;
+}
+
+uint8_t RunTimeStats_Read(const volatile rt_stats_slot_t *slot, rt_stats_frame_t *out)
+{
+  uint32_t seq = slot->seq;
+  if (seq == 0 || (seq & 1U)) return 0;
+
+  __sync_synchronize();
+  memcpy(out, (const void *)&slot->frame, sizeof(*out));
+  __sync_synchronize();
+  if (slot->seq != seq) return 0;
+
+  if (out->tag != RT_STATS_TAG || out->n_tasks > RUNTIME_STATS_MAX_TASKS) return 0;
+  return 1;
+}
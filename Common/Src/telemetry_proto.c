@@ -0,0 +1,245 @@
+/* Binary telemetry: fixed-size records, batches and COBS/CRC-16 link framing (CM4 and ESP32). */
+
+#include "../Inc/telemetry_proto.h"  // Relative: the Arduino build has no Common/Inc include path
+#include <string.h>
+
+// PFA2.ino pulls this file into its C++ translation unit
+#ifdef __cplusplus
+#define TP_STATIC_ASSERT static_assert
+#else
+#define TP_STATIC_ASSERT _Static_assert
+#endif
+
+TP_STATIC_ASSERT(sizeof(tp_header_t) == 8U, "tp_header_t is part of the wire format");
+TP_STATIC_ASSERT(sizeof(tp_ppg_t) == 26U, "tp_ppg_t is part of the wire format");
+TP_STATIC_ASSERT(sizeof(tp_temp_t) == 16U, "tp_temp_t is part of the wire format");
+TP_STATIC_ASSERT(sizeof(tp_event_t) == 28U, "tp_event_t is part of the wire format");
+TP_STATIC_ASSERT(sizeof(tp_seal_hdr_t) == TP_SEAL_HDR_LEN, "tp_seal_hdr_t is part of the wire format");
+TP_STATIC_ASSERT(sizeof(tp_link_t) == 12U, "tp_link_t is part of the wire format");
+TP_STATIC_ASSERT(sizeof(tp_link_t) >= TP_SEAL_HDR_LEN, "a link message must pass the frame decoder");
+TP_STATIC_ASSERT(TP_BATCH_ITEM_MAX <= 0xFFU, "item length is one byte");
+
+// CRC-16/CCITT-FALSE, one nibble at a time: 32-byte table, ~4 cycles per bit pair
+static const uint16_t kCrc16Nibble[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t TlmProto_Crc16(uint16_t crc, const uint8_t *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    crc = (uint16_t)((crc << 4) ^ kCrc16Nibble[(crc >> 12) ^ (data[i] >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ kCrc16Nibble[(crc >> 12) ^ (data[i] & 0x0FU)]);
+  }
+  return crc;
+}
+
+size_t TlmProto_CobsEncode(const uint8_t *in, size_t len, uint8_t *out)
+{
+  size_t code_at = 0;
+  size_t o = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] != 0U) {
+      out[o++] = in[i];
+      code++;
+    }
+    if (in[i] == 0U || code == 0xFFU) {
+      out[code_at] = code;
+      code_at = o++;
+      code = 1;
+    }
+  }
+  out[code_at] = code;
+  return o;
+}
+
+size_t TlmProto_CobsDecode(const uint8_t *in, size_t len, uint8_t *out)
+{
+  size_t i = 0;
+  size_t o = 0;
+
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0U || i + code - 1U > len) return 0;
+    for (uint8_t k = 1; k < code; k++) {
+      if (in[i] == 0U) return 0;
+      out[o++] = in[i++];
+    }
+    // A full block (0xFF) carries no implied zero, nor does the last one
+    if (code != 0xFFU && i < len) out[o++] = 0U;
+  }
+  return o;
+}
+
+size_t TlmProto_FrameEncode(const uint8_t *body, size_t len, uint8_t *out, size_t cap)
+{
+  uint8_t raw[TP_BODY_MAX + TP_FRAME_CRC_LEN];
+
+  if (len > TP_BODY_MAX || cap < TP_FRAME_MAX(len)) return 0;
+
+  memcpy(raw, body, len);
+  uint16_t crc = TlmProto_Crc16(0xFFFFU, raw, len);
+  raw[len] = (uint8_t)crc;
+  raw[len + 1U] = (uint8_t)(crc >> 8);
+
+  size_t o = TlmProto_CobsEncode(raw, len + TP_FRAME_CRC_LEN, out);
+  out[o++] = TP_FRAME_DELIM;
+  return o;
+}
+
+void TlmProto_DecoderInit(tp_decoder_t *dec)
+{
+  memset(dec, 0, sizeof(*dec));
+}
+
+size_t TlmProto_DecoderFeed(tp_decoder_t *dec, uint8_t byte, const uint8_t **body)
+{
+  if (byte != TP_FRAME_DELIM) {
+    if (dec->len < sizeof(dec->buf)) {
+      dec->buf[dec->len++] = byte;
+    } else {
+      dec->overflow = 1;
+    }
+    return 0;
+  }
+
+  // Delimiter: whatever was gathered is one frame candidate
+  uint32_t len = dec->len;
+  uint8_t overflow = dec->overflow;
+  dec->len = 0;
+  dec->overflow = 0;
+  if (len == 0U) return 0;  // Back-to-back delimiters
+
+  size_t n = overflow ? 0U : TlmProto_CobsDecode(dec->buf, len, dec->buf);
+  if (n < TP_SEAL_HDR_LEN + TP_FRAME_CRC_LEN || n > TP_BODY_MAX + TP_FRAME_CRC_LEN) {
+    dec->bad_frames++;
+    return 0;
+  }
+  n -= TP_FRAME_CRC_LEN;
+  uint16_t crc = (uint16_t)(dec->buf[n] | (dec->buf[n + 1U] << 8));
+  if (TlmProto_Crc16(0xFFFFU, dec->buf, n) != crc) {
+    dec->crc_errors++;
+    return 0;
+  }
+
+  dec->frames++;
+  *body = dec->buf;
+  return n;
+}
+
+void TlmProto_Nonce(uint32_t session, uint32_t ctr, uint8_t nonce[TP_NONCE_LEN])
+{
+  nonce[0] = (uint8_t)(session >> 24);
+  nonce[1] = (uint8_t)(session >> 16);
+  nonce[2] = (uint8_t)(session >> 8);
+  nonce[3] = (uint8_t)session;
+  nonce[4] = 0;
+  nonce[5] = 0;
+  nonce[6] = 0;
+  nonce[7] = 0;
+  nonce[8] = (uint8_t)(ctr >> 24);
+  nonce[9] = (uint8_t)(ctr >> 16);
+  nonce[10] = (uint8_t)(ctr >> 8);
+  nonce[11] = (uint8_t)ctr;
+}
+
+void TlmProto_BatchInit(tp_batch_t *batch)
+{
+  batch->buf[0] = TP_BATCH_VERSION;
+  batch->buf[1] = 0;
+  batch->len = TP_BATCH_HDR_LEN;
+  batch->count = 0;
+}
+
+uint8_t TlmProto_BatchAdd(tp_batch_t *batch, const uint8_t *item, size_t len)
+{
+  if (len == 0U || len > TP_BATCH_ITEM_MAX) return 0;
+  if (batch->len + 1U + len > sizeof(batch->buf) || batch->count == 0xFFU) return 0;
+
+  batch->buf[batch->len++] = (uint8_t)len;
+  memcpy(&batch->buf[batch->len], item, len);
+  batch->len = (uint16_t)(batch->len + len);
+  batch->buf[1] = ++batch->count;
+  return 1;
+}
+
+size_t TlmProto_BatchNext(const uint8_t *batch, size_t len, size_t *pos, const uint8_t **item)
+{
+  if (*pos == 0U) {
+    if (len < TP_BATCH_HDR_LEN || batch[0] != TP_BATCH_VERSION) return 0;
+    *pos = TP_BATCH_HDR_LEN;
+  }
+  if (*pos >= len) return 0;
+
+  size_t n = batch[*pos];
+  if (n == 0U || *pos + 1U + n > len) return 0;
+  *item = &batch[*pos + 1U];
+  *pos += 1U + n;
+  return n;
+}
+
+size_t TlmProto_RecordLen(uint8_t type)
+{
+  switch (type) {
+    case TP_REC_PPG:   return sizeof(tp_ppg_t);
+    case TP_REC_TEMP:  return sizeof(tp_temp_t);
+    case TP_REC_EVENT: return sizeof(tp_event_t);
+    case TP_REC_CONFIG: return sizeof(tp_config_t);
+    default:           return 0;
+  }
+}
+
+size_t TlmProto_RecordInit(tp_record_t *rec, uint8_t type, uint8_t seq, uint32_t ts_ms)
+{
+  memset(rec, 0, sizeof(*rec));
+  rec->h.tag = TP_RECORD_TAG;
+  rec->h.version = TP_RECORD_VERSION;
+  rec->h.type = type;
+  rec->h.seq = seq;
+  rec->h.ts_ms = ts_ms;
+  return TlmProto_RecordLen(type);
+}
+
+const tp_record_t *TlmProto_RecordView(const uint8_t *payload, size_t len)
+{
+  if (len < sizeof(tp_header_t)) return NULL;
+  if (payload[0] != TP_RECORD_TAG || payload[1] != TP_RECORD_VERSION) return NULL;
+  size_t expect = TlmProto_RecordLen(payload[2]);
+  if (expect == 0U || len != expect) return NULL;
+  return (const tp_record_t *)payload;  // Packed members: no alignment requirement
+}
+
+uint8_t TlmProto_RecordParse(const uint8_t *payload, size_t len, tp_record_t *out)
+{
+  if (TlmProto_RecordView(payload, len) == NULL) return 0;
+
+  memset(out, 0, sizeof(*out));
+  memcpy(out, payload, len);
+  return 1;
+}
+
+const tp_link_t *TlmProto_LinkView(const uint8_t *data, size_t len)
+{
+  if (len != sizeof(tp_link_t) || data[0] != TP_LINK_TAG) return NULL;
+  if (data[1] < TP_LINK_HELLO || data[1] > TP_LINK_RAW) return NULL;
+  return (const tp_link_t *)data;
+}
+
+uint16_t TlmProto_ToU16(float v, float scale)
+{
+  float s = v * scale;
+  if (!(s > 0.0f)) return 0;  // Negative or NaN
+  if (s >= 65535.0f) return 0xFFFFU;
+  return (uint16_t)(s + 0.5f);
+}
+
+int16_t TlmProto_ToI16(float v, float scale)
+{
+  float s = v * scale;
+  if (!(s == s)) return 0;
+  if (s >= 32767.0f) return 32767;
+  if (s <= -32768.0f) return -32768;
+  return (int16_t)((s < 0.0f) ? (s - 0.5f) : (s + 0.5f));
+}
@@ -0,0 +1,256 @@
+/* Runtime acquisition settings and the CFG text commands that change them (CM4 and ESP32). */
+
+#include "../Inc/vest_config.h"  // Relative: the Arduino build has no Common/Inc include path
+#include <stdio.h>
+#include <string.h>
+
+// MAX30100 LED_CONFIG steps, datasheet table 8
+static const uint16_t s_led_tenths[16] = {
+  0, 44, 76, 110, 142, 174, 208, 240, 271, 306, 338, 370, 402, 436, 468, 500,
+};
+
+static const uint16_t s_rates[] = { 50, 100, 167, 200 };
+static const uint16_t s_widths[] = { 200, 400, 800, 1600 };
+static const char *const s_dsp_names[] = { "OFF", "HR", "SPO2" };
+
+void VestCfg_Defaults(vest_config_t *cfg)
+{
+  cfg->rate_hz = 100;
+  cfg->pw_us = 1600;
+  cfg->led_ir = 6;
+  cfg->led_red = 6;
+  cfg->dsp = VEST_DSP_SPO2;
+  cfg->ai = 1;
+  cfg->report_ms = 0;
+}
+
+void VestCfg_LineInit(vest_line_t *line)
+{
+  line->len = 0;
+  line->overflow = 0;
+}
+
+size_t VestCfg_LineFeed(vest_line_t *line, uint8_t byte)
+{
+  if (byte == '\r' || byte == '\n' || byte == 0x00U) {
+    size_t len = line->overflow ? 0U : line->len;
+    line->buf[line->len] = '\0';
+    line->len = 0;
+    line->overflow = 0;
+    return (byte == 0x00U) ? 0U : len;
+  }
+  if (line->len >= VEST_CMD_LINE_MAX) {
+    line->overflow = 1;
+    return 0;
+  }
+  line->buf[line->len++] = (char)byte;
+  return 0;
+}
+
+uint8_t VestCfg_RateCode(uint16_t rate_hz)
+{
+  for (uint8_t i = 0; i < sizeof(s_rates) / sizeof(s_rates[0]); i++) {
+    if (s_rates[i] == rate_hz) return i;
+  }
+  return 0xFFU;
+}
+
+uint8_t VestCfg_PulseWidthCode(uint16_t pw_us)
+{
+  for (uint8_t i = 0; i < sizeof(s_widths) / sizeof(s_widths[0]); i++) {
+    if (s_widths[i] == pw_us) return i;
+  }
+  return 0xFFU;
+}
+
+uint16_t VestCfg_LedTenthsMa(uint8_t code)
+{
+  return (code < 16U) ? s_led_tenths[code] : 0U;
+}
+
+// Decimal up to the next space or the end; 0 if empty, malformed or above max
+static uint8_t cfg_uint(const char **p, uint32_t max, uint32_t *out)
+{
+  const char *s = *p;
+  uint32_t v = 0;
+
+  if (*s < '0' || *s > '9') return 0;
+  while (*s >= '0' && *s <= '9') {
+    uint32_t d = (uint32_t)(*s++ - '0');
+    if (v > (max - d) / 10U) return 0;
+    v = v * 10U + d;
+  }
+  if (*s != ' ' && *s != '\0') return 0;
+  *p = s;
+  *out = v;
+  return 1;
+}
+
+// mA with at most one decimal, in 0.1 mA
+static uint8_t cfg_tenths(const char **p, uint32_t *out)
+{
+  const char *s = *p;
+  uint32_t v = 0;
+  uint8_t digits = 0;
+
+  while (*s >= '0' && *s <= '9' && digits < 4U) {
+    v = v * 10U + (uint32_t)(*s++ - '0');
+    digits++;
+  }
+  if (digits == 0U) return 0;
+  v *= 10U;
+  if (*s == '.') {
+    s++;
+    if (*s < '0' || *s > '9') return 0;
+    v += (uint32_t)(*s++ - '0');
+  }
+  if (*s != ' ' && *s != '\0') return 0;
+  *p = s;
+  *out = v;
+  return 1;
+}
+
+// Highest step at or below tenths
+static uint8_t cfg_led_code(uint32_t tenths)
+{
+  uint8_t code = 0;
+  while (code < 15U && s_led_tenths[code + 1U] <= tenths) code++;
+  return code;
+}
+
+// Matches "KEY=" at *p and steps over it
+static uint8_t cfg_key(const char **p, const char *key)
+{
+  size_t n = strlen(key);
+  if (strncmp(*p, key, n) != 0 || (*p)[n] != '=') return 0;
+  *p += n + 1U;
+  return 1;
+}
+
+static int cfg_led(const char **p, uint8_t *code)
+{
+  uint32_t v;
+
+  if (!cfg_tenths(p, &v)) return VEST_CFG_ERR_SYNTAX;
+  if (v > s_led_tenths[15]) return VEST_CFG_ERR_RANGE;
+  *code = cfg_led_code(v);
+  return VEST_CFG_OK;
+}
+
+static int cfg_value(const char **p, vest_cmd_t *cmd)
+{
+  int st = VEST_CFG_OK;
+  uint32_t v;
+
+  if (cfg_key(p, "RATE")) {
+    if (!cfg_uint(p, 0xFFFFU, &v)) return VEST_CFG_ERR_SYNTAX;
+    if (VestCfg_RateCode((uint16_t)v) == 0xFFU) return VEST_CFG_ERR_RANGE;
+    cmd->v.rate_hz = (uint16_t)v;
+    cmd->set |= VEST_CFG_F_RATE;
+  } else if (cfg_key(p, "PW")) {
+    if (!cfg_uint(p, 0xFFFFU, &v)) return VEST_CFG_ERR_SYNTAX;
+    if (VestCfg_PulseWidthCode((uint16_t)v) == 0xFFU) return VEST_CFG_ERR_RANGE;
+    cmd->v.pw_us = (uint16_t)v;
+    cmd->set |= VEST_CFG_F_PW;
+  } else if (cfg_key(p, "LED_IR")) {
+    st = cfg_led(p, &cmd->v.led_ir);
+    cmd->set |= VEST_CFG_F_LED_IR;
+  } else if (cfg_key(p, "LED_RED")) {
+    st = cfg_led(p, &cmd->v.led_red);
+    cmd->set |= VEST_CFG_F_LED_RED;
+  } else if (cfg_key(p, "REPORT")) {
+    if (!cfg_uint(p, 0xFFFFFFFFUL, &v)) return VEST_CFG_ERR_SYNTAX;
+    if (v != 0U && (v < VEST_CFG_REPORT_MIN_MS || v > VEST_CFG_REPORT_MAX_MS)) return VEST_CFG_ERR_RANGE;
+    cmd->v.report_ms = v;
+    cmd->set |= VEST_CFG_F_REPORT;
+  } else if (cfg_key(p, "DSP")) {
+    uint8_t m;
+    for (m = 0; m < sizeof(s_dsp_names) / sizeof(s_dsp_names[0]); m++) {
+      size_t n = strlen(s_dsp_names[m]);
+      if (strncmp(*p, s_dsp_names[m], n) == 0 && ((*p)[n] == ' ' || (*p)[n] == '\0')) {
+        *p += n;
+        break;
+      }
+    }
+    if (m == sizeof(s_dsp_names) / sizeof(s_dsp_names[0])) return VEST_CFG_ERR_SYNTAX;
+    cmd->v.dsp = m;
+    cmd->set |= VEST_CFG_F_DSP;
+  } else if (cfg_key(p, "AI")) {
+    if (!cfg_uint(p, 0xFFFFU, &v)) return VEST_CFG_ERR_SYNTAX;
+    if (v > 1U) return VEST_CFG_ERR_RANGE;
+    cmd->v.ai = (uint8_t)v;
+    cmd->set |= VEST_CFG_F_AI;
+  } else {
+    return VEST_CFG_ERR_SYNTAX;
+  }
+  return st;
+}
+
+int VestCfg_Parse(const char *line, vest_cmd_t *cmd)
+{
+  const size_t n = sizeof(VEST_CMD_PREFIX) - 1U;
+  const char *p = line;
+  uint32_t id;
+
+  memset(cmd, 0, sizeof(*cmd));
+  while (*p == ' ') p++;
+  if (strncmp(p, VEST_CMD_PREFIX, n) != 0 || (p[n] != ' ' && p[n] != '\0')) return -1;
+  p += n;
+
+  while (*p == ' ') p++;
+  if (!cfg_uint(&p, 0xFFFFU, &id) || id == 0U) return VEST_CFG_ERR_SYNTAX;
+  cmd->id = (uint16_t)id;
+
+  for (;;) {
+    while (*p == ' ') p++;
+    if (*p == '\0') return VEST_CFG_OK;
+    int st = cfg_value(&p, cmd);
+    if (st != VEST_CFG_OK) {
+      cmd->set = 0;
+      return st;
+    }
+  }
+}
+
+uint8_t VestCfg_Merge(const vest_config_t *cur, const vest_cmd_t *cmd, vest_config_t *out)
+{
+  vest_config_t next = *cur;
+
+  if (cmd->set & VEST_CFG_F_RATE) next.rate_hz = cmd->v.rate_hz;
+  if (cmd->set & VEST_CFG_F_PW) next.pw_us = cmd->v.pw_us;
+  if (cmd->set & VEST_CFG_F_LED_IR) next.led_ir = cmd->v.led_ir;
+  if (cmd->set & VEST_CFG_F_LED_RED) next.led_red = cmd->v.led_red;
+  if (cmd->set & VEST_CFG_F_REPORT) next.report_ms = cmd->v.report_ms;
+  if (cmd->set & VEST_CFG_F_DSP) next.dsp = cmd->v.dsp;
+  if (cmd->set & VEST_CFG_F_AI) next.ai = cmd->v.ai;
+
+  // Datasheet table 9: the 16-bit conversion does not fit a shorter period
+  if (next.pw_us == 1600U && next.rate_hz > 100U) return VEST_CFG_ERR_COMBO;
+  *out = next;
+  return VEST_CFG_OK;
+}
+
+size_t VestCfg_Format(const vest_config_t *cfg, char *buf, size_t size)
+{
+  uint16_t ir = VestCfg_LedTenthsMa(cfg->led_ir);
+  uint16_t red = VestCfg_LedTenthsMa(cfg->led_red);
+  int n = snprintf(buf, size, "RATE=%u PW=%u LED_IR=%u.%u LED_RED=%u.%u REPORT=%lu DSP=%s AI=%u",
+                   (unsigned)cfg->rate_hz, (unsigned)cfg->pw_us, ir / 10U, ir % 10U, red / 10U, red % 10U,
+                   (unsigned long)cfg->report_ms,
+                   (cfg->dsp <= VEST_DSP_SPO2) ? s_dsp_names[cfg->dsp] : "?", (unsigned)cfg->ai);
+  if (n < 0 || size == 0U) return 0;
+  return ((size_t)n < size) ? (size_t)n : size - 1U;
+}
+
+const char *VestCfg_StatusName(uint8_t status)
+{
+  switch (status) {
+    case VEST_CFG_OK:         return "OK";
+    case VEST_CFG_ERR_SYNTAX: return "SYNTAX";
+    case VEST_CFG_ERR_RANGE:  return "RANGE";
+    case VEST_CFG_ERR_COMBO:  return "COMBO";
+    case VEST_CFG_ERR_BUSY:   return "BUSY";
+    case VEST_CFG_ERR_SENSOR: return "SENSOR";
+    default:                  return "?";
+  }
+}
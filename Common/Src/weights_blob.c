@@ -0,0 +1,176 @@
+/**
+  ******************************************************************************
+  * @file    weights_blob.c
+  * @brief   Versioned, CRC-checked container for X-CUBE-AI weights.
+  ******************************************************************************
+  */
+#include "weights_blob.h"
+#include <string.h>
+
+_Static_assert(sizeof(wblob_header_t) == WBLOB_HEADER_SIZE, "wblob_header_t must be 48 bytes");
+
+static const uint8_t kMagic[4] = { 'A', 'I', 'W', 'B' };
+
+// Nibble table keeps the CRC small enough for the CM4 RX path
+static const uint32_t kCrcNibble[16] = {
+  0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+  0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+  0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+  0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu,
+};
+
+uint32_t WBlob_Crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+    crc = (crc >> 4) ^ kCrcNibble[crc & 0x0F];
+  }
+  return ~crc;
+}
+
+static uint32_t rd_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t rd_le16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Decodes and checks the fixed header; does not look at the payload
+static wblob_status_t WBlob_ParseHeader(const uint8_t *raw, wblob_header_t *hdr)
+{
+  hdr->magic = rd_le32(&raw[0]);
+  hdr->format_version = rd_le16(&raw[4]);
+  hdr->header_size = rd_le16(&raw[6]);
+  memcpy(hdr->model_name, &raw[8], WBLOB_NAME_LEN);
+  hdr->model_name[WBLOB_NAME_LEN - 1] = '\0';
+  hdr->model_version = rd_le32(&raw[24]);
+  hdr->payload_size = rd_le32(&raw[28]);
+  hdr->payload_crc32 = rd_le32(&raw[32]);
+  hdr->flags = rd_le32(&raw[36]);
+  hdr->reserved = rd_le32(&raw[40]);
+  hdr->header_crc32 = rd_le32(&raw[44]);
+
+  if (hdr->magic != WBLOB_MAGIC) return WBLOB_ERR_MAGIC;
+  if (hdr->format_version != WBLOB_FORMAT_VERSION || hdr->header_size != WBLOB_HEADER_SIZE) {
+    return WBLOB_ERR_VERSION;
+  }
+  if (WBlob_Crc32(0, raw, WBLOB_HEADER_SIZE - 4) != hdr->header_crc32) return WBLOB_ERR_HEADER_CRC;
+  return WBLOB_OK;
+}
+
+wblob_status_t WBlob_Validate(const uint8_t *blob, uint32_t len, wblob_header_t *header)
+{
+  wblob_header_t hdr;
+  if (len < WBLOB_HEADER_SIZE) return WBLOB_ERR_TRUNCATED;
+
+  wblob_status_t st = WBlob_ParseHeader(blob, &hdr);
+  if (st != WBLOB_OK) return st;
+  if (hdr.payload_size > len - WBLOB_HEADER_SIZE) return WBLOB_ERR_TRUNCATED;
+  if (WBlob_Crc32(0, blob + WBLOB_HEADER_SIZE, hdr.payload_size) != hdr.payload_crc32) {
+    return WBLOB_ERR_PAYLOAD_CRC;
+  }
+
+  if (header) *header = hdr;
+  return WBLOB_OK;
+}
+
+const uint8_t *WBlob_Payload(const uint8_t *blob)
+{
+  return blob + WBLOB_HEADER_SIZE;
+}
+
+void WBlob_LoaderInit(wblob_loader_t *ld, uint8_t *slot, uint32_t capacity)
+{
+  memset(ld, 0, sizeof(*ld));
+  ld->slot = slot;
+  ld->capacity = capacity;
+  ld->state = WBLOB_RX_HUNT;
+}
+
+void WBlob_LoaderReset(wblob_loader_t *ld)
+{
+  ld->received = 0;
+  ld->expected = 0;
+  ld->crc = 0;
+  ld->state = WBLOB_RX_HUNT;
+}
+
+static wblob_status_t WBlob_LoaderFail(wblob_loader_t *ld, wblob_status_t err)
+{
+  ld->last_error = err;
+  ld->errors++;
+  WBlob_LoaderReset(ld);
+  return err;
+}
+
+wblob_status_t WBlob_LoaderFeed(wblob_loader_t *ld, const uint8_t *data, uint32_t len)
+{
+  wblob_status_t result = WBLOB_IN_PROGRESS;
+  uint32_t i = 0;
+
+  if (ld->state == WBLOB_RX_DONE) return WBLOB_ERR_BUSY;
+
+  while (i < len) {
+    switch (ld->state) {
+      case WBLOB_RX_HUNT:
+        if (data[i] == kMagic[ld->received]) {
+          ld->slot[ld->received++] = data[i];
+          if (ld->received == sizeof(kMagic)) ld->state = WBLOB_RX_HEADER;
+        } else {
+          // "AIWB" has no repeated prefix, so restarting at this byte is enough
+          ld->received = (data[i] == kMagic[0]) ? 1 : 0;
+          if (ld->received) ld->slot[0] = data[i];
+        }
+        i++;
+        break;
+
+      case WBLOB_RX_HEADER: {
+        ld->slot[ld->received++] = data[i++];
+        if (ld->received < WBLOB_HEADER_SIZE) break;
+
+        wblob_header_t hdr;
+        wblob_status_t st = WBlob_ParseHeader(ld->slot, &hdr);
+        if (st == WBLOB_OK && hdr.payload_size > ld->capacity - WBLOB_HEADER_SIZE) {
+          st = WBLOB_ERR_TOO_LARGE;
+        }
+        if (st != WBLOB_OK) {
+          result = WBlob_LoaderFail(ld, st);
+          break;
+        }
+        ld->expected = WBLOB_HEADER_SIZE + hdr.payload_size;
+        ld->crc = 0;
+        ld->state = WBLOB_RX_PAYLOAD;
+        break;
+      }
+
+      case WBLOB_RX_PAYLOAD: {
+        uint32_t n = ld->expected - ld->received;
+        if (n > len - i) n = len - i;
+        memcpy(&ld->slot[ld->received], &data[i], n);
+        ld->crc = WBlob_Crc32(ld->crc, &data[i], n);
+        ld->received += n;
+        i += n;
+        break;
+      }
+
+      case WBLOB_RX_DONE:
+      default:
+        return WBLOB_OK;
+    }
+
+    if (ld->state == WBLOB_RX_PAYLOAD && ld->received == ld->expected) {
+      if (ld->crc != rd_le32(&ld->slot[32])) {
+        result = WBlob_LoaderFail(ld, WBLOB_ERR_PAYLOAD_CRC);
+      } else {
+        ld->state = WBLOB_RX_DONE;
+        return WBLOB_OK;
+      }
+    }
+  }
+  return result;
+}
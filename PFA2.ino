@@ -1,11 +1,60 @@
 #include <WiFi.h>
+#include <WiFiClientSecure.h>
 #include <HTTPClient.h>
+#include <LittleFS.h>
 #include <Wire.h>
+#include <time.h>
 #include "MAX30100_PulseOximeter.h"
-#include "mbedtls/aes.h"
+// Shared with the CM4. Arduino only compiles sources in the sketch root, so the codec is pulled in here
+#include "Common/Inc/telemetry_proto.h"
+#include "Common/Src/telemetry_proto.c"
+#include "Common/Inc/vest_config.h"
+#include "Common/Src/vest_config.c"
+// Bridge logic, also built on Linux against shims of these APIs (tools/host/test_bridge.cpp)
+#include "Bridge/Inc/telemetry_rx.h"
+#include "Bridge/Src/telemetry_rx.c"
+#include "Bridge/Inc/telemetry_agg.h"
+#include "Bridge/Src/telemetry_agg.c"
+#include "Bridge/Inc/mqtt_client.h"
+#include "Bridge/Src/mqtt_client.c"
+#include "Bridge/Inc/bridge_link.h"
+#include "Bridge/Src/bridge_link.cpp"
+#include "Bridge/Inc/bridge_events.h"
+#include "Bridge/Src/bridge_events.cpp"
+#include "Bridge/Inc/bridge_uplink.h"
+#include "Bridge/Src/bridge_uplink.cpp"
 
 #define SENSOR_UPDATE_PERIOD_MS   10     // appel pox.update() toutes les 10 ms
-#define REPORTING_PERIOD_MS     30000     // envoi UART + Firebase toutes les 30 s
+#define REPORTING_PERIOD_MS     30000     // envoi UART + Firebase toutes les 30 s (agrégats de l'intervalle)
+#define FS_HTTP_TIMEOUT_MS       5000     // Firestore request, connection kept between reports
+
+// Store-and-forward journal (LittleFS): every report is appended, then uploaded in bulk
+#define JOURNAL_DIR             "/reports"
+#define JOURNAL_CKPT_PATH       "/reports/ckpt"
+#define JOURNAL_LEGACY_DIR      "/journal"  // 24-byte records without aggregates, removed at boot
+#define JOURNAL_SEG_RECORDS        64     // 64 x 48 B per segment file, under one 4 KB flash block
+#define JOURNAL_SEGMENTS           64     // Ring: 4096 reports, 34 h at one per 30 s
+#define JOURNAL_UPLOAD_MAX         20     // Reports per bulk commit
+#define JOURNAL_RETRY_MS        30000     // Back-off after a failed upload
+
+// Tasks: sensor + UART on core 1, never blocked by the network on core 0
+#define IO_TASK_CORE                1
+#define IO_TASK_PRIO                3     // Above loopTask and the Arduino core's own tasks on core 1
+#define IO_TASK_STACK            4096
+#define NET_TASK_CORE               0     // Same core as the WiFi/lwIP stack
+#define NET_TASK_PRIO               1
+#define NET_TASK_STACK          12288     // TLS handshake
+#define NET_QUEUE_LEN              16     // Reports and alerts in flight to the network task
+#define NET_POLL_MS               500     // WiFi state check while the queue is idle
+#define UART_RX_BUFFER           4096     // ~20 ms at 2 Mbaud; beyond, RTS holds the STM32 (deeper delays the NACKs)
+#define LOG_TX_BUFFER            2048     // Console: the I/O task's log lines do not wait for the UART
+#define MQTT_TOPIC_ROOT         "pfa"     // MQTT_TOPIC_ROOT/<docId>/<ppg|temp|event|report|burst|status>
+#define MQTT_KEEPALIVE_S           30
+#define MQTT_RETRY_MS            5000     // Between connection attempts to the broker
+#define MQTT_POLL_MS               20     // Network task wake-up while PUBLISHes await their PUBACK
+
+// Liaison STM32 : 115200 au démarrage, puis le débit rapide si le STM32 l'accepte (tp_link_t)
+#define LINK_BAUD_FAST        2000000     // HSI 64 MHz / 32 on the STM32, APB 80 MHz / 40 here: exact on both
 
 // Configuration Wi-Fi
 const char* ssid     = "Airbox-0D54";
@@ -18,229 +67,602 @@ const char* collection = "users";
 const char* docId      = "aLNCySCiPmgxUdvK1KJ7Y9C9hv13";
 
 // Optional ingestion endpoint (Cloud Function) that accepts POST { hr, spo2, temp, timestamp }
-// If empty, the sketch falls back to calling Firestore REST per-field (not recommended).
+// If empty, the sketch falls back to one Firestore REST commit per report (fields + history entry).
 const char* ingestionUrl = "";
 
+// Optional MQTT uplink: mqtt://host:1883 (tools/mqtt_broker.py on the LAN) or mqtts://host:8883.
+// When set, records stream live at QoS 1 and reports, alert events and bursts are published
+// instead of the Firestore commits; tools/mqtt_gateway.py writes them into Firestore.
+const char* mqttUrl      = "";
+const char* mqttUser     = "";   // Empty: no authentication
+const char* mqttPassword = "";
+
 // UART1 (ESP32) → RX1 du STM32 en GPIO16, TX1 vers STM32 en GPIO17
 static const int RX1_PIN = 16;
 static const int TX1_PIN = 17;
+// Contrôle de flux : GPIO18 (CTS) ← RTS du STM32 (PD12), GPIO19 (RTS) → CTS du STM32 (PD11)
+static const int CTS1_PIN = 18;
+static const int RTS1_PIN = 19;
 
 PulseOximeter pox;
-uint32_t  tsLastSensorUpdate = 0;
-uint32_t  tsLastReport       = 0;
 
-float     lastTemp     = -1.0f;   // température reçue du STM32
 String    tempBuffer   = "";
 bool      hasTempLine  = false;
 
-// --- AES-CTR framed UART reception from STM32 ---
-// Frame: [0xAA 0x55][IV(16)][LEN(2, BE)][CIPHERTEXT(len)] ; plaintext is ASCII line(s)
+// --- AES-GCM sealed UART reception from STM32 (Bridge/Inc/bridge_link.h) ---
 static const uint8_t AES_KEY_128[16] = { 0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
 
-enum UartRxState { WAIT_HDR1, WAIT_HDR2, READ_IV, READ_LEN, READ_PAYLOAD };
-static UartRxState rxState = WAIT_HDR1;
-static uint8_t rxIv[16];
-static uint8_t rxLenBE[2];
-static uint16_t rxLen = 0;
-static uint8_t rxPayload[256];
-static uint16_t rxCount = 0;
+static BridgeLink   stmLink;          // I/O task only
+static BridgeEvents stmEvents;        // I/O task only: aggregates, bursts, alerts
+static uint32_t     uartRateBytes = 0;   // stmLink.bytes and millis() at the last LINK line
+static uint32_t     uartRateMs    = 0;
+
+// --- Firestore REST or ingestion endpoint (Bridge/Inc/bridge_uplink.h), network task only ---
+static BridgeUplink uplink;
+
+static bool     journalReady    = false;
+static uint32_t journalFirst    = 0;   // Oldest seq still on flash, segment aligned
+static uint32_t journalTail     = 0;   // Next seq to upload (checkpoint)
+static uint32_t journalHead     = 0;   // Next seq to append
+static uint32_t journalLost     = 0;   // Dropped by the ring before upload, or corrupt
+static uint32_t journalUploaded = 0;
+static uint32_t journalRetryAt  = 0;
+static bool     wifiUp          = false;
+static uint32_t burstsSent      = 0;
+static uint32_t burstsLost      = 0;   // No WiFi or commit failed: bursts are not journaled
+
+// --- MQTT uplink (mqttUrl), see mqttService() ---
+static WiFiClient       mqttTcp;
+static WiFiClientSecure mqttTls;
+static Client*          mqttNet         = NULL;   // mqttTcp or mqttTls, NULL without mqttUrl
+static char             mqttHost[64];
+static uint16_t         mqttPort        = 0;
+static char             mqttClientId[24];           // pfa-<efuse MAC>, stable across boots
+static mqtt_t           mqtt;
+static uint32_t         mqttRetryAt     = 0;
+static bool             mqttWasUp       = false;
+static uint32_t         mqttLiveDropped = 0;        // Live records not published: offline or window full
+
+static QueueHandle_t netQueue       = NULL;
+static TaskHandle_t  ioTaskHandle   = NULL;
+static TaskHandle_t  netTaskHandle  = NULL;
+static uint32_t      netPosted      = 0;
+static uint32_t      netDropped[NET_TYPES] = {};   // Queue full, per NetMsgType
+static UBaseType_t   netQueueMax    = 0;             // Highest depth seen
+
+static bool netPost(const NetMsg& msg) {
+  if (xQueueSend(netQueue, &msg, 0) != pdTRUE) {
+    netDropped[msg.type]++;
+    return false;
+  }
+  netPosted++;
+  UBaseType_t depth = uxQueueMessagesWaiting(netQueue);
+  if (depth > netQueueMax) netQueueMax = depth;
+  return true;
+}
 
-static String plainLineBuffer = "";
-static uint16_t hrFromSTM = 0;
-static uint16_t spo2FromSTM = 0;
-static bool haveHrSpo2FromSTM = false;
+static bool postFromIo(void* user, const NetMsg& msg)
+{
+  (void)user;
+  return netPost(msg);
+}
 
-static void aesCtrDecrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* ct, uint8_t* pt, size_t len)
+// After the STM32's TXQ line, every 30 s: the link, uplink and task counters
+static void printStats(void* user)
 {
-  mbedtls_aes_context ctx;
-  mbedtls_aes_init(&ctx);
-  mbedtls_aes_setkey_enc(&ctx, key, 128);
-  unsigned char nonce_counter[16];
-  unsigned char stream_block[16];
-  size_t nc_off = 0;
-  memcpy(nonce_counter, iv, 16);
-  memset(stream_block, 0, sizeof(stream_block));
-  mbedtls_aes_crypt_ctr(&ctx, len, &nc_off, nonce_counter, stream_block, ct, pt);
-  mbedtls_aes_free(&ctx);
+  (void)user;
+  const tlm_rx_stats_t& st = stmLink.rx.stats;
+  uint32_t now = millis();
+  uint32_t rate = (now != uartRateMs) ? (uint32_t)((uint64_t)(stmLink.bytes - uartRateBytes) * 1000U / (now - uartRateMs)) : 0;
+  uartRateBytes = stmLink.bytes;
+  uartRateMs = now;
+  Serial.printf("LINK sess=%08lx frames=%lu crc_err=%lu bad=%lu auth_fail=%lu replay=%lu lost=%lu recovered=%lu nack=%lu batches=%lu items=%lu rec_lost=%lu bad_rec=%lu\n",
+                (unsigned long)st.session, (unsigned long)stmLink.rx.dec.frames, (unsigned long)stmLink.rx.dec.crc_errors,
+                (unsigned long)stmLink.rx.dec.bad_frames, (unsigned long)st.auth_failures, (unsigned long)st.replays,
+                (unsigned long)st.lost_frames, (unsigned long)st.recovered, (unsigned long)st.nacks,
+                (unsigned long)st.batches, (unsigned long)st.items,
+                (unsigned long)st.lost_records, (unsigned long)st.bad_records);
+  Serial.printf("UART baud=%lu rx=%luB/s switches=%lu fallbacks=%lu raw=%lu\n", (unsigned long)stmLink.baud,
+                (unsigned long)rate, (unsigned long)stmLink.switches, (unsigned long)stmLink.fallbacks,
+                (unsigned long)stmLink.rawBytes);
+  Serial.printf("FS commits=%lu fail=%lu tls=%lu last=%lums journal=%lu/%lu uploaded=%lu lost=%lu\n",
+                (unsigned long)uplink.commits, (unsigned long)uplink.failures, (unsigned long)uplink.handshakes,
+                (unsigned long)uplink.lastMs, (unsigned long)(journalHead - journalTail),
+                (unsigned long)(JOURNAL_SEGMENTS * JOURNAL_SEG_RECORDS), (unsigned long)journalUploaded,
+                (unsigned long)journalLost);
+  Serial.printf("EDGE bursts=%lu lost=%lu interval hr_n=%lu spo2_n=%lu temp_n=%lu\n",
+                (unsigned long)burstsSent, (unsigned long)burstsLost, (unsigned long)stmEvents.aggHr.n,
+                (unsigned long)stmEvents.aggSpo2.n, (unsigned long)stmEvents.aggTemp.n);
+  if (mqttNet != NULL) {
+    Serial.printf("MQTT state=%u connects=%lu timeouts=%lu pub=%lu acked=%lu resent=%lu inflight=%u ack=%lu/%lums live_drop=%lu\n",
+                  (unsigned)mqtt.state, (unsigned long)mqtt.stats.connects, (unsigned long)mqtt.stats.timeouts,
+                  (unsigned long)mqtt.stats.published, (unsigned long)mqtt.stats.acked,
+                  (unsigned long)mqtt.stats.resent, (unsigned)mqtt.inflight, (unsigned long)mqtt.stats.ack_ms_last,
+                  (unsigned long)mqtt.stats.ack_ms_max, (unsigned long)mqttLiveDropped);
+  }
+  Serial.printf("TASKS q=%u/%u max=%u posted=%lu drop=%lu/%lu/%lu/%lu/%lu stack io=%u net=%u\n",
+                (unsigned)uxQueueMessagesWaiting(netQueue), (unsigned)NET_QUEUE_LEN, (unsigned)netQueueMax,
+                (unsigned long)netPosted, (unsigned long)netDropped[NET_REPORT],
+                (unsigned long)netDropped[NET_ALERT], (unsigned long)netDropped[NET_SUMMARY],
+                (unsigned long)netDropped[NET_BURST], (unsigned long)netDropped[NET_RECORD],
+                (unsigned)uxTaskGetStackHighWaterMark(ioTaskHandle),
+                (unsigned)uxTaskGetStackHighWaterMark(netTaskHandle));
 }
 
-static void processPlaintextLine(const String& line)
+void onBeatDetected()
 {
-  if (line.startsWith("LM35 Temp:")) {
-    float t = 0.0f;
-    if (sscanf(line.c_str(), "LM35 Temp: %f", &t) == 1) {
-      lastTemp = t;
-      Serial.printf("▶ STM32 Temp: %.1f °C\n", lastTemp);
-    }
+  // Exemple de callback : on ne fait rien de spécial ici
+  // Juste pour démontrer que la librairie peut nous avertir
+  Serial.println("💓 Battement détecté !");
+}
+
+/* MQTT uplink ---------------------------------------------------------------
+ * One persistent connection (TCP, or TLS for mqtts://) owned by the network
+ * task, Bridge/Src/mqtt_client.c on top. Everything goes at QoS 1: live
+ * records are dropped when not connected or when MQTT_INFLIGHT PUBLISHes
+ * already await their PUBACK (the 30 s report still carries them); events,
+ * reports and bursts wait for room in the window, and reports leave the
+ * journal only once acknowledged. Payloads are the binary records as the
+ * STM32 sent them (telemetry_proto.h), JournalRecord, and for bursts
+ * [boot u32][alert u16][chunk u16][n u16] then the samples. The broker keeps
+ * "online" retained on .../status, replaced by the "offline" will.
+ */
+static void mqttTopic(char* out, size_t cap, const char* leaf) {
+  snprintf(out, cap, MQTT_TOPIC_ROOT "/%s/%s", docId, leaf);
+}
+
+static uint8_t mqttWrite(void* user, const uint8_t* data, size_t len) {
+  (void)user;
+  return mqttNet->write(data, len) == len;
+}
+
+static void mqttSetup() {
+  bool tls = strncmp(mqttUrl, "mqtts://", 8) == 0;
+  if (!tls && strncmp(mqttUrl, "mqtt://", 7) != 0) {
+    if (mqttUrl[0] != '\0') Serial.println("⚠️ mqttUrl ignorée : mqtt:// ou mqtts:// attendu");
     return;
   }
-  if (line.startsWith("MAX30100 Die Temp:")) {
-    float t = 0.0f;
-    if (sscanf(line.c_str(), "MAX30100 Die Temp: %f", &t) == 1) {
-      Serial.printf("ℹ️ STM32 Sensor Die Temp: %.2f °C\n", t);
+  const char* host = mqttUrl + (tls ? 8 : 7);
+  const char* colon = strchr(host, ':');
+  size_t n = colon ? (size_t)(colon - host) : strlen(host);
+  if (n == 0 || n >= sizeof(mqttHost)) return;
+  memcpy(mqttHost, host, n);
+  mqttHost[n] = '\0';
+  mqttPort = colon ? (uint16_t)atoi(colon + 1) : (tls ? 8883 : 1883);
+  if (tls) mqttTls.setInsecure();   // As for Firestore, the server certificate is not pinned
+  mqttNet = tls ? (Client*)&mqttTls : (Client*)&mqttTcp;
+  snprintf(mqttClientId, sizeof(mqttClientId), "pfa-%012llx", (unsigned long long)ESP.getEfuseMac());
+  const mqtt_ops_t ops = { mqttWrite, NULL };
+  Mqtt_Init(&mqtt, &ops);
+  Serial.printf("MQTT : %s:%u (%s), client %s\n", mqttHost, (unsigned)mqttPort, tls ? "TLS" : "TCP", mqttClientId);
+}
+
+// Connection upkeep, PUBACKs and keep-alive. Returns true while connected.
+static bool mqttService() {
+  if (mqttNet == NULL) return false;
+  uint32_t now = millis();
+  if (mqtt.state != MQTT_DISCONNECTED && (!wifiUp || !mqttNet->connected())) Mqtt_Disconnect(&mqtt, 0);
+
+  if (mqtt.state == MQTT_DISCONNECTED) {
+    if (mqttWasUp) {
+      mqttWasUp = false;
+      Serial.println("⚠️ MQTT déconnecté");
     }
+    if (!wifiUp || (int32_t)(now - mqttRetryAt) < 0) return false;
+    mqttRetryAt = now + MQTT_RETRY_MS;
+    mqttNet->stop();
+    if (!mqttNet->connect(mqttHost, mqttPort)) {
+      Serial.printf("❌ MQTT : %s:%u injoignable\n", mqttHost, (unsigned)mqttPort);
+      return false;
+    }
+    char will[64];
+    mqttTopic(will, sizeof(will), "status");
+    const mqtt_connect_t opt = { mqttClientId, mqttUser[0] ? mqttUser : NULL, mqttUser[0] ? mqttPassword : NULL,
+                                 will, (const uint8_t*)"offline", 7, 1, 1, MQTT_KEEPALIVE_S };
+    Mqtt_Connect(&mqtt, &opt, millis());
+  }
+
+  uint8_t buf[64];
+  while (mqttNet->available() > 0) {
+    int n = mqttNet->read(buf, sizeof(buf));
+    if (n <= 0) break;
+    Mqtt_Feed(&mqtt, buf, (size_t)n, millis());
+  }
+  if (Mqtt_Poll(&mqtt, millis()) == MQTT_DISCONNECTED) {
+    if (mqtt.return_code != 0) Serial.printf("❌ MQTT : connexion refusée (code %u)\n", mqtt.return_code);
+    mqtt.return_code = 0;
+    return false;
+  }
+  if (mqtt.state == MQTT_CONNECTED && !mqttWasUp) {
+    mqttWasUp = true;
+    char topic[64];
+    mqttTopic(topic, sizeof(topic), "status");
+    Mqtt_Publish(&mqtt, topic, (const uint8_t*)"online", 6, 1, 1, millis());
+    Serial.printf("✅ MQTT connecté (%u en attente renvoyés)\n", (unsigned)mqtt.inflight);
+  }
+  return mqtt.state == MQTT_CONNECTED;
+}
+
+// QoS 1. With wait, gives the window up to FS_HTTP_TIMEOUT_MS to make room.
+static bool mqttPublish(const char* leaf, const void* payload, size_t len, bool wait) {
+  char topic[64];
+  mqttTopic(topic, sizeof(topic), leaf);
+  uint32_t t0 = millis();
+  while (!Mqtt_Publish(&mqtt, topic, (const uint8_t*)payload, len, 1, 0, millis())) {
+    if (!wait || mqtt.inflight < MQTT_INFLIGHT || millis() - t0 >= FS_HTTP_TIMEOUT_MS) return false;
+    vTaskDelay(pdMS_TO_TICKS(MQTT_POLL_MS));
+    mqttService();
+  }
+  return true;
+}
+
+// Until every PUBLISH in the window is acknowledged, at most FS_HTTP_TIMEOUT_MS
+static bool mqttFlush() {
+  uint32_t t0 = millis();
+  while (mqtt.inflight > 0) {
+    if (millis() - t0 >= FS_HTTP_TIMEOUT_MS) return false;
+    vTaskDelay(pdMS_TO_TICKS(MQTT_POLL_MS));
+    mqttService();
+  }
+  return true;
+}
+
+static bool mqttPublishRecord(const tp_record_t& r) {
+  size_t len = TlmProto_RecordLen(r.h.type);
+  switch (r.h.type) {
+    case TP_REC_PPG:   return mqtt.state == MQTT_CONNECTED && mqttPublish("ppg", &r, len, false);
+    case TP_REC_TEMP:  return mqtt.state == MQTT_CONNECTED && mqttPublish("temp", &r, len, false);
+    case TP_REC_EVENT: return mqttPublish("event", &r, len, true);
+    case TP_REC_CONFIG: return mqttPublish("config", &r, len, true);
+    default:           return false;
+  }
+}
+
+// Reports leave the journal once the broker acknowledged every one of them
+static bool publishReports(const JournalRecord* recs, size_t n) {
+  if (mqtt.state != MQTT_CONNECTED) return false;
+  for (size_t i = 0; i < n; i++) {
+    if (!mqttPublish("report", &recs[i], sizeof(JournalRecord), true)) return false;
+  }
+  return mqttFlush();
+}
+
+static bool publishBurst(const NetBurst& b) {
+  uint8_t buf[10 + TLM_BURST_MAX];
+  memcpy(&buf[0], &uplink.boot, 4);
+  memcpy(&buf[4], &b.alertId, 2);
+  memcpy(&buf[6], &b.chunk, 2);
+  memcpy(&buf[8], &b.count, 2);
+  memcpy(&buf[10], b.data, b.len);
+  return mqtt.state == MQTT_CONNECTED && mqttPublish("burst", buf, 10U + b.len, true);
+}
+
+// Uploads a run of reports: published over MQTT if set, else over HTTPS (postReports())
+static bool uploadReports(const JournalRecord* recs, size_t n, bool newest) {
+  if (mqttNet != NULL) return publishReports(recs, n);
+  return postReports(uplink, recs, n, newest);
+}
+
+/* Journal ------------------------------------------------------------------
+ * Segment files JOURNAL_DIR/<segment number, hex> of JOURNAL_SEG_RECORDS
+ * records; record seq lives in segment seq / JOURNAL_SEG_RECORDS. Appends
+ * are LittleFS-atomic (a power cut loses at most the report being written).
+ * Flash wear is bounded: one small append per report, one checkpoint write
+ * per successful upload (not per record), and whole segments are deleted,
+ * never rewritten. At most JOURNAL_SEGMENTS segments are kept; beyond that
+ * the oldest goes, uploaded or not, and its reports count as lost.
+ */
+static String journalSegPath(uint32_t segment) {
+  char path[32];
+  snprintf(path, sizeof(path), JOURNAL_DIR "/%08lx", (unsigned long)segment);
+  return String(path);
+}
+
+static uint16_t journalCrc(const JournalRecord& r) {
+  return TlmProto_Crc16(0xFFFFU, (const uint8_t*)&r, offsetof(JournalRecord, crc));
+}
+
+static void journalSaveCheckpoint() {
+  uint32_t ckpt[2] = { journalTail, ~journalTail };
+  File f = LittleFS.open(JOURNAL_CKPT_PATH, FILE_WRITE);
+  if (f) {
+    f.write((const uint8_t*)ckpt, sizeof(ckpt));
+    f.close();
+  }
+}
+
+// Deletes segments from journalFirst up to (not including) the one holding seq
+static void journalTrimBefore(uint32_t seq) {
+  while (journalFirst + JOURNAL_SEG_RECORDS <= seq) {
+    LittleFS.remove(journalSegPath(journalFirst / JOURNAL_SEG_RECORDS));
+    journalFirst += JOURNAL_SEG_RECORDS;
+  }
+}
+
+static void journalInit() {
+  if (!LittleFS.begin(true)) {   // Formats an unreadable partition
+    Serial.println("❌ LittleFS indisponible : pas de journal, les rapports hors ligne seront perdus");
     return;
   }
-  if (line.startsWith("HR:")) {
-    float hr = 0.0f, spo2 = 0.0f;
-    if (sscanf(line.c_str(), "HR:%f", &hr) == 1) {
-      const char* p = strstr(line.c_str(), "SpO2:");
-      if (p) {
-        sscanf(p, "SpO2:%f", &spo2);
-      }
-      hrFromSTM = (uint16_t)roundf(hr);
-      spo2FromSTM = (uint16_t)roundf(spo2);
-      haveHrSpo2FromSTM = true;
-      Serial.printf("▶ STM32 HR/SPO2: %u / %u\n", hrFromSTM, spo2FromSTM);
+  if (LittleFS.exists(JOURNAL_LEGACY_DIR)) {
+    // Former format (one instantaneous value per report): not readable as JournalRecord
+    File old = LittleFS.open(JOURNAL_LEGACY_DIR);
+    for (File f = old.openNextFile(); f; f = old.openNextFile()) {
+      String path = String(JOURNAL_LEGACY_DIR "/") + f.name();
+      f.close();
+      LittleFS.remove(path);
     }
-    return;
+    old.close();
+    LittleFS.rmdir(JOURNAL_LEGACY_DIR);
+    Serial.println("ℹ️ Ancien journal supprimé");
+  }
+  LittleFS.mkdir(JOURNAL_DIR);
+
+  bool any = false;
+  uint32_t minSeg = 0, maxSeg = 0;
+  size_t maxSize = 0;
+  File dir = LittleFS.open(JOURNAL_DIR);
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    char* end = NULL;
+    uint32_t seg = strtoul(f.name(), &end, 16);
+    if (end == NULL || *end != '\0' || strlen(f.name()) != 8) continue;   // ckpt
+    if (!any || seg < minSeg) minSeg = seg;
+    if (!any || seg >= maxSeg) {
+      maxSeg = seg;
+      maxSize = f.size();
+    }
+    any = true;
+  }
+
+  uint32_t ckpt[2] = { 0, 0 };
+  File f = LittleFS.open(JOURNAL_CKPT_PATH, FILE_READ);
+  bool haveCkpt = f && f.read((uint8_t*)ckpt, sizeof(ckpt)) == sizeof(ckpt) && ckpt[1] == ~ckpt[0];
+  if (f) f.close();
+
+  if (any) {
+    journalFirst = minSeg * JOURNAL_SEG_RECORDS;
+    journalHead = maxSeg * JOURNAL_SEG_RECORDS + maxSize / sizeof(JournalRecord);
+  } else {
+    // Empty journal: continue the sequence from the next segment after the checkpoint
+    uint32_t from = haveCkpt ? ckpt[0] + JOURNAL_SEG_RECORDS - 1 : 0;
+    journalFirst = journalHead = from - from % JOURNAL_SEG_RECORDS;
   }
-  // Unknown line: just log
-  Serial.printf("STM32: %s\n", line.c_str());
+  journalTail = haveCkpt ? ckpt[0] : journalFirst;
+  if (journalTail < journalFirst) journalTail = journalFirst;
+  if (journalTail > journalHead) journalTail = journalHead;
+  journalReady = true;
+  Serial.printf("✅ Journal: %lu report(s) to upload\n", (unsigned long)(journalHead - journalTail));
 }
 
-static void pumpUartFrames()
-{
-  while (Serial1.available() > 0) {
-    int byteIn = Serial1.read();
-    if (byteIn < 0) return;
-    uint8_t b = (uint8_t)byteIn;
-    switch (rxState) {
-      case WAIT_HDR1:
-        if (b == 0xAA) rxState = WAIT_HDR2;
-        break;
-      case WAIT_HDR2:
-        if (b == 0x55) {
-          rxState = READ_IV;
-          rxCount = 0;
-        } else {
-          rxState = WAIT_HDR1;
-        }
-        break;
-      case READ_IV:
-        rxIv[rxCount++] = b;
-        if (rxCount >= 16) {
-          rxState = READ_LEN;
-          rxCount = 0;
-        }
-        break;
-      case READ_LEN:
-        rxLenBE[rxCount++] = b;
-        if (rxCount >= 2) {
-          rxLen = ((uint16_t)rxLenBE[0] << 8) | rxLenBE[1];
-          if (rxLen == 0 || rxLen > sizeof(rxPayload)) {
-            // invalid length, reset
-            rxState = WAIT_HDR1;
-          } else {
-            rxState = READ_PAYLOAD;
-            rxCount = 0;
-          }
-        }
-        break;
-      case READ_PAYLOAD:
-        rxPayload[rxCount++] = b;
-        if (rxCount >= rxLen) {
-          // decrypt
-          uint8_t pt[256];
-          aesCtrDecrypt(AES_KEY_128, rxIv, rxPayload, pt, rxLen);
-          // append to line buffer and split on \n
-          for (uint16_t i = 0; i < rxLen; i++) {
-            char c = (char)pt[i];
-            if (c == '\r') continue;
-            if (c == '\n') {
-              String line = plainLineBuffer;
-              line.trim();
-              if (line.length() > 0) processPlaintextLine(line);
-              plainLineBuffer = "";
-            } else {
-              if (plainLineBuffer.length() < 256) plainLineBuffer += c;
-            }
-          }
-          // ready for next frame
-          rxState = WAIT_HDR1;
-        }
-        break;
+static bool journalAppend(JournalRecord& r) {
+  r.seq = journalHead;
+  r.crc = journalCrc(r);
+  File f = LittleFS.open(journalSegPath(journalHead / JOURNAL_SEG_RECORDS), FILE_APPEND);
+  if (!f) return false;
+  size_t written = f.write((const uint8_t*)&r, sizeof(r));
+  f.close();
+  if (written != sizeof(r)) return false;
+  journalHead++;
+
+  // Ring full: the oldest segment goes, uploaded or not
+  uint32_t keepFrom = (journalHead - 1) / JOURNAL_SEG_RECORDS;
+  keepFrom = (keepFrom >= JOURNAL_SEGMENTS - 1) ? (keepFrom - (JOURNAL_SEGMENTS - 1)) * JOURNAL_SEG_RECORDS : 0;
+  if (journalTail < keepFrom) {
+    journalLost += keepFrom - journalTail;
+    journalTail = keepFrom;
+  }
+  journalTrimBefore(keepFrom);
+  return true;
+}
+
+// Reads up to max valid records from journalTail, within one segment
+static size_t journalRead(JournalRecord* recs, size_t max, uint32_t* next) {
+  uint32_t seq = journalTail;
+  uint32_t segEnd = (seq / JOURNAL_SEG_RECORDS + 1) * JOURNAL_SEG_RECORDS;
+  uint32_t end = (journalHead < segEnd) ? journalHead : segEnd;
+  size_t n = 0;
+
+  File f = LittleFS.open(journalSegPath(seq / JOURNAL_SEG_RECORDS), FILE_READ);
+  if (!f || !f.seek((seq % JOURNAL_SEG_RECORDS) * sizeof(JournalRecord))) {
+    // Segment gone or short: skip what it should have held
+    if (f) f.close();
+    journalLost += end - seq;
+    *next = end;
+    return 0;
+  }
+  for (; seq < end && n < max; seq++) {
+    JournalRecord r;
+    if (f.read((uint8_t*)&r, sizeof(r)) != sizeof(r)) {
+      journalLost += end - seq;
+      seq = end;
+      break;
+    }
+    if (r.seq != seq || r.crc != journalCrc(r)) {
+      journalLost++;
+      continue;
     }
+    recs[n++] = r;
   }
+  f.close();
+  *next = seq;
+  return n;
 }
 
-void onBeatDetected()
-{
-  // Exemple de callback : on ne fait rien de spécial ici
-  // Juste pour démontrer que la librairie peut nous avertir
-  Serial.println("💓 Battement détecté !");
+// One bulk upload of the backlog per call while connected
+static void journalDrain(uint32_t now) {
+  if (!journalReady || journalTail == journalHead || !wifiUp) return;
+  if ((int32_t)(now - journalRetryAt) < 0) return;
+
+  JournalRecord recs[JOURNAL_UPLOAD_MAX];
+  uint32_t next = journalTail;
+  size_t n = journalRead(recs, JOURNAL_UPLOAD_MAX, &next);
+  if (n > 0 && !uploadReports(recs, n, next == journalHead)) {
+    journalRetryAt = now + JOURNAL_RETRY_MS;
+    return;
+  }
+  journalUploaded += n;
+  journalTail = next;
+  journalSaveCheckpoint();
+  journalTrimBefore(journalTail);
 }
 
-bool updateFieldInFirestore(const char* field, double value) {
-  HTTPClient http;
-  String url = String("https://firestore.googleapis.com/v1/projects/")
-             + projectId
-             + "/databases/(default)/documents/"
-             + collection + "/" + docId
-             + "?updateMask.fieldPaths=" + field
-             + "&key=" + apiKey;
-
-  String body = String("{\"fields\":{\"")
-              + field
-              + "\":{\"doubleValue\":"
-              + String(value, 2)
-              + "}}}";
-
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  int code = http.PATCH(body);
-
-  if (code == HTTP_CODE_OK || code == HTTP_CODE_ACCEPTED) {
-    Serial.printf("✔️ Updated %s → %.2f\n", field, value);
-    http.end();
-    return true;
+// Keeps setup() and loop() free of WiFi waits: the station reconnects on its own
+static void wifiPoll() {
+  bool up = (WiFi.status() == WL_CONNECTED);
+  if (up == wifiUp) return;
+  wifiUp = up;
+  if (up) {
+    Serial.printf("✅ Connected to WiFi! (%lu report(s) en attente)\n", (unsigned long)(journalHead - journalTail));
+    configTime(0, 0, "pool.ntp.org", "time.google.com");
+    journalRetryAt = millis();
   } else {
-    Serial.printf("❌ HTTP %d: %s\n", code, http.errorToString(code).c_str());
-    http.end();
-    return false;
+    Serial.println("⚠️ WiFi déconnecté : les rapports sont journalisés");
+    uplink.client.stop();
   }
 }
 
-bool sendTelemetryJSON(uint16_t hr, uint16_t spo2, float temp) {
-  if (strlen(ingestionUrl) == 0) return false;
-
-  HTTPClient http;
-  http.begin(ingestionUrl);
-  http.addHeader("Content-Type", "application/json");
-
-  unsigned long ts = (unsigned long) (millis() / 1000UL);
-  String body = String("{")
-    + "\"hr\":" + String(hr) + ","
-    + "\"spo2\":" + String(spo2) + ","
-    + "\"temp\":" + String(temp,1) + ","
-    + "\"timestamp\":" + String(ts)
-    + "}";
-
-  int code = http.POST(body);
-  if (code == HTTP_CODE_OK || code == HTTP_CODE_ACCEPTED) {
-    Serial.println("✔️ Telemetry sent to ingestion endpoint");
-    http.end();
-    return true;
-  } else {
-    Serial.printf("❌ Ingestion HTTP %d: %s\n", code, http.errorToString(code).c_str());
-    http.end();
-    return false;
+// Commandes "CFG ..." tapées sur la console USB, transmises telles quelles au STM32
+// qui répond par un enregistrement TP_REC_CONFIG (Common/Inc/vest_config.h)
+static void consolePoll() {
+  static vest_line_t line;
+  static bool ready = false;
+  if (!ready) {
+    VestCfg_LineInit(&line);
+    ready = true;
+  }
+  while (Serial.available() > 0) {
+    if (VestCfg_LineFeed(&line, (uint8_t)Serial.read()) == 0) continue;
+    vest_cmd_t cmd;
+    if (VestCfg_Parse(line.buf, &cmd) < 0) {
+      Serial.printf("⚠️ Commande inconnue : %s\n", line.buf);
+      continue;
+    }
+    linkCommand(stmLink, line.buf);
+    Serial.printf("ESP32 → STM32 : %s\n", line.buf);
+  }
+}
+
+// Core 1: pox.update() every 10 ms, the UART pump and the 30 s report.
+// Nothing here waits on the network: reports and alerts are posted to netQueue.
+static void ioTask(void* arg) {
+  (void)arg;
+  TickType_t wake = xTaskGetTickCount();
+  uint32_t tsLastReport = millis();
+
+  for (;;) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SENSOR_UPDATE_PERIOD_MS));
+    uint32_t now = millis();
+
+    // === 1) Mise à jour du capteur (appeler obligatoirement souvent, sinon HR/SPO2 restera à 0) ===
+    pox.update();
+
+    // === 2) Trames AES-GCM du STM32 (UART1), puis négociation / maintien du débit ===
+    linkPoll(stmLink, now, linkPump(stmLink) != 0);
+    consolePoll();
+
+    // === 3) Rapport toutes les 30 s ===
+    if (now - tsLastReport >= REPORTING_PERIOD_MS) {
+      tsLastReport = now;
+
+      // Agrégats des mesures reçues du STM32 sur l'intervalle, sinon la mesure locale
+      if (stmEvents.aggHr.n == 0) TlmAgg_Add(&stmEvents.aggHr, (int32_t)pox.getHeartRate() * 10);
+      if (stmEvents.aggSpo2.n == 0) TlmAgg_Add(&stmEvents.aggSpo2, (int32_t)pox.getSpO2() * 10);
+      NetMsg msg = {};
+      msg.type = NET_REPORT;
+      eventsReport(stmEvents, msg.report);
+      uint16_t hr   = (uint16_t)((msg.report.hr.mean + 5) / 10);
+      uint16_t spo2 = (uint16_t)((msg.report.spo2.mean + 5) / 10);
+
+      // → 3a) On envoie HR/SPO2 au STM32 (UART1)
+      char buf[32];
+      snprintf(buf, sizeof(buf), "HR=%03u,SPO2=%03u\n", hr, spo2);
+      Serial1.write(buf);
+      Serial.print("ESP32 → STM32 : ");
+      Serial.print(buf);
+
+      // → 3b) Journalisé puis envoyé au backend par la tâche réseau
+      time_t t = time(nullptr);
+      msg.report.boot     = uplink.boot;
+      msg.report.uptimeMs = now;
+      msg.report.epoch    = (t >= 1600000000) ? (uint32_t)t : 0;
+      if (!netPost(msg)) Serial.println("⚠️ Rapport perdu : file réseau pleine");
+    }
+  }
+}
+
+// Core 0: WiFi state, journal and Firestore. May block for seconds.
+static void netTask(void* arg) {
+  (void)arg;
+  for (;;) {
+    // Straight on while there is a backlog to upload, otherwise wait for the I/O task
+    bool backlog = journalReady && journalTail != journalHead && wifiUp &&
+                   (int32_t)(millis() - journalRetryAt) >= 0;
+    NetMsg msg;
+    TickType_t idle = pdMS_TO_TICKS((mqtt.inflight > 0) ? MQTT_POLL_MS : NET_POLL_MS);
+    bool got = xQueueReceive(netQueue, &msg, backlog ? 0 : idle) == pdTRUE;
+
+    wifiPoll();
+    mqttService();
+    if (got) {
+      switch (msg.type) {
+        case NET_REPORT:
+          if (!journalReady || !journalAppend(msg.report)) {
+            // No journal: send it now or lose it
+            msg.report.seq = journalHead;
+            if (!wifiUp || !uploadReports(&msg.report, 1, true)) {
+              Serial.println("⚠️ Rapport perdu : ni journal ni WiFi");
+            }
+          }
+          break;
+        case NET_ALERT:     // Over MQTT, the event record itself (NET_RECORD) carries it
+          if (wifiUp && mqttNet == NULL) {
+            FsField fields[] = { { "anomalyAlert", msg.alert.active ? 1.0 : 0.0 }, { "anomalyScore", msg.alert.score } };
+            commitToFirestore(uplink, fields, 2);
+          }
+          break;
+        case NET_SUMMARY:
+          if (wifiUp && mqttNet == NULL) {
+            FsField fields[] = { { "anomalyMean", msg.summary.mean }, { "anomalyMax", msg.summary.max } };
+            commitToFirestore(uplink, fields, 2);
+          }
+          break;
+        case NET_BURST:
+          if (wifiUp && (mqttNet != NULL ? publishBurst(msg.burst) : commitBurst(uplink, msg.burst))) {
+            burstsSent++;
+          } else {
+            burstsLost++;
+          }
+          break;
+        case NET_RECORD:
+          if (!mqttPublishRecord(msg.record)) mqttLiveDropped++;
+          break;
+        default:
+          break;
+      }
+    }
+
+    // Rattrapage du journal, un envoi groupé par tour
+    journalDrain(millis());
   }
 }
 
 void setup() {
+  Serial.setTxBufferSize(LOG_TX_BUFFER);
   Serial.begin(115200);
   delay(100);
   Serial.println("ESP32 : Démarrage...");
 
-  // 1) Connexion Wi-Fi
+  // 1) Connexion Wi-Fi, sans attendre : les rapports vont au journal tant qu'elle n'est pas là
+  journalInit();
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(true);
   WiFi.begin(ssid, password);
-  Serial.print("Connecting to WiFi");
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(300);
-    Serial.print(".");
-  }
-  Serial.println("\n✅ Connected to WiFi!");
+  Serial.println("Connecting to WiFi (en arrière-plan)");
+
+  // Firestore session, kept alive between commits; the boot id prefixes the history documents
+  const UplinkConfig cloud = { FIRESTORE_URL, projectId, apiKey, collection, docId, ingestionUrl };
+  uplinkBegin(uplink, cloud, esp_random(), FS_HTTP_TIMEOUT_MS);
+  mqttSetup();
 
   // 2) Initialisation I2C
   Wire.begin(21, 22);
@@ -258,60 +680,22 @@ void setup() {
   pox.setOnBeatDetectedCallback(onBeatDetected);
 
   // 4) Initialisation UART1 (pour parler au STM32)
-  Serial1.begin(115200, SERIAL_8N1, RX1_PIN, TX1_PIN);
-  Serial.println("✅ UART1 initialisé (GPIO16=RX, GPIO17=TX).");
-
-  // Initialisons les timestamps
-  tsLastSensorUpdate = millis();
-  tsLastReport       = millis();
+  Serial1.setRxBufferSize(UART_RX_BUFFER);
+  Serial1.begin(TP_LINK_BAUD_BASE, SERIAL_8N1, RX1_PIN, TX1_PIN);
+  Serial1.setPins(RX1_PIN, TX1_PIN, CTS1_PIN, RTS1_PIN);   // Flow control stays off until negotiated
+  const BridgeEventsOps evOps = { postFromIo, printStats, NULL };
+  eventsBegin(stmEvents, evOps, mqttNet != NULL);   // Live records only for the MQTT uplink
+  const tlm_rx_ops_t appOps = { NULL, eventsRecord, eventsBinary, eventsLine, NULL, &stmEvents };
+  linkBegin(stmLink, Serial1, AES_KEY_128, LINK_BAUD_FAST, appOps);
+  Serial.println("✅ UART1 initialisé (GPIO16=RX, GPIO17=TX, GPIO18=CTS, GPIO19=RTS).");
+
+  // 5) Tâches : capteur + UART sur le cœur 1, réseau sur le cœur 0
+  netQueue = xQueueCreate(NET_QUEUE_LEN, sizeof(NetMsg));
+  xTaskCreatePinnedToCore(netTask, "net", NET_TASK_STACK, NULL, NET_TASK_PRIO, &netTaskHandle, NET_TASK_CORE);
+  xTaskCreatePinnedToCore(ioTask, "io", IO_TASK_STACK, NULL, IO_TASK_PRIO, &ioTaskHandle, IO_TASK_CORE);
 }
 
 void loop() {
-  uint32_t now = millis();
-
-  // === 1) Mise à jour du capteur (fréquence élevée) ===
-  if (now - tsLastSensorUpdate >= SENSOR_UPDATE_PERIOD_MS) {
-    tsLastSensorUpdate = now;
-    pox.update();   // Appeler obligatoirement souvent (sinon HR/SPO2 restera à 0)
-  }
-
-  // === 2) Lecture de la ligne Temp reçue du STM32 (UART1) ===
-  // Désormais, on traite des trames AES-CTR au lieu de texte brut
-  pumpUartFrames();
-
-  // === 3) Envoi toutes les 30 s (reporting) ===
-  if (now - tsLastReport >= REPORTING_PERIOD_MS) {
-    tsLastReport = now;
-
-    // Préférence aux mesures reçues du STM32 si disponibles
-    uint16_t hr   = haveHrSpo2FromSTM ? hrFromSTM : pox.getHeartRate();
-    uint16_t spo2 = haveHrSpo2FromSTM ? spo2FromSTM : pox.getSpO2();
-
-    // → 3a) On envoie HR/SPO2 au STM32 (UART1)
-    char buf[32];
-    snprintf(buf, sizeof(buf), "HR=%03u,SPO2=%03u\n", hr, spo2);
-    Serial1.write(buf);
-    Serial.print("ESP32 → STM32 : ");
-    Serial.print(buf);
-
-    // → 3b) On envoie la télémétrie au backend. Prefer ingestionUrl if configured.
-    if (WiFi.status() == WL_CONNECTED) {
-      bool ok = false;
-      if (strlen(ingestionUrl) > 0) {
-        ok = sendTelemetryJSON(hr, spo2, (lastTemp >= 0.0f) ? lastTemp : 0.0f);
-      }
-      if (!ok) {
-        // fallback: update individual fields via Firestore REST (requires API key)
-        updateFieldInFirestore("hr",   hr);
-        updateFieldInFirestore("spo2", spo2);
-        if (lastTemp >= 0.0f) {
-          updateFieldInFirestore("temp", lastTemp);
-        }
-      }
-    } else {
-      Serial.println("⚠️ WiFi déconnecté : impossible de mettre à jour Firebase");
-    }
-  }
-
-  // Ne jamais bloquer trop longtemps : sortir rapidement pour laisser "pox.update()" s'exécuter
+  // Everything runs in ioTask and netTask
+  vTaskDelete(NULL);
 }
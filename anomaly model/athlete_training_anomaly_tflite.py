@@ -10,6 +10,7 @@ from sklearn.preprocessing import StandardScaler, LabelEncoder
 from sklearn.metrics import classification_report, confusion_matrix, accuracy_score, roc_auc_score
 import joblib
 import os
+from export_folded_model import FEATURE_COLUMNS, export_all
 
 print("TensorFlow version:", tf.__version__)
 
@@ -45,9 +46,8 @@ class AthleteAnomalyDetectorTFLite:
         # Encode categorical variable
         X['Activity_encoded'] = self.activity_encoder.fit_transform(X['Activity'])
         
-        # Select numerical features
-        feature_columns = ['HeartRate', 'OxygenLevel', 'FatigueScore', 'tmp', 'Activity_encoded']
-        X_processed = X[feature_columns].values
+        # Select numerical features (order is the on-device contract, see export_folded_model.py)
+        X_processed = X[FEATURE_COLUMNS].values
         
         # Scale features
         X_scaled = self.scaler.fit_transform(X_processed)
@@ -382,6 +382,11 @@ def main():
     
     # Save preprocessing objects
     detector.save_preprocessing_objects()
+    detector.model.save("athlete_model.keras")
+
+    # Export the device model with the scaler folded into the first Dense layer
+    raw_samples = data.assign(Activity_encoded=detector.activity_encoder.transform(data['Activity']))[FEATURE_COLUMNS].values[:256]
+    export_all(detector.model, detector.scaler, detector.activity_encoder, raw_samples)
     
     # Test with sample data
     sample_data = {
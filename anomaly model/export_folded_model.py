@@ -0,0 +1,236 @@
+"""Export the anomaly model with feature scaling folded into the first Dense layer.
+
+The StandardScaler used during training computes z = (x - mean) / scale.
+For the first Dense layer y = z @ W + b this is equivalent to
+
+    y = x @ (W / scale[:, None]) + (b - (mean / scale) @ W)
+
+so the exported network takes raw sensor values directly and devices pay
+zero cycles for normalization. The feature order is frozen in generated
+headers shared by the STM32 firmware and the Flutter app.
+"""
+import argparse
+import os
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT = os.path.dirname(HERE)
+
+# Column order used by AthleteAnomalyDetectorTFLite.prepare_features()
+FEATURE_COLUMNS = ['HeartRate', 'OxygenLevel', 'FatigueScore', 'tmp', 'Activity_encoded']
+
+# C / Dart identifiers for each training column
+FEATURE_IDENTIFIERS = {
+    'HeartRate': ('HEART_RATE', 'heartRate', 'bpm'),
+    'OxygenLevel': ('SPO2', 'oxygenLevel', '%'),
+    'FatigueScore': ('FATIGUE', 'fatigueScore', '1..10'),
+    'tmp': ('TEMPERATURE', 'temperature', 'degC'),
+    'Activity_encoded': ('ACTIVITY', 'activity', 'LabelEncoder code'),
+}
+
+C_HEADER_PATH = os.path.join(REPO_ROOT, 'Common', 'Inc', 'athlet_features.h')
+DART_PATH = os.path.join(REPO_ROOT, 'app', 'lib', 'services', 'athlete_feature_contract.dart')
+
+
+def fold_scaler_into_dense(kernel, bias, mean, scale):
+    """Fold (x - mean) / scale into a Dense kernel of shape (n_in, n_out)"""
+    import numpy as np
+
+    kernel = np.asarray(kernel, dtype=np.float64)
+    bias = np.asarray(bias, dtype=np.float64)
+    mean = np.asarray(mean, dtype=np.float64)
+    scale = np.asarray(scale, dtype=np.float64)
+
+    if kernel.shape[0] != mean.shape[0]:
+        raise ValueError(f"Kernel expects {kernel.shape[0]} inputs, scaler has {mean.shape[0]}")
+
+    folded_kernel = kernel / scale[:, None]
+    folded_bias = bias - (mean / scale) @ kernel
+    return folded_kernel.astype(np.float32), folded_bias.astype(np.float32)
+
+
+def build_folded_model(model, scaler):
+    """Clone a trained Keras model and fold the scaler into its first Dense layer"""
+    from tensorflow import keras
+
+    folded = keras.models.clone_model(model)
+    folded.build(model.input_shape)
+    folded.set_weights(model.get_weights())
+
+    first_dense = next(layer for layer in folded.layers if isinstance(layer, keras.layers.Dense))
+    kernel, bias = first_dense.get_weights()
+    first_dense.set_weights(list(fold_scaler_into_dense(kernel, bias, scaler.mean_, scaler.scale_)))
+    return folded
+
+
+def check_equivalence(model, folded, scaler, raw_samples, tolerance=1e-4):
+    """Verify folded(raw) matches model(scaler(raw)) on a sample batch"""
+    import numpy as np
+
+    raw = np.asarray(raw_samples, dtype=np.float32)
+    expected = model.predict(scaler.transform(raw).astype(np.float32), verbose=0)
+    actual = folded.predict(raw, verbose=0)
+    max_err = float(np.max(np.abs(expected - actual)))
+    print(f"Folded model max abs error vs scaled reference: {max_err:.2e}")
+    if max_err > tolerance:
+        raise RuntimeError(f"Folding changed model output by {max_err:.2e} (> {tolerance:.0e})")
+    return max_err
+
+
+def convert_to_tflite(model, path):
+    """Convert without post-training quantization so folded weights stay exact"""
+    import tensorflow as tf
+
+    converter = tf.lite.TFLiteConverter.from_keras_model(model)
+    tflite_model = converter.convert()
+    with open(path, 'wb') as f:
+        f.write(tflite_model)
+    print(f"Folded TFLite model saved to {path}")
+    return path
+
+
+def render_c_header(mean, scale, activity_classes, folded=False):
+    """Render the shared feature-order contract for the STM32 firmware"""
+    if folded:
+        scaling = ['  * The StandardScaler is folded into the first dense layer of the exported',
+                   '  * model, so the network input is the raw feature vector in this order.']
+    else:
+        scaling = ['  * The network input is the feature vector in this order. The compiled',
+                   '  * network still expects standardised input, so ai_registry.c applies the',
+                   '  * training scaler; once CM7/X-CUBE-AI/App is regenerated from',
+                   '  * athlete_model_folded.tflite, export with --folded and the scaler goes.']
+    lines = [
+        '/**',
+        '  ******************************************************************************',
+        '  * @file    athlet_features.h',
+        '  * @brief   Input feature contract of the anomaly network.',
+        '  *          GENERATED by "anomaly model/export_folded_model.py" - do not edit.',
+        '  ******************************************************************************',
+    ] + scaling + [
+        '  ******************************************************************************',
+        '  */',
+        '#ifndef ATHLET_FEATURES_H',
+        '#define ATHLET_FEATURES_H',
+        '',
+        '/* Feature index in the network input vector */',
+    ]
+    for i, column in enumerate(FEATURE_COLUMNS):
+        c_name, _, unit = FEATURE_IDENTIFIERS[column]
+        lines.append(f'#define ATHLET_FEAT_{c_name:<12} ({i}U)  /* {column} [{unit}] */')
+    lines += [
+        f"#define {'ATHLET_FEATURE_COUNT':<24} ({len(FEATURE_COLUMNS)}U)",
+        '',
+        '/* Scaling already applied inside the network (1 = feed raw values) */',
+        f'#define ATHLET_FEATURES_SCALING_FOLDED  ({int(folded)})',
+        '',
+        '/* Activity LabelEncoder codes */',
+    ]
+    for code, name in enumerate(activity_classes):
+        lines.append(f'#define ATHLET_ACTIVITY_{name.upper():<14} ({code}U)')
+    lines += [
+        f'#define ATHLET_ACTIVITY_COUNT          ({len(activity_classes)}U)',
+        '',
+        '/* Training scaler, applied on device while SCALING_FOLDED is 0 */',
+        '#define ATHLET_SCALER_MEAN_INIT  { ' + ', '.join(f'{v:.9g}f' for v in mean) + ' }',
+        '#define ATHLET_SCALER_SCALE_INIT { ' + ', '.join(f'{v:.9g}f' for v in scale) + ' }',
+        '',
+        '#endif /* ATHLET_FEATURES_H */',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def render_dart_contract(mean, scale, activity_classes, folded=False):
+    """Render the same contract for the Flutter app"""
+    lines = [
+        '// GENERATED by "anomaly model/export_folded_model.py" - do not edit.',
+        '// Input feature contract of the anomaly network.',
+        'class AthleteFeatureContract {',
+        '  // Scaling already applied inside the network (true = feed raw values)' + ('' if folded else '.'),
+    ] + ([] if folded else ['  // The published athlete-anomaly-detector model is not folded yet.']) + [
+        f"  static const bool scalingFolded = {'true' if folded else 'false'};",
+        '',
+        '  // Feature index in the network input vector',
+    ]
+    for i, column in enumerate(FEATURE_COLUMNS):
+        _, dart_name, _ = FEATURE_IDENTIFIERS[column]
+        lines.append(f'  static const int {dart_name}Index = {i};')
+    lines += [
+        f'  static const int featureCount = {len(FEATURE_COLUMNS)};',
+        '',
+        '  // Activity LabelEncoder codes',
+        '  static const Map<String, int> activityCodes = {',
+    ]
+    for code, name in enumerate(activity_classes):
+        lines.append(f"    '{name}': {code},")
+    lines += [
+        '  };',
+        '',
+        '  // Training scaler, only used when scalingFolded is false',
+        '  static const List<double> scalerMean = [',
+    ]
+    lines += [f'    {repr(float(v))},' for v in mean]
+    lines += ['  ];', '', '  static const List<double> scalerScale = [']
+    lines += [f'    {repr(float(v))},' for v in scale]
+    lines += ['  ];', '}', '']
+    return '\n'.join(lines)
+
+
+def write_contracts(mean, scale, activity_classes, folded=False, c_path=C_HEADER_PATH, dart_path=DART_PATH):
+    """Write the C header and the Dart contract from the fitted preprocessing.
+
+    folded declares that the devices run the folded model: only set it once
+    CM7/X-CUBE-AI/App is regenerated and the model is published to Firebase ML,
+    or the firmware and the app feed raw values to a network expecting z-scores.
+    """
+    mean = [float(v) for v in mean]
+    scale = [float(v) for v in scale]
+    activity_classes = [str(c) for c in activity_classes]
+
+    os.makedirs(os.path.dirname(c_path), exist_ok=True)
+    with open(c_path, 'w', newline='\n') as f:
+        f.write(render_c_header(mean, scale, activity_classes, folded))
+    with open(dart_path, 'w', newline='\n') as f:
+        f.write(render_dart_contract(mean, scale, activity_classes, folded))
+    print(f"Feature contract written to {c_path} and {dart_path}")
+
+
+def export_all(model, scaler, activity_encoder, raw_samples, tflite_path="athlete_model_folded.tflite", folded=False):
+    """Fold, verify, convert and regenerate the shared contracts (see write_contracts for folded)"""
+    folded_model = build_folded_model(model, scaler)
+    check_equivalence(model, folded_model, scaler, raw_samples)
+    convert_to_tflite(folded_model, tflite_path)
+    write_contracts(scaler.mean_, scaler.scale_, activity_encoder.classes_, folded)
+    return tflite_path
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--model', default='athlete_model.keras')
+    parser.add_argument('--scaler', default='scaler.pkl')
+    parser.add_argument('--encoder', default='activity_encoder.pkl')
+    parser.add_argument('--data', default='AthleteTraining_anomaly.csv')
+    parser.add_argument('--output', default='athlete_model_folded.tflite')
+    parser.add_argument('--folded', action='store_true',
+                        help='contracts declare raw input: the folded model is flashed and published')
+    args = parser.parse_args()
+
+    import joblib
+    import pandas as pd
+    from tensorflow import keras
+
+    model = keras.models.load_model(args.model)
+    scaler = joblib.load(args.scaler)
+    activity_encoder = joblib.load(args.encoder)
+
+    data = pd.read_csv(args.data)
+    data['Activity_encoded'] = activity_encoder.transform(data['Activity'])
+    raw_samples = data[FEATURE_COLUMNS].values[:256]
+
+    export_all(model, scaler, activity_encoder, raw_samples, args.output, args.folded)
+    if not args.folded:
+        print("Regenerate CM7/X-CUBE-AI/App from the folded model with ST Edge AI Core, publish it to")
+        print("Firebase ML, then run again with --folded.")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,29 +1,10 @@
 // Dart preprocessing code for Athlete Anomaly Detection
+import 'athlete_feature_contract.dart';
+
 class AthleteAnomalyPreprocessor {
-  // Scaler parameters (from training)
-  static const List<double> scalerMean = [
-    130.10256991987998,
-    95.09956383382,
-    4.976967278282001,
-    37.82234,
-    1.522,
-  ];
-
-  static const List<double> scalerScale = [
-    14.704072545919214,
-    2.94924470225052,
-    1.9172122073361932,
-    0.3356687718570199,
-    1.1178175164131219,
-  ];
-
-  // Activity encoding mapping
-  static const Map<String, int> activityMapping = {
-    'Cycling': 0,
-    'Running': 1,
-    'Treadmill': 2,
-    'Weightlifting': 3,
-  };
+  // Feature order, activity codes and scaler come from the generated contract
+  static const Map<String, int> activityMapping =
+      AthleteFeatureContract.activityCodes;
 
   static List<double> preprocessInput({
     required double heartRate,
@@ -35,18 +16,21 @@ class AthleteAnomalyPreprocessor {
     // Encode activity
     int activityCode = activityMapping[activity] ?? 0;
 
-    // Create feature array
-    List<double> features = [
-      heartRate,
-      oxygenLevel,
-      fatigueScore,
-      temperature,
-      activityCode.toDouble(),
-    ];
-
-    // Apply scaling: (x - mean) / scale
-    for (int i = 0; i < features.length; i++) {
-      features[i] = (features[i] - scalerMean[i]) / scalerScale[i];
+    // Create feature array in the network input order
+    List<double> features =
+        List.filled(AthleteFeatureContract.featureCount, 0.0);
+    features[AthleteFeatureContract.heartRateIndex] = heartRate;
+    features[AthleteFeatureContract.oxygenLevelIndex] = oxygenLevel;
+    features[AthleteFeatureContract.fatigueScoreIndex] = fatigueScore;
+    features[AthleteFeatureContract.temperatureIndex] = temperature;
+    features[AthleteFeatureContract.activityIndex] = activityCode.toDouble();
+
+    // Until the folded model is published, the app standardises the input
+    if (!AthleteFeatureContract.scalingFolded) {
+      for (int i = 0; i < features.length; i++) {
+        features[i] = (features[i] - AthleteFeatureContract.scalerMean[i]) /
+            AthleteFeatureContract.scalerScale[i];
+      }
     }
 
     return features;
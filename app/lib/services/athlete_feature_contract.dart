@@ -0,0 +1,41 @@
+// Written from the app's scaler constants until
+// "anomaly model/export_folded_model.py" regenerates it from scaler.pkl.
+// Input feature contract of the anomaly network.
+class AthleteFeatureContract {
+  // Scaling already applied inside the network (true = feed raw values).
+  // The published athlete-anomaly-detector model is not folded yet.
+  static const bool scalingFolded = false;
+
+  // Feature index in the network input vector
+  static const int heartRateIndex = 0;
+  static const int oxygenLevelIndex = 1;
+  static const int fatigueScoreIndex = 2;
+  static const int temperatureIndex = 3;
+  static const int activityIndex = 4;
+  static const int featureCount = 5;
+
+  // Activity LabelEncoder codes
+  static const Map<String, int> activityCodes = {
+    'Cycling': 0,
+    'Running': 1,
+    'Treadmill': 2,
+    'Weightlifting': 3,
+  };
+
+  // Training scaler, only used when scalingFolded is false
+  static const List<double> scalerMean = [
+    130.10256991987998,
+    95.09956383382,
+    4.976967278282001,
+    37.82234,
+    1.522,
+  ];
+
+  static const List<double> scalerScale = [
+    14.704072545919214,
+    2.94924470225052,
+    1.9172122073361932,
+    0.3356687718570199,
+    1.1178175164131219,
+  ];
+}
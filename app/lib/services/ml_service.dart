@@ -7,6 +7,7 @@ import 'package:cloud_firestore/cloud_firestore.dart';
 import 'package:firebase_ml_model_downloader/firebase_ml_model_downloader.dart';
 import 'package:tflite_flutter/tflite_flutter.dart';
 import 'package:shared_preferences/shared_preferences.dart';
+import 'anomaly_preprocessor.dart';
 
 class MLService {
   // Singleton pattern
@@ -38,29 +39,6 @@ class MLService {
   static const double TEMP_RANGE = 5.0;
   static const double MAX_AGE = 100.0;
 
-  // Anomaly model preprocessing constants
-  static const List<double> SCALER_MEAN = [
-    130.10256991987998,
-    95.09956383382,
-    4.976967278282001,
-    37.82234,
-    1.522,
-  ];
-  static const List<double> SCALER_SCALE = [
-    14.704072545919214,
-    2.94924470225052,
-    1.9172122073361932,
-    0.3356687718570199,
-    1.1178175164131219,
-  ];
-
-  static const Map<String, int> ACTIVITY_MAPPING = {
-    'Cycling': 0,
-    'Running': 1,
-    'Treadmill': 2,
-    'Weightlifting': 3,
-  };
-
   Future<Map<String, dynamic>?> getHeartStatusModel() async {
     if (_isModelLoaded && _interpreter != null) {
       return {
@@ -349,24 +327,13 @@ class MLService {
     required double temperature,
     required String activity,
   }) {
-    // Encode activity
-    int activityCode = ACTIVITY_MAPPING[activity] ?? 0;
-
-    // Create feature array
-    List<double> features = [
-      heartRate,
-      oxygenLevel,
-      fatigueScore,
-      temperature,
-      activityCode.toDouble(),
-    ];
-
-    // Apply scaling: (x - mean) / scale
-    for (int i = 0; i < features.length; i++) {
-      features[i] = (features[i] - SCALER_MEAN[i]) / SCALER_SCALE[i];
-    }
-
-    return features;
+    return AthleteAnomalyPreprocessor.preprocessInput(
+      heartRate: heartRate,
+      oxygenLevel: oxygenLevel,
+      fatigueScore: fatigueScore,
+      temperature: temperature,
+      activity: activity,
+    );
   }
 
   Future<Map<String, dynamic>> predictAnomaly({
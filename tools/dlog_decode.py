@@ -0,0 +1,137 @@
+"""Turn CM4 deferred log frames back into text.
+
+The frame format is defined in CM4/Core/Inc/dlog.h and the messages in
+CM4/Core/Inc/dlog_ids.h; this tool builds its string table from that file,
+so it always matches the firmware it was checked out with:
+
+    [tag 0xC6][version][n][core][dropped(4)] then n x [ts_us(4)][id(2)][nargs][0][args(3 x 4)]
+
+Input is the ESP32 console (a capture file or stdin): "DLOG M4 <hex>" lines
+are decoded, every other line is passed through unchanged. --table writes the
+generated string table as JSON for other tools.
+"""
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT = os.path.dirname(HERE)
+DEFAULT_IDS = os.path.join(REPO_ROOT, 'CM4', 'Core', 'Inc', 'dlog_ids.h')
+
+DLOG_TAG = 0xC6
+DLOG_VERSION = 1
+DLOG_MAX_ARGS = 3
+
+_HEADER_FMT = '<BBBBI'
+_HEADER_SIZE = struct.calcsize(_HEADER_FMT)
+_RECORD_FMT = f'<IHBB{DLOG_MAX_ARGS}I'
+_RECORD_SIZE = struct.calcsize(_RECORD_FMT)
+
+_LINE_RE = re.compile(r'DLOG M(\d+) ([0-9a-fA-F]+)')
+_SPEC_RE = re.compile(r'%([-+ 0#]*)(\d*)(?:\.(\d+))?([udixXcf%])')
+
+
+def load_table(path):
+    """Parse dlog_ids.h, return {id: (name, format)}; IDs start at 1 (0 is DLOG_ID_NONE)"""
+    with open(path) as f:
+        source = re.sub(r'/\*.*?\*/', '', f.read(), flags=re.S)
+    entries = re.findall(r'^\s*DLOG_MSG\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', source, re.M)
+    if not entries:
+        raise ValueError(f"No DLOG_MSG entries in {path}")
+    return {i + 1: (name, fmt.encode().decode('unicode_escape')) for i, (name, fmt) in enumerate(entries)}
+
+
+def format_message(fmt, args):
+    """printf subset of dlog_ids.h, arguments are raw 32-bit words"""
+    it = iter(args)
+
+    def conv(m):
+        flags, width, prec, kind = m.groups()
+        if kind == '%':
+            return '%'
+        raw = next(it, 0)
+        spec = '%' + flags + width + (f'.{prec}' if prec is not None else '')
+        if kind == 'f':
+            (value,) = struct.unpack('<f', struct.pack('<I', raw))
+            return (spec + 'f') % value
+        if kind in 'di':
+            return (spec + 'd') % (raw - (1 << 32) if raw & 0x80000000 else raw)
+        if kind == 'c':
+            return chr(raw & 0xFF)
+        return (spec + kind) % raw
+
+    return _SPEC_RE.sub(conv, fmt)
+
+
+def decode_frame(frame, table):
+    """Return (core, dropped, [(ts_us, text)]) for one frame"""
+    if len(frame) < _HEADER_SIZE:
+        raise ValueError("Truncated frame")
+    tag, version, n, core, dropped = struct.unpack(_HEADER_FMT, frame[:_HEADER_SIZE])
+    if tag != DLOG_TAG or version != DLOG_VERSION:
+        raise ValueError(f"Not a log frame (tag 0x{tag:02x}, version {version})")
+    if len(frame) < _HEADER_SIZE + n * _RECORD_SIZE:
+        raise ValueError(f"Truncated frame: {n} records in {len(frame)} bytes")
+
+    messages = []
+    for i in range(n):
+        off = _HEADER_SIZE + i * _RECORD_SIZE
+        ts, msg_id, nargs, _, *args = struct.unpack(_RECORD_FMT, frame[off:off + _RECORD_SIZE])
+        if msg_id in table:
+            text = format_message(table[msg_id][1], args[:nargs])
+        else:
+            text = f"unknown id {msg_id} args {' '.join(f'0x{a:x}' for a in args[:nargs])}"
+        messages.append((ts, text))
+    return core, dropped, messages
+
+
+def decode_stream(lines, table, out):
+    """Decode DLOG lines, pass the rest through; return (records, dropped)"""
+    records = dropped_total = 0
+    for line in lines:
+        m = _LINE_RE.search(line)
+        if not m:
+            out.write(line)
+            continue
+        try:
+            core, dropped, messages = decode_frame(bytes.fromhex(m.group(2)), table)
+        except ValueError as err:
+            out.write(f"DLOG M{m.group(1)} undecodable: {err}\n")
+            continue
+        for ts, text in messages:
+            out.write(f"[{ts / 1e6:12.6f}] M{core} {text}\n")
+        if dropped:
+            out.write(f"[            ] M{core} {dropped} log records dropped (ring full)\n")
+        records += len(messages)
+        dropped_total += dropped
+    return records, dropped_total
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('input', nargs='?', help='ESP32 console capture (default: stdin)')
+    parser.add_argument('--ids', default=DEFAULT_IDS, help='dlog_ids.h to build the string table from')
+    parser.add_argument('--table', help='write the string table as JSON and exit')
+    args = parser.parse_args()
+
+    table = load_table(args.ids)
+    if args.table:
+        with open(args.table, 'w') as f:
+            json.dump({str(k): {'name': n, 'format': fmt} for k, (n, fmt) in table.items()}, f, indent=2)
+        print(f"{len(table)} messages -> {args.table}")
+        return 0
+
+    if args.input:
+        with open(args.input, errors='replace') as f:
+            records, dropped = decode_stream(f, table, sys.stdout)
+    else:
+        records, dropped = decode_stream(sys.stdin, table, sys.stdout)
+    print(f"{records} log records decoded, {dropped} dropped", file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,84 @@
+/* Host shim of the Arduino-ESP32 core, see Arduino.h. */
+#include "Arduino.h"
+#include <time.h>
+
+HardwareSerial Serial(true);
+HardwareSerial Serial1(false);
+
+static uint64_t monotonic_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000U + (uint64_t)ts.tv_nsec / 1000000U;
+}
+
+static const uint64_t g_start_ms = monotonic_ms();
+
+uint32_t millis(void)
+{
+  return (uint32_t)(monotonic_ms() - g_start_ms);
+}
+
+void delay(uint32_t ms)
+{
+  struct timespec ts = { (time_t)(ms / 1000U), (long)(ms % 1000U) * 1000000L };
+  nanosleep(&ts, NULL);
+}
+
+uint32_t esp_random(void)
+{
+  return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+void HardwareSerial::begin(unsigned long b, uint32_t config, int rxPin, int txPin)
+{
+  (void)config;
+  (void)rxPin;
+  (void)txPin;
+  baud = b;
+}
+
+size_t HardwareSerial::read(uint8_t* buf, size_t n)
+{
+  size_t avail = rx.size() - rxPos;
+  if (n > avail) n = avail;
+  memcpy(buf, &rx[rxPos], n);
+  rxPos += n;
+  if (rxPos == rx.size()) {
+    rx.clear();
+    rxPos = 0;
+  }
+  return n;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t n)
+{
+  if (console_) {
+    if (echo) fwrite(data, 1, n, stdout);
+  } else {
+    tx.insert(tx.end(), data, data + n);
+  }
+  return n;
+}
+
+size_t HardwareSerial::printf(const char* fmt, ...)
+{
+  char buf[512];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  return write((const uint8_t*)buf, ((size_t)n < sizeof(buf)) ? (size_t)n : sizeof(buf) - 1U);
+}
+
+size_t HardwareSerial::inject(const uint8_t* data, size_t n)
+{
+  size_t room = rxCap - (rx.size() - rxPos);
+  if (n > room) {
+    rxDropped += n - room;
+    n = room;
+  }
+  rx.insert(rx.end(), data, data + n);
+  return n;
+}
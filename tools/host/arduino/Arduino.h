@@ -0,0 +1,95 @@
+/* Host shim of the Arduino-ESP32 core: what Bridge/ uses, on Linux (tools/host/test_bridge.cpp).
+ * String follows the Arduino class closely enough for the JSON builders;
+ * Serial prints to stdout (or nowhere), Serial1 is a UART with both ends
+ * exposed to the test: an RX ring it fills, a TX log it reads back.
+ */
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+uint32_t millis(void);
+void delay(uint32_t ms);
+uint32_t esp_random(void);
+
+class String {
+ public:
+  String(const char* s = "") : s_(s != NULL ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned int v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  String(float v, unsigned int decimals = 2) { format(v, decimals); }
+  String(double v, unsigned int decimals = 2) { format(v, decimals); }
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned int length() const { return (unsigned int)s_.size(); }
+  void reserve(unsigned int n) { s_.reserve(n); }
+  void remove(unsigned int index) { if (index < s_.size()) s_.erase(index); }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  friend String operator+(String a, const String& b) { a.s_ += b.s_; return a; }
+  friend String operator+(String a, const char* b) { a.s_ += b; return a; }
+
+ private:
+  void format(double v, unsigned int decimals) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+    s_ = buf;
+  }
+  std::string s_;
+};
+
+// Flow control modes of HardwareSerial::setHwFlowCtrlMode (ESP-IDF uart_hw_flowcontrol_t)
+#define UART_HW_FLOWCTRL_DISABLE   0
+#define UART_HW_FLOWCTRL_CTS_RTS   3
+#define SERIAL_8N1                 0x800001cU
+
+class HardwareSerial {
+ public:
+  explicit HardwareSerial(bool console) : console_(console) {}
+
+  void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int rxPin = -1, int txPin = -1);
+  void setRxBufferSize(size_t n) { rxCap = n; }
+  void setPins(int rx, int tx, int cts = -1, int rts = -1) { (void)rx; (void)tx; (void)cts; (void)rts; }
+  bool setHwFlowCtrlMode(uint8_t mode, uint8_t threshold) { flowMode = mode; (void)threshold; return true; }
+  void updateBaudRate(unsigned long b) { baud = b; }
+  void flush(void) {}
+
+  int available(void) { return (int)(rx.size() - rxPos); }
+  size_t read(uint8_t* buf, size_t n);
+  size_t write(const uint8_t* data, size_t n);
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s) { return write(s); }
+  size_t println(const char* s = "") { return write(s) + write("\n"); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  // Host side: bytes from the STM32 into the RX ring, up to rxCap like the
+  // ESP32 driver; returns how many fitted. TX is kept in tx.
+  size_t inject(const uint8_t* data, size_t n);
+  bool echo = true;                  // Console: print to stdout
+  unsigned long baud = 0;
+  uint8_t flowMode = UART_HW_FLOWCTRL_DISABLE;
+  size_t rxCap = 256;
+  uint64_t rxDropped = 0;
+  std::vector<uint8_t> tx;
+
+ private:
+  bool console_;
+  std::vector<uint8_t> rx;
+  size_t rxPos = 0;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif /* ARDUINO_H */
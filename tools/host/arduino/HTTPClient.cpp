@@ -0,0 +1,118 @@
+/* Host shim of the ESP32 HTTPClient, see HTTPClient.h. */
+#include "HTTPClient.h"
+#include <poll.h>
+#include <strings.h>
+
+bool HTTPClient::parseUrl(const String& url)
+{
+  std::string u = url.c_str();
+  if (u.compare(0, 7, "http://") != 0) return false;   // No TLS here
+  size_t slash = u.find('/', 7);
+  std::string authority = u.substr(7, (slash == std::string::npos) ? std::string::npos : slash - 7);
+  path_ = (slash == std::string::npos) ? "/" : u.substr(slash);
+  size_t colon = authority.rfind(':');
+  host_ = authority.substr(0, colon);
+  port_ = (colon == std::string::npos) ? 80 : (uint16_t)atoi(authority.c_str() + colon + 1);
+  return !host_.empty();
+}
+
+bool HTTPClient::begin(WiFiClient& client, const String& url)
+{
+  client_ = &client;
+  headers_.clear();
+  return parseUrl(url);
+}
+
+bool HTTPClient::begin(const String& url)
+{
+  return begin(own_, url);
+}
+
+void HTTPClient::addHeader(const String& name, const String& value)
+{
+  headers_ += std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+}
+
+// Status line, headers, then Content-Length bytes of body
+int HTTPClient::readResponse(void)
+{
+  std::string in;
+  size_t headerEnd = std::string::npos;
+  size_t need = 0;
+  int code = HTTPC_ERROR_CONNECTION_LOST;
+
+  body_.clear();
+  keep_ = false;
+  for (;;) {
+    if (headerEnd != std::string::npos && in.size() >= headerEnd + need) break;
+    struct pollfd p = { client_->fd_, POLLIN, 0 };
+    int r = poll(&p, 1, timeoutMs_);
+    if (r == 0) return HTTPC_ERROR_READ_TIMEOUT;
+    char buf[1024];
+    int n = client_->read((uint8_t*)buf, sizeof(buf));
+    if (n <= 0) {
+      if (client_->fd_ < 0) return HTTPC_ERROR_CONNECTION_LOST;
+      continue;
+    }
+    in.append(buf, (size_t)n);
+    if (headerEnd == std::string::npos && (headerEnd = in.find("\r\n\r\n")) != std::string::npos) {
+      headerEnd += 4;
+      if (sscanf(in.c_str(), "HTTP/1.%*d %d", &code) != 1) return HTTPC_ERROR_CONNECTION_LOST;
+      keep_ = true;
+      size_t pos = in.find("\r\n") + 2;
+      while (pos < headerEnd - 2) {
+        size_t eol = in.find("\r\n", pos);
+        std::string line = in.substr(pos, eol - pos);
+        if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) need = (size_t)strtoul(line.c_str() + 15, NULL, 10);
+        if (strncasecmp(line.c_str(), "Connection:", 11) == 0 && strstr(line.c_str(), "close") != NULL) keep_ = false;
+        pos = eol + 2;
+      }
+    }
+  }
+  body_ = in.substr(headerEnd, need);
+  return code;
+}
+
+int HTTPClient::POST(const String& body)
+{
+  if (client_ == NULL || host_.empty()) return HTTPC_ERROR_CONNECTION_REFUSED;
+  if (!client_->connected() && !client_->connect(host_.c_str(), port_)) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+  char head[64];
+  snprintf(head, sizeof(head), ":%u\r\n", (unsigned)port_);
+  std::string req = "POST " + path_ + " HTTP/1.1\r\nHost: " + host_ + head
+                  + "User-Agent: ESP32HTTPClient\r\nConnection: " + (reuse_ ? "keep-alive" : "close") + "\r\n"
+                  + headers_ + "Content-Length: " + std::to_string(body.length()) + "\r\n\r\n";
+  if (client_->write((const uint8_t*)req.data(), req.size()) != req.size()) {
+    client_->stop();
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  if (client_->write((const uint8_t*)body.c_str(), body.length()) != body.length()) {
+    client_->stop();
+    return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+  }
+  int code = readResponse();
+  if (code < 0) client_->stop();
+  return code;
+}
+
+void HTTPClient::end(void)
+{
+  if (client_ != NULL && !(reuse_ && keep_)) client_->stop();
+  if (client_ == &own_) own_.stop();   // begin(url): nobody else holds the connection
+  client_ = NULL;
+  headers_.clear();
+}
+
+String HTTPClient::errorToString(int code)
+{
+  switch (code) {
+    case HTTPC_ERROR_CONNECTION_REFUSED:  return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED:  return "send header failed";
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+    case HTTPC_ERROR_NOT_CONNECTED:       return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST:     return "connection lost";
+    case HTTPC_ERROR_READ_TIMEOUT:        return "read Timeout";
+    default:                              return String();
+  }
+}
@@ -0,0 +1,49 @@
+/* Host shim of the ESP32 HTTPClient: HTTP/1.1 POST with keep-alive over WiFiClient, http:// only. */
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include "WiFi.h"
+
+#define HTTP_CODE_OK                      200
+#define HTTP_CODE_ACCEPTED                202
+#define HTTPC_ERROR_CONNECTION_REFUSED    (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED    (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED   (-3)
+#define HTTPC_ERROR_NOT_CONNECTED         (-4)
+#define HTTPC_ERROR_CONNECTION_LOST       (-5)
+#define HTTPC_ERROR_READ_TIMEOUT          (-11)
+
+class HTTPClient {
+ public:
+  HTTPClient() {}
+  HTTPClient(const HTTPClient&) = delete;
+  HTTPClient& operator=(const HTTPClient&) = delete;
+  ~HTTPClient() { end(); }
+
+  bool begin(WiFiClient& client, const String& url);
+  bool begin(const String& url);                  // On a connection of its own
+  void addHeader(const String& name, const String& value);
+  int POST(const String& body);
+  String getString(void) { return String(body_); }
+  void end(void);                                 // Keeps the connection if reusable
+  void setReuse(bool reuse) { reuse_ = reuse; }
+  void setTimeout(uint16_t ms) { timeoutMs_ = ms; }
+  static String errorToString(int code);
+
+ private:
+  bool parseUrl(const String& url);
+  int readResponse(void);
+
+  WiFiClient* client_ = NULL;
+  WiFiClient own_;
+  std::string host_;
+  uint16_t port_ = 80;
+  std::string path_;
+  std::string headers_;
+  std::string body_;
+  bool reuse_ = true;
+  bool keep_ = false;       // The server allows another request on the connection
+  uint16_t timeoutMs_ = 5000;
+};
+
+#endif /* HTTP_CLIENT_H */
@@ -0,0 +1,84 @@
+/* Host shim of the ESP32 WiFi library, see WiFi.h. */
+#include "WiFi.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+int WiFiClient::connect(const char* host, uint16_t port)
+{
+  struct addrinfo hints;
+  struct addrinfo* res = NULL;
+  char service[8];
+
+  stop();
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service, sizeof(service), "%u", (unsigned)port);
+  if (getaddrinfo(host, service, &hints, &res) != 0) return 0;
+  for (struct addrinfo* ai = res; ai != NULL && fd_ < 0; ai = ai->ai_next) {
+    int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) continue;
+    if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      fd_ = fd;
+    } else {
+      close(fd);
+    }
+  }
+  freeaddrinfo(res);
+  return fd_ >= 0;
+}
+
+size_t WiFiClient::write(const uint8_t* data, size_t len)
+{
+  size_t done = 0;
+  while (fd_ >= 0 && done < len) {
+    ssize_t n = send(fd_, data + done, len - done, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return 0;
+    done += (size_t)n;
+  }
+  return done == len ? len : 0;
+}
+
+int WiFiClient::available(void)
+{
+  int n = 0;
+  if (fd_ < 0 || ioctl(fd_, FIONREAD, &n) != 0) return 0;
+  return n;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t len)
+{
+  if (fd_ < 0) return -1;
+  ssize_t n = recv(fd_, buf, len, MSG_DONTWAIT);
+  if (n == 0) stop();   // Peer closed
+  return (n > 0) ? (int)n : -1;
+}
+
+uint8_t WiFiClient::connected(void)
+{
+  uint8_t b;
+  if (fd_ < 0) return 0;
+  ssize_t n = recv(fd_, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    stop();
+    return 0;
+  }
+  return 1;
+}
+
+void WiFiClient::stop(void)
+{
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+}
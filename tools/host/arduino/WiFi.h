@@ -0,0 +1,44 @@
+/* Host shim of the ESP32 WiFi library: the station is always up, WiFiClient is a POSIX TCP socket. */
+#ifndef WIFI_H
+#define WIFI_H
+
+#include "Arduino.h"
+
+typedef enum {
+  WL_IDLE_STATUS    = 0,
+  WL_CONNECTED      = 3,
+  WL_DISCONNECTED   = 6,
+} wl_status_t;
+
+class WiFiClass {
+ public:
+  wl_status_t status(void) { return up ? WL_CONNECTED : WL_DISCONNECTED; }
+  bool up = true;   // Host side: the test takes the station down
+};
+
+extern WiFiClass WiFi;
+
+class HTTPClient;
+
+class WiFiClient {
+ public:
+  WiFiClient() {}
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+  virtual ~WiFiClient() { stop(); }
+
+  int connect(const char* host, uint16_t port);   // 1 if connected
+  size_t write(const uint8_t* data, size_t len);  // All of it, or 0
+  int available(void);
+  int read(uint8_t* buf, size_t len);             // Without waiting; -1 if nothing
+  uint8_t connected(void);                        // 0 once the peer closed
+  void stop(void);
+  void setTimeout(uint32_t ms) { timeoutMs_ = ms; }
+
+ private:
+  friend class HTTPClient;
+  int fd_ = -1;
+  uint32_t timeoutMs_ = 5000;
+};
+
+#endif /* WIFI_H */
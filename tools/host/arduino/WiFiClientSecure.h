@@ -0,0 +1,12 @@
+/* Host shim of WiFiClientSecure: no TLS on the host, the stand-in servers speak plain HTTP. */
+#ifndef WIFI_CLIENT_SECURE_H
+#define WIFI_CLIENT_SECURE_H
+
+#include "WiFi.h"
+
+class WiFiClientSecure : public WiFiClient {
+ public:
+  void setInsecure(void) {}
+};
+
+#endif /* WIFI_CLIENT_SECURE_H */
@@ -0,0 +1,84 @@
+/* Host shims of mbedtls/gcm.h and mbedtls/base64.h. */
+#include "mbedtls/gcm.h"
+#include "mbedtls/base64.h"
+#include <string.h>
+
+void mbedtls_gcm_init(mbedtls_gcm_context* ctx)
+{
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_gcm_setkey(mbedtls_gcm_context* ctx, int cipher, const unsigned char* key, unsigned int keybits)
+{
+  if (cipher != MBEDTLS_CIPHER_ID_AES || keybits != 128U) return MBEDTLS_ERR_GCM_BAD_INPUT;
+  memcpy(ctx->key, key, sizeof(ctx->key));
+  ctx->keyed = 0;
+  return 0;
+}
+
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context* ctx, size_t length, const unsigned char* iv, size_t iv_len,
+                             const unsigned char* add, size_t add_len, const unsigned char* tag, size_t tag_len,
+                             const unsigned char* input, unsigned char* output)
+{
+  if (iv_len != AES_GCM_PREFIX_LEN + 4U || tag_len != AES_GCM_TAG_LEN) return MBEDTLS_ERR_GCM_BAD_INPUT;
+  if (!ctx->keyed || memcmp(ctx->prefix, iv, AES_GCM_PREFIX_LEN) != 0) {
+    AesGcm_Init(&ctx->gcm, ctx->key, iv, 0U);
+    memcpy(ctx->prefix, iv, AES_GCM_PREFIX_LEN);
+    ctx->keyed = 1;
+  }
+  uint32_t frame = ((uint32_t)iv[8] << 24) | ((uint32_t)iv[9] << 16) | ((uint32_t)iv[10] << 8) | iv[11];
+  if (output != input) memmove(output, input, length);
+  if (!AesGcm_Open(&ctx->gcm, frame, add, add_len, output, length, tag)) {
+    memset(output, 0, length);
+    return MBEDTLS_ERR_GCM_AUTH_FAILED;
+  }
+  return 0;
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context* ctx)
+{
+  memset(ctx, 0, sizeof(*ctx));
+}
+
+static const char kB64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+int mbedtls_base64_encode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen)
+{
+  size_t need = 4U * ((slen + 2U) / 3U);
+  if (dlen < need + 1U) {
+    *olen = need + 1U;
+    return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+  }
+  size_t o = 0;
+  for (size_t i = 0; i < slen; i += 3U) {
+    uint32_t v = (uint32_t)src[i] << 16;
+    if (i + 1U < slen) v |= (uint32_t)src[i + 1U] << 8;
+    if (i + 2U < slen) v |= src[i + 2U];
+    dst[o++] = (unsigned char)kB64[(v >> 18) & 63U];
+    dst[o++] = (unsigned char)kB64[(v >> 12) & 63U];
+    dst[o++] = (i + 1U < slen) ? (unsigned char)kB64[(v >> 6) & 63U] : '=';
+    dst[o++] = (i + 2U < slen) ? (unsigned char)kB64[v & 63U] : '=';
+  }
+  dst[o] = '\0';
+  *olen = o;
+  return 0;
+}
+
+int mbedtls_base64_decode(unsigned char* dst, size_t dlen, size_t* olen, const unsigned char* src, size_t slen)
+{
+  uint32_t v = 0;
+  size_t bits = 0, o = 0;
+  for (size_t i = 0; i < slen && src[i] != '='; i++) {
+    const char* p = (src[i] != '\0') ? strchr(kB64, src[i]) : NULL;
+    if (p == NULL) return MBEDTLS_ERR_BASE64_INVALID_CHARACTER;
+    v = (v << 6) | (uint32_t)(p - kB64);
+    bits += 6U;
+    if (bits >= 8U) {
+      bits -= 8U;
+      if (o >= dlen) return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+      dst[o++] = (unsigned char)(v >> bits);
+    }
+  }
+  *olen = o;
+  return 0;
+}
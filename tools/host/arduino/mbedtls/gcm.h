@@ -0,0 +1,30 @@
+/* Host shim of mbedtls/gcm.h: AES-128-GCM authenticated decryption on CM4/Core/Src/aes_gcm.c. */
+#ifndef MBEDTLS_GCM_H
+#define MBEDTLS_GCM_H
+
+#include <stddef.h>
+#include <stdint.h>
+extern "C" {
+#include "aes_gcm.h"
+}
+
+#define MBEDTLS_CIPHER_ID_AES      2
+#define MBEDTLS_ERR_GCM_AUTH_FAILED    (-0x0012)
+#define MBEDTLS_ERR_GCM_BAD_INPUT      (-0x0014)
+
+// aes_gcm.c keys a fixed 8-byte nonce prefix: re-keyed when the prefix changes (new session)
+typedef struct {
+  aes_gcm_t gcm;
+  uint8_t   key[16];
+  uint8_t   prefix[AES_GCM_PREFIX_LEN];
+  uint8_t   keyed;
+} mbedtls_gcm_context;
+
+void mbedtls_gcm_init(mbedtls_gcm_context* ctx);
+int mbedtls_gcm_setkey(mbedtls_gcm_context* ctx, int cipher, const unsigned char* key, unsigned int keybits);
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context* ctx, size_t length, const unsigned char* iv, size_t iv_len,
+                             const unsigned char* add, size_t add_len, const unsigned char* tag, size_t tag_len,
+                             const unsigned char* input, unsigned char* output);
+void mbedtls_gcm_free(mbedtls_gcm_context* ctx);
+
+#endif /* MBEDTLS_GCM_H */
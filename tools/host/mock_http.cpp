@@ -0,0 +1,138 @@
+/* In-process HTTP/1.1 server, see mock_http.h. */
+#include "mock_http.h"
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool MockHttp::start(void)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  int one = 1;
+
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) return false;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (bind(listenFd_, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd_, 16) != 0 ||
+      getsockname(listenFd_, (struct sockaddr*)&addr, &len) != 0) {
+    close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  port = ntohs(addr.sin_port);
+  running_ = true;
+  thread_ = std::thread(&MockHttp::loop, this);
+  return true;
+}
+
+void MockHttp::stop(void)
+{
+  if (!running_) return;
+  running_ = false;
+  thread_.join();
+  close(listenFd_);
+  listenFd_ = -1;
+}
+
+std::vector<MockRequest> MockHttp::take(void)
+{
+  std::lock_guard<std::mutex> guard(lock_);
+  std::vector<MockRequest> out;
+  out.swap(requests_);
+  return out;
+}
+
+struct MockConn {
+  int         fd;
+  uint32_t    id;
+  std::string in;
+};
+
+// One complete request at the front of c.in, removed; false if more bytes are needed
+static bool mock_parse(MockConn& c, MockRequest& req)
+{
+  size_t end = c.in.find("\r\n\r\n");
+  if (end == std::string::npos) return false;
+  size_t eol = c.in.find("\r\n");
+  size_t need = 0;
+  std::string line = c.in.substr(0, eol);
+  size_t sp1 = line.find(' ');
+  size_t sp2 = line.find(' ', sp1 + 1);
+  req.method = line.substr(0, sp1);
+  req.path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+  req.headers = c.in.substr(eol + 2, end + 2 - (eol + 2));
+  for (size_t pos = 0; pos < req.headers.size();) {
+    size_t next = req.headers.find("\r\n", pos);
+    if (strncasecmp(req.headers.c_str() + pos, "Content-Length:", 15) == 0) {
+      need = (size_t)strtoul(req.headers.c_str() + pos + 15, NULL, 10);
+    }
+    pos = next + 2;
+  }
+  if (c.in.size() < end + 4 + need) return false;
+  req.body = c.in.substr(end + 4, need);
+  req.conn = c.id;
+  c.in.erase(0, end + 4 + need);
+  return true;
+}
+
+void MockHttp::loop(void)
+{
+  std::vector<MockConn> conns;
+
+  while (running_) {
+    std::vector<struct pollfd> fds;
+    fds.push_back({ listenFd_, POLLIN, 0 });
+    for (const MockConn& c : conns) fds.push_back({ c.fd, POLLIN, 0 });
+    if (poll(fds.data(), fds.size(), 20) <= 0) continue;
+
+    if (fds[0].revents & POLLIN) {
+      int fd = accept(listenFd_, NULL, NULL);
+      if (fd >= 0) conns.push_back({ fd, ++connections, std::string() });
+    }
+    for (size_t i = 1; i < fds.size(); i++) {
+      if (fds[i].revents == 0) continue;
+      MockConn& c = conns[i - 1];
+      char buf[4096];
+      ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+      if (n <= 0) {
+        close(c.fd);
+        c.fd = -1;
+        continue;
+      }
+      c.in.append(buf, (size_t)n);
+      MockRequest req;
+      while (c.fd >= 0 && mock_parse(c, req)) {
+        {
+          std::lock_guard<std::mutex> guard(lock_);
+          requests_.push_back(req);
+        }
+        if (drop > 0) {
+          drop--;
+          close(c.fd);
+          c.fd = -1;
+          break;
+        }
+        char reply[160];
+        int len = snprintf(reply, sizeof(reply), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                           "Content-Length: 2\r\nConnection: keep-alive\r\n\r\n{}",
+                           status.load(), status == 200 ? "OK" : "Error");
+        if (send(c.fd, reply, (size_t)len, MSG_NOSIGNAL) != len) {
+          close(c.fd);
+          c.fd = -1;
+        }
+      }
+    }
+    for (size_t i = conns.size(); i-- > 0;) {
+      if (conns[i].fd < 0) conns.erase(conns.begin() + (long)i);
+    }
+  }
+  for (const MockConn& c : conns) close(c.fd);
+}
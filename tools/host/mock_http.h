@@ -0,0 +1,47 @@
+/* In-process HTTP/1.1 server standing in for Firestore and the ingestion endpoint (test_bridge). */
+#ifndef MOCK_HTTP_H
+#define MOCK_HTTP_H
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct MockRequest {
+  std::string method;
+  std::string path;
+  std::string headers;   // As received, one "Name: value\r\n" per line
+  std::string body;
+  uint32_t    conn;      // Connection number, from 1
+};
+
+/*
+ * Listens on 127.0.0.1 (any free port), keeps connections alive and
+ * answers every request with status and "{}". One thread polls all
+ * connections, so a client may keep one open while it opens another.
+ */
+class MockHttp {
+ public:
+  ~MockHttp() { stop(); }
+  bool start(void);
+  void stop(void);
+  std::vector<MockRequest> take(void);   // Requests received since the last call
+
+  uint16_t port = 0;
+  std::atomic<int> status{200};
+  std::atomic<int> drop{0};              // Next requests answered by closing the connection
+  std::atomic<uint32_t> connections{0};
+
+ private:
+  void loop(void);
+
+  int listenFd_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  std::mutex lock_;
+  std::vector<MockRequest> requests_;
+};
+
+#endif /* MOCK_HTTP_H */
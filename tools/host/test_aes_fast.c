@@ -0,0 +1,308 @@
+/* Host test and benchmark of the CM4 UART cipher (CM4/Core/Src/aes_fast.c,
+ * aes_gcm.c) against tiny-AES (CM4/Core/Src/aes.c), which secure_uart.c used before.
+ * Cycle counts come from the x86 TSC (or nanoseconds elsewhere); on the CM4
+ * the same ratios apply, the absolute figures do not.
+ * Usage: test_aes_fast
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aes.h"
+#include "aes_gcm.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#define CYCLE_UNIT "cycles"
+#else
+static uint64_t ns_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#define CYCLES() ns_now()
+#define CYCLE_UNIT "ns"
+#endif
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+static const uint8_t kKey[16] = { 0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
+
+static uint32_t g_rng = 0x9E3779B9u;
+
+static uint32_t rng(void)
+{
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 17;
+  g_rng ^= g_rng << 5;
+  return g_rng;
+}
+
+// What secure_uart_send() did per frame before: key expansion + tiny-AES CTR
+static void old_xcrypt(uint32_t ctr, uint8_t *buf, size_t len)
+{
+  struct AES_ctx ctx;
+  uint8_t iv[AES_BLOCKLEN] = { 0 };
+  iv[12] = (uint8_t)(ctr >> 24);
+  iv[13] = (uint8_t)(ctr >> 16);
+  iv[14] = (uint8_t)(ctr >> 8);
+  iv[15] = (uint8_t)ctr;
+  AES_init_ctx_iv(&ctx, kKey, iv);
+  AES_CTR_xcrypt_buffer(&ctx, buf, len);
+}
+
+static void test_fips197(void)
+{
+  // FIPS-197 appendix C.1
+  static const uint8_t key[16] = { 0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f };
+  static const uint8_t pt[16] = { 0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff };
+  static const uint8_t ct[16] = { 0x69,0xc4,0xe0,0xd8,0x6a,0x7b,0x04,0x30,0xd8,0xcd,0xb7,0x80,0x70,0xb4,0xc5,0x5a };
+  aes_fast_key_t k;
+  uint8_t out[16];
+
+  AesFast_KeyInit(&k, key);
+  AesFast_EncryptBlock(&k, pt, out);
+  CHECK(memcmp(out, ct, 16) == 0);
+  memcpy(out, pt, 16);
+  AesFast_EncryptBlock(&k, out, out);  // In place
+  CHECK(memcmp(out, ct, 16) == 0);
+
+  // Same as tiny-AES ECB on random blocks
+  struct AES_ctx tiny;
+  AesFast_KeyInit(&k, kKey);
+  AES_init_ctx(&tiny, kKey);
+  for (int i = 0; i < 1000; i++) {
+    uint8_t a[16], b[16];
+    for (int j = 0; j < 16; j++) a[j] = b[j] = (uint8_t)rng();
+    AesFast_EncryptBlock(&k, a, a);
+    AES_ECB_encrypt(&tiny, b);
+    CHECK(memcmp(a, b, 16) == 0);
+  }
+}
+
+static size_t unhex(const char *hex, uint8_t *out)
+{
+  size_t n = 0;
+  for (; hex[0] && hex[1]; hex += 2) {
+    unsigned v;
+    sscanf(hex, "%2x", &v);
+    out[n++] = (uint8_t)v;
+  }
+  return n;
+}
+
+// SP 800-38D / McGrew-Viega test cases 1, 2 and 4 (AES-128, 96-bit IV)
+static void test_gcm_vectors(void)
+{
+  static const struct {
+    const char *key, *iv, *pt, *aad, *ct, *tag;
+  } tc[] = {
+    { "00000000000000000000000000000000", "000000000000000000000000", "", "", "",
+      "58e2fccefa7e3061367f1d57a4e7455a" },
+    { "00000000000000000000000000000000", "000000000000000000000000",
+      "00000000000000000000000000000000", "", "0388dace60b6a392f328c2b971b2fe78",
+      "ab6e47d42cec13bdf53a67b21257bddf" },
+    { "feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+      "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+      "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+      "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+      "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+      "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+      "5bc94fbc3221a5db94fae95ae7121a47" },
+  };
+  static aes_gcm_t ctx;
+
+  for (size_t i = 0; i < sizeof(tc) / sizeof(tc[0]); i++) {
+    uint8_t key[16], iv[12], pt[64], aad[32], ct[64], tag[16], out[16];
+    unhex(tc[i].key, key);
+    unhex(tc[i].iv, iv);
+    size_t len = unhex(tc[i].pt, pt);
+    size_t aad_len = unhex(tc[i].aad, aad);
+    unhex(tc[i].ct, ct);
+    unhex(tc[i].tag, tag);
+    // IV = 8-byte prefix || 32-bit frame counter
+    uint32_t frame = ((uint32_t)iv[8] << 24) | ((uint32_t)iv[9] << 16) | ((uint32_t)iv[10] << 8) | iv[11];
+
+    AesGcm_Init(&ctx, key, iv, frame);
+    uint8_t buf[64];
+    memcpy(buf, pt, len);
+    AesGcm_Seal(&ctx, frame, aad, aad_len, buf, len, out);
+    CHECK(memcmp(buf, ct, len) == 0);
+    CHECK(memcmp(out, tag, 16) == 0);
+
+    CHECK(AesGcm_Open(&ctx, frame, aad, aad_len, buf, len, tag));
+    CHECK(memcmp(buf, pt, len) == 0);
+  }
+}
+
+// Data blocks are plain CTR from counter 2, checked against tiny-AES
+static void test_gcm_counter_layout(void)
+{
+  static aes_gcm_t ctx;
+  static const uint8_t prefix[AES_GCM_PREFIX_LEN] = { 1, 2, 3, 4, 0, 0, 0, 0 };
+  static const uint32_t frames[] = { 7u, 0xFFFFFFFFu };
+
+  AesGcm_Init(&ctx, kKey, prefix, 7);
+  for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++) {
+    uint8_t a[200], b[200], tag[16];
+    for (size_t k = 0; k < sizeof(a); k++) a[k] = b[k] = (uint8_t)rng();
+    AesGcm_Seal(&ctx, frames[f], NULL, 0, a, sizeof(a), tag);
+
+    struct AES_ctx tiny;
+    uint8_t iv[16];
+    memcpy(iv, prefix, 8);
+    iv[8] = (uint8_t)(frames[f] >> 24);
+    iv[9] = (uint8_t)(frames[f] >> 16);
+    iv[10] = (uint8_t)(frames[f] >> 8);
+    iv[11] = (uint8_t)frames[f];
+    iv[12] = 0; iv[13] = 0; iv[14] = 0; iv[15] = 2;
+    AES_init_ctx_iv(&tiny, kKey, iv);
+    AES_CTR_xcrypt_buffer(&tiny, b, sizeof(b));
+    CHECK(memcmp(a, b, sizeof(a)) == 0);
+  }
+}
+
+// Any change to the header (AAD), ciphertext or tag is refused, and the
+// buffer is left as it was
+static void test_gcm_tamper(void)
+{
+  static aes_gcm_t ctx;
+  static const uint8_t prefix[AES_GCM_PREFIX_LEN] = { 0xDE, 0xAD, 0xBE, 0xEF, 0, 0, 0, 0 };
+  uint8_t hdr[8] = { 0xEF, 0xBE, 0xAD, 0xDE, 5, 0, 0, 0 };
+  uint8_t pt[100], buf[100], copy[100], tag[16];
+
+  AesGcm_Init(&ctx, kKey, prefix, 5);
+  for (size_t k = 0; k < sizeof(pt); k++) pt[k] = (uint8_t)rng();
+  memcpy(buf, pt, sizeof(buf));
+  AesGcm_Seal(&ctx, 5, hdr, sizeof(hdr), buf, sizeof(buf), tag);
+  memcpy(copy, buf, sizeof(copy));
+
+  for (int i = 0; i < 300; i++) {
+    uint8_t h[8], t[16];
+    memcpy(buf, copy, sizeof(buf));
+    memcpy(h, hdr, sizeof(h));
+    memcpy(t, tag, sizeof(t));
+    uint32_t frame = 5;
+    uint8_t bit = (uint8_t)(1u << (rng() % 8));
+    switch (i % 4) {
+      case 0: buf[rng() % sizeof(buf)] ^= bit; break;
+      case 1: h[rng() % sizeof(h)] ^= bit; break;
+      case 2: t[rng() % sizeof(t)] ^= bit; break;
+      default: frame = 6; break;                    // Replayed under another counter
+    }
+    uint8_t before[100];
+    memcpy(before, buf, sizeof(before));
+    CHECK(!AesGcm_Open(&ctx, frame, h, sizeof(h), buf, sizeof(buf), t));
+    CHECK(memcmp(buf, before, sizeof(buf)) == 0);
+  }
+  memcpy(buf, copy, sizeof(buf));
+  CHECK(AesGcm_Open(&ctx, 5, hdr, sizeof(hdr), buf, sizeof(buf), tag));
+  CHECK(memcmp(buf, pt, sizeof(pt)) == 0);
+}
+
+// Frames of random length with and without idle refills in between, and
+// counters that skip (dropped frames) or cross the 32-bit carry: the cache
+// never changes the output
+static void test_gcm_cache(void)
+{
+  static aes_gcm_t warm, cold;
+  static const uint8_t prefix[AES_GCM_PREFIX_LEN] = { 9, 8, 7, 6, 0, 0, 0, 0 };
+  static const uint32_t starts[] = { 1u, 0xFFFFFFF0u };
+
+  for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); s++) {
+    uint32_t frame = starts[s];
+    AesGcm_Init(&warm, kKey, prefix, frame);
+    AesGcm_Init(&cold, kKey, prefix, frame);
+    for (int f = 0; f < 2000; f++) {
+      uint8_t a[300], b[300], ta[16], tb[16], aad[8];
+      size_t len = rng() % (sizeof(a) + 1);
+      for (size_t k = 0; k < len; k++) a[k] = b[k] = (uint8_t)rng();
+      for (size_t k = 0; k < sizeof(aad); k++) aad[k] = (uint8_t)rng();
+      if (rng() & 1) AesGcm_Refill(&warm, rng() % (2U * AES_GCM_KS_BLOCKS + 4U));
+      AesGcm_Seal(&warm, frame, aad, sizeof(aad), a, len, ta);
+      AesGcm_Seal(&cold, frame, aad, sizeof(aad), b, len, tb);
+      CHECK(memcmp(a, b, len) == 0 && memcmp(ta, tb, 16) == 0);
+      frame += (rng() % 8 == 0) ? 1U + rng() % 40 : 1U;
+    }
+    CHECK(warm.hits > 0 && warm.misses > 0);
+    CHECK(cold.hits == 0);
+  }
+
+  // Full cache: the next frame costs no AES at all, only GHASH
+  AesGcm_Init(&warm, kKey, prefix, 100);
+  CHECK(AesGcm_Refill(&warm, 1000) == AES_GCM_KS_FRAMES * (1U + AES_GCM_KS_BLOCKS));
+  CHECK(AesGcm_Refill(&warm, 1000) == 0);
+  uint8_t buf[256] = { 0 }, tag[16];
+  AesGcm_Seal(&warm, 100, NULL, 0, buf, sizeof(buf), tag);
+  CHECK(warm.misses == 0 && warm.hits == 1U + AES_GCM_KS_BLOCKS);
+  // Frame 100's slot now serves frame 102
+  CHECK(AesGcm_Refill(&warm, 1000) == 1U + AES_GCM_KS_BLOCKS);
+}
+
+typedef enum { BENCH_OLD, BENCH_COLD, BENCH_WARM } bench_mode_t;
+
+static double bench(bench_mode_t mode, size_t len, uint32_t frames)
+{
+  static aes_gcm_t ctx;
+  static const uint8_t prefix[AES_GCM_PREFIX_LEN] = { 0 };
+  static uint8_t buf[256];
+  uint8_t hdr[8] = { 0 }, tag[16];
+  uint64_t total = 0;
+
+  AesGcm_Init(&ctx, kKey, prefix, 1);
+  for (uint32_t f = 1; f <= frames; f++) {
+    if (mode == BENCH_WARM) AesGcm_Refill(&ctx, 1U + AES_GCM_KS_BLOCKS);  // Idle time, not counted
+    uint64_t t0 = CYCLES();
+    if (mode == BENCH_OLD) {
+      old_xcrypt(f, buf, len);
+    } else {
+      AesGcm_Seal(&ctx, f, hdr, sizeof(hdr), buf, len, tag);
+    }
+    total += CYCLES() - t0;
+  }
+  return (double)total / ((double)frames * (double)len);
+}
+
+static void test_benchmark(void)
+{
+  static const size_t lens[] = { 26, 64, 256 };
+  double old256 = 0.0, warm256 = 0.0;
+
+  printf("%-6s %16s %16s %16s   (" CYCLE_UNIT "/byte)\n", "bytes", "tiny-AES CTR", "GCM T-table", "GCM + idle cache");
+  for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+    double old = bench(BENCH_OLD, lens[i], 20000);
+    double cold = bench(BENCH_COLD, lens[i], 20000);
+    double warm = bench(BENCH_WARM, lens[i], 20000);
+    printf("%-6u %16.1f %16.1f %16.1f\n", (unsigned)lens[i], old, cold, warm);
+    if (lens[i] == 256) {
+      old256 = old;
+      warm256 = warm;
+    }
+  }
+  // Authentication included, a sealed batch still costs less than the old
+  // unauthenticated CTR frame; loose bound for a loaded build machine
+  CHECK(warm256 * 2.0 < old256);
+}
+
+int main(void)
+{
+  test_fips197();
+  test_gcm_vectors();
+  test_gcm_counter_layout();
+  test_gcm_tamper();
+  test_gcm_cache();
+  test_benchmark();
+
+  if (g_failures) {
+    printf("test_aes_fast: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_aes_fast: OK\n");
+  return 0;
+}
@@ -0,0 +1,753 @@
+/* Host build of the ESP32 bridge (Bridge/ units) against the Arduino, WiFi,
+ * HTTPClient and mbedtls shims in arduino/, with an in-process HTTP server
+ * (mock_http.cpp) standing in for Firestore. Frames are sealed as
+ * secure_uart.c does (CM4/Core/Src/aes_gcm.c) and take the whole path:
+ * Serial1 RX ring, COBS/CRC, AES-GCM open, records, aggregates, bursts and
+ * alerts, then Firestore commits over HTTP, checked on the server side.
+ * Usage: test_bridge [frames]                 tests, then the benchmarks
+ *        test_bridge --capture FILE [runs]    writes a synthetic STM32 UART capture
+ *        test_bridge --replay FILE [URL]      replays a capture (the raw bytes UART1
+ *                                             received) and commits to URL, e.g.
+ *                                             tools/ingest_server.py; the mock if none
+ */
+#include <Arduino.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <time.h>
+#include "../../Bridge/Inc/bridge_link.h"
+#include "../../Bridge/Inc/bridge_events.h"
+#include "../../Bridge/Inc/bridge_uplink.h"
+#include "mbedtls/base64.h"
+#include "mock_http.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+static const uint8_t kKey[16] = { 0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
+
+#define BRIDGE_FAST_BAUD     (2000000UL)   // LINK_BAUD_FAST in PFA2.ino
+#define BRIDGE_UART_RX       (4096U)       // UART_RX_BUFFER in PFA2.ino
+#define REPORT_SAMPLES       (30U)         // PPG records per report: 30 s at 1 Hz
+#define UPLOAD_BATCH         (20U)         // JOURNAL_UPLOAD_MAX in PFA2.ino
+#define FEED_SLICE           (16U)         // Bytes per UART read, under the shortest frame
+#define SCENARIO_SECONDS     (90U)
+#define ALERT_START_AT       (40U)         // Seconds into the scenario
+#define ALERT_END_AT         (60U)
+
+/*----------------------------------------------------------------------------*/
+// Sender: what secure_uart.c does on the CM4
+
+struct Sender {
+  aes_gcm_t  gcm;
+  uint32_t   session;
+  uint32_t   ctr;
+  uint8_t    seq;
+  tp_batch_t batch;
+};
+
+static void sender_init(Sender& tx, uint32_t session)
+{
+  uint8_t nonce[TP_NONCE_LEN];
+  memset(&tx, 0, sizeof(tx));
+  tx.session = session;
+  tx.ctr = 1;
+  TlmProto_Nonce(session, 0U, nonce);
+  AesGcm_Init(&tx.gcm, kKey, nonce, tx.ctr);
+  TlmProto_BatchInit(&tx.batch);
+}
+
+static void sender_add(Sender& tx, const void* item, size_t len)
+{
+  CHECK(TlmProto_BatchAdd(&tx.batch, (const uint8_t*)item, len));
+}
+
+static void sender_text(Sender& tx, const char* s)
+{
+  sender_add(tx, s, strlen(s));
+}
+
+// Seals the batch and appends the frame to out
+static void sender_seal(Sender& tx, std::vector<uint8_t>& out)
+{
+  uint8_t body[TP_BODY_MAX];
+  uint8_t frame[TP_FRAME_MAX(TP_BODY_MAX)];
+  tp_seal_hdr_t hdr = { tx.session, tx.ctr };
+  size_t len = TP_SEAL_HDR_LEN + tx.batch.len;
+
+  memcpy(body, &hdr, TP_SEAL_HDR_LEN);
+  memcpy(&body[TP_SEAL_HDR_LEN], tx.batch.buf, tx.batch.len);
+  AesGcm_Seal(&tx.gcm, tx.ctr, body, TP_SEAL_HDR_LEN, &body[TP_SEAL_HDR_LEN], tx.batch.len, &body[len]);
+  len += TP_SEAL_TAG_LEN;
+  tx.ctr++;
+  TlmProto_BatchInit(&tx.batch);
+  size_t n = TlmProto_FrameEncode(body, len, frame, sizeof(frame));
+  out.insert(out.end(), frame, frame + n);
+}
+
+// PPG record of second t; the expected burst samples are built from the same values
+static uint16_t scenario_hr(uint32_t t) { return (uint16_t)(700U + (t * 37U) % 120U); }
+static uint16_t scenario_spo2(uint32_t t) { return (uint16_t)(960U + t % 25U); }
+static int16_t scenario_temp(uint32_t t) { return (int16_t)(3640 + (int32_t)((t / 5U) % 12U) * 5); }
+
+static void sender_event(Sender& tx, uint32_t ts, uint8_t event, uint16_t alertId, uint16_t score, uint16_t peak)
+{
+  tp_record_t rec;
+  size_t len = TlmProto_RecordInit(&rec, TP_REC_EVENT, tx.seq++, ts);
+  rec.event.event = event;
+  rec.event.alert_id = alertId;
+  rec.event.score_x1000 = score;
+  rec.event.peak_x1000 = peak;
+  sender_add(tx, &rec, len);
+}
+
+/*
+ * SCENARIO_SECONDS of telemetry, one sealed batch per second: a PPG record,
+ * the LM35 every 5 s, an alert from ALERT_START_AT to ALERT_END_AT, a CPU
+ * load frame and a TXQ line every 30 s, the alert summary at the end.
+ */
+static void scenario(Sender& tx, uint32_t t0, uint16_t alertId, std::vector<uint8_t>& out)
+{
+  static const uint8_t load[] = { 0xC5, 1, 4, 1, 0x40, 0x42, 0x0F, 0, 0x10, 0x27, 0x05, 0,
+                                  'T', 'l', 'm', ' ', 0x34, 0x01 };
+  for (uint32_t s = 0; s < SCENARIO_SECONDS; s++) {
+    uint32_t t = t0 + s;
+    uint32_t ts = 1000U * t;
+    tp_record_t rec;
+    if (s % 5U == 0U) {
+      size_t len = TlmProto_RecordInit(&rec, TP_REC_TEMP, tx.seq++, ts);
+      rec.temp.celsius_x100 = scenario_temp(t);
+      rec.temp.source = TP_TEMP_LM35;
+      sender_add(tx, &rec, len);
+    }
+    size_t len = TlmProto_RecordInit(&rec, TP_REC_PPG, tx.seq++, ts);
+    rec.ppg.hr_x10 = scenario_hr(t);
+    rec.ppg.spo2_x10 = scenario_spo2(t);
+    rec.ppg.pi_x100 = 124;
+    rec.ppg.peaks = 5;
+    rec.ppg.flags = TP_PPG_FINGER | TP_PPG_HR_VALID;
+    sender_add(tx, &rec, len);
+    if (s + 1U == ALERT_START_AT) sender_event(tx, ts, 1, alertId, 870, 0);
+    if (s + 1U == ALERT_END_AT) sender_event(tx, ts, 2, alertId, 0, 930);
+    if (s + 1U == SCENARIO_SECONDS) sender_event(tx, ts, 3, 0, 120, 930);
+    if (s % 30U == 29U) {
+      sender_add(tx, load, sizeof(load));
+      sender_text(tx, "TXQ:M4 sess=5eed0001 items=4 queued=0 dropped=0 busy=0\n");
+    }
+    sender_seal(tx, out);
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+// The sketch's I/O task and network task, run in turn
+
+struct HostBridge {
+  BridgeLink          link;
+  BridgeEvents        events;
+  BridgeUplink        uplink;
+  std::vector<NetMsg> queue;    // netQueue
+  uint32_t            reportSeq;
+  uint32_t            txqLines;
+  uint32_t            uploadFailures;
+};
+
+static bool host_post(void* user, const NetMsg& msg)
+{
+  ((HostBridge*)user)->queue.push_back(msg);
+  return true;
+}
+
+static void host_stats(void* user)
+{
+  ((HostBridge*)user)->txqLines++;
+}
+
+static void bridge_begin(HostBridge& b, const char* firestoreUrl, const char* ingestionUrl)
+{
+  static const UplinkConfig cfg_template = { NULL, "test-project", "test-key", "users", "vest-1", "" };
+  UplinkConfig cfg = cfg_template;
+  cfg.firestoreUrl = firestoreUrl;
+  cfg.ingestionUrl = ingestionUrl;
+  b.queue.clear();
+  b.reportSeq = 0;
+  b.txqLines = 0;
+  b.uploadFailures = 0;
+  Serial1.begin(TP_LINK_BAUD_BASE);
+  Serial1.setRxBufferSize(BRIDGE_UART_RX);
+  Serial1.setHwFlowCtrlMode(UART_HW_FLOWCTRL_DISABLE, 0);
+  Serial1.tx.clear();
+  const BridgeEventsOps evOps = { host_post, host_stats, &b };
+  eventsBegin(b.events, evOps, false);
+  const tlm_rx_ops_t appOps = { NULL, eventsRecord, eventsBinary, eventsLine, NULL, &b.events };
+  linkBegin(b.link, Serial1, kKey, BRIDGE_FAST_BAUD, appOps);
+  uplinkBegin(b.uplink, cfg, 0x0b00700dU, 2000U);
+}
+
+// netTask without the journal: every message is uploaded at once
+static void bridge_net(HostBridge& b)
+{
+  for (NetMsg& msg : b.queue) {
+    bool ok = true;
+    switch (msg.type) {
+      case NET_REPORT:
+        ok = postReports(b.uplink, &msg.report, 1, true);
+        break;
+      case NET_ALERT: {
+        FsField fields[] = { { "anomalyAlert", msg.alert.active ? 1.0 : 0.0 }, { "anomalyScore", msg.alert.score } };
+        ok = commitToFirestore(b.uplink, fields, 2);
+        break;
+      }
+      case NET_SUMMARY: {
+        FsField fields[] = { { "anomalyMean", msg.summary.mean }, { "anomalyMax", msg.summary.max } };
+        ok = commitToFirestore(b.uplink, fields, 2);
+        break;
+      }
+      case NET_BURST:
+        ok = commitBurst(b.uplink, msg.burst);
+        break;
+      default:
+        break;
+    }
+    if (!ok) b.uploadFailures++;
+  }
+  b.queue.clear();
+}
+
+// ioTask: one pump of the UART, the link upkeep, a report every REPORT_SAMPLES PPG records
+static uint32_t bridge_io(HostBridge& b)
+{
+  uint32_t batches = linkPump(b.link);
+  linkPoll(b.link, millis(), batches != 0);
+  if (b.events.aggHr.n >= REPORT_SAMPLES) {
+    NetMsg msg = {};
+    msg.type = NET_REPORT;
+    eventsReport(b.events, msg.report);
+    msg.report.seq = b.reportSeq++;
+    msg.report.boot = b.uplink.boot;
+    msg.report.uptimeMs = millis();
+    host_post(&b, msg);
+  }
+  return batches;
+}
+
+// The stream through the RX ring slice by slice, each followed by a pump: slices
+// shorter than a frame complete at most one per pump, as at 115200 baud
+static void bridge_feed(HostBridge& b, const uint8_t* data, size_t len, size_t slice, bool upload)
+{
+  for (size_t pos = 0; pos < len;) {
+    pos += Serial1.inject(&data[pos], std::min(slice, len - pos));
+    while (Serial1.available() > 0) {
+      bridge_io(b);
+      if (upload) bridge_net(b);
+    }
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+// Server side
+
+static const char* kCommitPath = "/v1/projects/test-project/databases/(default)/documents:commit?key=test-key";
+
+// Value of "key":{"<kind>":"..."} or "key":{"<kind>":...} after from
+static std::string json_value(const std::string& body, const std::string& key, size_t from = 0)
+{
+  size_t k = body.find("\"" + key + "\":{", from);
+  if (k == std::string::npos) return std::string();
+  size_t colon = body.find("\":", body.find('{', k) + 1);
+  size_t start = colon + 2;
+  if (body[start] == '"') start++;
+  size_t end = body.find_first_of("\"}", start);
+  return body.substr(start, end - start);
+}
+
+// Brackets and braces nest and close, outside strings: what a hand-built JSON body gets wrong
+static bool json_balanced(const std::string& body)
+{
+  std::string open;
+  bool quoted = false;
+  for (size_t i = 0; i < body.size(); i++) {
+    char c = body[i];
+    if (quoted) {
+      if (c == '\\') i++;
+      else if (c == '"') quoted = false;
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == '{' || c == '[') {
+      open.push_back(c);
+    } else if (c == '}' || c == ']') {
+      if (open.empty() || open.back() != ((c == '}') ? '{' : '[')) return false;
+      open.pop_back();
+    }
+  }
+  return open.empty() && !quoted;
+}
+
+static std::vector<uint8_t> b64_decode(const std::string& s)
+{
+  std::vector<uint8_t> out(s.size());
+  size_t olen = 0;
+  CHECK(mbedtls_base64_decode(out.data(), out.size(), &olen, (const unsigned char*)s.data(), s.size()) == 0);
+  out.resize(olen);
+  return out;
+}
+
+// Link messages the bridge sent on Serial1
+static std::vector<tp_link_t> sent_link_messages(void)
+{
+  std::vector<tp_link_t> out;
+  tp_decoder_t dec;
+  TlmProto_DecoderInit(&dec);
+  for (uint8_t byte : Serial1.tx) {
+    const uint8_t* body = NULL;
+    size_t len = TlmProto_DecoderFeed(&dec, byte, &body);
+    const tp_link_t* msg = (len != 0U) ? TlmProto_LinkView(body, len) : NULL;
+    if (msg != NULL) out.push_back(*msg);
+  }
+  return out;
+}
+
+/*----------------------------------------------------------------------------*/
+
+// Encrypt -> frame -> UART -> decrypt -> records -> Firestore commits, checked document by document
+static void test_end_to_end(MockHttp& server)
+{
+  static HostBridge b;
+  char url[64];
+  snprintf(url, sizeof(url), "http://127.0.0.1:%u", (unsigned)server.port);
+  bridge_begin(b, url, "");
+  server.take();
+  uint32_t conns = server.connections;
+
+  Sender tx;
+  std::vector<uint8_t> stream;
+  sender_init(tx, 0x5EED0001u);
+  scenario(tx, 0, 7, stream);
+  bridge_feed(b, stream.data(), stream.size(), FEED_SLICE, true);
+
+  const tlm_rx_stats_t& st = b.link.rx.stats;
+  CHECK(st.batches == SCENARIO_SECONDS);
+  CHECK(st.auth_failures == 0U && st.lost_frames == 0U && st.lost_records == 0U && st.bad_records == 0U);
+  CHECK(b.txqLines == SCENARIO_SECONDS / 30U);
+  CHECK(b.uploadFailures == 0U);
+  CHECK(b.uplink.failures == 0U);
+  CHECK(b.uplink.handshakes == 1U && server.connections == conns + 1U);   // One kept-alive connection
+
+  // The HELLO went out at the base rate, offering the fast one
+  linkPoll(b.link, b.link.helloAt + LINK_HELLO_MS, false);
+  std::vector<tp_link_t> sent = sent_link_messages();
+  CHECK(!sent.empty() && sent[0].op == TP_LINK_HELLO && sent[0].value == BRIDGE_FAST_BAUD &&
+        (sent[0].flags & TP_LINK_RTSCTS) != 0U);
+
+  // Expected reports and burst samples, from the sender's values
+  std::vector<tlm_agg_summary_t> hr(SCENARIO_SECONDS / REPORT_SAMPLES);
+  for (uint32_t r = 0; r < hr.size(); r++) {
+    tlm_agg_t agg;
+    TlmAgg_Reset(&agg);
+    for (uint32_t t = r * REPORT_SAMPLES; t < (r + 1U) * REPORT_SAMPLES; t++) TlmAgg_Add(&agg, scenario_hr(t));
+    TlmAgg_Summarize(&agg, &hr[r]);
+  }
+  std::vector<std::vector<int32_t>> expected;
+  for (uint32_t t = ALERT_START_AT - BURST_PRE_SAMPLES; t < ALERT_END_AT + BURST_POST_SAMPLES; t++) {
+    int32_t temp = scenario_temp(t - t % 5U);
+    expected.push_back({ (int32_t)(1000U * t), scenario_hr(t), scenario_spo2(t), temp });
+  }
+
+  uint32_t reports = 0, alerts = 0, summaries = 0, chunks = 0;
+  std::vector<std::vector<int32_t>> samples;
+  for (const MockRequest& req : server.take()) {
+    CHECK(req.method == "POST" && req.path == kCommitPath);
+    CHECK(req.headers.find("Content-Type: application/json") != std::string::npos);
+    CHECK(json_balanced(req.body));
+    const std::string& body = req.body;
+    if (body.find("/history/") != std::string::npos) {
+      char id[32];
+      snprintf(id, sizeof(id), "/history/0b00700d-%u\"", (unsigned)reports);
+      CHECK(body.find("projects/test-project/databases/(default)/documents/users/vest-1") != std::string::npos);
+      CHECK(body.find(id) != std::string::npos);
+      std::vector<uint8_t> agg = b64_decode(json_value(body, "agg"));
+      CHECK(agg.size() == 3U * sizeof(tlm_agg_summary_t));
+      tlm_agg_summary_t got;
+      memcpy(&got, agg.data(), sizeof(got));
+      if (reports < hr.size()) CHECK(memcmp(&got, &hr[reports], sizeof(got)) == 0);
+      char field[48];
+      snprintf(field, sizeof(field), "%u.00", (unsigned)((got.mean + 5) / 10));
+      CHECK(json_value(body, "hr", body.find("\"updateMask\"") - 120) == field);   // User document
+      CHECK(body.find("\"updateMask\":{\"fieldPaths\":[\"hr\",\"spo2\",\"temp\"]}") != std::string::npos);
+      reports++;
+    } else if (body.find("/bursts/") != std::string::npos) {
+      char id[32];
+      snprintf(id, sizeof(id), "/bursts/0b00700d-7-%u\"", (unsigned)chunks);
+      CHECK(body.find(id) != std::string::npos);
+      std::vector<uint8_t> data = b64_decode(json_value(body, "samples"));
+      size_t pos = 0;
+      int32_t v[TLM_BURST_FIELDS] = { 0 };
+      uint32_t n = 0;
+      while (TlmBurst_Next(data.data(), data.size(), &pos, v)) {
+        samples.push_back(std::vector<int32_t>(v, v + TLM_BURST_FIELDS));
+        n++;
+      }
+      CHECK(json_value(body, "n") == std::to_string(n));
+      chunks++;
+    } else if (body.find("anomalyAlert") != std::string::npos) {
+      CHECK(json_value(body, "anomalyAlert") == (alerts == 0U ? "1.00" : "0.00"));
+      CHECK(json_value(body, "anomalyScore") == (alerts == 0U ? "0.87" : "0.93"));
+      alerts++;
+    } else if (body.find("anomalyMean") != std::string::npos) {
+      CHECK(json_value(body, "anomalyMean") == "0.12" && json_value(body, "anomalyMax") == "0.93");
+      summaries++;
+    } else {
+      CHECK(!"unexpected commit");
+    }
+  }
+  CHECK(reports == hr.size());
+  CHECK(alerts == 2U && summaries == 1U);
+  CHECK(chunks >= 2U);
+  CHECK(samples == expected);
+  printf("end to end: %zu B in %u frames -> %u reports, %u alerts, %u burst chunks (%zu samples), %u commits\n",
+         stream.size(), (unsigned)st.batches, (unsigned)reports, (unsigned)alerts, (unsigned)chunks, samples.size(),
+         (unsigned)b.uplink.commits);
+}
+
+// NACK of a lost frame, the ACCEPT of the fast rate and the fallback after silence
+static void test_link(void)
+{
+  static HostBridge b;
+  bridge_begin(b, "http://127.0.0.1:9", "");
+  Sender tx;
+  std::vector<std::vector<uint8_t>> frames(4);
+  sender_init(tx, 0x5EED0002u);
+  for (uint32_t i = 0; i < frames.size(); i++) {
+    tp_record_t rec;
+    size_t len = TlmProto_RecordInit(&rec, TP_REC_PPG, tx.seq++, 1000U * i);
+    rec.ppg.hr_x10 = 700;
+    rec.ppg.flags = TP_PPG_HR_VALID;
+    sender_add(tx, &rec, len);
+    if (i == 3U) {
+      const tp_link_t accept = { TP_LINK_TAG, TP_LINK_ACCEPT, TP_LINK_RTSCTS, 0, 0, BRIDGE_FAST_BAUD };
+      sender_add(tx, &accept, sizeof(accept));
+    }
+    sender_seal(tx, frames[i]);
+  }
+
+  // Frame 2 lost on the line: frame 3 shows the gap and the bridge asks for it
+  bridge_feed(b, frames[0].data(), frames[0].size(), FEED_SLICE, false);
+  bridge_feed(b, frames[2].data(), frames[2].size(), FEED_SLICE, false);
+  bool nacked = false;
+  for (const tp_link_t& m : sent_link_messages()) {
+    if (m.op == TP_LINK_NACK) nacked = m.session == tx.session && m.value == 2U && m.count == 1U;
+  }
+  CHECK(nacked);
+  bridge_feed(b, frames[1].data(), frames[1].size(), FEED_SLICE, false);
+  CHECK(b.link.rx.stats.recovered == 1U && b.events.aggHr.n == 3U);
+
+  // ACCEPT inside a sealed batch: the switch follows the pump
+  CHECK(Serial1.baud == TP_LINK_BAUD_BASE);
+  bridge_feed(b, frames[3].data(), frames[3].size(), FEED_SLICE, false);
+  CHECK(Serial1.baud == BRIDGE_FAST_BAUD && Serial1.flowMode == UART_HW_FLOWCTRL_CTS_RTS);
+  CHECK(b.link.baud == BRIDGE_FAST_BAUD && b.link.switches == 1U);
+
+  // Nothing authentic for LINK_SILENCE_MS: back to the base rate, without flow control
+  linkPoll(b.link, millis() + LINK_SILENCE_MS, false);
+  CHECK(Serial1.baud == TP_LINK_BAUD_BASE && Serial1.flowMode == UART_HW_FLOWCTRL_DISABLE);
+  CHECK(b.link.fallbacks == 1U);
+}
+
+// A trace dump announced by a RAW item passes by undecoded, in full or cut short
+static void test_raw(void)
+{
+  static HostBridge b;
+  bridge_begin(b, "http://127.0.0.1:9", "");
+  Sender tx;
+  std::vector<uint8_t> stream;
+  std::vector<uint8_t> dump(3000);
+  for (size_t i = 0; i < dump.size(); i++) dump[i] = (uint8_t)((i * 131U) >> 3);   // Delimiters included
+  sender_init(tx, 0x5EED0004u);
+
+  const tp_link_t raw = { TP_LINK_TAG, TP_LINK_RAW, 0, 0, 0, (uint32_t)dump.size() };
+  sender_add(tx, &raw, sizeof(raw));
+  sender_seal(tx, stream);
+  stream.insert(stream.end(), dump.begin(), dump.end());
+  tp_record_t rec;
+  size_t len = TlmProto_RecordInit(&rec, TP_REC_PPG, tx.seq++, 1000U);
+  rec.ppg.hr_x10 = 700;
+  rec.ppg.flags = TP_PPG_HR_VALID;
+  sender_add(tx, &rec, len);
+  sender_seal(tx, stream);
+  bridge_feed(b, stream.data(), stream.size(), FEED_SLICE, false);
+  CHECK(b.link.rawBytes == dump.size() && b.link.rawLeft == 0U);
+  CHECK(b.link.rx.dec.bad_frames == 0U && b.link.rx.dec.crc_errors == 0U && b.link.rx.stats.nacks == 0U);
+  CHECK(b.events.aggHr.n == 1U);
+
+  // Truncated on the STM32 side: skipping ends at the deadline and decoding resumes
+  stream.clear();
+  sender_add(tx, &raw, sizeof(raw));
+  sender_seal(tx, stream);
+  stream.insert(stream.end(), dump.begin(), dump.begin() + 1000);
+  bridge_feed(b, stream.data(), stream.size(), FEED_SLICE, false);
+  CHECK(b.link.rawLeft == dump.size() - 1000U);
+  linkPoll(b.link, b.link.rawUntil, false);
+  CHECK(b.link.rawLeft == 0U);
+  stream.clear();
+  sender_add(tx, &rec, len);
+  sender_seal(tx, stream);
+  bridge_feed(b, stream.data(), stream.size(), FEED_SLICE, false);
+  CHECK(b.events.aggHr.n == 2U && b.link.rx.stats.nacks == 0U);
+}
+
+// A console command out to the STM32 as a line, its acknowledgement back as a record
+static void test_command(void)
+{
+  static HostBridge b;
+  bridge_begin(b, "http://127.0.0.1:9", "");
+  linkCommand(b.link, "CFG 21 RATE=50 DSP=SPO2");
+
+  // What the STM32's line assembler (uart_rx.c -> app_tasks.c) makes of the bytes
+  vest_line_t line;
+  vest_cmd_t cmd;
+  unsigned lines = 0;
+  VestCfg_LineInit(&line);
+  for (uint8_t byte : Serial1.tx) {
+    if (VestCfg_LineFeed(&line, byte) != 0U) lines++;
+  }
+  CHECK(Serial1.tx.size() >= TP_LINK_PREAMBLE && Serial1.tx[0] == TP_FRAME_DELIM);
+  CHECK(lines == 1U && strcmp(line.buf, "CFG 21 RATE=50 DSP=SPO2") == 0);
+  CHECK(VestCfg_Parse(line.buf, &cmd) == VEST_CFG_OK && cmd.id == 21U);
+
+  Sender tx;
+  std::vector<uint8_t> frame;
+  sender_init(tx, 0x5EED0004u);
+  tp_record_t rec;
+  size_t len = TlmProto_RecordInit(&rec, TP_REC_CONFIG, tx.seq++, 1000U);
+  rec.config.cmd_id = 21;
+  rec.config.status = VEST_CFG_OK;
+  rec.config.rate_hz = 50;
+  rec.config.pw_us = 1600;
+  rec.config.dsp = VEST_DSP_SPO2;
+  rec.config.ai = 1;
+  sender_add(tx, &rec, len);
+  sender_seal(tx, frame);
+  bridge_feed(b, frame.data(), frame.size(), FEED_SLICE, false);
+  CHECK(b.link.rx.stats.batches == 1U && b.link.rx.stats.bad_records == 0U);
+}
+
+// Retry on a dropped connection, server errors, the ingestion endpoint
+static void test_uplink(MockHttp& server)
+{
+  static HostBridge b;
+  char url[64], ingest[80];
+  snprintf(url, sizeof(url), "http://127.0.0.1:%u", (unsigned)server.port);
+  snprintf(ingest, sizeof(ingest), "%s/telemetry", url);
+  bridge_begin(b, url, "");
+  server.take();
+
+  FsField fields[] = { { "anomalyAlert", 1.0 } };
+  CHECK(commitToFirestore(b.uplink, fields, 1));
+  server.drop = 1;   // The server closed the kept-alive connection: one retry on a new one
+  CHECK(commitToFirestore(b.uplink, fields, 1));
+  CHECK(b.uplink.commits == 2U && b.uplink.failures == 0U && b.uplink.handshakes == 2U);
+  CHECK(server.take().size() == 3U);
+
+  server.status = 503;
+  CHECK(!commitToFirestore(b.uplink, fields, 1));
+  CHECK(b.uplink.failures == 1U);
+  server.status = 200;
+  server.take();
+
+  // With an ingestion endpoint, one POST per report
+  bridge_begin(b, url, ingest);
+  JournalRecord recs[2] = {};
+  for (uint32_t i = 0; i < 2U; i++) {
+    recs[i].seq = i;
+    recs[i].boot = b.uplink.boot;
+    recs[i].uptimeMs = 30000U * (i + 1U);
+    recs[i].epoch = 1700000000U + 30U * i;
+    recs[i].hr.mean = (int16_t)(724 + i);
+    recs[i].hr.n = 30;
+    recs[i].spo2.mean = 975;
+    recs[i].temp.mean = 3650;
+    recs[i].temp.n = 6;
+  }
+  CHECK(postReports(b.uplink, recs, 2, true));
+  std::vector<MockRequest> got = server.take();
+  CHECK(got.size() == 2U);
+  if (got.size() == 2U) {
+    CHECK(got[0].path == "/telemetry" && got[0].headers.find("X-Vest-Id: vest-1") != std::string::npos);
+    CHECK(got[0].body == "{\"hr\":72,\"spo2\":98,\"temp\":36.5,\"timestamp\":1700000000}");
+    CHECK(got[1].body == "{\"hr\":73,\"spo2\":98,\"temp\":36.5,\"timestamp\":1700000030}");
+  }
+}
+
+/*----------------------------------------------------------------------------*/
+// Benchmarks
+
+#define BENCH_DISTINCT  (64U)
+
+static double now_s(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Frames decoded per second by the bridge's I/O path: UART ring, link, records, aggregates, console lines
+static void bench_decode(uint32_t frames)
+{
+  static HostBridge b;
+  Sender tx;
+  std::vector<uint8_t> stream;
+  sender_init(tx, 0x5EED0003u);
+  for (uint32_t i = 0; i < BENCH_DISTINCT; i++) {
+    tp_record_t rec;
+    for (uint32_t k = 0; k < 4U; k++) {
+      size_t len = TlmProto_RecordInit(&rec, TP_REC_PPG, tx.seq++, 250U * (4U * i + k));
+      rec.ppg.hr_x10 = (uint16_t)(600U + i);
+      rec.ppg.spo2_x10 = 978;
+      rec.ppg.flags = TP_PPG_FINGER | TP_PPG_HR_VALID;
+      sender_add(tx, &rec, len);
+    }
+    size_t len = TlmProto_RecordInit(&rec, TP_REC_TEMP, tx.seq++, 1000U * i);
+    rec.temp.celsius_x100 = (int16_t)(3650 + i);
+    sender_add(tx, &rec, len);
+    sender_seal(tx, stream);
+  }
+
+  bridge_begin(b, "http://127.0.0.1:9", "");
+  uint32_t rounds = (frames + BENCH_DISTINCT - 1U) / BENCH_DISTINCT;
+  uint32_t accepted = 0;
+  double t0 = now_s();
+  for (uint32_t r = 0; r < rounds; r++) {
+    b.link.rx.stats.session = ~tx.session;   // Same frames under a new session, not replays
+    for (size_t pos = 0; pos < stream.size();) {
+      pos += Serial1.inject(&stream[pos], stream.size() - pos);
+      accepted += linkPump(b.link);
+    }
+    b.queue.clear();
+    TlmAgg_Reset(&b.events.aggHr);
+  }
+  double dt = now_s() - t0;
+  CHECK(accepted == rounds * BENCH_DISTINCT && b.link.rx.stats.auth_failures == 0U);
+  printf("decode   %6.1f B/frame %10.0f frames/s %10.0f records/s %6.1f MB/s\n",
+         (double)stream.size() / BENCH_DISTINCT, accepted / dt, 5.0 * accepted / dt,
+         (double)stream.size() * rounds / dt / 1e6);
+}
+
+// Report commits per second over the kept-alive connection, JSON building included
+static void bench_upload(MockHttp& server, uint32_t commits)
+{
+  static HostBridge b;
+  char url[64];
+  snprintf(url, sizeof(url), "http://127.0.0.1:%u", (unsigned)server.port);
+  bridge_begin(b, url, "");
+  JournalRecord recs[UPLOAD_BATCH] = {};
+  for (uint32_t i = 0; i < UPLOAD_BATCH; i++) {
+    recs[i].boot = b.uplink.boot;
+    recs[i].seq = i;
+    recs[i].hr.mean = 724;
+    recs[i].hr.n = 30;
+  }
+  std::vector<double> ms;
+  double t0 = now_s();
+  for (uint32_t i = 0; i < commits; i++) {
+    double t = now_s();
+    CHECK(commitReports(b.uplink, recs, (i % 2U) ? UPLOAD_BATCH : 1U, true));
+    ms.push_back((now_s() - t) * 1e3);
+  }
+  double dt = now_s() - t0;
+  server.take();
+  std::sort(ms.begin(), ms.end());
+  printf("upload   %10.0f commits/s (1 and %u reports) p50 %.2f ms p99 %.2f ms, %u connection(s)\n",
+         commits / dt, (unsigned)UPLOAD_BATCH, ms[ms.size() / 2], ms[ms.size() * 99 / 100],
+         (unsigned)b.uplink.handshakes);
+}
+
+/*----------------------------------------------------------------------------*/
+// Captures
+
+static int write_capture(const char* path, uint32_t runs)
+{
+  Sender tx;
+  std::vector<uint8_t> stream;
+  sender_init(tx, 0x5EED0004u);
+  for (uint32_t r = 0; r < runs; r++) scenario(tx, r * SCENARIO_SECONDS, (uint16_t)(r + 1U), stream);
+  FILE* f = fopen(path, "wb");
+  if (f == NULL || fwrite(stream.data(), 1, stream.size(), f) != stream.size()) {
+    perror(path);
+    if (f != NULL) fclose(f);
+    return 1;
+  }
+  fclose(f);
+  printf("%s: %zu bytes, %u frames, %u s of telemetry\n", path, stream.size(), (unsigned)(tx.ctr - 1U),
+         (unsigned)(runs * SCENARIO_SECONDS));
+  return 0;
+}
+
+static int replay_capture(const char* path, const char* url)
+{
+  static HostBridge b;
+  MockHttp server;
+  std::vector<uint8_t> stream;
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    perror(path);
+    return 1;
+  }
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) stream.insert(stream.end(), buf, buf + n);
+  fclose(f);
+
+  char mock[64];
+  if (url == NULL) {
+    if (!server.start()) return 1;
+    snprintf(mock, sizeof(mock), "http://127.0.0.1:%u", (unsigned)server.port);
+    url = mock;
+  }
+  bridge_begin(b, url, "");
+  double t0 = now_s();
+  bridge_feed(b, stream.data(), stream.size(), FEED_SLICE, true);
+  bridge_net(b);
+  double dt = now_s() - t0;
+
+  const tlm_rx_stats_t& st = b.link.rx.stats;
+  Serial.printf("REPLAY %zu B frames=%lu crc_err=%lu auth_fail=%lu lost=%lu batches=%lu items=%lu "
+                "commits=%lu fail=%lu in %.3f s (%.0f frames/s with uploads)\n",
+                stream.size(), (unsigned long)b.link.rx.dec.frames, (unsigned long)b.link.rx.dec.crc_errors,
+                (unsigned long)st.auth_failures, (unsigned long)st.lost_frames, (unsigned long)st.batches,
+                (unsigned long)st.items, (unsigned long)b.uplink.commits, (unsigned long)b.uplink.failures, dt,
+                b.link.rx.dec.frames / dt);
+  server.stop();
+  return (b.uplink.failures == 0U) ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc >= 3 && strcmp(argv[1], "--capture") == 0) {
+    return write_capture(argv[2], (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 10U);
+  }
+  if (argc >= 3 && strcmp(argv[1], "--replay") == 0) {
+    return replay_capture(argv[2], (argc > 3) ? argv[3] : NULL);
+  }
+  uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200000U;
+
+  MockHttp server;
+  CHECK(server.start());
+  Serial.echo = false;   // The bridge logs every record
+  test_end_to_end(server);
+  test_link();
+  test_raw();
+  test_command();
+  test_uplink(server);
+  bench_decode(frames);
+  bench_upload(server, 2000U);
+  Serial.echo = true;
+  server.stop();
+
+  if (g_failures != 0) {
+    printf("test_bridge: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_bridge: OK\n");
+  return 0;
+}
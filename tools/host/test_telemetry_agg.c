@@ -0,0 +1,185 @@
+/* Host test of the bridge's edge summaries (Common/Src/telemetry_agg.c).
+ * Aggregates against a double-precision reference, burst round trips and
+ * the encoded size of a realistic burst against raw and JSON samples.
+ * Usage: test_telemetry_agg
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry_agg.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+static uint32_t g_rng = 0x2468ACE1u;
+
+static uint32_t rng(void)
+{
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 17;
+  g_rng ^= g_rng << 5;
+  return g_rng;
+}
+
+static void test_agg_edges(void)
+{
+  tlm_agg_t agg;
+  tlm_agg_summary_t s;
+
+  TlmAgg_Reset(&agg);
+  TlmAgg_Summarize(&agg, &s);
+  CHECK(s.n == 0 && s.min == 0 && s.max == 0 && s.mean == 0 && s.std == 0);
+
+  TlmAgg_Add(&agg, -314);
+  TlmAgg_Summarize(&agg, &s);
+  CHECK(s.n == 1 && s.min == -314 && s.max == -314 && s.mean == -314 && s.std == 0);
+
+  // Rounding of the mean, both signs
+  TlmAgg_Reset(&agg);
+  TlmAgg_Add(&agg, 1);
+  TlmAgg_Add(&agg, 2);
+  TlmAgg_Summarize(&agg, &s);
+  CHECK(s.mean == 2 && s.std == 0);   // std 0.5, rounded down
+  TlmAgg_Reset(&agg);
+  TlmAgg_Add(&agg, -1);
+  TlmAgg_Add(&agg, -2);
+  TlmAgg_Summarize(&agg, &s);
+  CHECK(s.mean == -2);
+
+  // Extremes over the full count: no overflow in the variance
+  TlmAgg_Reset(&agg);
+  for (uint32_t i = 0; i < TLM_AGG_N_MAX + 10U; i++) TlmAgg_Add(&agg, (i & 1U) ? 32767 : -32768);
+  TlmAgg_Summarize(&agg, &s);
+  CHECK(s.n == TLM_AGG_N_MAX && s.min == -32768 && s.max == 32767);
+  CHECK(s.std == 32767 || s.std == 32768);
+  CHECK(s.mean == 0 || s.mean == -1 || s.mean == 1);
+}
+
+static void test_agg_random(void)
+{
+  for (int round = 0; round < 200; round++) {
+    tlm_agg_t agg;
+    tlm_agg_summary_t s;
+    uint32_t n = 1U + rng() % 2000U;
+    int32_t base = (int32_t)(rng() % 4000U) - 2000;
+    int32_t spread = 1 + (int32_t)(rng() % 300U);
+    double sum = 0.0, sumsq = 0.0;
+    int32_t lo = 32767, hi = -32768;
+
+    TlmAgg_Reset(&agg);
+    for (uint32_t i = 0; i < n; i++) {
+      int32_t v = base + (int32_t)(rng() % (uint32_t)(2 * spread + 1)) - spread;
+      TlmAgg_Add(&agg, v);
+      sum += v;
+      sumsq += (double)v * v;
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+    }
+    TlmAgg_Summarize(&agg, &s);
+    double mean = sum / n;
+    double sd = sqrt(sumsq / n - mean * mean);
+    CHECK(s.n == n && s.min == lo && s.max == hi);
+    CHECK(fabs(s.mean - mean) <= 0.5 + 1e-9);
+    CHECK(s.std <= sd + 1e-6 && sd - s.std < 1.0 + 1e-6);
+  }
+}
+
+static int burst_roundtrip(const int32_t (*samples)[TLM_BURST_FIELDS], uint32_t n, tlm_burst_t *b)
+{
+  int32_t v[TLM_BURST_FIELDS] = { 0 };
+  size_t pos = 0;
+
+  TlmBurst_Init(b);
+  for (uint32_t i = 0; i < n; i++) {
+    if (!TlmBurst_Add(b, samples[i])) return 0;
+  }
+  if (b->count != n) return 0;
+  for (uint32_t i = 0; i < n; i++) {
+    if (!TlmBurst_Next(b->buf, b->len, &pos, v)) return 0;
+    if (memcmp(v, samples[i], sizeof(v)) != 0) return 0;
+  }
+  return !TlmBurst_Next(b->buf, b->len, &pos, v) && pos == b->len;
+}
+
+static void test_burst(void)
+{
+  static tlm_burst_t b;
+  static int32_t samples[TLM_BURST_MAX][TLM_BURST_FIELDS];
+
+  // Extremes and timestamp roll-over
+  const int32_t edge[][TLM_BURST_FIELDS] = {
+    { (int32_t)0xFFFFFC18u, 32767, -32768, 0 },
+    { 1000, -32768, 32767, -1 },
+    { INT32_MIN, INT32_MAX, 0, 1 },
+    { INT32_MAX, INT32_MIN, 0, 0 },
+  };
+  CHECK(burst_roundtrip(edge, 4, &b));
+
+  // Random walks until full
+  for (int round = 0; round < 200; round++) {
+    uint32_t n = 0;
+    int32_t cur[TLM_BURST_FIELDS] = { (int32_t)rng(), 700, 975, 3650 };
+    TlmBurst_Init(&b);
+    for (;;) {
+      cur[0] = (int32_t)((uint32_t)cur[0] + 900U + rng() % 200U);   // Rolls over
+      for (uint32_t k = 1; k < TLM_BURST_FIELDS; k++) cur[k] += (int32_t)(rng() % 41U) - 20;
+      if (!TlmBurst_Add(&b, cur)) break;
+      memcpy(samples[n++], cur, sizeof(cur));
+    }
+    CHECK(b.len <= TLM_BURST_MAX && b.len > TLM_BURST_MAX - TLM_BURST_SAMPLE_MAX);
+    CHECK(burst_roundtrip((const int32_t (*)[TLM_BURST_FIELDS])samples, n, &b));
+  }
+
+  // Truncated data is rejected, not overrun
+  int32_t v[TLM_BURST_FIELDS] = { 0 };
+  size_t pos = 0;
+  const uint8_t cut[] = { 0x80, 0x80 };
+  CHECK(!TlmBurst_Next(cut, sizeof(cut), &pos, v) && pos == 0);
+  const uint8_t longvar[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0, 0, 0 };
+  CHECK(!TlmBurst_Next(longvar, sizeof(longvar), &pos, v));
+}
+
+// A second of vital signs per sample, as the CM4 PPG task produces them
+static void test_burst_size(void)
+{
+  tlm_burst_t b;
+  int32_t cur[TLM_BURST_FIELDS] = { 3600000, 724, 978, 3651 };
+  char json[128];
+  size_t json_bytes = 0;
+
+  TlmBurst_Init(&b);
+  for (;;) {
+    cur[0] += 1000 + (int32_t)(rng() % 5U);
+    cur[1] += (int32_t)(rng() % 21U) - 10;
+    cur[2] += (int32_t)(rng() % 5U) - 2;
+    cur[3] += (int32_t)(rng() % 3U) - 1;
+    if (!TlmBurst_Add(&b, cur)) break;
+    json_bytes += (size_t)snprintf(json, sizeof(json),
+                                   "{\"t\":%ld,\"hr\":%.1f,\"spo2\":%.1f,\"temp\":%.2f},", (long)cur[0],
+                                   cur[1] / 10.0, cur[2] / 10.0, cur[3] / 100.0);
+  }
+  double per = (double)b.len / b.count;
+  printf("burst: %u samples in %u bytes, %.2f B/sample (raw 10, JSON %.1f)\n", (unsigned)b.count,
+         (unsigned)b.len, per, (double)json_bytes / b.count);
+  CHECK(per < 6.0);
+  CHECK(b.count >= 30U);
+}
+
+int main(void)
+{
+  test_agg_edges();
+  test_agg_random();
+  test_burst();
+  test_burst_size();
+
+  if (g_failures != 0) {
+    printf("test_telemetry_agg: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_telemetry_agg: OK\n");
+  return 0;
+}
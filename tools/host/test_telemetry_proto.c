@@ -0,0 +1,419 @@
+/* Host test of the telemetry records, batches and link framing (Common/Src/telemetry_proto.c).
+ * Round trips, COBS edge cases, a corruption fuzz of the stream decoder and
+ * a throughput / size comparison against the former ASCII lines.
+ * Usage: test_telemetry_proto [fuzz iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "telemetry_proto.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+// Former framing: [0xAA 0x55][IV(16)][LEN(2)] in front of the AES-CTR text
+#define ASCII_FRAME_OVERHEAD  (20U)
+
+static uint32_t g_rng = 0x12345678u;
+
+static uint32_t rng(void)
+{
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 17;
+  g_rng ^= g_rng << 5;
+  return g_rng;
+}
+
+// One record of each type, filled as the CM4 telemetry task does
+static size_t make_record(uint8_t type, uint8_t seq, tp_record_t *rec)
+{
+  size_t len = TlmProto_RecordInit(rec, type, seq, 123456u + seq);
+  switch (type) {
+    case TP_REC_PPG:
+      rec->ppg.hr_x10 = TlmProto_ToU16(72.46f, 10.0f);
+      rec->ppg.spo2_x10 = TlmProto_ToU16(97.8f, 10.0f);
+      rec->ppg.ratio_x1000 = TlmProto_ToU16(0.612f, 1000.0f);
+      rec->ppg.pi_x100 = TlmProto_ToU16(512.0f / 41234.0f, 10000.0f);
+      rec->ppg.dc_ir = 41234;
+      rec->ppg.dc_red = 38211;
+      rec->ppg.ac_ir = 512;
+      rec->ppg.ac_red = 402;
+      rec->ppg.peaks = 5;
+      rec->ppg.flags = TP_PPG_FINGER | TP_PPG_HR_VALID;
+      break;
+    case TP_REC_TEMP:
+      rec->temp.celsius_x100 = TlmProto_ToI16(-3.14f, 100.0f);
+      rec->temp.source = TP_TEMP_LM35;
+      rec->temp.raw = 0;  // Zero bytes exercise COBS
+      break;
+    case TP_REC_EVENT:
+      rec->event.event = 1;
+      rec->event.model = 0;
+      rec->event.alert_id = 0x00FF;
+      rec->event.frame = 0xFFFFFFFFu;
+      rec->event.score_x1000 = 873;
+      break;
+    case TP_REC_CONFIG:
+      rec->config.cmd_id = 42;
+      rec->config.status = 0;
+      rec->config.dsp = 2;
+      rec->config.rate_hz = 167;
+      rec->config.pw_us = 400;
+      rec->config.led_ir = 6;
+      rec->config.led_red = 4;
+      rec->config.ai = 1;
+      rec->config.report_ms = 5000;
+      break;
+  }
+  return len;
+}
+
+static void test_crc16(void)
+{
+  // Check value of CRC-16/CCITT-FALSE
+  CHECK(TlmProto_Crc16(0xFFFF, (const uint8_t *)"123456789", 9) == 0x29B1);
+  uint16_t c = TlmProto_Crc16(0xFFFF, (const uint8_t *)"1234", 4);
+  CHECK(TlmProto_Crc16(c, (const uint8_t *)"56789", 5) == 0x29B1);
+}
+
+static void test_fixed_point(void)
+{
+  CHECK(TlmProto_ToU16(72.46f, 10.0f) == 725);
+  CHECK(TlmProto_ToU16(-1.0f, 10.0f) == 0);
+  CHECK(TlmProto_ToU16(1e9f, 1.0f) == 0xFFFF);
+  CHECK(TlmProto_ToI16(-3.14f, 100.0f) == -314);
+  CHECK(TlmProto_ToI16(-1e9f, 1.0f) == -32768);
+  float nan = 0.0f / 0.0f;
+  CHECK(TlmProto_ToU16(nan, 10.0f) == 0);
+  CHECK(TlmProto_ToI16(nan, 10.0f) == 0);
+}
+
+static int cobs_roundtrip(const uint8_t *in, size_t len)
+{
+  static uint8_t enc[TP_COBS_MAX(1024)];
+  static uint8_t dec[1024];
+  size_t n = TlmProto_CobsEncode(in, len, enc);
+  if (n > TP_COBS_MAX(len)) return 0;
+  for (size_t i = 0; i < n; i++) {
+    if (enc[i] == 0) return 0;
+  }
+  // In place, as the stream decoder does it
+  size_t m = TlmProto_CobsDecode(enc, n, enc);
+  memcpy(dec, enc, m);
+  return m == len && memcmp(dec, in, len) == 0;
+}
+
+static void test_cobs_edges(void)
+{
+  static uint8_t buf[1024];
+
+  CHECK(cobs_roundtrip(buf, 0));
+  memset(buf, 0, sizeof(buf));
+  CHECK(cobs_roundtrip(buf, 1));
+  CHECK(cobs_roundtrip(buf, 300));
+  // Runs of non-zero bytes around the 254-byte block limit
+  memset(buf, 0xFF, sizeof(buf));
+  for (size_t len = 250; len <= 260; len++) CHECK(cobs_roundtrip(buf, len));
+  CHECK(cobs_roundtrip(buf, 508));
+  CHECK(cobs_roundtrip(buf, 1024));
+  buf[253] = 0;
+  CHECK(cobs_roundtrip(buf, 254));
+  CHECK(cobs_roundtrip(buf, 255));
+  for (int i = 0; i < 2000; i++) {
+    size_t len = rng() % sizeof(buf);
+    for (size_t k = 0; k < len; k++) buf[k] = (rng() & 3) ? (uint8_t)rng() : 0;
+    CHECK(cobs_roundtrip(buf, len));
+  }
+
+  // Malformed blocks are rejected, not overrun
+  const uint8_t short_block[] = { 5, 1, 2 };
+  CHECK(TlmProto_CobsDecode(short_block, sizeof(short_block), buf) == 0);
+  const uint8_t zero_code[] = { 0, 1 };
+  CHECK(TlmProto_CobsDecode(zero_code, sizeof(zero_code), buf) == 0);
+}
+
+// Body as secure_uart.c builds it, without the cipher: header then plaintext
+static size_t make_body(uint32_t ctr, const uint8_t *data, size_t len, uint8_t *body)
+{
+  tp_seal_hdr_t hdr = { 0xA5A50001u, ctr };
+  memcpy(body, &hdr, sizeof(hdr));
+  memcpy(&body[sizeof(hdr)], data, len);
+  return sizeof(hdr) + len;
+}
+
+static void test_record_roundtrip(void)
+{
+  static const uint8_t types[] = { TP_REC_PPG, TP_REC_TEMP, TP_REC_EVENT, TP_REC_CONFIG };
+  static uint8_t frame[TP_FRAME_MAX(TP_BODY_MAX)];
+  static uint8_t body[TP_BODY_MAX + 1];
+
+  for (size_t t = 0; t < sizeof(types); t++) {
+    tp_record_t rec, out;
+    size_t len = make_record(types[t], (uint8_t)t, &rec);
+    CHECK(len == TlmProto_RecordLen(types[t]));
+
+    size_t blen = make_body(0x01020300u + (uint32_t)t, (const uint8_t *)&rec, len, body);
+    size_t n = TlmProto_FrameEncode(body, blen, frame, sizeof(frame));
+    CHECK(n > 0 && n <= TP_FRAME_MAX(blen));
+    CHECK(frame[n - 1] == TP_FRAME_DELIM);
+
+    tp_decoder_t dec;
+    TlmProto_DecoderInit(&dec);
+    const uint8_t *got_body = NULL;
+    size_t got = 0;
+    for (size_t i = 0; i < n; i++) got = TlmProto_DecoderFeed(&dec, frame[i], &got_body);
+    CHECK(got == blen);
+    tp_seal_hdr_t hdr;
+    memcpy(&hdr, got_body, sizeof(hdr));
+    CHECK(hdr.session == 0xA5A50001u && hdr.ctr == 0x01020300u + (uint32_t)t);
+    CHECK(got == blen && TlmProto_RecordParse(got_body + TP_SEAL_HDR_LEN, got - TP_SEAL_HDR_LEN, &out));
+    CHECK(memcmp(&out, &rec, len) == 0);
+    CHECK(dec.frames == 1 && dec.crc_errors == 0 && dec.bad_frames == 0);
+  }
+
+  // Wrong version, unknown type and wrong length are refused
+  tp_record_t rec, out;
+  size_t len = make_record(TP_REC_PPG, 0, &rec);
+  CHECK(!TlmProto_RecordParse((const uint8_t *)&rec, len - 1, &out));
+  rec.h.version = TP_RECORD_VERSION + 1;
+  CHECK(!TlmProto_RecordParse((const uint8_t *)&rec, len, &out));
+  rec.h.version = TP_RECORD_VERSION;
+  rec.h.type = 0x7F;
+  CHECK(!TlmProto_RecordParse((const uint8_t *)&rec, len, &out));
+
+  // Oversized bodies and short output buffers are refused
+  CHECK(TlmProto_FrameEncode(body, TP_BODY_MAX + 1, frame, sizeof(frame)) == 0);
+  CHECK(TlmProto_FrameEncode(body, len, frame, TP_FRAME_MAX(len) - 1) == 0);
+
+  // A body shorter than the header is not a frame
+  tp_decoder_t dec;
+  TlmProto_DecoderInit(&dec);
+  const uint8_t *got_body = NULL;
+  size_t n = TlmProto_FrameEncode(body, TP_SEAL_HDR_LEN - 1, frame, sizeof(frame));
+  for (size_t i = 0; i < n; i++) CHECK(TlmProto_DecoderFeed(&dec, frame[i], &got_body) == 0);
+  CHECK(dec.bad_frames == 1);
+}
+
+static void test_nonce(void)
+{
+  static const uint8_t expect[TP_NONCE_LEN] = { 0xCA,0xFE,0xBA,0xBE, 0,0,0,0, 0x00,0x00,0x01,0x02 };
+  uint8_t nonce[TP_NONCE_LEN];
+  TlmProto_Nonce(0xCAFEBABEu, 0x0102u, nonce);
+  CHECK(memcmp(nonce, expect, sizeof(nonce)) == 0);
+}
+
+static void test_batch(void)
+{
+  static uint8_t items[200][TP_BATCH_ITEM_MAX];
+  static size_t lens[200];
+  tp_batch_t batch;
+  uint8_t big[TP_BATCH_ITEM_MAX + 1] = { 0 };
+
+  TlmProto_BatchInit(&batch);
+  CHECK(batch.len == TP_BATCH_HDR_LEN && batch.count == 0);
+  CHECK(!TlmProto_BatchAdd(&batch, big, 0));
+  CHECK(!TlmProto_BatchAdd(&batch, big, sizeof(big)));
+  CHECK(TlmProto_BatchAdd(&batch, big, TP_BATCH_ITEM_MAX));   // Largest item fills a batch alone
+  CHECK(batch.len == TP_BATCH_MAX);
+  CHECK(!TlmProto_BatchAdd(&batch, big, 1));
+
+  // Random items until full, then walk them back
+  for (int round = 0; round < 500; round++) {
+    uint32_t n = 0;
+    TlmProto_BatchInit(&batch);
+    for (;;) {
+      lens[n] = 1 + rng() % ((rng() & 1) ? 40 : TP_BATCH_ITEM_MAX);
+      for (size_t k = 0; k < lens[n]; k++) items[n][k] = (uint8_t)rng();
+      if (!TlmProto_BatchAdd(&batch, items[n], lens[n])) break;
+      n++;
+    }
+    CHECK(n > 0 && batch.count == n && batch.buf[1] == n);
+    CHECK(batch.len + 1U + lens[n] > TP_BATCH_MAX);   // Refused only when it really did not fit
+
+    size_t pos = 0, got;
+    const uint8_t *item = NULL;
+    uint32_t i = 0;
+    while ((got = TlmProto_BatchNext(batch.buf, batch.len, &pos, &item)) != 0) {
+      CHECK(i < n && got == lens[i] && memcmp(item, items[i], got) == 0);
+      i++;
+    }
+    CHECK(i == n && pos == batch.len);
+  }
+
+  // Malformed batches stop the walk instead of overrunning
+  size_t pos = 0;
+  const uint8_t *item = NULL;
+  const uint8_t bad_version[] = { TP_BATCH_VERSION + 1, 1, 1, 0x41 };
+  CHECK(TlmProto_BatchNext(bad_version, sizeof(bad_version), &pos, &item) == 0);
+  pos = 0;
+  const uint8_t truncated[] = { TP_BATCH_VERSION, 2, 1, 0x41, 5, 0x42 };
+  CHECK(TlmProto_BatchNext(truncated, sizeof(truncated), &pos, &item) == 1 && item[0] == 0x41);
+  CHECK(TlmProto_BatchNext(truncated, sizeof(truncated), &pos, &item) == 0);
+  pos = 0;
+  const uint8_t zero_len[] = { TP_BATCH_VERSION, 1, 0 };
+  CHECK(TlmProto_BatchNext(zero_len, sizeof(zero_len), &pos, &item) == 0);
+}
+
+// Random stream of frames with bit flips, dropped bytes and inserted noise.
+// The decoder must never crash or overrun, must resynchronise after damage,
+// and every frame it accepts must be one that was sent.
+static void test_fuzz(uint32_t iterations)
+{
+  enum { FRAMES = 64 };
+  static uint8_t bodies[FRAMES][TP_BODY_MAX];
+  static size_t lens[FRAMES];
+  static uint8_t clean[FRAMES * TP_FRAME_MAX(TP_BODY_MAX)];
+  static uint8_t noisy[2 * sizeof(clean)];
+  static size_t starts[FRAMES];
+  uint32_t accepted = 0, wrong = 0, resynced = 0;
+
+  for (uint32_t it = 0; it < iterations; it++) {
+    size_t clen = 0;
+    for (uint32_t f = 0; f < FRAMES; f++) {
+      lens[f] = TP_SEAL_HDR_LEN + rng() % (TP_BODY_MAX - TP_SEAL_HDR_LEN + 1);
+      for (size_t k = 0; k < lens[f]; k++) bodies[f][k] = (rng() & 7) ? (uint8_t)rng() : 0;
+      memcpy(bodies[f], &f, sizeof(f));  // Frame index where the session would be
+      starts[f] = clen;
+      clen += TlmProto_FrameEncode(bodies[f], lens[f], &clean[clen], sizeof(clean) - clen);
+    }
+
+    // Damage the first 3/4 of the stream only; the tail proves resynchronisation
+    size_t damage_end = clen * 3 / 4;
+    size_t nlen = 0;
+    uint32_t rate = 1 + rng() % 200;  // One event per `rate` bytes on average
+    for (size_t i = 0; i < clen; i++) {
+      uint8_t b = clean[i];
+      if (i < damage_end && rng() % rate == 0) {
+        switch (rng() % 4) {
+          case 0: b ^= (uint8_t)(1u << (rng() % 8)); break;   // Bit flip
+          case 1: continue;                                   // Dropped byte
+          case 2: noisy[nlen++] = (uint8_t)rng(); break;      // Inserted noise
+          default: b = (uint8_t)rng(); break;                 // Replaced byte
+        }
+      }
+      noisy[nlen++] = b;
+    }
+
+    tp_decoder_t dec;
+    uint8_t seen[FRAMES] = { 0 };
+    TlmProto_DecoderInit(&dec);
+    for (size_t i = 0; i < nlen; i++) {
+      const uint8_t *body = NULL;
+      uint32_t before = dec.frames;
+      size_t got = TlmProto_DecoderFeed(&dec, noisy[i], &body);
+      CHECK(dec.len <= sizeof(dec.buf));
+      if (dec.frames == before) continue;
+      accepted++;
+      uint32_t f;
+      memcpy(&f, body, sizeof(f));
+      if (f < FRAMES && got == lens[f] && memcmp(body, bodies[f], got) == 0) {
+        seen[f] = 1;
+      } else {
+        wrong++;  // Only a CRC-16 collision gets here; the GCM tag drops it later
+      }
+    }
+
+    // A frame whose leading delimiter is past the damage must come through
+    for (uint32_t f = 1; f < FRAMES; f++) {
+      if (starts[f] <= damage_end) continue;
+      CHECK(seen[f]);
+      resynced++;
+    }
+  }
+
+  printf("fuzz: %u streams, %u frames accepted, %u after damage, %u CRC collisions\n",
+         (unsigned)iterations, (unsigned)accepted, (unsigned)resynced, (unsigned)wrong);
+  // CRC-16 lets ~1/65536 damaged candidates through; stay well under 0.1 %
+  CHECK(wrong * 1000U <= accepted);
+}
+
+static double now_s(void)
+{
+  return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static void test_throughput_and_size(void)
+{
+  enum { N = 200000, PER_BATCH = 4 };
+  static uint8_t frame[TP_FRAME_MAX(TP_BODY_MAX)];
+  static uint8_t body[TP_BODY_MAX];
+  tp_record_t rec;
+  size_t len = make_record(TP_REC_PPG, 0, &rec);
+  size_t blen = make_body(0, (const uint8_t *)&rec, len, body);
+  size_t bytes = 0;
+  uint32_t sink = 0;
+
+  double t0 = now_s();
+  for (uint32_t i = 0; i < N; i++) {
+    body[TP_SEAL_HDR_LEN + 3] = (uint8_t)i;  // Record seq
+    bytes += TlmProto_FrameEncode(body, blen, frame, sizeof(frame));
+    sink += frame[1];
+  }
+  double t_enc = now_s() - t0;
+
+  size_t flen = TlmProto_FrameEncode(body, blen, frame, sizeof(frame));
+  tp_decoder_t dec;
+  TlmProto_DecoderInit(&dec);
+  t0 = now_s();
+  for (uint32_t i = 0; i < N; i++) {
+    for (size_t k = 0; k < flen; k++) {
+      const uint8_t *got;
+      sink += (uint32_t)TlmProto_DecoderFeed(&dec, frame[k], &got);
+    }
+  }
+  double t_dec = now_s() - t0;
+  CHECK(dec.frames == N);
+
+  if (t_enc <= 0.0) t_enc = 1e-9;
+  if (t_dec <= 0.0) t_dec = 1e-9;
+  printf("encode: %.1f MB/s, %.0f frames/s; decode: %.1f MB/s, %.0f frames/s (sink %u)\n",
+         bytes / t_enc / 1e6, N / t_enc, (double)flen * N / t_dec / 1e6, N / t_dec, (unsigned)sink);
+
+  // Sealed frames: one record alone, and PER_BATCH records sharing the header, tag and CRC
+  tp_batch_t batch;
+  TlmProto_BatchInit(&batch);
+  CHECK(TlmProto_BatchAdd(&batch, (const uint8_t *)&rec, len));
+  size_t single = TlmProto_FrameEncode(body, make_body(1, batch.buf, batch.len, body) + TP_SEAL_TAG_LEN,
+                                       frame, sizeof(frame));
+  for (uint32_t i = 1; i < PER_BATCH; i++) CHECK(TlmProto_BatchAdd(&batch, (const uint8_t *)&rec, len));
+  size_t batched = TlmProto_FrameEncode(body, make_body(2, batch.buf, batch.len, body) + TP_SEAL_TAG_LEN,
+                                        frame, sizeof(frame));
+
+  // The same PPG result as the former ASCII line
+  char line[192];
+  int ascii = snprintf(line, sizeof(line),
+                       "HR:72.5bpm SpO2:97.8%% IR(DC:41234 AC:512) RED(DC:38211 AC:402) R:0.612 Pks:5\r\n");
+  size_t ascii_wire = (size_t)ascii + ASCII_FRAME_OVERHEAD;
+  printf("PPG: ASCII %d B payload / %u B on the wire; record %u B, sealed alone %u B, "
+         "%u per batch %.1f B each (%.1fx less than ASCII)\n",
+         ascii, (unsigned)ascii_wire, (unsigned)len, (unsigned)single, (unsigned)PER_BATCH,
+         (double)batched / PER_BATCH, (double)ascii_wire * PER_BATCH / batched);
+  CHECK((size_t)ascii >= 3U * len);
+  CHECK(batched * 10U < single * PER_BATCH * 7U);   // Header, tag and CRC paid once
+  CHECK(ascii_wire * PER_BATCH * 10U >= 25U * batched);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t iterations = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200U;
+
+  test_crc16();
+  test_fixed_point();
+  test_cobs_edges();
+  test_record_roundtrip();
+  test_nonce();
+  test_batch();
+  test_fuzz(iterations);
+  test_throughput_and_size();
+
+  if (g_failures) {
+    printf("test_telemetry_proto: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_telemetry_proto: OK\n");
+  return 0;
+}
@@ -0,0 +1,711 @@
+/* Host test and benchmark of the ESP32 link receiver (Common/Src/telemetry_rx.c)
+ * fed with frames sealed as secure_uart.c does (CM4/Core/Src/aes_gcm.c).
+ * malloc/calloc/realloc are wrapped at link time (see the Makefile) so the
+ * benchmark can count heap allocations per frame; the target is zero.
+ * A byte-level simulation of the UART (rate, bit errors, the ESP32 RX ring
+ * and its pump, RTS/CTS, NACK retransmission from the CM4 history) gives the
+ * sustained throughput and frame loss of each link mode.
+ * Usage: test_telemetry_rx [frames]
+ */
+#define _POSIX_C_SOURCE 199309L   // clock_gettime
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "telemetry_rx.h"
+#include "aes_gcm.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+/*----------------------------------------------------------------------------*/
+// Heap accounting (-Wl,--wrap=...)
+
+// volatile: the compiler assumes malloc() leaves program globals alone
+static volatile unsigned long g_allocs = 0;
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t m, size_t n);
+void *__real_realloc(void *p, size_t n);
+
+void *__wrap_malloc(size_t n)
+{
+  g_allocs++;
+  return __real_malloc(n);
+}
+
+void *__wrap_calloc(size_t m, size_t n)
+{
+  g_allocs++;
+  return __real_calloc(m, n);
+}
+
+void *__wrap_realloc(void *p, size_t n)
+{
+  g_allocs++;
+  return __real_realloc(p, n);
+}
+
+/*----------------------------------------------------------------------------*/
+// Sender: what secure_uart.c does on the CM4
+
+static const uint8_t kKey[16] = { 0x2b,0x7e,0x15,0x16,0x28,0xae,0xd2,0xa6,0xab,0xf7,0x15,0x88,0x09,0xcf,0x4f,0x3c };
+
+typedef struct {
+  aes_gcm_t  gcm;
+  uint8_t    sealed;
+  uint32_t   session;
+  uint32_t   ctr;
+  uint8_t    seq;
+  tp_batch_t batch;
+} sender_t;
+
+static void sender_init(sender_t *tx, uint32_t session, uint8_t sealed)
+{
+  uint8_t nonce[TP_NONCE_LEN];
+
+  memset(tx, 0, sizeof(*tx));
+  tx->sealed = sealed;
+  tx->session = session;
+  tx->ctr = 1;
+  TlmProto_Nonce(session, 0U, nonce);
+  AesGcm_Init(&tx->gcm, kKey, nonce, tx->ctr);
+  TlmProto_BatchInit(&tx->batch);
+}
+
+static void sender_add(sender_t *tx, const void *item, size_t len)
+{
+  CHECK(TlmProto_BatchAdd(&tx->batch, (const uint8_t *)item, len));
+}
+
+static void sender_text(sender_t *tx, const char *s)
+{
+  sender_add(tx, s, strlen(s));
+}
+
+static void sender_ppg(sender_t *tx, uint16_t hr_x10)
+{
+  tp_record_t rec;
+  size_t len = TlmProto_RecordInit(&rec, TP_REC_PPG, tx->seq, 1000u * tx->seq);
+  tx->seq++;
+  rec.ppg.hr_x10 = hr_x10;
+  rec.ppg.spo2_x10 = 978;
+  rec.ppg.pi_x100 = 124;
+  rec.ppg.peaks = 5;
+  sender_add(tx, &rec, len);
+}
+
+static void sender_temp(sender_t *tx, int16_t celsius_x100)
+{
+  tp_record_t rec;
+  size_t len = TlmProto_RecordInit(&rec, TP_REC_TEMP, tx->seq, 1000u * tx->seq);
+  tx->seq++;
+  rec.temp.celsius_x100 = celsius_x100;
+  rec.temp.source = TP_TEMP_LM35;
+  sender_add(tx, &rec, len);
+}
+
+// Seals the batch into a link frame; the counter moves on even if the frame is not sent
+static size_t sender_seal(sender_t *tx, uint8_t *out, size_t cap)
+{
+  uint8_t body[TP_BODY_MAX];
+  tp_seal_hdr_t hdr = { tx->session, tx->ctr };
+  size_t len = TP_SEAL_HDR_LEN + tx->batch.len;
+
+  memcpy(body, &hdr, TP_SEAL_HDR_LEN);
+  memcpy(&body[TP_SEAL_HDR_LEN], tx->batch.buf, tx->batch.len);
+  if (tx->sealed) {
+    AesGcm_Seal(&tx->gcm, tx->ctr, body, TP_SEAL_HDR_LEN, &body[TP_SEAL_HDR_LEN], tx->batch.len, &body[len]);
+    len += TP_SEAL_TAG_LEN;
+  }
+  tx->ctr++;
+  TlmProto_BatchInit(&tx->batch);
+  return TlmProto_FrameEncode(body, len, out, cap);
+}
+
+/*----------------------------------------------------------------------------*/
+// Receiver callbacks
+
+typedef struct {
+  aes_gcm_t gcm;
+  uint8_t   prefix[AES_GCM_PREFIX_LEN];
+  uint8_t   keyed;
+  uint32_t  records;
+  uint32_t  binaries;
+  uint32_t  lines;
+  uint16_t  last_hr_x10;
+  int16_t   last_temp_x100;
+  char      last_line[TLM_RX_LINE_MAX + 1U];
+  size_t    last_line_len;
+  uint64_t  binary_bytes;
+  uint32_t  nack_calls;
+  uint32_t  nack_session;
+  uint32_t  nack_first;
+  uint32_t  nack_count;
+  void     *sim;           // link_sim_t of the simulation, NULL otherwise
+} sink_t;
+
+static void sim_nack(void *sim, uint32_t first, uint32_t count);
+
+// The ESP32 uses mbedtls; here the CM4 implementation, re-keyed per session
+static uint8_t sink_open(void *user, const uint8_t nonce[TP_NONCE_LEN], const uint8_t *aad, size_t aad_len,
+                         const uint8_t *ct, size_t len, const uint8_t tag[TP_SEAL_TAG_LEN], uint8_t *pt)
+{
+  sink_t *s = (sink_t *)user;
+  uint32_t frame = ((uint32_t)nonce[8] << 24) | ((uint32_t)nonce[9] << 16) |
+                   ((uint32_t)nonce[10] << 8) | nonce[11];
+
+  if (!s->keyed || memcmp(s->prefix, nonce, AES_GCM_PREFIX_LEN) != 0) {
+    AesGcm_Init(&s->gcm, kKey, nonce, 0U);
+    memcpy(s->prefix, nonce, AES_GCM_PREFIX_LEN);
+    s->keyed = 1;
+  }
+  memcpy(pt, ct, len);
+  return AesGcm_Open(&s->gcm, frame, aad, aad_len, pt, len, tag);
+}
+
+static void sink_record(void *user, const tp_record_t *rec)
+{
+  sink_t *s = (sink_t *)user;
+  s->records++;
+  if (rec->h.type == TP_REC_PPG) s->last_hr_x10 = rec->ppg.hr_x10;
+  if (rec->h.type == TP_REC_TEMP) s->last_temp_x100 = rec->temp.celsius_x100;
+}
+
+static void sink_binary(void *user, const uint8_t *item, size_t len)
+{
+  sink_t *s = (sink_t *)user;
+  (void)item;
+  s->binaries++;
+  s->binary_bytes += len;
+}
+
+static void sink_line(void *user, const char *line, size_t len)
+{
+  sink_t *s = (sink_t *)user;
+  s->lines++;
+  CHECK(line[len] == '\0' && strlen(line) == len);
+  memcpy(s->last_line, line, len + 1U);
+  s->last_line_len = len;
+}
+
+static void sink_nack(void *user, uint32_t session, uint32_t first, uint8_t count)
+{
+  sink_t *s = (sink_t *)user;
+  s->nack_calls++;
+  s->nack_session = session;
+  s->nack_first = first;
+  s->nack_count = count;
+  if (s->sim != NULL) sim_nack(s->sim, first, count);
+}
+
+static void rx_init(tlm_rx_t *rx, sink_t *sink, uint8_t sealed)
+{
+  const tlm_rx_ops_t ops = { sealed ? sink_open : NULL, sink_record, sink_binary, sink_line, sink_nack, sink };
+  memset(sink, 0, sizeof(*sink));
+  TlmRx_Init(rx, &ops);
+}
+
+/*----------------------------------------------------------------------------*/
+
+static uint8_t g_frame[TP_FRAME_MAX(TP_BODY_MAX)];
+
+static void test_items(uint8_t sealed)
+{
+  static tlm_rx_t rx;
+  sink_t sink;
+  sender_t tx;
+  static const uint8_t load[] = { 0xC5, 1, 4, 0, 0x40, 0x42, 0x0F, 0, 0x10, 0x27, 0x05, 0 };
+
+  rx_init(&rx, &sink, sealed);
+  sender_init(&tx, 0x1234ABCDu, sealed);
+
+  sender_ppg(&tx, 725);
+  sender_temp(&tx, -314);
+  sender_add(&tx, load, sizeof(load));
+  sender_text(&tx, "  TXQ:M4 sess=1234abcd");   // Line continued in the next batch
+  size_t n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  CHECK(TlmRx_Feed(&rx, g_frame, n) == 1U);
+  CHECK(sink.records == 2U && sink.binaries == 1U && sink.lines == 0U);
+  CHECK(sink.last_hr_x10 == 725 && sink.last_temp_x100 == -314);
+
+  sender_text(&tx, " items=12 \t\r\nHEALTH ok\n\n");
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  // Byte by byte, as the UART delivers it
+  for (size_t i = 0; i < n; i++) TlmRx_Feed(&rx, &g_frame[i], 1);
+  CHECK(sink.lines == 2U);
+  CHECK(strcmp(sink.last_line, "HEALTH ok") == 0);
+  CHECK(rx.stats.batches == 2U && rx.stats.items == 5U && rx.stats.lines == 2U);
+  CHECK(rx.stats.session == 0x1234ABCDu && rx.stats.last_ctr == 2U);
+  CHECK(rx.stats.auth_failures == 0U && rx.stats.lost_frames == 0U && rx.stats.lost_records == 0U);
+}
+
+static void test_lines(void)
+{
+  static tlm_rx_t rx;
+  sink_t sink;
+  sender_t tx;
+
+  rx_init(&rx, &sink, 1);
+  sender_init(&tx, 7u, 1);
+  sender_text(&tx, "  TXQ:M4 sess=1234abcd");
+  sender_text(&tx, " items=12 \t\r\n");
+  size_t n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  CHECK(sink.lines == 1U);
+  CHECK(strcmp(sink.last_line, "TXQ:M4 sess=1234abcd items=12") == 0);
+  CHECK(sink.last_line_len == strlen("TXQ:M4 sess=1234abcd items=12"));
+
+  // Longer than the line buffer: cut, delivered, counted
+  static char longline[200];
+  memset(longline, 'x', 200);
+  sender_add(&tx, longline, 200);
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  sender_add(&tx, longline, 100);
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  sender_text(&tx, "\n");
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  CHECK(sink.lines == 2U && sink.last_line_len == TLM_RX_LINE_MAX);
+  CHECK(rx.stats.long_lines == 1U);
+}
+
+static void test_link_errors(void)
+{
+  static tlm_rx_t rx;
+  static uint8_t saved[TP_FRAME_MAX(TP_BODY_MAX)];
+  sink_t sink;
+  sender_t tx;
+
+  rx_init(&rx, &sink, 1);
+  sender_init(&tx, 0xCAFE0001u, 1);
+
+  sender_ppg(&tx, 600);
+  size_t saved_len = sender_seal(&tx, saved, sizeof(saved));
+  TlmRx_Feed(&rx, saved, saved_len);
+  CHECK(rx.stats.batches == 1U);
+
+  // Replayed frame: authentic, but not newer
+  TlmRx_Feed(&rx, saved, saved_len);
+  CHECK(rx.stats.replays == 1U && rx.stats.batches == 1U && sink.records == 1U);
+
+  // Two frames never sent, and a record sequence gap
+  sender_ppg(&tx, 601);
+  sender_seal(&tx, g_frame, sizeof(g_frame));
+  tx.seq += 3;
+  sender_ppg(&tx, 602);
+  sender_seal(&tx, g_frame, sizeof(g_frame));
+  sender_ppg(&tx, 603);
+  size_t n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  CHECK(rx.stats.lost_frames == 2U);
+  CHECK(rx.stats.lost_records == 5U);
+  CHECK(sink.last_hr_x10 == 603);
+
+  // Tampered ciphertext with a valid CRC: the tag catches it
+  {
+    uint8_t body[TP_BODY_MAX];
+    sender_ppg(&tx, 604);
+    n = sender_seal(&tx, g_frame, sizeof(g_frame));
+    size_t len = TlmProto_CobsDecode(g_frame, n - 1U, body) - TP_FRAME_CRC_LEN;
+    body[TP_SEAL_HDR_LEN + 3U] ^= 0x01U;
+    n = TlmProto_FrameEncode(body, len, g_frame, sizeof(g_frame));
+    TlmRx_Feed(&rx, g_frame, n);
+    CHECK(rx.stats.auth_failures == 1U && sink.last_hr_x10 == 603);
+  }
+
+  // Bad record: right tag, unknown version
+  {
+    uint8_t bad[sizeof(tp_ppg_t)] = { TP_RECORD_TAG, 9, TP_REC_PPG };
+    sender_add(&tx, bad, sizeof(bad));
+    n = sender_seal(&tx, g_frame, sizeof(g_frame));
+    TlmRx_Feed(&rx, g_frame, n);
+    CHECK(rx.stats.bad_records == 1U);
+  }
+
+  // Sender reboot: new session, counters start over
+  sender_init(&tx, 0xCAFE0002u, 1);
+  sender_ppg(&tx, 610);
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  CHECK(rx.stats.session == 0xCAFE0002u && rx.stats.last_ctr == 1U);
+  CHECK(sink.last_hr_x10 == 610 && rx.stats.lost_records == 5U);
+
+  // Corrupted bytes on the wire: CRC error, next frame still decodes
+  sender_ppg(&tx, 611);
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  g_frame[n / 2U] ^= 0x40U;
+  TlmRx_Feed(&rx, g_frame, n);
+  sender_ppg(&tx, 612);
+  n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  CHECK(rx.dec.crc_errors + rx.dec.bad_frames == 1U);
+  CHECK(sink.last_hr_x10 == 612 && rx.stats.lost_frames == 4U && rx.stats.lost_records == 6U);
+}
+
+// Gaps are NACKed once; their frames are taken late, once, within the window
+static void test_retransmit(void)
+{
+  static tlm_rx_t rx;
+  static uint8_t frames[6][TP_FRAME_MAX(TP_BODY_MAX)];
+  size_t len[6];
+  sink_t sink;
+  sender_t tx;
+
+  rx_init(&rx, &sink, 1);
+  sender_init(&tx, 0xBEEF0001u, 1);
+  for (uint32_t i = 1; i <= 5; i++) {
+    sender_ppg(&tx, (uint16_t)(700U + i));
+    len[i] = sender_seal(&tx, frames[i], sizeof(frames[i]));
+  }
+
+  TlmRx_Feed(&rx, frames[1], len[1]);
+  TlmRx_Feed(&rx, frames[4], len[4]);
+  CHECK(sink.nack_calls == 1U && sink.nack_session == 0xBEEF0001u);
+  CHECK(sink.nack_first == 2U && sink.nack_count == 2U);
+  CHECK(rx.stats.lost_frames == 2U && rx.stats.lost_records == 2U && rx.stats.nacks == 1U);
+
+  // Sent again, in any order: late records still count, and are no longer lost
+  TlmRx_Feed(&rx, frames[3], len[3]);
+  CHECK(rx.stats.recovered == 1U && sink.last_hr_x10 == 703 && rx.stats.lost_records == 1U);
+  TlmRx_Feed(&rx, frames[3], len[3]);
+  CHECK(rx.stats.replays == 1U && rx.stats.recovered == 1U);
+  TlmRx_Feed(&rx, frames[2], len[2]);
+  CHECK(rx.stats.recovered == 2U && rx.stats.lost_records == 0U && sink.records == 4U);
+  TlmRx_Feed(&rx, frames[5], len[5]);
+  CHECK(rx.stats.last_ctr == 5U && rx.stats.lost_records == 0U && sink.nack_calls == 1U);
+  CHECK(rx.stats.batches == 5U && sink.records == 5U);
+
+  // A gap wider than the window: only its newest TLM_RX_WINDOW - 1 frames are asked for
+  uint8_t first_frame[TP_FRAME_MAX(TP_BODY_MAX)];
+  size_t first_len = 0;
+  const uint32_t last = 6U + TLM_RX_WINDOW + 8U;
+  for (uint32_t i = 6; i < last; i++) {
+    sender_ppg(&tx, 800);
+    size_t n = sender_seal(&tx, g_frame, sizeof(g_frame));
+    if (i == 6) {
+      memcpy(first_frame, g_frame, n);
+      first_len = n;
+    }
+  }
+  sender_ppg(&tx, 846);
+  size_t n = sender_seal(&tx, g_frame, sizeof(g_frame));
+  TlmRx_Feed(&rx, g_frame, n);
+  CHECK(sink.nack_calls == 2U && sink.nack_count == TLM_RX_WINDOW - 1U);
+  CHECK(sink.nack_first == last - (TLM_RX_WINDOW - 1U));
+  CHECK(rx.stats.lost_frames == 2U + (last - 6U));
+  TlmRx_Feed(&rx, first_frame, first_len);   // Too old
+  CHECK(rx.stats.replays == 2U && rx.stats.recovered == 2U);
+}
+
+/*----------------------------------------------------------------------------*/
+// Link simulation, one UART byte at a time:
+//   CM4: saturating sender, batches of binary items (raw PPG blocks), history
+//        of SIM_RETX_LEN frames served ahead of new ones (secure_uart.c)
+//   wire: 10 bits per byte, independent bit errors
+//   ESP32: UART FIFO + RX ring, emptied into TlmRx_Feed() every SIM_PUMP_US
+//        (I/O task), with a SIM_STALL_US stall once a second (a slow log
+//        line, a flash write); RTS holds the CM4 when both are full,
+//        otherwise bytes are dropped. NACKs reach the CM4 after their own
+//        wire time and SIM_SERVICE_US (telemetry task).
+
+#define SIM_RETX_LEN     (32U)      // SECURE_UART_RETX_LEN
+#define SIM_RING         (4096U + 100U)  // PFA2.ino UART_RX_BUFFER + RTS threshold in the FIFO
+#define SIM_PUMP_US      (10000U)   // SENSOR_UPDATE_PERIOD_MS
+#define SIM_STALL_US     (50000U)
+#define SIM_SERVICE_US   (1000U)
+#define SIM_ITEM_LEN     (80U)      // 16 IR + 16 red samples, 16-bit, + header
+#define SIM_ITEMS        (3U)       // Per batch: 3 x 81 + 2 = 245 of TP_BATCH_MAX
+#define SIM_NACK_MAX     (64U)
+
+typedef struct {
+  uint32_t baud;
+  double   ber;
+  uint8_t  rtscts;
+  uint8_t  retx;
+} link_cfg_t;
+
+typedef struct {
+  const link_cfg_t *cfg;
+  uint64_t t_ns;
+  uint32_t byte_ns;
+  // NACKs in flight to the CM4: arrival time, range
+  uint64_t nack_at[SIM_NACK_MAX];
+  uint32_t nack_first[SIM_NACK_MAX];
+  uint32_t nack_count[SIM_NACK_MAX];
+  uint32_t nack_n;
+  uint32_t nacks_dropped;
+  double   p_byte;         // A byte is hit if any of its 10 bits is
+} link_sim_t;
+
+static double sim_rand(void)
+{
+  static uint64_t x = 0x9E3779B97F4A7C15ULL;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return (double)(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void sim_nack(void *sim, uint32_t first, uint32_t count)
+{
+  link_sim_t *ls = (link_sim_t *)sim;
+  if (!ls->cfg->retx) return;
+  if (ls->nack_n == SIM_NACK_MAX) {
+    ls->nacks_dropped++;
+    return;
+  }
+  // tp_link_t frame plus TP_LINK_PREAMBLE on the wire, then the telemetry task
+  uint32_t wire = TP_LINK_PREAMBLE + TP_FRAME_MAX(sizeof(tp_link_t));
+  for (uint32_t i = 0; i < wire; i++) {
+    if (sim_rand() < ls->p_byte) {
+      ls->nacks_dropped++;   // Fails the CRC on the CM4
+      return;
+    }
+  }
+  ls->nack_at[ls->nack_n] = ls->t_ns + (uint64_t)wire * ls->byte_ns + SIM_SERVICE_US * 1000ULL;
+  ls->nack_first[ls->nack_n] = first;
+  ls->nack_count[ls->nack_n] = count;
+  ls->nack_n++;
+}
+
+static void link_sim(const link_cfg_t *cfg, double seconds, double *goodput, double *loss)
+{
+  static tlm_rx_t rx;
+  static sink_t sink;
+  static sender_t tx;
+  static link_sim_t ls;
+  static uint8_t hist[SIM_RETX_LEN][TP_FRAME_MAX(TP_BODY_MAX)];
+  static uint32_t hist_ctr[SIM_RETX_LEN];
+  static size_t hist_len[SIM_RETX_LEN];
+  static uint8_t ring[SIM_RING];
+  static uint8_t chunk[SIM_RING];
+  static uint32_t retx_queue[SIM_NACK_MAX * TLM_RX_WINDOW];
+  uint8_t item[SIM_ITEM_LEN];
+  uint32_t ring_head = 0, ring_count = 0, retx_n = 0, retx_pos = 0;
+  uint32_t sealed = 0, resent = 0, expired = 0, overflow = 0, corrupted = 0, held = 0;
+  const uint8_t *cur = NULL;
+  size_t cur_len = 0, cur_pos = 0;
+  uint64_t end_ns = (uint64_t)(seconds * 1e9);
+  uint64_t next_pump = SIM_PUMP_US * 1000ULL;
+  uint64_t next_stall = 1000000000ULL;
+
+  memset(&ls, 0, sizeof(ls));
+  ls.cfg = cfg;
+  ls.p_byte = 1.0;
+  for (uint32_t i = 0; i < 10U; i++) ls.p_byte *= 1.0 - cfg->ber;
+  ls.p_byte = 1.0 - ls.p_byte;
+  ls.byte_ns = (uint32_t)(10.0e9 / cfg->baud + 0.5);
+  rx_init(&rx, &sink, 1);
+  sink.sim = &ls;
+  sender_init(&tx, 0x51A10000u + cfg->baud, 1);
+  memset(hist_ctr, 0, sizeof(hist_ctr));
+  memset(item, 0x5A, sizeof(item));
+  item[0] = 0x90;   // Binary item
+
+  // Sends for `seconds`, then drains: the tail frames get their NACK round trip
+  for (;;) {
+    uint8_t sending = (ls.t_ns < end_ns);
+    if (!sending && cur == NULL && retx_pos == retx_n && ls.nack_n == 0U && ring_count == 0U) break;
+
+    if (ls.t_ns >= next_pump) {
+      uint64_t pump_at = next_pump;
+      next_pump += SIM_PUMP_US * 1000ULL;
+      if (pump_at >= next_stall) {
+        next_stall += 1000000000ULL;
+        next_pump += SIM_STALL_US * 1000ULL;
+      }
+      uint32_t n = 0;
+      while (ring_count > 0U) {
+        chunk[n++] = ring[ring_head];
+        ring_head = (ring_head + 1U) % SIM_RING;
+        ring_count--;
+      }
+      if (n > 0U) TlmRx_Feed(&rx, chunk, n);
+    }
+
+    // NACKs that reached the CM4 join the retransmit queue
+    for (uint32_t i = 0; i < ls.nack_n;) {
+      if (ls.nack_at[i] > ls.t_ns) {
+        i++;
+        continue;
+      }
+      for (uint32_t k = 0; k < ls.nack_count[i] && retx_n < sizeof(retx_queue) / sizeof(retx_queue[0]); k++) {
+        retx_queue[retx_n++] = ls.nack_first[i] + k;
+      }
+      ls.nack_n--;
+      ls.nack_at[i] = ls.nack_at[ls.nack_n];
+      ls.nack_first[i] = ls.nack_first[ls.nack_n];
+      ls.nack_count[i] = ls.nack_count[ls.nack_n];
+    }
+
+    if (cur == NULL) {
+      while (cur == NULL && retx_pos < retx_n) {
+        uint32_t ctr = retx_queue[retx_pos++];
+        uint32_t slot = ctr % SIM_RETX_LEN;
+        if (hist_ctr[slot] == ctr) {
+          cur = hist[slot];
+          cur_len = hist_len[slot];
+          resent++;
+        } else {
+          expired++;
+        }
+      }
+      if (retx_pos == retx_n) retx_pos = retx_n = 0;
+      if (cur == NULL && sending) {
+        uint32_t slot = tx.ctr % SIM_RETX_LEN;
+        for (uint32_t i = 0; i < SIM_ITEMS; i++) sender_add(&tx, item, sizeof(item));
+        hist_ctr[slot] = tx.ctr;
+        hist_len[slot] = sender_seal(&tx, hist[slot], sizeof(hist[slot]));
+        cur = hist[slot];
+        cur_len = hist_len[slot];
+        sealed++;
+      }
+      cur_pos = 0;
+    }
+
+    if (cur != NULL) {
+      if (ring_count >= SIM_RING && cfg->rtscts) {
+        held++;   // CTS deasserted: the byte waits
+      } else {
+        uint8_t b = cur[cur_pos++];
+        if (sim_rand() < ls.p_byte) {
+          b ^= (uint8_t)(1U << (uint32_t)(sim_rand() * 8.0));
+          corrupted++;
+        }
+        if (ring_count < SIM_RING) {
+          ring[(ring_head + ring_count) % SIM_RING] = b;
+          ring_count++;
+        } else {
+          overflow++;
+        }
+        if (cur_pos == cur_len) cur = NULL;
+      }
+    }
+    ls.t_ns += ls.byte_ns;
+  }
+
+  uint32_t lost = sealed - rx.stats.batches;
+  *goodput = (double)sink.binary_bytes / seconds;
+  *loss = (sealed != 0U) ? (double)lost / sealed : 0.0;
+  printf("%7lu baud %-7s %-4s ber %-6.0e %7.1f kB/s payload (%4.1f %% of the wire) frames %6lu "
+         "crc %4lu nack %4lu resent %4lu expired %3lu lost %4lu (%.3f %%)%s\n",
+         (unsigned long)cfg->baud, cfg->rtscts ? "RTS/CTS" : "-", cfg->retx ? "NACK" : "-", cfg->ber,
+         *goodput / 1e3, 100.0 * *goodput / (cfg->baud / 10.0), (unsigned long)sealed,
+         (unsigned long)(rx.dec.crc_errors + rx.dec.bad_frames + rx.stats.auth_failures),
+         (unsigned long)rx.stats.nacks, (unsigned long)resent, (unsigned long)expired, (unsigned long)lost,
+         100.0 * *loss, overflow ? " (RX ring overflows)" : "");
+  (void)corrupted;
+  (void)held;
+  CHECK(rx.stats.batches + lost == sealed);
+}
+
+static void test_link_modes(void)
+{
+  static const link_cfg_t base = { 115200U, 0.0, 0, 0 };
+  static const link_cfg_t fast_noflow = { 2000000U, 0.0, 0, 0 };
+  static const link_cfg_t fast_flow = { 2000000U, 0.0, 1, 0 };
+  static const link_cfg_t fast_noisy = { 2000000U, 1e-6, 1, 0 };
+  static const link_cfg_t fast_nack = { 2000000U, 1e-6, 1, 1 };
+  static const link_cfg_t fast_bad = { 2000000U, 1e-5, 1, 1 };
+  static const link_cfg_t max_nack = { 4000000U, 1e-6, 1, 1 };
+  double goodput, loss;
+
+  link_sim(&base, 10.0, &goodput, &loss);
+  CHECK(loss == 0.0 && goodput > 0.8 * 11520.0);
+  link_sim(&fast_noflow, 10.0, &goodput, &loss);
+  CHECK(loss > 0.0);   // The stall overflows the ring
+  link_sim(&fast_flow, 10.0, &goodput, &loss);
+  CHECK(loss == 0.0 && goodput > 150000.0);
+  link_sim(&fast_noisy, 10.0, &goodput, &loss);
+  link_sim(&fast_nack, 10.0, &goodput, &loss);
+  CHECK(loss == 0.0);
+  link_sim(&fast_bad, 10.0, &goodput, &loss);
+  CHECK(loss < 0.001);
+  link_sim(&max_nack, 10.0, &goodput, &loss);
+  CHECK(loss == 0.0);
+}
+
+/*----------------------------------------------------------------------------*/
+// Benchmark: a stream of typical batches (PPG, temperature, load frame, TXQ line)
+
+#define BENCH_DISTINCT  (64U)
+
+static double now_s(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void bench(uint8_t sealed, uint32_t frames)
+{
+  static tlm_rx_t rx;
+  static uint8_t stream[BENCH_DISTINCT * TP_FRAME_MAX(TP_BODY_MAX)];
+  static const uint8_t load[] = { 0xC5, 1, 4, 1, 0x40, 0x42, 0x0F, 0, 0x10, 0x27, 0x05, 0,
+                                  'T', 'l', 'm', ' ', 0x34, 0x01, 'I', 'D', 'L', 'E', 0x10, 0x27 };
+  sink_t sink;
+  sender_t tx;
+  size_t stream_len = 0;
+
+  sender_init(&tx, 0x5EED0000u + sealed, sealed);
+  for (uint32_t i = 0; i < BENCH_DISTINCT; i++) {
+    sender_ppg(&tx, (uint16_t)(600U + i));
+    sender_temp(&tx, (int16_t)(3650 + i));
+    sender_add(&tx, load, sizeof(load));
+    sender_text(&tx, "TXQ:M4 sess=5eed0001 items=4 queued=0 dropped=0 busy=0\n");
+    stream_len += sender_seal(&tx, &stream[stream_len], sizeof(stream) - stream_len);
+  }
+
+  rx_init(&rx, &sink, sealed);
+  uint32_t rounds = (frames + BENCH_DISTINCT - 1U) / BENCH_DISTINCT;
+  uint32_t accepted = 0;
+  unsigned long allocs = g_allocs;
+  double t0 = now_s();
+  for (uint32_t r = 0; r < rounds; r++) {
+    // Same frames again under a new session, so none is taken for a replay
+    rx.stats.session = ~tx.session;
+    accepted += TlmRx_Feed(&rx, stream, stream_len);
+  }
+  double dt = now_s() - t0;
+  allocs = g_allocs - allocs;
+
+  CHECK(accepted == rounds * BENCH_DISTINCT);
+  CHECK(sink.records == 2U * accepted && sink.lines == accepted && sink.binaries == accepted);
+  CHECK(allocs == 0UL);
+  printf("%-8s %6.1f B/frame %12.0f frames/s %8.1f MB/s %6.2f allocs/frame\n",
+         sealed ? "AES-GCM" : "clear", (double)stream_len / BENCH_DISTINCT, accepted / dt,
+         (double)stream_len * rounds / dt / 1e6, (double)allocs / accepted);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t frames = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 200000U;
+
+  // The wrapper sees allocations made from this program
+  unsigned long before = g_allocs;
+  void *volatile p = malloc(16);
+  free(p);
+  CHECK(g_allocs == before + 1UL);
+
+  test_items(1);
+  test_items(0);
+  test_lines();
+  test_link_errors();
+  test_retransmit();
+  bench(0, frames);
+  bench(1, frames);
+  test_link_modes();
+
+  if (g_failures != 0) {
+    printf("test_telemetry_rx: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_telemetry_rx: OK\n");
+  return 0;
+}
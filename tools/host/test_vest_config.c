@@ -0,0 +1,183 @@
+/* Host test of the CFG command channel (Common/Src/vest_config.c).
+ * Line assembly over a noisy stream, parser accept/reject cases, merge rules
+ * and a Format -> Parse round trip over every setting.
+ * Usage: test_vest_config
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vest_config.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+// Feeds a byte string, returns the number of lines that came out; keeps the last
+static unsigned feed(vest_line_t *line, const char *data, size_t len, char *last, size_t size)
+{
+  unsigned lines = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (VestCfg_LineFeed(line, (uint8_t)data[i]) != 0U) {
+      snprintf(last, size, "%s", line->buf);
+      lines++;
+    }
+  }
+  return lines;
+}
+
+static void test_lines(void)
+{
+  vest_line_t line;
+  char last[VEST_CMD_LINE_MAX + 1U];
+  static const char stream[] = "\n\nHR=072,SPO2=098\n\x00\x05\x0a\xC8\x01\x00\n\nCFG 7 AI=0\r\n";
+
+  VestCfg_LineInit(&line);
+  // The bridge's report line, a link frame with a LF inside, then a command
+  unsigned n = feed(&line, stream, sizeof(stream) - 1U, last, sizeof(last));
+  CHECK(n == 3);
+  CHECK(strcmp(last, "CFG 7 AI=0") == 0);
+
+  // A 0x00 delimiter drops what came before it
+  n = feed(&line, "CFG 9\x00" "CFG 10\n", 13, last, sizeof(last));
+  CHECK(n == 1 && strcmp(last, "CFG 10") == 0);
+
+  // An over-long line is dropped whole, the next one is intact
+  char big[VEST_CMD_LINE_MAX + 20U];
+  memset(big, 'A', sizeof(big));
+  big[sizeof(big) - 1U] = '\n';
+  n = feed(&line, big, sizeof(big), last, sizeof(last));
+  CHECK(n == 0);
+  n = feed(&line, "CFG 11\n", 7, last, sizeof(last));
+  CHECK(n == 1 && strcmp(last, "CFG 11") == 0);
+}
+
+static void test_parse(void)
+{
+  vest_cmd_t cmd;
+
+  CHECK(VestCfg_Parse("HR=072,SPO2=098", &cmd) == -1);
+  CHECK(VestCfg_Parse("CFGX 1", &cmd) == -1);
+  CHECK(VestCfg_Parse("TRC?", &cmd) == -1);
+
+  CHECK(VestCfg_Parse("CFG 12", &cmd) == VEST_CFG_OK);
+  CHECK(cmd.id == 12 && cmd.set == 0);
+
+  CHECK(VestCfg_Parse("CFG 65535 RATE=200 PW=400 LED_IR=24 LED_RED=11.0 REPORT=5000 DSP=HR AI=0", &cmd) == VEST_CFG_OK);
+  CHECK(cmd.id == 65535);
+  CHECK(cmd.set == (VEST_CFG_F_RATE | VEST_CFG_F_PW | VEST_CFG_F_LED_IR | VEST_CFG_F_LED_RED |
+                    VEST_CFG_F_REPORT | VEST_CFG_F_DSP | VEST_CFG_F_AI));
+  CHECK(cmd.v.rate_hz == 200 && cmd.v.pw_us == 400 && cmd.v.led_ir == 7 && cmd.v.led_red == 3);
+  CHECK(cmd.v.report_ms == 5000 && cmd.v.dsp == VEST_DSP_HR && cmd.v.ai == 0);
+
+  // LED currents round down to a step
+  CHECK(VestCfg_Parse("CFG 1 LED_IR=20.7 LED_RED=50", &cmd) == VEST_CFG_OK);
+  CHECK(cmd.v.led_ir == 5 && cmd.v.led_red == 15);
+  CHECK(VestCfg_Parse("CFG 1 LED_IR=0", &cmd) == VEST_CFG_OK && cmd.v.led_ir == 0);
+
+  // Syntax errors keep the id when it was readable
+  CHECK(VestCfg_Parse("CFG", &cmd) == VEST_CFG_ERR_SYNTAX && cmd.id == 0);
+  CHECK(VestCfg_Parse("CFG 0", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG 70000", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG x", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG 3 FOO=1", &cmd) == VEST_CFG_ERR_SYNTAX && cmd.id == 3 && cmd.set == 0);
+  CHECK(VestCfg_Parse("CFG 3 RATE=", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG 3 RATE=1x0", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG 3 DSP=SPO", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG 3 LED_IR=1.", &cmd) == VEST_CFG_ERR_SYNTAX);
+  CHECK(VestCfg_Parse("CFG 3 REPORT=99999999999", &cmd) == VEST_CFG_ERR_SYNTAX);
+
+  CHECK(VestCfg_Parse("CFG 4 RATE=400", &cmd) == VEST_CFG_ERR_RANGE && cmd.id == 4);
+  CHECK(VestCfg_Parse("CFG 4 PW=300", &cmd) == VEST_CFG_ERR_RANGE);
+  CHECK(VestCfg_Parse("CFG 4 LED_RED=50.1", &cmd) == VEST_CFG_ERR_RANGE);
+  CHECK(VestCfg_Parse("CFG 4 REPORT=999", &cmd) == VEST_CFG_ERR_RANGE);
+  CHECK(VestCfg_Parse("CFG 4 REPORT=600001", &cmd) == VEST_CFG_ERR_RANGE);
+  CHECK(VestCfg_Parse("CFG 4 AI=2", &cmd) == VEST_CFG_ERR_RANGE);
+  CHECK(VestCfg_Parse("CFG 4 REPORT=0", &cmd) == VEST_CFG_OK && cmd.v.report_ms == 0);
+}
+
+static void test_merge(void)
+{
+  vest_config_t cur, out;
+  vest_cmd_t cmd;
+
+  VestCfg_Defaults(&cur);
+  CHECK(VestCfg_RateCode(cur.rate_hz) == 1 && VestCfg_PulseWidthCode(cur.pw_us) == 3);
+  CHECK(VestCfg_LedTenthsMa(cur.led_ir) == 208 && VestCfg_LedTenthsMa(16) == 0);
+
+  // 1600 us does not fit 200 Hz, alone or after a rate change
+  CHECK(VestCfg_Parse("CFG 5 RATE=200", &cmd) == VEST_CFG_OK);
+  memset(&out, 0xA5, sizeof(out));
+  CHECK(VestCfg_Merge(&cur, &cmd, &out) == VEST_CFG_ERR_COMBO);
+  CHECK(out.rate_hz == 0xA5A5);
+
+  CHECK(VestCfg_Parse("CFG 6 RATE=200 PW=800", &cmd) == VEST_CFG_OK);
+  CHECK(VestCfg_Merge(&cur, &cmd, &out) == VEST_CFG_OK);
+  CHECK(out.rate_hz == 200 && out.pw_us == 800 && out.led_ir == cur.led_ir && out.ai == 1);
+
+  // A query changes nothing
+  CHECK(VestCfg_Parse("CFG 8", &cmd) == VEST_CFG_OK);
+  CHECK(VestCfg_Merge(&cur, &cmd, &out) == VEST_CFG_OK && memcmp(&out, &cur, sizeof(cur)) == 0);
+}
+
+static void test_format_roundtrip(void)
+{
+  static const uint16_t rates[] = { 50, 100, 167, 200 };
+  static const uint16_t widths[] = { 200, 400, 800, 1600 };
+  static const uint32_t reports[] = { 0, 1000, 600000 };
+  char text[160];
+  char line[200];
+  unsigned checked = 0;
+
+  for (size_t r = 0; r < 4; r++) {
+    for (size_t w = 0; w < 4; w++) {
+      for (uint8_t led = 0; led < 16; led++) {
+        vest_config_t cfg, out;
+        vest_cmd_t cmd;
+
+        VestCfg_Defaults(&cfg);
+        cfg.rate_hz = rates[r];
+        cfg.pw_us = widths[w];
+        cfg.led_ir = led;
+        cfg.led_red = (uint8_t)(15U - led);
+        cfg.dsp = (uint8_t)(led % 3U);
+        cfg.ai = (uint8_t)(led & 1U);
+        cfg.report_ms = reports[led % 3U];
+        if (cfg.pw_us == 1600U && cfg.rate_hz > 100U) continue;
+
+        size_t n = VestCfg_Format(&cfg, text, sizeof(text));
+        CHECK(n > 0 && n < VEST_CMD_LINE_MAX - 10U);
+        snprintf(line, sizeof(line), "CFG 99 %s", text);
+        CHECK(VestCfg_Parse(line, &cmd) == VEST_CFG_OK);
+        vest_config_t other;
+        memset(&other, 0, sizeof(other));
+        CHECK(VestCfg_Merge(&other, &cmd, &out) == VEST_CFG_OK);
+        CHECK(memcmp(&out, &cfg, sizeof(cfg)) == 0);
+        checked++;
+      }
+    }
+  }
+  CHECK(checked == 14U * 16U);
+
+  // Truncation stays terminated
+  vest_config_t cfg;
+  VestCfg_Defaults(&cfg);
+  CHECK(VestCfg_Format(&cfg, text, 8) == 7 && strlen(text) == 7);
+  CHECK(strcmp(VestCfg_StatusName(VEST_CFG_ERR_COMBO), "COMBO") == 0);
+}
+
+int main(void)
+{
+  test_lines();
+  test_parse();
+  test_merge();
+  test_format_roundtrip();
+
+  if (g_failures) {
+    printf("test_vest_config: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_vest_config: OK\n");
+  return 0;
+}
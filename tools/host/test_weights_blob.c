@@ -0,0 +1,192 @@
+/* Host test of the weights blob loader (Common/Src/weights_blob.c).
+ * Usage: test_weights_blob [blob produced by tools/pack_weights.py]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "weights_blob.h"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); g_failures++; } \
+  } while (0)
+
+static void wr_le32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+// Same layout as tools/pack_weights.py
+static uint32_t build_blob(uint8_t *out, const char *name, uint32_t version,
+                           const uint8_t *payload, uint32_t size)
+{
+  memset(out, 0, WBLOB_HEADER_SIZE);
+  wr_le32(&out[0], WBLOB_MAGIC);
+  out[4] = WBLOB_FORMAT_VERSION; out[5] = 0;
+  out[6] = WBLOB_HEADER_SIZE; out[7] = 0;
+  strncpy((char *)&out[8], name, WBLOB_NAME_LEN - 1);
+  wr_le32(&out[24], version);
+  wr_le32(&out[28], size);
+  wr_le32(&out[32], WBlob_Crc32(0, payload, size));
+  wr_le32(&out[44], WBlob_Crc32(0, out, WBLOB_HEADER_SIZE - 4));
+  memcpy(&out[WBLOB_HEADER_SIZE], payload, size);
+  return WBLOB_HEADER_SIZE + size;
+}
+
+// Feeds a stream in chunks of `chunk` bytes.
+// Returns WBLOB_OK once a blob completes, else the first error seen.
+static wblob_status_t feed_chunks(wblob_loader_t *ld, const uint8_t *data, uint32_t len, uint32_t chunk)
+{
+  wblob_status_t first = WBLOB_IN_PROGRESS;
+  for (uint32_t off = 0; off < len; off += chunk) {
+    uint32_t n = (len - off < chunk) ? len - off : chunk;
+    wblob_status_t st = WBlob_LoaderFeed(ld, &data[off], n);
+    if (st == WBLOB_OK) return st;
+    if (st != WBLOB_IN_PROGRESS && first == WBLOB_IN_PROGRESS) first = st;
+  }
+  return first;
+}
+
+static void test_crc32(void)
+{
+  // Standard check value of CRC-32/ISO-HDLC
+  CHECK(WBlob_Crc32(0, (const uint8_t *)"123456789", 9) == 0xCBF43926u);
+  // Incremental update matches one-shot
+  uint32_t c = WBlob_Crc32(0, (const uint8_t *)"1234", 4);
+  CHECK(WBlob_Crc32(c, (const uint8_t *)"56789", 5) == 0xCBF43926u);
+}
+
+static void test_roundtrip_every_chunk_size(void)
+{
+  uint8_t payload[2948];
+  static uint8_t blob[WBLOB_HEADER_SIZE + sizeof(payload)];
+  static uint8_t slot[4096];
+  for (uint32_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 37u + 11u);
+  uint32_t len = build_blob(blob, "athlet", 7, payload, sizeof(payload));
+
+  const uint32_t chunks[] = { 1, 3, 47, 48, 49, 512, len };
+  for (uint32_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+    wblob_loader_t ld;
+    WBlob_LoaderInit(&ld, slot, sizeof(slot));
+    CHECK(feed_chunks(&ld, blob, len, chunks[c]) == WBLOB_OK);
+    CHECK(ld.received == len);
+
+    wblob_header_t hdr;
+    CHECK(WBlob_Validate(slot, ld.received, &hdr) == WBLOB_OK);
+    CHECK(strcmp(hdr.model_name, "athlet") == 0);
+    CHECK(hdr.model_version == 7);
+    CHECK(hdr.payload_size == sizeof(payload));
+    CHECK(memcmp(WBlob_Payload(slot), payload, sizeof(payload)) == 0);
+
+    // Done until reset: the slot is not overwritten by later traffic
+    CHECK(WBlob_LoaderFeed(&ld, blob, 4) == WBLOB_ERR_BUSY);
+  }
+}
+
+static void test_skips_leading_traffic(void)
+{
+  uint8_t payload[64];
+  uint8_t stream[512];
+  uint8_t slot[256];
+  memset(payload, 0x5A, sizeof(payload));
+
+  // Line traffic and a partial magic before the real blob
+  const char *noise = "HR=072,SPO2=098\nAIW";
+  uint32_t n = (uint32_t)strlen(noise);
+  memcpy(stream, noise, n);
+  n += build_blob(&stream[n], "athlet", 1, payload, sizeof(payload));
+
+  wblob_loader_t ld;
+  WBlob_LoaderInit(&ld, slot, sizeof(slot));
+  CHECK(feed_chunks(&ld, stream, n, 1) == WBLOB_OK);
+  CHECK(WBlob_Validate(slot, ld.received, NULL) == WBLOB_OK);
+}
+
+static void test_rejects_corruption(void)
+{
+  uint8_t payload[128];
+  uint8_t blob[WBLOB_HEADER_SIZE + sizeof(payload)];
+  uint8_t slot[512];
+  for (uint32_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)i;
+  uint32_t len = build_blob(blob, "athlet", 2, payload, sizeof(payload));
+  wblob_loader_t ld;
+
+  // Payload bit flip
+  blob[WBLOB_HEADER_SIZE + 10] ^= 0x01;
+  WBlob_LoaderInit(&ld, slot, sizeof(slot));
+  CHECK(feed_chunks(&ld, blob, len, 16) == WBLOB_ERR_PAYLOAD_CRC);
+  CHECK(ld.errors == 1 && ld.state == WBLOB_RX_HUNT);
+  CHECK(WBlob_Validate(blob, len, NULL) == WBLOB_ERR_PAYLOAD_CRC);
+  blob[WBLOB_HEADER_SIZE + 10] ^= 0x01;
+
+  // Header bit flip (model version)
+  blob[24] ^= 0x80;
+  WBlob_LoaderInit(&ld, slot, sizeof(slot));
+  CHECK(feed_chunks(&ld, blob, len, len) == WBLOB_ERR_HEADER_CRC);
+  CHECK(WBlob_Validate(blob, len, NULL) == WBLOB_ERR_HEADER_CRC);
+  blob[24] ^= 0x80;
+
+  // Unknown format version
+  blob[4] = 2;
+  wr_le32(&blob[44], WBlob_Crc32(0, blob, WBLOB_HEADER_SIZE - 4));
+  CHECK(WBlob_Validate(blob, len, NULL) == WBLOB_ERR_VERSION);
+  blob[4] = WBLOB_FORMAT_VERSION;
+  wr_le32(&blob[44], WBlob_Crc32(0, blob, WBLOB_HEADER_SIZE - 4));
+
+  // Slot too small
+  WBlob_LoaderInit(&ld, slot, WBLOB_HEADER_SIZE + 64);
+  CHECK(feed_chunks(&ld, blob, len, 1) == WBLOB_ERR_TOO_LARGE);
+
+  // Truncated in memory
+  CHECK(WBlob_Validate(blob, len - 1, NULL) == WBLOB_ERR_TRUNCATED);
+
+  // A good blob right after a bad one is still accepted
+  static uint8_t two[2 * sizeof(blob)];
+  memcpy(two, blob, len);
+  two[WBLOB_HEADER_SIZE] ^= 0xFF;
+  memcpy(&two[len], blob, len);
+  WBlob_LoaderInit(&ld, slot, sizeof(slot));
+  CHECK(feed_chunks(&ld, two, 2 * len, 1) == WBLOB_OK);
+  CHECK(ld.errors == 1);
+  CHECK(memcmp(WBlob_Payload(slot), payload, sizeof(payload)) == 0);
+}
+
+static void test_packer_output(const char *path)
+{
+  static uint8_t file[64 * 1024];
+  static uint8_t slot[64 * 1024];
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    printf("FAIL cannot open %s\n", path);
+    g_failures++;
+    return;
+  }
+  uint32_t len = (uint32_t)fread(file, 1, sizeof(file), f);
+  fclose(f);
+
+  wblob_loader_t ld;
+  WBlob_LoaderInit(&ld, slot, sizeof(slot));
+  CHECK(feed_chunks(&ld, file, len, 64) == WBLOB_OK);
+
+  wblob_header_t hdr;
+  CHECK(WBlob_Validate(slot, ld.received, &hdr) == WBLOB_OK);
+  printf("packer blob: %s v%u, %u bytes of weights\n",
+         hdr.model_name, (unsigned)hdr.model_version, (unsigned)hdr.payload_size);
+}
+
+int main(int argc, char **argv)
+{
+  test_crc32();
+  test_roundtrip_every_chunk_size();
+  test_skips_leading_traffic();
+  test_rejects_corruption();
+  if (argc > 1) test_packer_output(argv[1]);
+
+  if (g_failures) {
+    printf("test_weights_blob: %d failure(s)\n", g_failures);
+    return 1;
+  }
+  printf("test_weights_blob: OK\n");
+  return 0;
+}
@@ -0,0 +1,241 @@
+"""Simulate a squad of vests uploading to an ingestion endpoint and measure it.
+
+Each vest is a thread with its own kept-alive HTTP connection, like the
+bridge's, sending on a fixed schedule (open loop) what PFA2.ino sends:
+
+    commit      Firestore documents:commit of --batch history reports (a
+                journal drain uploads up to 20), the newest one also updating
+                the user document; with --burst-every, burst documents too
+    telemetry   one POST /telemetry per report (ingestionUrl)
+    mqtt        one tp_ppg_t record per send on pfa/<vest>/ppg at QoS 1 (mqttUrl),
+                to --broker; latency runs to the PUBACK
+
+Latency is measured from the scheduled send time, so a server that falls
+behind shows up in the percentiles instead of silently slowing the senders.
+Run against tools/ingest_server.py:
+
+    python3 tools/ingest_server.py --store /tmp/ingest.jsonl &
+    python3 tools/ingest_load.py --vests 50 --interval 1 --duration 30
+
+or against tools/mqtt_broker.py, with tools/mqtt_gateway.py forwarding to it.
+"""
+import argparse
+import base64
+import http.client
+import json
+import math
+import random
+import struct
+import sys
+import threading
+import time
+from urllib.parse import urlsplit
+
+from mqtt_broker import PUBACK, ProtocolError
+from mqtt_gateway import PPG, MqttClient
+
+AGG_FMT = '<hhhHH'   # tlm_agg_summary_t, see tools/ingest_server.py
+
+
+def firestore_fields(values):
+    return {k: {'integerValue': str(v)} if isinstance(v, int) else
+            {'bytesValue': v.decode()} if isinstance(v, bytes) else
+            {'doubleValue': round(v, 2)} for k, v in values.items()}
+
+
+def burst_bytes(rng, n):
+    """n samples as the bridge's TlmBurst_Add() encodes them"""
+    out, prev, cur = bytearray(), [0, 0, 0, 0], [rng.randrange(1 << 31), 720, 975, 3650]
+    for _ in range(n):
+        cur = [cur[0] + 1000, cur[1] + rng.randint(-10, 10), cur[2] + rng.randint(-2, 2), cur[3] + rng.randint(-1, 1)]
+        for i in range(4):
+            d = (cur[i] - prev[i]) & 0xFFFFFFFF
+            z = ((d << 1) ^ (0xFFFFFFFF if d & 0x80000000 else 0)) & 0xFFFFFFFF
+            while z >= 0x80:
+                out.append((z & 0x7F) | 0x80)
+                z >>= 7
+            out.append(z)
+        prev = cur
+    return bytes(out)
+
+
+class Vest:
+    def __init__(self, index, args):
+        self.id = f'vest{index:03d}'
+        self.boot = random.getrandbits(32)
+        self.seq = 0
+        self.rng = random.Random(index)
+        self.args = args
+        url = urlsplit(args.url)
+        self.host, self.port = url.hostname, url.port or 80
+        self.base = url.path.rstrip('/')
+        self.conn = None
+        self.mqtt = None
+        self.results = []      # (scheduled, sent, done, error or None, reports)
+        self.late = 0
+
+    def report(self):
+        r = self.rng
+        hr = [r.randint(600, 1800) for _ in range(30)]
+        spo2 = [r.randint(940, 1000) for _ in range(30)]
+        temp = [r.randint(3600, 3900) for _ in range(30)]
+        agg = b''.join(struct.pack(AGG_FMT, min(v), max(v), sum(v) // len(v), 25, len(v)) for v in (hr, spo2, temp))
+        self.seq += 1
+        return self.seq, {'hr': float((sum(hr) // 30 + 5) // 10), 'spo2': float((sum(spo2) // 30 + 5) // 10),
+                          'temp': sum(temp) / 3000.0}, base64.b64encode(agg)
+
+    def commit_body(self, burst):
+        user = f'projects/{self.args.project}/databases/(default)/documents/users/{self.id}'
+        writes = []
+        for i in range(self.args.batch):
+            seq, values, agg = self.report()
+            fields = firestore_fields(dict(values, uptimeMs=seq * 30000, agg=agg))
+            writes.append({'update': {'name': f'{user}/history/{self.boot:08x}-{seq}', 'fields': fields},
+                           'updateTransforms': [{'fieldPath': 'receivedAt', 'setToServerValue': 'REQUEST_TIME'}]})
+            if i == self.args.batch - 1:
+                writes.append({'update': {'name': user, 'fields': firestore_fields(values)},
+                               'updateMask': {'fieldPaths': list(values)}})
+        if burst:
+            samples = base64.b64encode(burst_bytes(self.rng, 35))
+            writes.append({'update': {'name': f'{user}/bursts/{self.boot:08x}-{self.seq}-0',
+                                      'fields': firestore_fields({'alertId': self.seq, 'chunk': 0, 'n': 35,
+                                                                  'samples': samples})}})
+        path = f'{self.base}/v1/projects/{self.args.project}/databases/(default)/documents:commit'
+        return path, {}, writes, self.args.batch
+
+    def telemetry_body(self):
+        seq, values, _ = self.report()
+        return f'{self.base}/telemetry', {'X-Vest-Id': self.id}, dict(values, timestamp=seq * 30), 1
+
+    def ppg_record(self):
+        r = self.rng
+        self.seq += 1
+        return struct.pack(PPG, 0xC7, 1, 1, self.seq & 0xFF, self.seq * 1000, r.randint(600, 1800),
+                           r.randint(940, 1000), 520, r.randint(150, 400), 41000, 39000, 300, 250, 2, 3)
+
+    def publish(self, leaf, payload):
+        """QoS 1, waits for the PUBACK"""
+        for attempt in range(2):
+            try:
+                if self.mqtt is None:
+                    self.mqtt = MqttClient(self.args.broker, self.id, keepalive=60, timeout=self.args.timeout)
+                    self.mqtt.connect(will=(f'pfa/{self.id}/status', b'offline', True))
+                pid = self.mqtt.publish(f'pfa/{self.id}/{leaf}', payload)
+                while True:
+                    got = self.mqtt.read()
+                    if got is None:
+                        raise TimeoutError('no PUBACK')
+                    if got[0] >> 4 == PUBACK and struct.unpack('>H', got[1])[0] == pid:
+                        return None
+            except (OSError, ConnectionError, ProtocolError) as err:
+                self.mqtt.close(graceful=False)
+                self.mqtt = None
+                if attempt == 1:
+                    return type(err).__name__
+        return 'unreachable'
+
+    def request(self, path, headers, body):
+        data = json.dumps({'writes': body} if isinstance(body, list) else body).encode()
+        for attempt in range(2):   # Once more on a fresh connection, as the bridge does
+            try:
+                if self.conn is None:
+                    self.conn = http.client.HTTPConnection(self.host, self.port, timeout=self.args.timeout)
+                self.conn.request('POST', path, data, dict(headers, **{'Content-Type': 'application/json'}))
+                resp = self.conn.getresponse()
+                resp.read()
+                return (None if resp.status == 200 else f'http {resp.status}')
+            except (OSError, http.client.HTTPException) as err:
+                self.conn.close()
+                self.conn = None
+                if attempt == 1:
+                    return type(err).__name__
+        return 'unreachable'
+
+    def run(self, start, stop):
+        period = self.args.interval
+        t = start + self.rng.random() * period   # Vests are not in phase
+        n = 0
+        while t < stop:
+            now = time.monotonic()
+            if t > now:
+                time.sleep(t - now)
+            else:
+                self.late += 1
+            n += 1
+            burst = self.args.burst_every and n % self.args.burst_every == 0
+            if self.args.format == 'mqtt':
+                sent = time.monotonic()
+                error = self.publish('ppg', self.ppg_record())
+                if burst and error is None:
+                    error = self.publish('burst', struct.pack('<IHHH', self.boot, n, 0, 35) + burst_bytes(self.rng, 35))
+                reports = 1
+            else:
+                if self.args.format == 'commit':
+                    path, headers, body, reports = self.commit_body(burst)
+                else:
+                    path, headers, body, reports = self.telemetry_body()
+                sent = time.monotonic()
+                error = self.request(path, headers, body)
+            self.results.append((t, sent, time.monotonic(), error, reports))
+            t += period
+        if self.conn is not None:
+            self.conn.close()
+        if self.mqtt is not None:
+            self.mqtt.close()
+
+
+def percentile(sorted_values, p):
+    """Nearest rank"""
+    if not sorted_values:
+        return float('nan')
+    return sorted_values[max(0, math.ceil(p / 100.0 * len(sorted_values)) - 1)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--url', default='http://127.0.0.1:8080', help='ingestion server base URL')
+    parser.add_argument('--format', choices=('commit', 'telemetry', 'mqtt'), default='commit')
+    parser.add_argument('--broker', default='mqtt://127.0.0.1:1883', help='MQTT broker URL (--format mqtt)')
+    parser.add_argument('--vests', type=int, default=40)
+    parser.add_argument('--interval', type=float, default=30.0, help='seconds between uploads per vest')
+    parser.add_argument('--batch', type=int, default=1, help='reports per commit (journal drain: up to 20)')
+    parser.add_argument('--burst-every', type=int, default=0, help='add a burst to every Nth commit')
+    parser.add_argument('--duration', type=float, default=60.0, help='seconds')
+    parser.add_argument('--timeout', type=float, default=5.0, help='per request, as FS_HTTP_TIMEOUT_MS')
+    parser.add_argument('--project', default='trackervest-4e4f4')
+    args = parser.parse_args()
+
+    vests = [Vest(i, args) for i in range(args.vests)]
+    start = time.monotonic() + 0.2
+    stop = start + args.duration
+    threads = [threading.Thread(target=v.run, args=(start, stop), daemon=True) for v in vests]
+    for th in threads:
+        th.start()
+    for th in threads:
+        th.join()
+    elapsed = max([r[2] for v in vests for r in v.results] + [stop]) - start
+
+    results = [r for v in vests for r in v.results]
+    ok = [r for r in results if r[3] is None]
+    errors = {}
+    for r in results:
+        if r[3] is not None:
+            errors[r[3]] = errors.get(r[3], 0) + 1
+    latency = sorted((r[2] - r[0]) * 1e3 for r in ok)
+    service = sorted((r[2] - r[1]) * 1e3 for r in ok)
+    reports = sum(r[4] for r in ok)
+
+    print(f"{args.vests} vests, {args.format}, batch {args.batch}, every {args.interval:g} s, {elapsed:.1f} s")
+    print(f"requests  {len(results)} sent, {len(ok)} ok, {len(results) - len(ok)} failed "
+          f"({100.0 * (len(results) - len(ok)) / max(1, len(results)):.2f} %)"
+          + (f": {', '.join(f'{k} x{v}' for k, v in sorted(errors.items()))}" if errors else ''))
+    print(f"throughput {len(ok) / elapsed:.1f} req/s, {reports / elapsed:.1f} reports/s")
+    print(f"latency   p50 {percentile(latency, 50):.1f} ms  p99 {percentile(latency, 99):.1f} ms  "
+          f"max {latency[-1] if latency else float('nan'):.1f} ms  (from scheduled send)")
+    print(f"service   p50 {percentile(service, 50):.1f} ms  p99 {percentile(service, 99):.1f} ms")
+    print(f"late sends {sum(v.late for v in vests)} (sender behind schedule)")
+    return 0 if len(ok) == len(results) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,223 @@
+"""Local stand-in for the vest telemetry backend, writing to an append-only store.
+
+Accepts what the ESP32 bridge (PFA2.ino) sends:
+
+    POST /telemetry                      {hr, spo2, temp, timestamp}, one report
+                                         (ingestionUrl; the vest id comes from X-Vest-Id)
+    POST .../documents:commit            Firestore REST commit, the bridge's batch
+                                         format: history reports, user fields, bursts
+
+Every accepted document becomes one JSON line in the store, with the server
+receive time, the document path and its fields as plain values; the `agg`
+summaries and delta-encoded burst `samples` are decoded (Common/Inc/telemetry_agg.h).
+A single writer thread appends and flushes; requests are acknowledged only
+once their lines are written (and fsynced with --fsync), several requests
+sharing one write.
+
+    GET /stats                           counters as JSON
+"""
+import argparse
+import base64
+import json
+import os
+import queue
+import struct
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+AGG_FMT = '<hhhHH'                      # tlm_agg_summary_t: min, max, mean, std, n
+AGG_SIZE = struct.calcsize(AGG_FMT)
+AGG_METRICS = ('hr', 'spo2', 'temp')    # JournalRecord order, x10, x10, x100
+BURST_FIELDS = ('ts_ms', 'hr_x10', 'spo2_x10', 'celsius_x100')
+MAX_BODY = 1 << 20
+
+
+def decode_agg(raw):
+    """Three tlm_agg_summary_t, as the bridge's `agg` bytesValue"""
+    if len(raw) != AGG_SIZE * len(AGG_METRICS):
+        raise ValueError(f"agg is {len(raw)} bytes")
+    out = {}
+    for i, name in enumerate(AGG_METRICS):
+        mn, mx, mean, std, n = struct.unpack_from(AGG_FMT, raw, i * AGG_SIZE)
+        out[name] = {'min': mn, 'max': mx, 'mean': mean, 'std': std, 'n': n}
+    return out
+
+
+def decode_burst(raw):
+    """Zigzag varint deltas, TLM_BURST_FIELDS per sample, first sample relative to 0"""
+    samples, cur, pos = [], [0] * len(BURST_FIELDS), 0
+    while pos < len(raw):
+        for i in range(len(BURST_FIELDS)):
+            z = shift = 0
+            while True:
+                if pos >= len(raw) or shift > 28:
+                    raise ValueError('truncated burst')
+                b = raw[pos]
+                pos += 1
+                z |= (b & 0x7F) << shift
+                shift += 7
+                if not b & 0x80:
+                    break
+            d = (z >> 1) ^ -(z & 1)
+            v = (cur[i] + d) & 0xFFFFFFFF
+            cur[i] = v - (1 << 32) if v & 0x80000000 else v
+        samples.append(dict(zip(BURST_FIELDS, cur)))
+    return samples
+
+
+def plain_value(name, value):
+    """Firestore typed value -> JSON value"""
+    (kind, v), = value.items()
+    if kind == 'doubleValue':
+        return float(v)
+    if kind == 'integerValue':
+        return int(v)
+    if kind == 'bytesValue':
+        raw = base64.b64decode(v)
+        if name == 'agg':
+            return decode_agg(raw)
+        if name == 'samples':
+            return decode_burst(raw)
+        return v
+    if kind in ('stringValue', 'timestampValue', 'booleanValue'):
+        return v
+    raise ValueError(f"unsupported value type {kind}")
+
+
+def commit_documents(body):
+    """documents:commit -> [(path, fields)]"""
+    docs = []
+    for write in body['writes']:
+        update = write['update']
+        path = update['name'].split('/documents/', 1)[-1]
+        fields = {k: plain_value(k, v) for k, v in update.get('fields', {}).items()}
+        docs.append((path, fields))
+    return docs
+
+
+class Store:
+    """Append-only JSON lines, one writer thread, group commit"""
+
+    def __init__(self, path, fsync):
+        self.file = open(path, 'a', encoding='utf-8')
+        self.fsync = fsync
+        self.pending = queue.Queue()
+        self.lock = threading.Lock()
+        self.stats = {'requests': 0, 'documents': 0, 'bytes': 0, 'errors': 0, 'writes': 0}
+        threading.Thread(target=self._writer, daemon=True).start()
+
+    def append(self, lines):
+        done = threading.Event()
+        self.pending.put((lines, done))
+        done.wait()
+
+    def count(self, **delta):
+        with self.lock:
+            for k, v in delta.items():
+                self.stats[k] += v
+
+    def _writer(self):
+        while True:
+            batch = [self.pending.get()]
+            while True:
+                try:
+                    batch.append(self.pending.get_nowait())
+                except queue.Empty:
+                    break
+            data = ''.join(line for lines, _ in batch for line in lines)
+            self.file.write(data)
+            self.file.flush()
+            if self.fsync:
+                os.fsync(self.file.fileno())
+            self.count(writes=1, bytes=len(data))
+            for _, done in batch:
+                done.set()
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'   # Keep-alive, as the bridge reuses its connection
+    disable_nagle_algorithm = True  # Headers and body go out separately: no delayed-ACK stall
+    store = None
+    quiet = True
+
+    def log_message(self, fmt, *args):
+        if not self.quiet:
+            super().log_message(fmt, *args)
+
+    def reply(self, code, obj):
+        data = json.dumps(obj).encode()
+        self.send_response(code)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def do_GET(self):
+        if self.path != '/stats':
+            self.reply(404, {'error': 'not found'})
+            return
+        with self.store.lock:
+            stats = dict(self.store.stats)
+        self.reply(200, stats)
+
+    def do_POST(self):
+        length = int(self.headers.get('Content-Length', 0))
+        if length <= 0 or length > MAX_BODY:
+            self.store.count(requests=1, errors=1)
+            self.reply(413 if length > MAX_BODY else 411, {'error': 'bad length'})
+            return
+        raw = self.rfile.read(length)
+        now = time.time()
+        try:
+            body = json.loads(raw)
+            if self.path.split('?', 1)[0].endswith('documents:commit'):
+                docs = commit_documents(body)
+            elif self.path == '/telemetry':
+                vest = self.headers.get('X-Vest-Id', self.client_address[0])
+                docs = [(f'telemetry/{vest}', {k: body[k] for k in ('hr', 'spo2', 'temp', 'timestamp')})]
+            else:
+                self.store.count(requests=1, errors=1)
+                self.reply(404, {'error': 'not found'})
+                return
+        except (ValueError, KeyError, TypeError, AttributeError) as err:
+            self.store.count(requests=1, errors=1)
+            self.reply(400, {'error': str(err)})
+            return
+
+        self.store.append([json.dumps({'t': now, 'path': p, 'fields': f}, separators=(',', ':')) + '\n'
+                           for p, f in docs])
+        self.store.count(requests=1, documents=len(docs))
+        stamp = time.strftime('%Y-%m-%dT%H:%M:%S', time.gmtime(now)) + f'.{int(now % 1 * 1e6):06d}Z'
+        if self.path == '/telemetry':
+            self.reply(200, {'ok': True})
+        else:
+            self.reply(200, {'writeResults': [{'updateTime': stamp} for _ in docs], 'commitTime': stamp})
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=8080)
+    parser.add_argument('--store', default='ingest.jsonl', help='append-only JSON lines file')
+    parser.add_argument('--fsync', action='store_true', help='fsync before acknowledging')
+    parser.add_argument('--verbose', action='store_true', help='log every request')
+    args = parser.parse_args()
+
+    Handler.store = Store(args.store, args.fsync)
+    Handler.quiet = not args.verbose
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    print(f"ingest: http://{args.host}:{args.port} -> {args.store}{' (fsync)' if args.fsync else ''}",
+          file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(f"ingest: {Handler.store.stats}", file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
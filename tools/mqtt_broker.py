@@ -0,0 +1,366 @@
+"""Local stand-in for an MQTT 3.1.1 broker (Mosquitto-like), for the vests and the gateway.
+
+Standard library only. It covers what the bridge (PFA2.ino, Common/Src/mqtt_client.c)
+and tools/mqtt_gateway.py use:
+
+    CONNECT         clean or persistent sessions, will message, keep-alive
+    PUBLISH         QoS 0 and 1 (PUBACK once routed), retained messages
+    SUBSCRIBE       + and # wildcards, granted QoS up to 1; UNSUBSCRIBE
+    PINGREQ, DISCONNECT
+
+QoS-1 messages for a persistent session are queued while its client is away
+(up to --queue per session, the oldest dropped beyond) and, with those still
+unacknowledged, delivered again with DUP set when it reconnects. At most
+--inflight are unacknowledged per client. QoS 2 is refused (the connection
+is closed). With --certfile and --keyfile the broker listens with TLS (mqtts).
+
+The packet helpers below are shared with tools/mqtt_gateway.py.
+"""
+import argparse
+import asyncio
+import collections
+import itertools
+import ssl
+import struct
+import sys
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, UNSUBSCRIBE, UNSUBACK = 8, 9, 10, 11
+PINGREQ, PINGRESP, DISCONNECT = 12, 13, 14
+
+
+class ProtocolError(Exception):
+    pass
+
+
+def packet(first, body=b''):
+    """Fixed header (type << 4 | flags) and remaining length, then body"""
+    n, out = len(body), bytearray([first])
+    while True:
+        b, n = n & 0x7F, n >> 7
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out) + body
+
+
+def mqtt_str(s):
+    b = s.encode() if isinstance(s, str) else s
+    return struct.pack('>H', len(b)) + b
+
+
+def publish_packet(topic, payload, qos=0, retain=False, dup=False, pid=0):
+    first = PUBLISH << 4 | (0x08 if dup else 0) | qos << 1 | (1 if retain else 0)
+    return packet(first, mqtt_str(topic) + (struct.pack('>H', pid) if qos else b'') + payload)
+
+
+def parse_publish(first, body):
+    """-> topic, payload, qos, retain, dup, pid"""
+    qos = (first >> 1) & 3
+    if qos > 1:
+        raise ProtocolError('QoS 2 is not supported')
+    tl = struct.unpack_from('>H', body)[0]
+    topic = body[2:2 + tl].decode()
+    pos = 2 + tl
+    pid = 0
+    if qos:
+        pid = struct.unpack_from('>H', body, pos)[0]
+        pos += 2
+    return topic, body[pos:], qos, bool(first & 1), bool(first & 0x08), pid
+
+
+def remaining_length(read_byte):
+    n = 0
+    for i in range(4):
+        b = read_byte()
+        n |= (b & 0x7F) << (7 * i)
+        if not b & 0x80:
+            return n
+    raise ProtocolError('remaining length over 4 bytes')
+
+
+def topic_matches(flt, topic):
+    f, t = flt.split('/'), topic.split('/')
+    if topic.startswith('$') and f[0] in ('+', '#'):
+        return False
+    for i, part in enumerate(f):
+        if part == '#':
+            return True
+        if i >= len(t) or (part != '+' and part != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+class Session:
+    def __init__(self, cid, persistent):
+        self.cid = cid
+        self.persistent = persistent
+        self.subs = {}                              # filter -> granted QoS
+        self.queue = collections.deque()            # (topic, payload, retain) waiting for a free slot
+        self.inflight = collections.OrderedDict()   # pid -> (topic, payload, retain), sent, not acked
+        self.pids = itertools.count(1)
+        self.conn = None
+
+    def next_pid(self):
+        while True:
+            pid = next(self.pids) % 0x10000
+            if pid and pid not in self.inflight:
+                return pid
+
+
+class Broker:
+    def __init__(self, args):
+        self.args = args
+        self.sessions = {}
+        self.retained = {}
+        self.anon = itertools.count(1)
+        self.stats = collections.Counter()
+
+    # Delivery -----------------------------------------------------------
+    def deliver(self, s, topic, payload, qos, retain=False):
+        if qos == 0:
+            if s.conn is not None:
+                s.conn.send(publish_packet(topic, payload, 0, retain))
+                self.stats['delivered'] += 1
+            return
+        if s.conn is not None and len(s.inflight) < self.args.inflight and not s.queue:
+            self.send_qos1(s, topic, payload, retain)
+        elif s.conn is not None or s.persistent:
+            if len(s.queue) >= self.args.queue:
+                s.queue.popleft()
+                self.stats['dropped'] += 1
+            s.queue.append((topic, payload, retain))
+            self.stats['queued'] += 1
+
+    def send_qos1(self, s, topic, payload, retain, dup=False, pid=None):
+        if pid is None:
+            pid = s.next_pid()
+            s.inflight[pid] = (topic, payload, retain)
+        s.conn.send(publish_packet(topic, payload, 1, retain, dup, pid))
+        self.stats['redelivered' if dup else 'delivered'] += 1
+
+    def drain(self, s):
+        while s.conn is not None and s.queue and len(s.inflight) < self.args.inflight:
+            self.send_qos1(s, *s.queue.popleft())
+
+    def route(self, topic, payload, qos, retain):
+        self.stats['published'] += 1
+        if retain:
+            if payload:
+                self.retained[topic] = (payload, qos)
+            else:
+                self.retained.pop(topic, None)
+        for s in list(self.sessions.values()):
+            granted = [q for f, q in s.subs.items() if topic_matches(f, topic)]
+            if granted:
+                self.deliver(s, topic, payload, min(qos, max(granted)))
+
+    # Connections --------------------------------------------------------
+    async def handle(self, reader, writer):
+        conn = Connection(self, reader, writer)
+        self.stats['connections'] += 1
+        try:
+            await conn.run()
+        except (ProtocolError, ValueError, UnicodeDecodeError, struct.error) as err:
+            self.stats['protocol_errors'] += 1
+            if self.args.verbose:
+                print(f"broker: {conn.cid or writer.get_extra_info('peername')}: {err}", file=sys.stderr)
+        except (asyncio.IncompleteReadError, ConnectionError, asyncio.TimeoutError, ssl.SSLError):
+            pass
+        finally:
+            conn.close()
+
+    async def report(self, period):
+        while True:
+            await asyncio.sleep(period)
+            online = sum(1 for s in self.sessions.values() if s.conn is not None)
+            print(f"broker: {online}/{len(self.sessions)} sessions online, {dict(self.stats)}", file=sys.stderr)
+
+
+class Connection:
+    def __init__(self, broker, reader, writer):
+        self.broker = broker
+        self.reader = reader
+        self.writer = writer
+        self.session = None
+        self.cid = None
+        self.will = None
+        self.graceful = False
+
+    def send(self, data):
+        if not self.writer.is_closing():
+            self.writer.write(data)
+
+    async def read_packet(self, timeout):
+        head = await asyncio.wait_for(self.reader.readexactly(1), timeout)
+        buf = bytearray()
+        for _ in range(4):
+            b = (await self.reader.readexactly(1))[0]
+            buf.append(b)
+            if not b & 0x80:
+                break
+        n = remaining_length(iter(buf).__next__)
+        return head[0], (await self.reader.readexactly(n)) if n else b''
+
+    async def run(self):
+        first, body = await self.read_packet(10.0)
+        if first >> 4 != CONNECT:
+            raise ProtocolError('first packet is not CONNECT')
+        keepalive = self.connect(body)
+        if self.session is None:
+            return
+        b = self.broker
+        timeout = keepalive * 1.5 if keepalive else None
+        while True:
+            first, body = await self.read_packet(timeout)
+            kind = first >> 4
+            if kind == PUBLISH:
+                topic, payload, qos, retain, _, pid = parse_publish(first, body)
+                if '+' in topic or '#' in topic:
+                    raise ProtocolError('wildcard in a PUBLISH topic')
+                b.route(topic, payload, qos, retain)
+                if qos:
+                    self.send(packet(PUBACK << 4, struct.pack('>H', pid)))
+            elif kind == PUBACK:
+                pid = struct.unpack('>H', body)[0]
+                if self.session.inflight.pop(pid, None) is not None:
+                    b.stats['acked'] += 1
+                b.drain(self.session)
+            elif kind == SUBSCRIBE:
+                self.subscribe(body)
+            elif kind == UNSUBSCRIBE:
+                pid, pos = struct.unpack_from('>H', body)[0], 2
+                while pos < len(body):
+                    n = struct.unpack_from('>H', body, pos)[0]
+                    self.session.subs.pop(body[pos + 2:pos + 2 + n].decode(), None)
+                    pos += 2 + n
+                self.send(packet(UNSUBACK << 4, struct.pack('>H', pid)))
+            elif kind == PINGREQ:
+                self.send(packet(PINGRESP << 4))
+            elif kind == DISCONNECT:
+                self.graceful = True
+                return
+            else:
+                raise ProtocolError(f'unexpected packet type {kind}')
+            await self.writer.drain()
+
+    def connect(self, body):
+        b = self.broker
+        pos = 2 + struct.unpack_from('>H', body)[0]
+        name, level, flags, keepalive = body[2:pos], body[pos], body[pos + 1], struct.unpack_from('>H', body, pos + 2)[0]
+        pos += 4
+        if name != b'MQTT' or level != 4:
+            self.send(packet(CONNACK << 4, b'\x00\x01'))   # Unacceptable protocol version
+            return 0
+
+        def field():
+            nonlocal pos
+            n = struct.unpack_from('>H', body, pos)[0]
+            pos += 2 + n
+            return body[pos - n:pos]
+
+        cid = field().decode()
+        clean = bool(flags & 0x02)
+        if flags & 0x04:
+            self.will = (field().decode(), field(), (flags >> 3) & 3, bool(flags & 0x20))
+        if not cid:
+            if not clean:
+                self.send(packet(CONNACK << 4, b'\x00\x02'))   # Identifier rejected
+                return 0
+            cid = f'anon-{next(b.anon)}'
+        self.cid = cid
+
+        old = b.sessions.get(cid)
+        if old is not None and old.conn is not None:
+            old.conn.will = None          # Taken over: no will
+            old.conn.writer.close()
+            old.conn = None
+        present = not clean and old is not None
+        if not present:
+            old = Session(cid, not clean)
+            b.sessions[cid] = old
+        self.session = old
+        old.conn = self
+        self.send(packet(CONNACK << 4, bytes([1 if present else 0, 0])))
+
+        # Unacknowledged first, as they were, then what queued while away
+        for pid, (topic, payload, retain) in list(old.inflight.items()):
+            b.send_qos1(old, topic, payload, retain, dup=True, pid=pid)
+        b.drain(old)
+        return keepalive
+
+    def subscribe(self, body):
+        b = self.broker
+        pid, pos = struct.unpack_from('>H', body)[0], 2
+        granted, new = [], []
+        while pos < len(body):
+            n = struct.unpack_from('>H', body, pos)[0]
+            flt = body[pos + 2:pos + 2 + n].decode()
+            qos = min(body[pos + 2 + n] & 3, 1)
+            pos += 3 + n
+            self.session.subs[flt] = qos
+            granted.append(qos)
+            new.append((flt, qos))
+        self.send(packet(SUBACK << 4, struct.pack('>H', pid) + bytes(granted)))
+        for topic, (payload, rqos) in list(b.retained.items()):
+            for flt, qos in new:
+                if topic_matches(flt, topic):
+                    q = min(qos, rqos)
+                    if q:
+                        pid = self.session.next_pid()
+                        self.session.inflight[pid] = (topic, payload, True)
+                    self.send(publish_packet(topic, payload, q, True, False, pid if q else 0))
+                    break
+
+    def close(self):
+        b = self.broker
+        s = self.session
+        if s is not None and s.conn is self:
+            s.conn = None
+            if not s.persistent:
+                del b.sessions[s.cid]
+            if self.will is not None and not self.graceful:
+                topic, payload, qos, retain = self.will
+                b.route(topic, payload, min(qos, 1), retain)
+                b.stats['wills'] += 1
+        self.writer.close()
+
+
+async def serve(args):
+    broker = Broker(args)
+    ctx = None
+    if args.certfile:
+        ctx = ssl.create_default_context(ssl.Purpose.CLIENT_AUTH)
+        ctx.load_cert_chain(args.certfile, args.keyfile)
+    server = await asyncio.start_server(broker.handle, args.host, args.port, ssl=ctx)
+    print(f"broker: {'mqtts' if ctx else 'mqtt'}://{args.host}:{args.port}", file=sys.stderr)
+    if args.stats > 0:
+        asyncio.ensure_future(broker.report(args.stats))
+    try:
+        async with server:
+            await server.serve_forever()
+    finally:
+        print(f"broker: {dict(broker.stats)}", file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=None, help='default 1883, 8883 with TLS')
+    parser.add_argument('--certfile', help='PEM certificate: listen with TLS')
+    parser.add_argument('--keyfile', help='PEM private key of --certfile')
+    parser.add_argument('--queue', type=int, default=10000, help='QoS-1 messages kept per absent persistent session')
+    parser.add_argument('--inflight', type=int, default=64, help='unacknowledged QoS-1 messages per client')
+    parser.add_argument('--stats', type=float, default=0.0, help='print counters every N seconds')
+    parser.add_argument('--verbose', action='store_true', help='log protocol errors')
+    args = parser.parse_args()
+    if args.port is None:
+        args.port = 8883 if args.certfile else 1883
+    try:
+        asyncio.run(serve(args))
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,395 @@
+"""Forward the vests' MQTT stream into Firestore, as the bridge's HTTPS path writes it.
+
+Subscribes with a persistent session at QoS 1 to pfa/+/#, one topic level per
+athlete (the users/<athlete> document) and one per kind of message:
+
+    pfa/<athlete>/ppg     tp_ppg_t (26 B)       user document: hr, spo2, pi, liveMs
+    pfa/<athlete>/temp    tp_temp_t (16 B)      user document: temp (LM35 only)
+    pfa/<athlete>/event   tp_event_t (28 B)     user document: anomalyAlert and anomalyScore,
+                                                or anomalyMean and anomalyMax
+    pfa/<athlete>/report  JournalRecord (48 B)  history/<boot>-<seq>, and hr, spo2, temp
+    pfa/<athlete>/burst   [boot u32][alert u16][chunk u16][n u16] samples
+                                                bursts/<boot>-<alert>-<chunk>
+    pfa/<athlete>/config  tp_config_t (24 B)
+                                                user document: cfgCmd, cfgStatus and the
+                                                settings (cfgRateHz, cfgPwUs, ... cfgAi)
+    pfa/<athlete>/status  "online"/"offline", retained (the will)
+                                                user document: online
+
+Records are the STM32's, as Common/Inc/telemetry_proto.h lays them out.
+Messages are gathered for up to --linger ms (or --max-writes writes), written
+as one documents:commit, and acknowledged only once the commit succeeded: a
+failed commit is retried, and if the gateway stops first the broker delivers
+again. Document names come from the payload, so a repeated message rewrites
+the same document. Live values only update the user document, one write per
+athlete and commit with the newest value of each field.
+
+    python3 tools/mqtt_broker.py &
+    python3 tools/ingest_server.py --store /tmp/ingest.jsonl &
+    python3 tools/mqtt_gateway.py --firestore http://127.0.0.1:8080
+"""
+import argparse
+import base64
+import http.client
+import json
+import math
+import socket
+import ssl
+import struct
+import sys
+import time
+from urllib.parse import urlsplit
+
+from mqtt_broker import (CONNACK, CONNECT, DISCONNECT, PINGREQ, PINGRESP, PUBACK, PUBLISH, SUBACK, SUBSCRIBE,
+                         ProtocolError, mqtt_str, packet, parse_publish, publish_packet, remaining_length)
+
+HEADER = '<BBBBI'                           # tp_header_t: tag, version, type, seq, ts_ms
+PPG = HEADER + 'HHHHHHHHBB'                 # tp_ppg_t
+TEMP = HEADER + 'hBBI'                      # tp_temp_t
+EVENT = HEADER + 'BBHIHHII'                 # tp_event_t
+REPORT = '<IIII' + 'hhhHH' * 3 + 'H'        # JournalRecord: seq, boot, uptime, epoch, hr, spo2, temp, crc
+CONFIG = HEADER + 'HBBHHBBBBI'           # tp_config_t
+BURST = '<IHHH'
+RECORD_TAG, RECORD_VERSION = 0xC7, 1
+REC_PPG, REC_TEMP, REC_EVENT, REC_CONFIG = 1, 2, 3, 4
+PPG_FINGER, PPG_HR_VALID = 1, 2
+EVENT_START, EVENT_END, EVENT_SUMMARY = 1, 2, 3
+CONFIG_STATUS = ('OK', 'SYNTAX', 'RANGE', 'COMBO', 'BUSY', 'SENSOR')   # vest_cfg_status_t
+CONFIG_DSP = ('OFF', 'HR', 'SPO2')
+
+
+class MqttClient:
+    """Blocking MQTT 3.1.1 client over TCP or TLS, enough for the gateway and the load generator"""
+
+    def __init__(self, url, client_id, clean=True, keepalive=30, timeout=10.0):
+        u = urlsplit(url)
+        self.tls = u.scheme == 'mqtts'
+        self.host, self.port = u.hostname or '127.0.0.1', u.port or (8883 if self.tls else 1883)
+        self.client_id, self.clean, self.keepalive, self.timeout = client_id, clean, keepalive, timeout
+        self.sock = None
+        self.buf = bytearray()
+        self.pids = 0
+        self.last_tx = 0.0
+
+    def connect(self, will=None):
+        sock = socket.create_connection((self.host, self.port), timeout=self.timeout)
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        if self.tls:
+            ctx = ssl.create_default_context()
+            ctx.check_hostname = False
+            ctx.verify_mode = ssl.CERT_NONE     # Like the bridge's setInsecure()
+            sock = ctx.wrap_socket(sock, server_hostname=self.host)
+        self.sock, self.buf = sock, bytearray()
+        flags = 0x02 if self.clean else 0
+        payload = mqtt_str(self.client_id)
+        if will is not None:
+            topic, msg, retain = will
+            flags |= 0x04 | 0x08 | (0x20 if retain else 0)
+            payload += mqtt_str(topic) + mqtt_str(msg)
+        self.send(packet(CONNECT << 4, mqtt_str('MQTT') + bytes([4, flags]) + struct.pack('>H', self.keepalive)
+                         + payload))
+        first, body = self.read()
+        if first >> 4 != CONNACK or len(body) != 2 or body[1] != 0:
+            raise ProtocolError(f'connection refused: {body.hex()}')
+        return bool(body[0] & 1)   # Session present
+
+    def close(self, graceful=True):
+        if self.sock is None:
+            return
+        try:
+            if graceful:
+                self.send(packet(DISCONNECT << 4))
+            self.sock.close()
+        except OSError:
+            pass
+        self.sock = None
+
+    def send(self, data):
+        self.sock.sendall(data)
+        self.last_tx = time.monotonic()
+
+    def next_pid(self):
+        self.pids = self.pids % 0xFFFF + 1
+        return self.pids
+
+    def publish(self, topic, payload, qos=1, retain=False):
+        pid = self.next_pid() if qos else 0
+        self.send(publish_packet(topic, payload, qos, retain, False, pid))
+        return pid
+
+    def subscribe(self, filters):
+        pid = self.next_pid()
+        self.send(packet(SUBSCRIBE << 4 | 2, struct.pack('>H', pid)
+                         + b''.join(mqtt_str(f) + bytes([q]) for f, q in filters)))
+        return pid
+
+    def puback(self, pid):
+        self.send(packet(PUBACK << 4, struct.pack('>H', pid)))
+
+    def ping_if_due(self):
+        if self.keepalive and time.monotonic() - self.last_tx >= self.keepalive / 2:
+            self.send(packet(PINGREQ << 4))
+
+    def read(self, timeout=None):
+        """-> (first byte, body), or None if no whole packet came within timeout"""
+        deadline = time.monotonic() + (timeout if timeout is not None else self.timeout)
+        while True:
+            got = self.parse()
+            if got is not None:
+                return got
+            left = deadline - time.monotonic()
+            if left <= 0:
+                return None
+            self.sock.settimeout(left)
+            try:
+                data = self.sock.recv(65536)
+            except (socket.timeout, TimeoutError):
+                return None
+            if not data:
+                raise ConnectionError('closed by the broker')
+            self.buf += data
+
+    def parse(self):
+        """One whole packet off the receive buffer, None if incomplete"""
+        pos = 1
+        def byte():
+            nonlocal pos
+            if pos >= len(self.buf):
+                raise IndexError
+            pos += 1
+            return self.buf[pos - 1]
+        try:
+            n = remaining_length(byte)
+        except IndexError:
+            return None
+        if len(self.buf) < pos + n:
+            return None
+        first, body = self.buf[0], bytes(self.buf[pos:pos + n])
+        del self.buf[:pos + n]
+        return first, body
+
+
+def fields(values):
+    """Plain values -> Firestore typed values"""
+    out = {}
+    for k, v in values.items():
+        if isinstance(v, bool):
+            out[k] = {'booleanValue': v}
+        elif isinstance(v, int):
+            out[k] = {'integerValue': str(v)}
+        elif isinstance(v, bytes):
+            out[k] = {'bytesValue': base64.b64encode(v).decode()}
+        elif isinstance(v, str):
+            out[k] = {'stringValue': v}
+        else:
+            out[k] = {'doubleValue': round(v, 3)}
+    return out
+
+
+class Gateway:
+    def __init__(self, args):
+        self.args = args
+        self.docs = f'projects/{args.project}/databases/(default)/documents'
+        u = urlsplit(args.firestore)
+        self.fs_https = u.scheme == 'https'
+        self.fs_host, self.fs_port = u.hostname, u.port or (443 if self.fs_https else 80)
+        self.fs_path = f"{u.path.rstrip('/')}/v1/{self.docs}:commit" + (f'?key={args.api_key}' if args.api_key else '')
+        self.fs = None
+        self.stats = {'messages': 0, 'duplicates': 0, 'commits': 0, 'writes': 0, 'failures': 0, 'bad': 0}
+        self.delays = []   # Receive to commit, ms, since the last report
+
+    def user(self, athlete):
+        return f'{self.docs}/{self.args.collection}/{athlete}'
+
+    def writes(self, athlete, leaf, payload):
+        """One message -> (Firestore writes, live user fields merged per commit)"""
+        user = self.user(athlete)
+        if leaf in ('ppg', 'temp', 'event', 'config'):
+            if len(payload) < 8:
+                raise ValueError('short record')
+            tag, version, kind, _, ts = struct.unpack_from(HEADER, payload)
+            if tag != RECORD_TAG or version != RECORD_VERSION:
+                raise ValueError('not a record')
+        if leaf == 'ppg':
+            r = struct.unpack(PPG, payload)
+            live = {'spo2': r[6] / 10.0, 'pi': r[8] / 100.0, 'liveMs': ts} if r[14] & PPG_FINGER else {'liveMs': ts}
+            if r[14] & PPG_HR_VALID:
+                live['hr'] = r[5] / 10.0
+            return [], live
+        if leaf == 'temp':
+            r = struct.unpack(TEMP, payload)
+            return [], ({'temp': r[5] / 100.0} if r[6] == 0 else {})
+        if leaf == 'event':
+            r = struct.unpack(EVENT, payload)
+            event, score, peak = r[5], r[9] / 1000.0, r[10] / 1000.0
+            if event == EVENT_START:
+                return [], {'anomalyAlert': 1.0, 'anomalyScore': score}
+            if event == EVENT_END:
+                return [], {'anomalyAlert': 0.0, 'anomalyScore': peak}
+            if event == EVENT_SUMMARY:
+                return [], {'anomalyMean': score, 'anomalyMax': peak}
+            return [], {}
+        if leaf == 'config':
+            r = struct.unpack(CONFIG, payload)
+            cmd, status, dsp, rate, pw, led_ir, led_red, ai, _, report = r[5:]
+            return [], {'cfgCmd': cmd, 'cfgStatus': CONFIG_STATUS[status] if status < len(CONFIG_STATUS) else str(status),
+                        'cfgRateHz': rate, 'cfgPwUs': pw, 'cfgLedIr': led_ir, 'cfgLedRed': led_red,
+                        'cfgReportMs': report, 'cfgDsp': CONFIG_DSP[dsp] if dsp < len(CONFIG_DSP) else str(dsp),
+                        'cfgAi': bool(ai)}
+        if leaf == 'report':
+            r = struct.unpack(REPORT, payload)
+            seq, boot, uptime, epoch = r[:4]
+            hr, spo2, temp = r[4:9], r[9:14], r[14:19]
+            values = {'hr': float((hr[2] + 5) // 10), 'spo2': float((spo2[2] + 5) // 10)}
+            if temp[4]:
+                values['temp'] = temp[2] / 100.0
+            doc = dict(values, uptimeMs=uptime, agg=payload[16:46])
+            if epoch:
+                doc['ts'] = time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime(epoch))
+            w = {'update': {'name': f'{user}/history/{boot:08x}-{seq}', 'fields': fields(doc)},
+                 'updateTransforms': [{'fieldPath': 'receivedAt', 'setToServerValue': 'REQUEST_TIME'}]}
+            if 'ts' in doc:
+                w['update']['fields']['ts'] = {'timestampValue': doc['ts']}
+            return [w], values
+        if leaf == 'burst':
+            boot, alert, chunk, n = struct.unpack_from(BURST, payload)
+            doc = {'alertId': alert, 'chunk': chunk, 'n': n, 'samples': payload[struct.calcsize(BURST):]}
+            return [{'update': {'name': f'{user}/bursts/{boot:08x}-{alert}-{chunk}', 'fields': fields(doc)},
+                     'updateTransforms': [{'fieldPath': 'receivedAt', 'setToServerValue': 'REQUEST_TIME'}]}], {}
+        if leaf == 'status':
+            return [], {'online': payload == b'online'}
+        raise ValueError(f'unknown topic pfa/{athlete}/{leaf}')
+
+    def commit(self, writes):
+        body = json.dumps({'writes': writes}).encode()
+        for attempt in range(2):   # Once more on a fresh connection, as the bridge does
+            try:
+                if self.fs is None:
+                    cls = http.client.HTTPSConnection if self.fs_https else http.client.HTTPConnection
+                    self.fs = cls(self.fs_host, self.fs_port, timeout=self.args.timeout)
+                self.fs.request('POST', self.fs_path, body, {'Content-Type': 'application/json'})
+                resp = self.fs.getresponse()
+                resp.read()
+                if resp.status == 200:
+                    return True
+                print(f"gateway: Firestore HTTP {resp.status}", file=sys.stderr)
+                return False
+            except (OSError, http.client.HTTPException) as err:
+                self.fs.close()
+                self.fs = None
+                if attempt == 1:
+                    print(f"gateway: Firestore {type(err).__name__}", file=sys.stderr)
+        return False
+
+    def flush(self, client, pending):
+        """pending: [(pid, received at, athlete, leaf, payload)] -> committed and acknowledged"""
+        writes, live = [], {}
+        for _, _, athlete, leaf, payload in pending:
+            try:
+                w, values = self.writes(athlete, leaf, payload)
+            except (ValueError, struct.error) as err:
+                self.stats['bad'] += 1     # Acknowledged anyway: it would come back forever
+                print(f"gateway: pfa/{athlete}/{leaf}: {err}", file=sys.stderr)
+                continue
+            writes += w
+            live.setdefault(athlete, {}).update(values)
+        for athlete, values in live.items():
+            if values:
+                writes.append({'update': {'name': self.user(athlete), 'fields': fields(values)},
+                               'updateMask': {'fieldPaths': list(values)}})
+        while writes and not self.commit(writes):
+            self.stats['failures'] += 1
+            time.sleep(self.args.retry)
+        done = time.monotonic()
+        if writes:
+            self.stats['commits'] += 1
+            self.stats['writes'] += len(writes)
+        for pid, received, *_ in pending:
+            if pid:
+                client.puback(pid)
+            self.delays.append((done - received) * 1e3)
+
+    def report(self, elapsed):
+        d = sorted(self.delays)
+        p = (lambda q: d[max(0, math.ceil(q / 100.0 * len(d)) - 1)]) if d else (lambda q: float('nan'))
+        print(f"gateway: {len(d) / elapsed:.1f} msg/s, receive to commit p50 {p(50):.1f} ms p99 {p(99):.1f} ms, "
+              f"{self.stats}", file=sys.stderr)
+        self.delays = []
+
+    def run(self):
+        args = self.args
+        while True:
+            client = MqttClient(args.broker, args.client_id, clean=False, keepalive=args.keepalive)
+            try:
+                present = client.connect()
+                client.subscribe([(f'{args.prefix}/+/#', 1)])
+                print(f"gateway: {args.broker} ({'session resumed' if present else 'new session'}) -> "
+                      f"{args.firestore}", file=sys.stderr)
+                self.loop(client)
+            except (OSError, ConnectionError, ProtocolError) as err:
+                print(f"gateway: broker {err}, reconnecting", file=sys.stderr)
+                client.close(graceful=False)
+                time.sleep(args.retry)
+
+    def loop(self, client):
+        args = self.args
+        pending, deadline = [], None
+        last_report = time.monotonic()
+        while True:
+            now = time.monotonic()
+            wait = 0.5 if deadline is None else max(0.0, deadline - now)
+            got = client.read(wait)
+            if got is not None:
+                first, body = got
+                kind = first >> 4
+                if kind == PUBLISH:
+                    topic, payload, qos, _, dup, pid = parse_publish(first, body)
+                    parts = topic.split('/')
+                    self.stats['messages'] += 1
+                    self.stats['duplicates'] += dup
+                    if len(parts) != 3:
+                        self.stats['bad'] += 1
+                        if qos:
+                            client.puback(pid)
+                        continue
+                    pending.append((pid if qos else 0, time.monotonic(), parts[1], parts[2], payload))
+                    if deadline is None:
+                        deadline = time.monotonic() + args.linger / 1e3
+                elif kind not in (SUBACK, PINGRESP):
+                    raise ProtocolError(f'unexpected packet type {kind}')
+            now = time.monotonic()
+            if pending and (now >= deadline or len(pending) >= args.max_writes):
+                self.flush(client, pending)
+                pending, deadline = [], None
+            client.ping_if_due()
+            if args.stats and now - last_report >= args.stats:
+                self.report(now - last_report)
+                last_report = now
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--broker', default='mqtt://127.0.0.1:1883', help='mqtt:// or mqtts:// URL')
+    parser.add_argument('--client-id', default='pfa-gateway')
+    parser.add_argument('--prefix', default='pfa', help='topic root, as MQTT_TOPIC_ROOT in PFA2.ino')
+    parser.add_argument('--firestore', default='http://127.0.0.1:8080',
+                        help='base URL: tools/ingest_server.py, or https://firestore.googleapis.com')
+    parser.add_argument('--api-key', default='', help='appended as ?key= to the commit URL')
+    parser.add_argument('--project', default='trackervest-4e4f4')
+    parser.add_argument('--collection', default='users')
+    parser.add_argument('--linger', type=float, default=50.0, help='ms to gather messages into one commit')
+    parser.add_argument('--max-writes', type=int, default=200, help='messages per commit (Firestore: 500 writes)')
+    parser.add_argument('--keepalive', type=int, default=30)
+    parser.add_argument('--timeout', type=float, default=5.0, help='per Firestore request')
+    parser.add_argument('--retry', type=float, default=1.0, help='seconds before retrying a failed commit')
+    parser.add_argument('--stats', type=float, default=10.0, help='print rate and latency every N seconds, 0: never')
+    args = parser.parse_args()
+    try:
+        Gateway(args).run()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,139 @@
+"""Pack X-CUBE-AI weights into a versioned, CRC-checked blob and optionally send it.
+
+The blob format is defined in Common/Inc/weights_blob.h:
+
+    [header (48 bytes, little-endian)][raw weights]
+
+Weights are read either from a generated <name>_data_params.c (the
+s_<name>_weights_array_u64 table) or from a raw binary file. The blob can be
+written to a file and/or sent to the CM4 USART3 (ST-LINK VCP on the Nucleo),
+which stages it for the CM7 to hot-swap between two inferences.
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT = os.path.dirname(HERE)
+DEFAULT_APP_DIR = os.path.join(REPO_ROOT, 'CM7', 'X-CUBE-AI', 'App')
+
+WBLOB_MAGIC = 0x42574941  # "AIWB"
+WBLOB_FORMAT_VERSION = 1
+WBLOB_HEADER_SIZE = 48
+WBLOB_NAME_LEN = 16
+
+# magic, format_version, header_size, model_name, model_version,
+# payload_size, payload_crc32, flags, reserved (header_crc32 appended)
+_HEADER_FMT = '<IHH16sIIIII'
+
+
+def weights_from_params_c(params_c, params_h=None):
+    """Rebuild the raw weights bytes from a generated *_data_params.c"""
+    with open(params_c) as f:
+        source = f.read()
+    match = re.search(r'ai_u64\s+s_\w+_weights_array_u64\[\d+\]\s*=\s*\{(.*?)\};', source, re.S)
+    if not match:
+        raise ValueError(f"No weights array found in {params_c}")
+    words = [int(v, 16) for v in re.findall(r'0x([0-9a-fA-F]+)U', match.group(1))]
+    data = b''.join(struct.pack('<Q', w) for w in words)
+
+    params_h = params_h or params_c[:-2] + '.h'
+    if os.path.exists(params_h):
+        with open(params_h) as f:
+            size = re.search(r'_DATA_WEIGHTS_SIZE\s+\((\d+)\)', f.read())
+        if size:
+            data = data[:int(size.group(1))]
+    return data
+
+
+def pack(weights, model_name, model_version):
+    """Return the blob bytes for a weights payload"""
+    name = model_name.encode('ascii')
+    if len(name) >= WBLOB_NAME_LEN:
+        raise ValueError(f"Model name must be shorter than {WBLOB_NAME_LEN} characters")
+
+    header = struct.pack(_HEADER_FMT, WBLOB_MAGIC, WBLOB_FORMAT_VERSION, WBLOB_HEADER_SIZE,
+                         name.ljust(WBLOB_NAME_LEN, b'\0'), model_version,
+                         len(weights), zlib.crc32(weights), 0, 0)
+    header += struct.pack('<I', zlib.crc32(header))
+    assert len(header) == WBLOB_HEADER_SIZE
+    return header + weights
+
+
+def unpack(blob):
+    """Decode and check a blob, return (model_name, model_version, weights)"""
+    if len(blob) < WBLOB_HEADER_SIZE:
+        raise ValueError("Truncated header")
+    fields = struct.unpack(_HEADER_FMT, blob[:WBLOB_HEADER_SIZE - 4])
+    magic, fmt, hdr_size, name, version, size, crc = fields[:7]
+    (hdr_crc,) = struct.unpack('<I', blob[WBLOB_HEADER_SIZE - 4:WBLOB_HEADER_SIZE])
+    if magic != WBLOB_MAGIC or fmt != WBLOB_FORMAT_VERSION or hdr_size != WBLOB_HEADER_SIZE:
+        raise ValueError("Not a weights blob")
+    if zlib.crc32(blob[:WBLOB_HEADER_SIZE - 4]) != hdr_crc:
+        raise ValueError("Header CRC mismatch")
+    weights = blob[WBLOB_HEADER_SIZE:WBLOB_HEADER_SIZE + size]
+    if len(weights) != size or zlib.crc32(weights) != crc:
+        raise ValueError("Payload CRC mismatch")
+    return name.rstrip(b'\0').decode('ascii'), version, weights
+
+
+def send_serial(blob, port, baud):
+    """Write the blob to a serial port (POSIX termios, no extra dependency)"""
+    import termios
+
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+    try:
+        attrs = termios.tcgetattr(fd)
+        speed = getattr(termios, f'B{baud}')
+        attrs[0] = 0                                          # iflag
+        attrs[1] = 0                                          # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0                                          # lflag
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        os.write(fd, blob)
+        termios.tcdrain(fd)
+    finally:
+        os.close(fd)
+    print(f"Sent {len(blob)} bytes to {port} at {baud} baud")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--name', default='athlet', help='X-CUBE-AI network name')
+    parser.add_argument('--version', type=int, required=True, help='model version (> 0)')
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument('--params-c', help='generated <name>_data_params.c')
+    source.add_argument('--raw', help='raw weights binary')
+    parser.add_argument('-o', '--output', help='write the blob to this file')
+    parser.add_argument('--port', help='serial port to send the blob to')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.raw:
+        with open(args.raw, 'rb') as f:
+            weights = f.read()
+    else:
+        params_c = args.params_c or os.path.join(DEFAULT_APP_DIR, f'{args.name}_data_params.c')
+        weights = weights_from_params_c(params_c)
+
+    blob = pack(weights, args.name, args.version)
+    print(f"{args.name} v{args.version}: {len(weights)} bytes of weights, "
+          f"crc32 0x{zlib.crc32(weights):08x}")
+
+    if args.output:
+        with open(args.output, 'wb') as f:
+            f.write(blob)
+        print(f"Blob written to {args.output}")
+    if args.port:
+        send_serial(blob, args.port, args.baud)
+    if not args.output and not args.port:
+        parser.error("nothing to do, give --output and/or --port")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
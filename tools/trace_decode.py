@@ -0,0 +1,245 @@
+"""Decode a CM4 event trace dump into a Chrome/Perfetto timeline.
+
+The dump format is defined in CM4/Core/Inc/tracer.h:
+
+    [header (20 bytes)][task table (16 bytes each)][events (8 bytes each)][crc32]
+
+The dump is either read from a file (raw bytes captured from USART3) or
+requested from the board: "TRC?" is written to the serial port (ST-LINK VCP
+on the Nucleo) and the reply is read back. The output JSON opens in
+ui.perfetto.dev or chrome://tracing; every task, interrupt, bus and STOP
+period gets its own track.
+"""
+import argparse
+import json
+import os
+import select
+import struct
+import sys
+import time
+import zlib
+
+TRACER_DUMP_MAGIC = 0x44435254  # "TRCD"
+TRACER_DUMP_VERSION = 1
+TRACER_DUMP_COMMAND = b'TRC?'
+TRACER_NAME_LEN = 12
+
+# magic, version, n_tasks, event_size, ts_hz, n_events, lost
+_HEADER_FMT = '<IBBHIII'
+_HEADER_SIZE = struct.calcsize(_HEADER_FMT)
+_TASK_FMT = f'<I{TRACER_NAME_LEN}s'
+_TASK_SIZE = struct.calcsize(_TASK_FMT)
+_EVENT_FMT = '<IBBH'
+_EVENT_SIZE = struct.calcsize(_EVENT_FMT)
+
+# tracer_event_id_t
+EV_TASK_IN = 1
+EV_ISR_ENTER = 2
+EV_ISR_EXIT = 3
+EV_I2C_BEGIN = 4
+EV_I2C_END = 5
+EV_UART_TX_BEGIN = 6
+EV_UART_TX_END = 7
+EV_STOP_ENTER = 8
+EV_STOP_EXIT = 9
+EV_QUEUE_DROP = 10
+
+IRQ_NAMES = {1: 'EXTI5 (MAX30100 INT)', 2: 'USART3', 3: 'LPTIM1'}
+QUEUE_NAMES = {1: 'ppg', 2: 'result', 3: 'telemetry'}
+
+# Track ids below 100 are FreeRTOS task numbers
+TID_ISR_BASE = 100
+TID_I2C = 200
+TID_UART_TX = 201
+TID_STOP = 202
+PID = 4  # CM4
+
+
+def parse_dump(data):
+    """Check a dump, return (header dict, {task number: name}, [(ts_us, id, a8, a16)])"""
+    start = data.find(struct.pack('<I', TRACER_DUMP_MAGIC))
+    if start < 0 or len(data) - start < _HEADER_SIZE:
+        raise ValueError("No trace dump header found")
+    data = data[start:]
+    magic, version, n_tasks, event_size, ts_hz, n_events, lost = \
+        struct.unpack(_HEADER_FMT, data[:_HEADER_SIZE])
+    if version != TRACER_DUMP_VERSION or event_size != _EVENT_SIZE or ts_hz == 0:
+        raise ValueError(f"Unsupported dump (version {version}, event size {event_size})")
+
+    size = dump_size(n_tasks, n_events)
+    if len(data) < size:
+        raise ValueError(f"Truncated dump: {len(data)} of {size} bytes")
+    (crc,) = struct.unpack('<I', data[size - 4:size])
+    if zlib.crc32(data[:size - 4]) != crc:
+        raise ValueError("Dump CRC mismatch")
+
+    tasks = {}
+    off = _HEADER_SIZE
+    for _ in range(n_tasks):
+        number, name = struct.unpack(_TASK_FMT, data[off:off + _TASK_SIZE])
+        tasks[number] = name.split(b'\0', 1)[0].decode('ascii', 'replace')
+        off += _TASK_SIZE
+
+    # 32-bit timestamps wrap every ~71 minutes at 1 MHz
+    events = []
+    base = 0
+    prev = None
+    for _ in range(n_events):
+        ts, ev, a8, a16 = struct.unpack(_EVENT_FMT, data[off:off + _EVENT_SIZE])
+        off += _EVENT_SIZE
+        if prev is not None and ts < prev:
+            base += 1 << 32
+        prev = ts
+        events.append(((base + ts) * 1000000 / ts_hz, ev, a8, a16))
+
+    header = {'n_tasks': n_tasks, 'n_events': n_events, 'lost': lost, 'ts_hz': ts_hz}
+    return header, tasks, events
+
+
+def dump_size(n_tasks, n_events):
+    return _HEADER_SIZE + n_tasks * _TASK_SIZE + n_events * _EVENT_SIZE + 4
+
+
+def to_chrome_trace(tasks, events):
+    """Turn decoded events into a list of Chrome trace events"""
+    out = []
+    if not events:
+        return out
+    t0 = events[0][0]
+    t_end = events[-1][0] - t0
+
+    def meta(tid, name, sort):
+        out.append({'ph': 'M', 'pid': PID, 'tid': tid, 'name': 'thread_name', 'args': {'name': name}})
+        out.append({'ph': 'M', 'pid': PID, 'tid': tid, 'name': 'thread_sort_index',
+                    'args': {'sort_index': sort}})
+
+    def slice_(tid, name, begin, end, args=None):
+        ev = {'ph': 'X', 'pid': PID, 'tid': tid, 'name': name, 'ts': begin, 'dur': max(end - begin, 0)}
+        if args:
+            ev['args'] = args
+        out.append(ev)
+
+    out.append({'ph': 'M', 'pid': PID, 'name': 'process_name', 'args': {'name': 'CM4'}})
+    seen_tids = set()
+    running = None  # (task number, start)
+    open_isr = {}
+    open_i2c = None
+    open_tx = None
+    open_stop = None
+
+    for ts, ev, a8, a16 in events:
+        ts -= t0
+        if ev == EV_TASK_IN:
+            if running is not None:
+                slice_(running[0], tasks.get(running[0], f'task {running[0]}'), running[1], ts)
+            running = (a16, ts)
+            seen_tids.add(a16)
+        elif ev == EV_ISR_ENTER:
+            open_isr[a8] = ts
+        elif ev == EV_ISR_EXIT and a8 in open_isr:
+            slice_(TID_ISR_BASE + a8, IRQ_NAMES.get(a8, f'irq {a8}'), open_isr.pop(a8), ts)
+            seen_tids.add(TID_ISR_BASE + a8)
+        elif ev == EV_I2C_BEGIN:
+            open_i2c = (ts, a8, a16)
+        elif ev == EV_I2C_END and open_i2c is not None:
+            begin, reg, nbytes = open_i2c
+            slice_(TID_I2C, f'reg 0x{reg:02x} x{nbytes}', begin, ts, {'status': a8})
+            open_i2c = None
+        elif ev == EV_UART_TX_BEGIN:
+            open_tx = (ts, a16)
+        elif ev == EV_UART_TX_END and open_tx is not None:
+            slice_(TID_UART_TX, f'tx {open_tx[1]} B', open_tx[0], ts, {'status': a8})
+            open_tx = None
+        elif ev == EV_STOP_ENTER:
+            open_stop = (ts, a16)
+        elif ev == EV_STOP_EXIT and open_stop is not None:
+            slice_(TID_STOP, 'STOP', open_stop[0], ts,
+                   {'expected_ticks': open_stop[1], 'ticks': a16, 'wake': 'timer' if a8 else 'irq'})
+            open_stop = None
+        elif ev == EV_QUEUE_DROP:
+            out.append({'ph': 'i', 'pid': PID, 'tid': running[0] if running else TID_ISR_BASE,
+                        's': 'p', 'ts': ts, 'name': f'drop {QUEUE_NAMES.get(a8, a8)}'})
+
+    # The dump itself runs in the telemetry task: close what is still open
+    if running is not None:
+        slice_(running[0], tasks.get(running[0], f'task {running[0]}'), running[1], t_end)
+
+    for number in sorted(seen_tids):
+        if number < TID_ISR_BASE:
+            meta(number, tasks.get(number, f'task {number}'), number)
+        else:
+            meta(number, 'ISR ' + IRQ_NAMES.get(number - TID_ISR_BASE, str(number)), number)
+    meta(TID_I2C, 'I2C1', TID_I2C)
+    meta(TID_UART_TX, 'USART3 TX', TID_UART_TX)
+    meta(TID_STOP, 'D2 STOP', TID_STOP)
+    return out
+
+
+def request_serial(port, baud, timeout):
+    """Send the dump command and read the reply (POSIX termios, no extra dependency)"""
+    import termios
+
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+    try:
+        attrs = termios.tcgetattr(fd)
+        speed = getattr(termios, f'B{baud}')
+        attrs[0] = 0                                          # iflag
+        attrs[1] = 0                                          # oflag
+        attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        attrs[3] = 0                                          # lflag
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        termios.tcflush(fd, termios.TCIFLUSH)
+        os.write(fd, TRACER_DUMP_COMMAND)
+
+        # Telemetry frames may precede the dump; stop once the whole dump is in
+        data = b''
+        deadline = time.monotonic() + timeout
+        magic = struct.pack('<I', TRACER_DUMP_MAGIC)
+        while time.monotonic() < deadline:
+            ready, _, _ = select.select([fd], [], [], 0.2)
+            if ready:
+                data += os.read(fd, 4096)
+            start = data.find(magic)
+            if start >= 0 and len(data) - start >= _HEADER_SIZE:
+                fields = struct.unpack(_HEADER_FMT, data[start:start + _HEADER_SIZE])
+                if len(data) - start >= dump_size(fields[2], fields[5]):
+                    return data[start:]
+        raise TimeoutError(f"No complete trace dump from {port} within {timeout} s")
+    finally:
+        os.close(fd)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--input', help='raw dump captured from USART3')
+    source.add_argument('--port', help='serial port to request the dump from')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--timeout', type=float, default=5.0, help='seconds to wait for the dump')
+    parser.add_argument('--save-raw', help='also write the raw dump to this file')
+    parser.add_argument('-o', '--output', required=True, help='Chrome trace JSON to write')
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+    else:
+        data = request_serial(args.port, args.baud, args.timeout)
+    if args.save_raw:
+        with open(args.save_raw, 'wb') as f:
+            f.write(data)
+
+    header, tasks, events = parse_dump(data)
+    trace = to_chrome_trace(tasks, events)
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': trace, 'displayTimeUnit': 'ms'}, f)
+
+    span_ms = (events[-1][0] - events[0][0]) / 1000 if events else 0
+    print(f"{header['n_events']} events over {span_ms:.1f} ms, {header['lost']} lost, "
+          f"{len(tasks)} tasks -> {args.output}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())